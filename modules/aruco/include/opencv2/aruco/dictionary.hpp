@@ -40,6 +40,7 @@ the use of this software, even if advised of the possibility of such damage.
 #define __OPENCV_DICTIONARY_HPP__
 
 #include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
 
 namespace cv {
 namespace aruco {
@@ -101,6 +102,10 @@ class CV_EXPORTS_W Dictionary {
     /**
      * @brief Given a matrix of bits. Returns whether if marker is identified or not.
      * It returns by reference the correct id (if any) and the correct rotation
+     *
+     * The search uses a lookup structure over bytesList, built on the first call and rebuilt when
+     * bytesList is reallocated or resized. It must be rebuilt by hand (see clearIndex) if the codes
+     * are modified in place.
      */
     bool identify(const Mat &onlyBits, int &idx, int &rotation, double maxCorrectionRate) const;
 
@@ -127,6 +132,21 @@ class CV_EXPORTS_W Dictionary {
       * @brief Transform list of bytes to matrix of bits
       */
     static Mat getBitsFromByteList(const Mat &byteList, int markerSize);
+
+
+    /**
+      * @brief Discard the lookup structure used by identify, so that it is rebuilt on next call
+      */
+    void clearIndex();
+
+    private:
+    class Index;
+
+    /** get the lookup structure over current bytesList, building it if needed */
+    Ptr<Index> getIndex() const;
+
+    mutable Ptr<Index> index;
+    mutable Mutex indexMutex;
 };
 
 
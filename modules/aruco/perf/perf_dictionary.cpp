@@ -0,0 +1,61 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+using std::tr1::get;
+
+typedef std::tr1::tuple<int, double> DictionaryParams;
+typedef perf::TestBaseWithParam<DictionaryParams> dictionary;
+
+// the marker candidates of a crowded frame: mostly dictionary codes with a few wrong bits, in any
+// rotation, and some quads which are not markers at all
+PERF_TEST_P(dictionary, identify,
+            testing::Combine(testing::Values((int)aruco::DICT_4X4_1000, (int)aruco::DICT_5X5_1000,
+                                             (int)aruco::DICT_6X6_1000, (int)aruco::DICT_7X7_1000),
+                             testing::Values(0.6, 1.0)))
+{
+    Ptr<aruco::Dictionary> dict = aruco::getPredefinedDictionary(get<0>(GetParam()));
+    double rate = get<1>(GetParam());
+    int markerSize = dict->markerSize;
+    int maxFlips = max(1, int(dict->maxCorrectionBits * rate));
+
+    RNG rng(0);
+    vector<Mat> candidates(1000);
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        Mat& bits = candidates[i];
+        if (i % 5 == 0)
+        {
+            bits.create(markerSize, markerSize, CV_8UC1);
+            rng.fill(bits, RNG::UNIFORM, 0, 2);
+            continue;
+        }
+        int id = rng.uniform(0, dict->bytesList.rows);
+        bits = aruco::Dictionary::getBitsFromByteList(dict->bytesList.rowRange(id, id + 1), markerSize);
+        for (int f = rng.uniform(0, maxFlips + 1); f > 0; f--)
+        {
+            uchar& bit = bits.at<uchar>(rng.uniform(0, markerSize), rng.uniform(0, markerSize));
+            bit = 1 - bit;
+        }
+        for (int k = rng.uniform(0, 4); k > 0; k--)
+        {
+            transpose(bits, bits);
+            flip(bits, bits, 1);
+        }
+    }
+
+    int found = 0;
+    TEST_CYCLE()
+    {
+        found = 0;
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            int id, rotation;
+            found += dict->identify(candidates[i], id, rotation, rate) ? 1 : 0;
+        }
+    }
+
+    RecordProperty("identified", found);
+    SANITY_CHECK_NOTHING();
+}
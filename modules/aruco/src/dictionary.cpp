@@ -42,6 +42,8 @@ the use of this software, even if advised of the possibility of such damage.
 #include <opencv2/imgproc.hpp>
 #include "predefined_dictionaries.hpp"
 #include "opencv2/core/hal/hal.hpp"
+#include <algorithm>
+#include <climits>
 
 namespace cv {
 namespace aruco {
@@ -90,6 +92,195 @@ Ptr<Dictionary> Dictionary::get(int dict) {
 }
 
 
+/**
+  * @brief Lookup structure over the codes of a dictionary (multi-index hashing)
+  *
+  * The bits of a code are split in s disjoint substrings, and for each substring a hash table maps
+  * its value to the markers having it in any of their 4 rotations. If a candidate is at distance
+  * <= R from some rotation of a marker, at least one of its substrings is at distance <= R/s from
+  * the same substring of that rotation, so probing every table within that radius finds all the
+  * markers that the linear search can accept.
+  */
+class Dictionary::Index {
+    public:
+    Index(const Mat &bytesList, int markerSize);
+
+    /**
+      * true if the index was built from this very buffer. The index shares the buffer, so it cannot
+      * be released and another one allocated at the same address while the index is alive
+      */
+    bool isValidFor(const Mat &bytesList, int markerSize) const {
+        return bytesList.data == codes.data && bytesList.rows == codes.rows &&
+               bytesList.cols == codes.cols && markerSize == msize;
+    }
+
+    /**
+      * Markers which may be within maxDistance of code, sorted by id. Returns false if probing the
+      * tables would cost more than checking all the markers.
+      */
+    bool candidates(const uchar *code, int maxDistance, vector< int > &ids) const;
+
+    private:
+    unsigned int key(const uchar *code, int s) const;
+    void probe(int s, unsigned int k, int from, int budget, vector< int > &ids) const;
+
+    Mat codes;                            // shares the buffer of bytesList
+    int rows, msize;
+
+    vector< int > start, length;          // bit range of each substring
+    vector< vector< int > > offsets;      // bucket k of substring s is entries[s][offsets[s][k]...]
+    vector< vector< int > > entries;
+};
+
+
+Dictionary::Index::Index(const Mat &bytesList, int markerSize)
+    : codes(bytesList), rows(bytesList.rows), msize(markerSize) {
+
+    int nbits = markerSize * markerSize;
+    int nbytes = bytesList.cols;
+    if(rows == 0 || nbits == 0) return;
+
+    // substrings long enough for the buckets to be almost empty, short enough for the tables to
+    // stay small
+    int targetLength = 4;
+    while(targetLength < 16 && (1 << targetLength) < 4 * rows)
+        targetLength++;
+    int nsub = (nbits + targetLength - 1) / targetLength;
+
+    start.resize(nsub);
+    length.resize(nsub);
+    offsets.resize(nsub);
+    entries.resize(nsub);
+    for(int s = 0, b = 0; s < nsub; s++) {
+        start[s] = b;
+        length[s] = nbits / nsub + (s < nbits % nsub ? 1 : 0);
+        b += length[s];
+    }
+
+    // counting sort of the 4 rotations of every marker, by the value of each substring
+    vector< unsigned int > keys(4 * rows);
+    for(int s = 0; s < nsub; s++) {
+        vector< int > &off = offsets[s];
+        off.assign((1 << length[s]) + 1, 0);
+        for(int m = 0; m < rows; m++) {
+            for(int r = 0; r < 4; r++) {
+                unsigned int k = key(bytesList.ptr(m) + r * nbytes, s);
+                keys[4 * m + r] = k;
+                off[k + 1]++;
+            }
+        }
+        for(size_t k = 1; k < off.size(); k++)
+            off[k] += off[k - 1];
+
+        vector< int > fill(off.begin(), off.end() - 1);
+        entries[s].resize(4 * rows);
+        for(int m = 0; m < rows; m++) {
+            for(int r = 0; r < 4; r++) {
+                unsigned int k = keys[4 * m + r];
+                // several rotations of a marker may share a bucket, keep it once
+                if(fill[k] > off[k] && entries[s][fill[k] - 1] == m) continue;
+                entries[s][fill[k]++] = m;
+            }
+        }
+        // close the gaps left by the duplicates
+        int n = 0;
+        for(size_t k = 0; k + 1 < off.size(); k++) {
+            int first = off[k], last = fill[k];
+            off[k] = n;
+            for(int i = first; i < last; i++)
+                entries[s][n++] = entries[s][i];
+        }
+        off.back() = n;
+        entries[s].resize(n);
+    }
+}
+
+
+unsigned int Dictionary::Index::key(const uchar *code, int s) const {
+    unsigned int k = 0;
+    for(int i = 0; i < length[s]; i++) {
+        int b = start[s] + i;
+        k |= (unsigned int)((code[b >> 3] >> (b & 7)) & 1) << i;
+    }
+    return k;
+}
+
+
+void Dictionary::Index::probe(int s, unsigned int k, int from, int budget,
+                              vector< int > &ids) const {
+    const vector< int > &off = offsets[s];
+    ids.insert(ids.end(), entries[s].begin() + off[k], entries[s].begin() + off[k + 1]);
+    if(budget == 0) return;
+    for(int i = from; i < length[s]; i++)
+        probe(s, k ^ (1u << i), i + 1, budget - 1, ids);
+}
+
+
+bool Dictionary::Index::candidates(const uchar *code, int maxDistance, vector< int > &ids) const {
+    int nsub = (int)start.size();
+    if(nsub == 0) return false;
+    int radius = maxDistance / nsub;
+
+    // buckets to visit, sum of C(length, i) for i <= radius over all substrings, and expected
+    // number of markers in them
+    double probes = 0, hits = 0;
+    for(int s = 0; s < nsub; s++) {
+        if(radius >= length[s]) return false;
+        double c = 1, n = 0;
+        for(int i = 0; i <= radius; i++) {
+            n += c;
+            c = c * (length[s] - i) / (i + 1);
+        }
+        probes += n;
+        hits += n * (4. * rows / (1 << length[s]));
+    }
+    if(probes + hits >= rows) return false;
+
+    ids.clear();
+    for(int s = 0; s < nsub; s++)
+        probe(s, key(code, s), 0, radius, ids);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return true;
+}
+
+
+/**
+  * @brief Minimum distance between a code and the 4 rotations of a marker, and the first rotation
+  * reaching it
+  */
+static int _markerDistance(const uchar *marker, const uchar *code, int nbytes, int &rotation) {
+    int minDistance = INT_MAX;
+    rotation = -1;
+    for(int r = 0; r < 4; r++) {
+        int currentHamming = cv::hal::normHamming(marker + r * nbytes, code, nbytes);
+        if(currentHamming < minDistance) {
+            minDistance = currentHamming;
+            rotation = r;
+        }
+    }
+    return minDistance;
+}
+
+
+/**
+ */
+Ptr<Dictionary::Index> Dictionary::getIndex() const {
+    AutoLock lock(indexMutex);
+    if(!index || !index->isValidFor(bytesList, markerSize))
+        index = makePtr<Index>(bytesList, markerSize);
+    return index;
+}
+
+
+/**
+ */
+void Dictionary::clearIndex() {
+    AutoLock lock(indexMutex);
+    index.release();
+}
+
+
 /**
  */
 bool Dictionary::identify(const Mat &onlyBits, int &idx, int &rotation,
@@ -101,24 +292,32 @@ bool Dictionary::identify(const Mat &onlyBits, int &idx, int &rotation,
 
     // get as a byte list
     Mat candidateBytes = getByteListFromBits(onlyBits);
+    const uchar *code = candidateBytes.ptr();
+    int nbytes = candidateBytes.cols;
 
     idx = -1; // by default, not found
+    if(maxCorrectionRecalculed < 0) return false;
+
+    // the candidates are in increasing order, so the first accepted is the one the linear search
+    // would return
+    vector< int > ids;
+    if(getIndex()->candidates(code, maxCorrectionRecalculed, ids)) {
+        for(size_t i = 0; i < ids.size(); i++) {
+            int currentRotation;
+            if(_markerDistance(bytesList.ptr(ids[i]), code, nbytes, currentRotation) <=
+               maxCorrectionRecalculed) {
+                idx = ids[i];
+                rotation = currentRotation;
+                break;
+            }
+        }
+        return idx != -1;
+    }
 
     // search closest marker in dict
     for(int m = 0; m < bytesList.rows; m++) {
-        int currentMinDistance = markerSize * markerSize + 1;
-        int currentRotation = -1;
-        for(unsigned int r = 0; r < 4; r++) {
-            int currentHamming = cv::hal::normHamming(
-                    bytesList.ptr(m)+r*candidateBytes.cols,
-                    candidateBytes.ptr(),
-                    candidateBytes.cols);
-
-            if(currentHamming < currentMinDistance) {
-                currentMinDistance = currentHamming;
-                currentRotation = r;
-            }
-        }
+        int currentRotation;
+        int currentMinDistance = _markerDistance(bytesList.ptr(m), code, nbytes, currentRotation);
 
         // if maxCorrection is fullfilled, return this one
         if(currentMinDistance <= maxCorrectionRecalculed) {
@@ -39,6 +39,7 @@ the use of this software, even if advised of the possibility of such damage.
 
 #include "test_precomp.hpp"
 #include <opencv2/aruco.hpp>
+#include "opencv2/core/hal/hal.hpp"
 #include <string>
 
 using namespace std;
@@ -507,3 +508,92 @@ TEST(CV_ArucoBitCorrection, algorithmic) {
     CV_ArucoBitCorrection test;
     test.safe_run();
 }
+
+/**
+ * @brief Check identify against a linear search over the dictionary, for codes close to markers
+ * and random ones, at several correction rates
+ */
+TEST(CV_ArucoDictionary, identifyLinearSearch) {
+    RNG rng(0);
+    const int dicts[] = { aruco::DICT_4X4_1000, aruco::DICT_5X5_1000, aruco::DICT_6X6_1000,
+                          aruco::DICT_7X7_1000, aruco::DICT_ARUCO_ORIGINAL };
+    const double rates[] = { 0., 0.6, 1., 3. };
+
+    for(int d = 0; d < 5; d++) {
+        Ptr<aruco::Dictionary> dictionary = aruco::getPredefinedDictionary(dicts[d]);
+        int markerSize = dictionary->markerSize;
+        int nbytes = dictionary->bytesList.cols;
+
+        for(int i = 0; i < 500; i++) {
+            Mat bits;
+            if(i % 4 == 0) {
+                bits.create(markerSize, markerSize, CV_8UC1);
+                rng.fill(bits, RNG::UNIFORM, 0, 2);
+            } else {
+                int id = rng.uniform(0, dictionary->bytesList.rows);
+                bits = aruco::Dictionary::getBitsFromByteList(dictionary->bytesList.rowRange(id, id + 1),
+                                                              markerSize);
+                int flips = rng.uniform(0, 6);
+                for(int f = 0; f < flips; f++) {
+                    uchar &bit = bits.at< uchar >(rng.uniform(0, markerSize), rng.uniform(0, markerSize));
+                    bit = 1 - bit;
+                }
+                for(int k = rng.uniform(0, 4); k > 0; k--) {
+                    transpose(bits, bits);
+                    flip(bits, bits, 1);
+                }
+            }
+            Mat candidateBytes = aruco::Dictionary::getByteListFromBits(bits);
+
+            for(int r = 0; r < 4; r++) {
+                int maxCorrection = int(double(dictionary->maxCorrectionBits) * rates[r]);
+                int expectedId = -1, expectedRotation = -1;
+                for(int m = 0; m < dictionary->bytesList.rows && expectedId < 0; m++) {
+                    int minDistance = markerSize * markerSize + 1, minRotation = -1;
+                    for(int k = 0; k < 4; k++) {
+                        int distance = cv::hal::normHamming(dictionary->bytesList.ptr(m) + k * nbytes,
+                                                            candidateBytes.ptr(), nbytes);
+                        if(distance < minDistance) {
+                            minDistance = distance;
+                            minRotation = k;
+                        }
+                    }
+                    if(minDistance <= maxCorrection) {
+                        expectedId = m;
+                        expectedRotation = minRotation;
+                    }
+                }
+
+                int id = -1, rotation = -1;
+                bool found = dictionary->identify(bits, id, rotation, rates[r]);
+                ASSERT_EQ(expectedId >= 0, found);
+                ASSERT_EQ(expectedId, id);
+                if(found) ASSERT_EQ(expectedRotation, rotation);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Check that identify uses the new codes after bytesList is replaced by another buffer of the
+ * same size, which the allocator may place at the address of the released one
+ */
+TEST(CV_ArucoDictionary, identifyAfterBytesListReassigned) {
+    Ptr<aruco::Dictionary> dict100 = aruco::getPredefinedDictionary(aruco::DICT_4X4_100);
+    aruco::Dictionary dictionary(dict100->bytesList.rowRange(0, 50).clone(), dict100->markerSize,
+                                 dict100->maxCorrectionBits);
+
+    for(int pass = 0; pass < 2; pass++) {
+        int offset = pass * 50;
+        for(int id = 0; id < 50; id++) {
+            Mat bits = aruco::Dictionary::getBitsFromByteList(dict100->bytesList.rowRange(offset + id,
+                                                                                          offset + id + 1),
+                                                              dictionary.markerSize);
+            int foundId = -1, rotation = -1;
+            ASSERT_TRUE(dictionary.identify(bits, foundId, rotation, 0.));
+            ASSERT_EQ(id, foundId);
+            ASSERT_EQ(0, rotation);
+        }
+        dictionary.bytesList = dict100->bytesList.rowRange(50, 100).clone();
+    }
+}
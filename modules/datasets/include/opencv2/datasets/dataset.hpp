@@ -498,6 +498,11 @@ Usage:
 ~~~
 ./opencv/build/bin/example_datasets_track_vot -p=/home/user/path_to_unpacked_files/VOT2015/
 ~~~
+
+For benchmark runs, TRACK_vot::setPrefetch and TRACK_alov::setPrefetch decode the next frames of the
+active sequence ahead of getNextFrame, on a background thread in C++11 builds and otherwise in
+groups across the parallel_for_ pool (see FramePrefetcher), optionally in grayscale or downscaled at
+load time.
 @}
 
 */
@@ -0,0 +1,97 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2014, Itseez Inc, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Itseez Inc or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#ifndef OPENCV_DATASETS_FRAME_PREFETCHER_HPP
+#define OPENCV_DATASETS_FRAME_PREFETCHER_HPP
+
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+namespace cv
+{
+namespace datasets
+{
+
+//! @addtogroup datasets_track
+//! @{
+
+/** @brief Reads a sequence of image files ahead of the consumer.
+
+When built as C++11, a background thread decodes the frames following the current position into a
+bounded queue of at most prefetchCount Mats, while the consumer processes the previous ones;
+getNextFrame hands them out in order and only blocks when the queue is empty. Other builds decode
+the next prefetchCount frames across the parallel_for_ pool whenever getNextFrame finds the queue
+empty. Frames can be converted at load time through the
+imread flags, e.g. IMREAD_GRAYSCALE or IMREAD_REDUCED_COLOR_2 to decode a downscaled image directly.
+*/
+class CV_EXPORTS FramePrefetcher
+{
+public:
+    /** @brief Creates a prefetcher
+    @param prefetchCount Maximum number of frames decoded ahead.
+    @param flags Flags passed to imread.
+    */
+    static Ptr<FramePrefetcher> create(int prefetchCount = 8, int flags = IMREAD_COLOR);
+
+    virtual ~FramePrefetcher() {}
+
+    /** @brief Sets the sequence of files to read and restarts reading at startIndex */
+    virtual void setPaths(const std::vector<std::string> &paths, int startIndex = 0) = 0;
+
+    /** @brief Returns the next frame of the sequence, false at the end of the sequence or if the file can't be read */
+    virtual bool getNextFrame(Mat &frame) = 0;
+
+    /** @brief Index in the sequence of the frame returned by the next getNextFrame call */
+    virtual int getPosition() const = 0;
+
+    virtual int getPrefetchCount() const = 0;
+    virtual int getFlags() const = 0;
+};
+
+//! @}
+
+}
+}
+
+#endif
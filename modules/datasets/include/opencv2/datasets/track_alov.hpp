@@ -47,6 +47,7 @@
 
 #include "opencv2/datasets/dataset.hpp"
 #include "opencv2/datasets/util.hpp"
+#include "opencv2/datasets/frame_prefetcher.hpp"
 
 using namespace std;
 
@@ -93,6 +94,12 @@ public:
     virtual bool getFrame(Mat &frame, int datasetID, int frameID) = 0;
     virtual vector <Point2f> getGT(int datasetID, int frameID) = 0;
 
+    /** @brief Decodes the frames returned by getNextFrame ahead of time, see FramePrefetcher
+    @param prefetchCount Number of frames decoded ahead, 0 to read the frames one by one.
+    @param flags Flags passed to imread, e.g. IMREAD_GRAYSCALE or IMREAD_REDUCED_COLOR_2.
+    */
+    virtual void setPrefetch(int prefetchCount, int flags = IMREAD_COLOR) = 0;
+
 protected:
     vector <vector <Ptr<TRACK_alovObj> > > data;
     int activeDatasetID;
@@ -47,6 +47,7 @@
 
 #include "opencv2/datasets/dataset.hpp"
 #include "opencv2/datasets/util.hpp"
+#include "opencv2/datasets/frame_prefetcher.hpp"
 
 using namespace std;
 
@@ -80,6 +81,12 @@ public:
 
     virtual bool getNextFrame(Mat &frame) = 0;
 
+    /** @brief Decodes the frames returned by getNextFrame ahead of time, see FramePrefetcher
+    @param prefetchCount Number of frames decoded ahead, 0 to read the frames one by one.
+    @param flags Flags passed to imread, e.g. IMREAD_GRAYSCALE or IMREAD_REDUCED_COLOR_2.
+    */
+    virtual void setPrefetch(int prefetchCount, int flags = IMREAD_COLOR) = 0;
+
     virtual vector <Point2d> getGT() = 0;
 
 protected:
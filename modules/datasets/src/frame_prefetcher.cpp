@@ -0,0 +1,240 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2014, Itseez Inc, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Itseez Inc or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "opencv2/datasets/frame_prefetcher.hpp"
+
+#include <opencv2/core/utility.hpp>
+
+#include <deque>
+
+// the producer thread needs the C++11 standard library, other builds decode the frames in groups
+// across the parallel_for_ pool when the queue runs empty
+#if __cplusplus >= 201103L || (defined _MSC_VER && _MSC_VER >= 1800)
+#define HAVE_PREFETCH_THREAD 1
+#include <condition_variable>
+#include <thread>
+#endif
+
+namespace cv
+{
+namespace datasets
+{
+
+using namespace std;
+
+class DecodeFramesInvoker : public ParallelLoopBody
+{
+public:
+    DecodeFramesInvoker(const vector<string> &_paths, int _first, int _flags, vector<Mat> &_frames) :
+        paths(_paths), first(_first), flags(_flags), frames(_frames)
+    {
+    }
+
+    virtual void operator()(const Range &range) const
+    {
+        for (int i = range.start; i < range.end; ++i)
+        {
+            try
+            {
+                frames[i] = imread(paths[first + i], flags);
+            }
+            catch (...)
+            {
+                // reported to the consumer as an unreadable frame
+            }
+        }
+    }
+
+private:
+    const vector<string> &paths;
+    int first;
+    int flags;
+    vector<Mat> &frames;
+};
+
+class FramePrefetcherImpl : public FramePrefetcher
+{
+public:
+    FramePrefetcherImpl(int _prefetchCount, int _flags) :
+        prefetchCount(std::max(_prefetchCount, 1)), flags(_flags), generation(0), position(0), next(0),
+        stopping(false)
+    {
+#ifdef HAVE_PREFETCH_THREAD
+        producer = std::thread(&FramePrefetcherImpl::produce, this);
+#endif
+    }
+
+    virtual ~FramePrefetcherImpl()
+    {
+#ifdef HAVE_PREFETCH_THREAD
+        // a frame being decoded is finished, then the producer leaves
+        mutex.lock();
+        stopping = true;
+        cond.notify_all();
+        mutex.unlock();
+        producer.join();
+#endif
+    }
+
+    virtual void setPaths(const vector<string> &_paths, int startIndex);
+    virtual bool getNextFrame(Mat &frame);
+
+    virtual int getPosition() const
+    {
+        AutoLock lock(mutex);
+        return position;
+    }
+    virtual int getPrefetchCount() const { return prefetchCount; }
+    virtual int getFlags() const { return flags; }
+
+private:
+#ifdef HAVE_PREFETCH_THREAD
+    void produce();
+#else
+    void decodeAhead();
+#endif
+
+    int prefetchCount;
+    int flags;
+
+    // everything below is guarded by the mutex
+    vector<string> paths;
+    int generation;         // incremented by setPaths, frames decoded for an older one are dropped
+    int position;           // index of the next frame to return
+    int next;               // index of the next frame to decode
+    deque<Mat> queue;       // decoded frames paths[position] .. paths[next - 1]
+    bool stopping;
+
+    mutable Mutex mutex;
+#ifdef HAVE_PREFETCH_THREAD
+    std::condition_variable_any cond;
+    std::thread producer;
+#endif
+};
+
+#ifdef HAVE_PREFETCH_THREAD
+void FramePrefetcherImpl::produce()
+{
+    mutex.lock();
+    for (;;)
+    {
+        while (!stopping && (next >= (int)paths.size() || (int)queue.size() >= prefetchCount))
+            cond.wait(mutex);
+        if (stopping)
+            break;
+
+        string path = paths[next];
+        int gen = generation;
+        mutex.unlock();
+
+        Mat frame;
+        try
+        {
+            frame = imread(path, flags);
+        }
+        catch (...)
+        {
+            // reported to the consumer as an unreadable frame
+        }
+
+        mutex.lock();
+        if (gen == generation)
+        {
+            queue.push_back(frame);
+            next++;
+            cond.notify_all();
+        }
+    }
+    mutex.unlock();
+}
+#else
+void FramePrefetcherImpl::decodeAhead()
+{
+    int count = std::min(prefetchCount, (int)paths.size() - next);
+    vector<Mat> frames(count);
+    parallel_for_(Range(0, count), DecodeFramesInvoker(paths, next, flags, frames));
+    queue.insert(queue.end(), frames.begin(), frames.end());
+    next += count;
+}
+#endif
+
+void FramePrefetcherImpl::setPaths(const vector<string> &_paths, int startIndex)
+{
+    AutoLock lock(mutex);
+    paths = _paths;
+    generation++;
+    position = std::max(startIndex, 0);
+    next = position;
+    queue.clear();
+#ifdef HAVE_PREFETCH_THREAD
+    cond.notify_all();
+#endif
+}
+
+bool FramePrefetcherImpl::getNextFrame(Mat &frame)
+{
+    AutoLock lock(mutex);
+    if (position >= (int)paths.size())
+        return false;
+#ifdef HAVE_PREFETCH_THREAD
+    while (queue.empty())
+        cond.wait(mutex);
+#else
+    if (queue.empty())
+        decodeAhead();
+#endif
+
+    frame = queue.front();
+    queue.pop_front();
+    position++;
+#ifdef HAVE_PREFETCH_THREAD
+    cond.notify_all();
+#endif
+    return !frame.empty();
+}
+
+Ptr<FramePrefetcher> FramePrefetcher::create(int prefetchCount, int flags)
+{
+    return Ptr<FramePrefetcherImpl>(new FramePrefetcherImpl(prefetchCount, flags));
+}
+
+}
+}
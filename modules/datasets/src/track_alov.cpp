@@ -60,6 +60,8 @@ public:
     {
         activeDatasetID = 1;
         frameCounter = 0;
+        loadFlags = IMREAD_COLOR;
+        prefetchedDatasetID = -1;
     }
     //Destructor
     virtual ~TRACK_alovImpl() {}
@@ -81,11 +83,17 @@ protected:
     virtual vector <Point2f> getNextGT();
     virtual vector <Point2f> getGT(int datasetID, int frameID);
 
+    virtual void setPrefetch(int prefetchCount, int flags);
+
     void loadDataset(const string &path);
     void loadDatasetAnnotatedOnly(const string &path);
 
     string fullFramePath(string rootPath, int sectionID, int videoID, int frameID);
     string fullAnnoPath(string rootPath, int sectionID, int videoID);
+
+    int loadFlags;                      // imread flags
+    Ptr<FramePrefetcher> prefetcher;    // empty if frames are read one by one
+    int prefetchedDatasetID;            // dataset the prefetcher reads from
 };
 
 
@@ -344,12 +352,35 @@ bool TRACK_alovImpl::initDataset(int id)
     }
 }
 
+void TRACK_alovImpl::setPrefetch(int prefetchCount, int flags)
+{
+    loadFlags = flags;
+    prefetchedDatasetID = -1;
+    if (prefetchCount > 0)
+        prefetcher = FramePrefetcher::create(prefetchCount, flags);
+    else
+        prefetcher.release();
+}
+
 bool  TRACK_alovImpl::getNextFrame(Mat &frame)
 {
     if (frameCounter >= (int)data[activeDatasetID - 1].size())
         return false;
+    if (prefetcher)
+    {
+        if (prefetchedDatasetID != activeDatasetID || prefetcher->getPosition() != frameCounter)
+        {
+            vector <string> paths;
+            for (size_t i = 0; i < data[activeDatasetID - 1].size(); ++i)
+                paths.push_back(data[activeDatasetID - 1][i]->imagePath);
+            prefetcher->setPaths(paths, frameCounter);
+            prefetchedDatasetID = activeDatasetID;
+        }
+        frameCounter++;
+        return prefetcher->getNextFrame(frame);
+    }
     string imgPath = data[activeDatasetID - 1][frameCounter]->imagePath;
-    frame = imread(imgPath);
+    frame = imread(imgPath, loadFlags);
     frameCounter++;
     return !frame.empty();
 }
@@ -359,7 +390,7 @@ bool  TRACK_alovImpl::getFrame(Mat &frame, int datasetID, int frameID)
     if (frameID > (int)data[datasetID-1].size())
         return false;
     string imgPath = data[datasetID-1][frameID-1]->imagePath;
-    frame = imread(imgPath);
+    frame = imread(imgPath, loadFlags);
     return !frame.empty();
 }
 
@@ -60,6 +60,8 @@ namespace cv
             {
                 activeDatasetID = 1;
                 frameCounter = 0;
+                loadFlags = IMREAD_COLOR;
+                prefetchedDatasetID = -1;
             }
             //Destructor
             virtual ~TRACK_votImpl() {}
@@ -78,9 +80,15 @@ namespace cv
 
             virtual vector <Point2d> getGT();
 
+            virtual void setPrefetch(int prefetchCount, int flags);
+
             void loadDataset(const string &path);
 
             string numberToString(int number);
+
+            int loadFlags;                      // imread flags
+            Ptr<FramePrefetcher> prefetcher;    // empty if frames are read one by one
+            int prefetchedDatasetID;            // dataset the prefetcher reads from
         };
 
         void TRACK_votImpl::load(const string &path)
@@ -211,12 +219,35 @@ namespace cv
             }
         }
 
+        void TRACK_votImpl::setPrefetch(int prefetchCount, int flags)
+        {
+            loadFlags = flags;
+            prefetchedDatasetID = -1;
+            if (prefetchCount > 0)
+                prefetcher = FramePrefetcher::create(prefetchCount, flags);
+            else
+                prefetcher.release();
+        }
+
         bool  TRACK_votImpl::getNextFrame(Mat &frame)
         {
             if (frameCounter >= (int)data[activeDatasetID - 1].size())
                 return false;
+            if (prefetcher)
+            {
+                if (prefetchedDatasetID != activeDatasetID || prefetcher->getPosition() != frameCounter)
+                {
+                    vector <string> paths;
+                    for (size_t i = 0; i < data[activeDatasetID - 1].size(); ++i)
+                        paths.push_back(data[activeDatasetID - 1][i]->imagePath);
+                    prefetcher->setPaths(paths, frameCounter);
+                    prefetchedDatasetID = activeDatasetID;
+                }
+                frameCounter++;
+                return prefetcher->getNextFrame(frame);
+            }
             string imgPath = data[activeDatasetID - 1][frameCounter]->imagePath;
-            frame = imread(imgPath);
+            frame = imread(imgPath, loadFlags);
             frameCounter++;
             return !frame.empty();
         }
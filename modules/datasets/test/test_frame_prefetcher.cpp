@@ -0,0 +1,92 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+#include <cstdio>
+
+using namespace std;
+using namespace cv;
+using namespace cv::datasets;
+
+namespace
+{
+
+/* Small frames each filled with its index, written to temporary files */
+class FrameSequence
+{
+public:
+    explicit FrameSequence(int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            paths.push_back(tempfile(".png"));
+            CV_Assert(imwrite(paths.back(), Mat(16, 16, CV_8UC1, Scalar::all(i))));
+        }
+    }
+
+    ~FrameSequence()
+    {
+        for (size_t i = 0; i < paths.size(); i++)
+            remove(paths[i].c_str());
+    }
+
+    vector<string> paths;
+};
+
+}
+
+TEST(Datasets_FramePrefetcher, order)
+{
+    FrameSequence sequence(40);
+    vector<string> paths = sequence.paths;
+    paths[25] = paths[25] + ".missing";
+
+    Ptr<FramePrefetcher> prefetcher = FramePrefetcher::create(4, IMREAD_GRAYSCALE);
+    prefetcher->setPaths(paths, 5);
+
+    Mat frame;
+    bool restarted = false;
+    for (int i = 5; i < 40; i++)
+    {
+        ASSERT_EQ(i, prefetcher->getPosition());
+        bool ok = prefetcher->getNextFrame(frame);
+        if (i == 25)
+        {
+            // unreadable frames are reported and skipped
+            ASSERT_FALSE(ok);
+            continue;
+        }
+        ASSERT_TRUE(ok);
+        ASSERT_EQ(i, (int)frame.at<uchar>(0, 0));
+
+        // restart in the middle of the sequence, with the queue full
+        if (i == 30 && !restarted)
+        {
+            prefetcher->setPaths(paths, 10);
+            restarted = true;
+            i = 9;
+        }
+    }
+    EXPECT_FALSE(prefetcher->getNextFrame(frame));
+    EXPECT_EQ(40, prefetcher->getPosition());
+}
+
+TEST(Datasets_FramePrefetcher, destroy_while_prefetching)
+{
+    FrameSequence sequence(20);
+    for (int iter = 0; iter < 20; iter++)
+    {
+        Ptr<FramePrefetcher> prefetcher = FramePrefetcher::create(16, IMREAD_COLOR);
+        prefetcher->setPaths(sequence.paths);
+        if (iter % 2)
+        {
+            Mat frame;
+            ASSERT_TRUE(prefetcher->getNextFrame(frame));
+            ASSERT_EQ(0, (int)frame.at<Vec3b>(0, 0)[0]);
+        }
+        // the producer is still decoding when the prefetcher goes away
+        prefetcher.release();
+    }
+}
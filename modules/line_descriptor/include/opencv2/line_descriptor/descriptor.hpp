@@ -555,6 +555,8 @@ class CV_EXPORTS BinaryDescriptor : public Algorithm
 
     bool bValidate_;  //flag to decide whether line will be validated
 
+    EdgeChains edges_;  //edge chains of the last image, kept to reuse their memory
+
     int ksize_;  //the size of Gaussian kernel: ksize X ksize, default value is 5.
 
     float sigma_;  //the sigma of Gaussian kernal, default value is 1.0.
@@ -842,6 +844,10 @@ unsigned char binaryConversion( float* f1, float* f2 );
 /* compute LBD descriptors using EDLine extractor */
 int computeLBD( ScaleLines &keyLines, bool useDetectionData = false );
 
+/* parallel bodies: line detection over octaves, LBD computation over groups of lines */
+class EDLineInvoker;
+class ComputeLBDInvoker;
+
 /* gathers lines in groups using EDLine extractor.
  Each group contains the same line, detected in different octaves */
 int OctaveKeyLines( cv::Mat& image, ScaleLines &keyLines );
@@ -984,6 +990,9 @@ or from the one internal to class
 @param trainDescriptors dataset of descriptors furnished by user
 @param matches vector to host retrieved matches
 @param mask mask to select which input descriptors must be matched to one in dataset
+
+@note The index built on trainDescriptors is kept and reused by the following calls, as long as
+they receive the same train descriptors.
  */
 void match( const Mat& queryDescriptors, const Mat& trainDescriptors, std::vector<DMatch>& matches, const Mat& mask = Mat() ) const;
 
@@ -1062,11 +1071,21 @@ void add( const std::vector<Mat>& descriptors );
 
 /** @brief Update dataset by inserting into it all descriptors that were stored locally by *add* function.
 
-@note Every time this function is invoked, current dataset is deleted and locally stored descriptors
-are inserted into dataset. The locally stored copy of just inserted descriptors is then removed.
+@note Locally stored descriptors are appended to the ones already in dataset, whose indexes do not
+change, and only the new descriptors are inserted in the hash tables. The locally stored copy of just
+inserted descriptors is then removed.
  */
 void train();
 
+/** @brief Remove from dataset the descriptors of an image inserted by *add* function.
+
+@param imgIdx index of the image, as reported in DMatch::imgIdx
+
+@note Removed descriptors are no longer returned by matching functions; indexes of the remaining
+descriptors and images do not change.
+ */
+void remove( int imgIdx );
+
 /** @brief Create a BinaryDescriptorMatcher object and return a smart pointer to it.
  */
 static Ptr<BinaryDescriptorMatcher> createBinaryDescriptorMatcher();
@@ -1087,33 +1106,6 @@ BinaryDescriptorMatcher();
 }
 
 private:
-class BucketGroup
-{
-
-public:
-/** constructor */
-BucketGroup(bool needAllocateGroup = true);
-
-/** destructor */
-~BucketGroup();
-
-/** insert data into the bucket */
-void insert( int subindex, UINT32 data );
-
-/** perform a query to the bucket */
-UINT32* query( int subindex, int *size );
-
-/** utility functions */
-void insert_value( std::vector<uint32_t>& vec, int index, UINT32 data );
-void push_value( std::vector<uint32_t>& vec, UINT32 Data );
-
-/** data fields */
-UINT32 empty;
-std::vector<uint32_t> group;
-
-
-};
-
 class SparseHashtable
 {
 
@@ -1122,8 +1114,11 @@ private:
 /** Maximum bits per key before folding the table */
 static const int MAX_B;
 
-/** Bins (each bin is an Array object for duplicates of the same key) */
-std::vector<BucketGroup> table;
+/** Start of every bucket in entries (bucket i spans [offsets[i], offsets[i+1])) */
+std::vector<UINT32> offsets;
+
+/** Indexes of the codes, sorted by bucket and, in every bucket, by insertion order */
+std::vector<UINT32> entries;
 
 public:
 
@@ -1136,11 +1131,15 @@ SparseHashtable();
 /** initializer */
 int init( int _b );
 
-/** insert data */
-void insert( UINT64 index, UINT32 data );
+/** build the table in bulk: keys[i * stride] is the key of the i-th code */
+void build( const UINT64* keys, UINT32 N, int stride );
+
+/** insert N codes, whose indexes start from first and are greater than the ones in the table:
+keys[i * stride] is the key of the code first + i */
+void insert( const UINT64* keys, UINT32 first, UINT32 N, int stride );
 
 /** query data */
-UINT32* query( UINT64 index, int* size );
+const UINT32* query( UINT64 index, int* size ) const;
 
 /** Bits per index */
 int b;
@@ -1200,7 +1199,7 @@ inline void set( UINT64 index )
 arr[index >> 5] |= ( (UINT32) 0x01 ) << ( index % 32 );
 }
 
-inline UINT8 get( UINT64 index )
+inline UINT8 get( UINT64 index ) const
 {
 return ( arr[index >> 5] & ( ( (UINT32) 0x01 ) << ( index % 32 ) ) ) != 0;
 }
@@ -1211,6 +1210,10 @@ inline void erase()
 memset( arr, 0, sizeof(UINT32) * length );
 }
 
+private:
+bitarray( const bitarray& );
+bitarray& operator=( const bitarray& );
+
 };
 
 class Mihasher
@@ -1238,17 +1241,14 @@ int D;
 /** Maximum hamming search radius per substring */
 int d;
 
-/** Maximum results to return */
-int K;
-
 /** Number of codes */
 UINT64 N;
 
 /** Table of original full-length codes */
 cv::Mat codes;
 
-/** Counter for eliminating duplicate results (it is not thread safe) */
-Ptr<bitarray> counter;
+/** Flags of the codes removed from dataset, that queries must skip */
+std::vector<uchar> removed;
 
 /** Array of m hashtables */
 std::vector<SparseHashtable> H;
@@ -1256,8 +1256,26 @@ std::vector<SparseHashtable> H;
 /** Volume of a b-bit Hamming ball with radius s (for s = 0 to d) */
 std::vector<UINT32> xornum;
 
+/** Scratch memory of the queries run by a thread */
+struct QueryBuffers
+{
+/** Counter for eliminating duplicate results */
+bitarray counter;
+
+/** Substrings of the query */
+std::vector<UINT64> chunks;
+
+/** Results found at every Hamming distance */
+std::vector<UINT32> res;
+
 /** Used within generation of binary codes at a certain Hamming distance */
 int power[100];
+};
+
+class BatchQueryInvoker;
+
+/** Scratch memory of every thread running queries */
+mutable TLSData<QueryBuffers> queryBuffers;
 
 /** constructor */
 Mihasher();
@@ -1268,30 +1286,42 @@ Mihasher();
 /** constructor 2 */
 Mihasher( int B, int m );
 
-/** K setter */
-void setK( int K );
+/** populate tables, replacing current content */
+void populate( const cv::Mat & codes );
 
-/** populate tables */
-void populate( cv::Mat & codes, UINT32 N, int dim1codes );
+/** append codes to the ones already stored and insert them in tables */
+void append( const cv::Mat & codes );
 
-/** execute a batch query */
-void batchquery( UINT32 * results, UINT32 *numres/*, qstat *stats*/, const cv::Mat & q, UINT32 numq, int dim1queries );
+/** mark count codes starting from first as removed */
+void remove( UINT32 first, UINT32 count );
+
+/** execute a batch query (one query per row of q), returning up to K results per query */
+void batchquery( UINT32 * results, UINT32 *numres/*, qstat *stats*/, const cv::Mat & q, int K ) const;
 
 private:
 
+/** build all the hashtables in bulk from current codes */
+void buildTables();
+
 /** execute a single query */
-void query( UINT32 * results, UINT32* numres/*, qstat *stats*/, UINT8 *q, UINT64 * chunks, UINT32 * res );
+void query( UINT32 * results, UINT32* numres/*, qstat *stats*/, const UINT8 *q, int K, QueryBuffers& buffers ) const;
 };
 
+/** get an index of the descriptors, reusing the one built by the previous call if they did not change */
+Ptr<Mihasher> getTrainIndex( const Mat& trainDescriptors ) const;
+
 /** retrieve Hamming distances */
 void checkKDistances( UINT32 * numres, int k, std::vector<int>& k_distances, int row, int string_length ) const;
 
 /** matrix to store new descriptors */
 Mat descriptorsMat;
 
-/** map storing where each bunch of descriptors benins in DS */
+/** map storing where each bunch of descriptors benins in DS (images without descriptors excluded) */
 std::map<int, int> indexesMap;
 
+/** index of the first descriptor and number of descriptors of every image */
+std::vector<std::pair<int, int> > imagesRanges;
+
 /** internal MiHaser representing dataset */
 Ptr<Mihasher> dataset;
 
@@ -1304,6 +1334,12 @@ int numImages;
 /** number of descriptors in dataset */
 int descrInDS;
 
+/** index of the descriptors of the last pair-wise matching call */
+mutable Ptr<Mihasher> trainIndex;
+
+/** guard of trainIndex */
+mutable Mutex trainIndexMutex;
+
 };
 
 /* --------------------------------------------------------------------------------------------
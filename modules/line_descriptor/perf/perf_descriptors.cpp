@@ -75,3 +75,31 @@ PERF_TEST_P(file_str, descriptors, testing::Values(IMAGES))
   SANITY_CHECK_NOTHING();
 
 }
+
+typedef perf::TestBaseWithParam<Size> frame_size;
+
+/* detection and description of the lines of an HD frame, as in a tracking pipeline */
+PERF_TEST_P(frame_size, detect_and_compute, testing::Values(sz720p, sz1080p))
+{
+  std::string filename = getDataPath( "stitching/a3.png" );
+  Mat image = imread( filename, IMREAD_GRAYSCALE );
+
+  if( image.empty() )
+    FAIL()<< "Unable to load source image " << filename;
+
+  Mat frame;
+  resize( image, frame, GetParam() );
+
+  Mat descriptors;
+  std::vector<KeyLine> keylines;
+  Ptr<BinaryDescriptor> bd = BinaryDescriptor::createBinaryDescriptor();
+  declare.in( frame );
+
+  TEST_CYCLE()
+  {
+    keylines.clear();
+    ( *bd )( frame, Mat(), keylines, descriptors );
+  }
+
+  SANITY_CHECK_NOTHING();
+}
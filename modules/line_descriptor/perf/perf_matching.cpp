@@ -142,6 +142,32 @@ PERF_TEST(matching, single_match)
 
 }
 
+PERF_TEST(matching, dataset_match)
+{
+  std::vector<Mat> images( 20 );
+  for ( size_t i = 0; i < images.size(); i++ )
+  {
+    images[i].create( 1000, DIM, CV_8UC1 );
+    theRNG().fill( images[i], RNG::UNIFORM, Scalar( 0 ), Scalar( 256 ) );
+  }
+
+  Mat query = images[0].clone();
+  std::vector<DMatch> dm;
+  Ptr<BinaryDescriptorMatcher> bd = BinaryDescriptorMatcher::createBinaryDescriptorMatcher();
+
+  /* the dataset is trained once, queries are repeated on the same index */
+  bd->add( images );
+  bd->train();
+
+  TEST_CYCLE()
+  {
+    dm.clear();
+    bd->match( query, dm );
+  }
+
+  SANITY_CHECK_NOTHING();
+}
+
 PERF_TEST(knn_matching, knn_match_distances_test)
 {
   Mat query, train, distances;
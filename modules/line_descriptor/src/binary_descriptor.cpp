@@ -40,6 +40,7 @@
  //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #ifdef _MSC_VER
     #if (_MSC_VER <= 1700)
@@ -274,13 +275,6 @@ void BinaryDescriptor::operator()( InputArray image, InputArray mask, CV_OUT std
   if( !useProvidedKeyLines )
   {
     keylines.clear();
-    BinaryDescriptor *bn = const_cast<BinaryDescriptor*>( this );
-    bn->edLineVec_.clear();
-    bn->edLineVec_.resize( params.numOfOctave_ );
-
-    for ( int i = 0; i < params.numOfOctave_; i++ )
-    bn->edLineVec_[i] = Ptr<EDLineDetector>( new EDLineDetector() );
-
     detectImpl( imageMat, keylines, maskMat );
 
   }
@@ -691,6 +685,28 @@ void BinaryDescriptor::computeImpl( const Mat& imageSrc, std::vector<KeyLine>& k
 
 }
 
+/* extracts lines from a range of octaves: each octave has its own
+ EDLineDetector, that keeps the results and the gradient images */
+class BinaryDescriptor::EDLineInvoker : public ParallelLoopBody
+{
+public:
+  EDLineInvoker( std::vector<Ptr<EDLineDetector> >& _edLineVec, std::vector<Mat>& _octaveImages, std::vector<int>& _detected ) :
+      edLineVec( _edLineVec ), octaveImages( _octaveImages ), detected( _detected )
+  {
+  }
+
+  void operator()( const Range& range ) const
+  {
+    for ( int octaveCount = range.start; octaveCount < range.end; octaveCount++ )
+      detected[octaveCount] = edLineVec[octaveCount]->EDline( octaveImages[octaveCount] );
+  }
+
+private:
+  std::vector<Ptr<EDLineDetector> >& edLineVec;
+  std::vector<Mat>& octaveImages;
+  std::vector<int>& detected;
+};
+
 int BinaryDescriptor::OctaveKeyLines( cv::Mat& image, ScaleLines &keyLines )
 {
 
@@ -702,28 +718,29 @@ int BinaryDescriptor::OctaveKeyLines( cv::Mat& image, ScaleLines &keyLines )
   float curSigma2 = 1.0;  //[sqrt(2)]^0=1;
   double factor = sqrt( 2.0 );  //the down sample factor between connective two octave images
 
-  /* loop over number of octaves */
+  /* reuse the line detectors of previous calls, with their buffers, creating only the missing ones */
+  edLineVec_.resize( params.numOfOctave_ );
+  images_sizes.resize( params.numOfOctave_ );
   for ( int octaveCount = 0; octaveCount < params.numOfOctave_; octaveCount++ )
   {
-    /* matrix storing results from blurring processes */
-    cv::Mat blur;
+    if( !edLineVec_[octaveCount] )
+      edLineVec_[octaveCount] = Ptr<EDLineDetector>( new EDLineDetector() );
+  }
+
+  /* matrices storing results from blurring processes */
+  std::vector<cv::Mat> blur( params.numOfOctave_ );
 
+  /* loop over number of octaves: every level of pyramid is computed from previous one */
+  for ( int octaveCount = 0; octaveCount < params.numOfOctave_; octaveCount++ )
+  {
     /* apply Gaussian blur */
     float increaseSigma = sqrt( curSigma2 - preSigma2 );
-    cv::GaussianBlur( image, blur, cv::Size( params.ksize_, params.ksize_ ), increaseSigma );
-    images_sizes[octaveCount] = blur.size();
-
-    /* for current octave, extract lines */
-    if( ( edLineVec_[octaveCount]->EDline( blur ) ) != 1 )
-    {
-      return -1;
-    }
-
-    /* update number of total extracted lines */
-    numOfFinalLine += edLineVec_[octaveCount]->lines_.numOfLines;
+    cv::GaussianBlur( image, blur[octaveCount], cv::Size( params.ksize_, params.ksize_ ), increaseSigma );
+    images_sizes[octaveCount] = blur[octaveCount].size();
 
     /* resize image for next level of pyramid */
-    cv::resize( blur, image, cv::Size(), ( 1.f / factor ), ( 1.f / factor ) );
+    if( octaveCount + 1 < params.numOfOctave_ )
+      cv::resize( blur[octaveCount], image, cv::Size(), ( 1.f / factor ), ( 1.f / factor ) );
 
     /* update sigma values */
     preSigma2 = curSigma2;
@@ -731,6 +748,21 @@ int BinaryDescriptor::OctaveKeyLines( cv::Mat& image, ScaleLines &keyLines )
 
   } /* end of loop over number of octaves */
 
+  /* extract lines from all octaves concurrently, each one with its own detector */
+  std::vector<int> detected( params.numOfOctave_, -1 );
+  parallel_for_( Range( 0, params.numOfOctave_ ), EDLineInvoker( edLineVec_, blur, detected ) );
+
+  for ( int octaveCount = 0; octaveCount < params.numOfOctave_; octaveCount++ )
+  {
+    if( detected[octaveCount] != 1 )
+    {
+      return -1;
+    }
+
+    /* update number of total extracted lines */
+    numOfFinalLine += edLineVec_[octaveCount]->lines_.numOfLines;
+  }
+
   /* prepare a vector to store octave information associated to extracted lines */
   std::vector < OctaveLine > octaveLines( numOfFinalLine );
 
@@ -1028,349 +1060,313 @@ int BinaryDescriptor::OctaveKeyLines( cv::Mat& image, ScaleLines &keyLines )
   return 1;
 }
 
-int BinaryDescriptor::computeLBD( ScaleLines &keyLines, bool useDetectionData )
+/* adds the statistics of a row of the line support region, i.e. the sums of positive and negative
+ gradient projections along dL and dO {pgdL, ngdL, pgdO, ngdO} and their squares, to the ones of a band */
+static inline void accumulateBandSums( float* bandSum, float* band2Sum, float coef, const float* rowSum, const float* row2Sum )
 {
-  //the default length of the band is the line length.
-  short numOfFinalLine = (short) keyLines.size();
-  float *dL = new float[2];  //line direction cos(dir), sin(dir)
-  float *dO = new float[2];  //the clockwise orthogonal vector of line direction.
-  short heightOfLSP = (short) ( params.widthOfBand_ * NUM_OF_BANDS );  //the height of line support region;
-  short descriptor_size = NUM_OF_BANDS * 8;  //each band, we compute the m( pgdL, ngdL,  pgdO, ngdO) and std( pgdL, ngdL,  pgdO, ngdO);
-  float pgdLRowSum;  //the summation of {g_dL |g_dL>0 } for each row of the region;
-  float ngdLRowSum;  //the summation of {g_dL |g_dL<0 } for each row of the region;
-  float pgdL2RowSum;  //the summation of {g_dL^2 |g_dL>0 } for each row of the region;
-  float ngdL2RowSum;  //the summation of {g_dL^2 |g_dL<0 } for each row of the region;
-  float pgdORowSum;  //the summation of {g_dO |g_dO>0 } for each row of the region;
-  float ngdORowSum;  //the summation of {g_dO |g_dO<0 } for each row of the region;
-  float pgdO2RowSum;  //the summation of {g_dO^2 |g_dO>0 } for each row of the region;
-  float ngdO2RowSum;  //the summation of {g_dO^2 |g_dO<0 } for each row of the region;
-
-  float *pgdLBandSum = new float[NUM_OF_BANDS];  //the summation of {g_dL |g_dL>0 } for each band of the region;
-  float *ngdLBandSum = new float[NUM_OF_BANDS];  //the summation of {g_dL |g_dL<0 } for each band of the region;
-  float *pgdL2BandSum = new float[NUM_OF_BANDS];  //the summation of {g_dL^2 |g_dL>0 } for each band of the region;
-  float *ngdL2BandSum = new float[NUM_OF_BANDS];  //the summation of {g_dL^2 |g_dL<0 } for each band of the region;
-  float *pgdOBandSum = new float[NUM_OF_BANDS];  //the summation of {g_dO |g_dO>0 } for each band of the region;
-  float *ngdOBandSum = new float[NUM_OF_BANDS];  //the summation of {g_dO |g_dO<0 } for each band of the region;
-  float *pgdO2BandSum = new float[NUM_OF_BANDS];  //the summation of {g_dO^2 |g_dO>0 } for each band of the region;
-  float *ngdO2BandSum = new float[NUM_OF_BANDS];  //the summation of {g_dO^2 |g_dO<0 } for each band of the region;
-
-  short numOfBitsBand = NUM_OF_BANDS * sizeof(float);
-  short lengthOfLSP;  //the length of line support region, varies with lines
-  short halfHeight = ( heightOfLSP - 1 ) / 2;
-  short halfWidth;
-  short bandID;
-  float coefInGaussion;
-  float lineMiddlePointX, lineMiddlePointY;
-  float sCorX, sCorY, sCorX0, sCorY0;
-  short tempCor, xCor, yCor;  //pixel coordinates in image plane
-  short dx, dy;
-  float gDL;  //store the gradient projection of pixels in support region along dL vector
-  float gDO;  //store the gradient projection of pixels in support region along dO vector
-  short imageWidth, imageHeight, realWidth;
-  short *pdxImg, *pdyImg;
-  float *desVec;
-
-  short sameLineSize;
-  short octaveCount;
-  OctaveSingleLine *pSingleLine;
-  /* loop over list of LineVec */
-  for ( short lineIDInScaleVec = 0; lineIDInScaleVec < numOfFinalLine; lineIDInScaleVec++ )
+#if CV_SIMD128
+  v_store( bandSum, v_load( bandSum ) + v_setall_f32( coef ) * v_load( rowSum ) );
+  v_store( band2Sum, v_load( band2Sum ) + v_setall_f32( coef * coef ) * v_load( row2Sum ) );
+#else
+  for ( int i = 0; i < 4; i++ )
   {
-    sameLineSize = (short) ( keyLines[lineIDInScaleVec].size() );
-    /* loop over current LineVec's lines */
-    for ( short lineIDInSameLine = 0; lineIDInSameLine < sameLineSize; lineIDInSameLine++ )
-    {
-      /* get a line in current LineVec and its original ID in its octave */
-      pSingleLine = & ( keyLines[lineIDInScaleVec][lineIDInSameLine] );
-      octaveCount = (short) pSingleLine->octaveCount;
+    bandSum[i] += coef * rowSum[i];
+    band2Sum[i] += coef * coef * row2Sum[i];
+  }
+#endif
+}
 
-      if( useDetectionData )
-      {
-        /* retrieve associated dxImg and dyImg */
-        pdxImg = edLineVec_[octaveCount]->dxImg_.ptr<short>();
-        pdyImg = edLineVec_[octaveCount]->dyImg_.ptr<short>();
-
-        /* get image size to work on from real one */
-        realWidth = (short) edLineVec_[octaveCount]->imageWidth;
-        imageWidth = realWidth - 1;
-        imageHeight = (short) ( edLineVec_[octaveCount]->imageHeight - 1 );
-      }
+/* computes means and standard deviations of {pgdL, ngdL, pgdO, ngdO} in a band */
+static inline void bandDescriptor( float* desVec, const float* bandSum, const float* band2Sum, float invN )
+{
+#if CV_SIMD128
+  v_float32x4 vInvN = v_setall_f32( invN );
+  v_float32x4 mean = v_load( bandSum ) * vInvN;
+  v_store( desVec, mean );
+  v_store( desVec + 4, v_sqrt( v_load( band2Sum ) * vInvN - mean * mean ) );
+#else
+  for ( int i = 0; i < 4; i++ )
+  {
+    float temp = bandSum[i] * invN;
+    desVec[i] = temp;
+    desVec[i + 4] = sqrt( band2Sum[i] * invN - temp * temp );
+  }
+#endif
+}
 
-      else
-      {
-        /* retrieve associated dxImg and dyImg */
-        pdxImg = dxImg_vector[octaveCount].ptr<short>();
-        pdyImg = dyImg_vector[octaveCount].ptr<short>();
-
-        /* get image size to work on from real one */
-        realWidth = (short) images_sizes[octaveCount].width;
-        imageWidth = realWidth - 1;
-        imageHeight = (short) ( images_sizes[octaveCount].height - 1 );
-      }
+/* computes the LBD descriptors of a range of groups of lines. Every line only reads
+ the gradient images of its octave and writes its own descriptor */
+class BinaryDescriptor::ComputeLBDInvoker : public ParallelLoopBody
+{
+public:
+  ComputeLBDInvoker( ScaleLines& _keyLines, const std::vector<Mat>& _dxImg, const std::vector<Mat>& _dyImg, int _widthOfBand,
+                     const std::vector<double>& _gaussCoefG, const std::vector<double>& _gaussCoefL ) :
+      keyLines( _keyLines ), dxImg( _dxImg ), dyImg( _dyImg ), widthOfBand( _widthOfBand ), gaussCoefG( _gaussCoefG ), gaussCoefL( _gaussCoefL )
+  {
+  }
 
-      /* initialize memory areas */
-      memset( pgdLBandSum, 0, numOfBitsBand );
-      memset( ngdLBandSum, 0, numOfBitsBand );
-      memset( pgdL2BandSum, 0, numOfBitsBand );
-      memset( ngdL2BandSum, 0, numOfBitsBand );
-      memset( pgdOBandSum, 0, numOfBitsBand );
-      memset( ngdOBandSum, 0, numOfBitsBand );
-      memset( pgdO2BandSum, 0, numOfBitsBand );
-      memset( ngdO2BandSum, 0, numOfBitsBand );
-
-      /* get length of line and its half */
-      lengthOfLSP = (short) keyLines[lineIDInScaleVec][lineIDInSameLine].numOfPixels;
-      halfWidth = ( lengthOfLSP - 1 ) / 2;
-
-      /* get middlepoint of line */
-      lineMiddlePointX = (float) ( 0.5 * ( pSingleLine->sPointInOctaveX + pSingleLine->ePointInOctaveX ) );
-      lineMiddlePointY = (float) ( 0.5 * ( pSingleLine->sPointInOctaveY + pSingleLine->ePointInOctaveY ) );
-
-      /*1.rotate the local coordinate system to the line direction (direction is the angle
-       between positive line direction and positive X axis)
-       *2.compute the gradient projection of pixels in line support region*/
-
-      /* get the vector representing original image reference system after rotation to aligh with
-       line's direction */
-      dL[0] = cos( pSingleLine->direction );
-      dL[1] = sin( pSingleLine->direction );
-
-      /* set the clockwise orthogonal vector of line direction */
-      dO[0] = -dL[1];
-      dO[1] = dL[0];
-
-      /* get rotated reference frame */
-      sCorX0 = -dL[0] * halfWidth + dL[1] * halfHeight + lineMiddlePointX;  //hID =0; wID = 0;
-      sCorY0 = -dL[1] * halfWidth - dL[0] * halfHeight + lineMiddlePointY;
-
-      /* BIAS::Matrix<float> gDLMat(heightOfLSP,lengthOfLSP) */
-      for ( short hID = 0; hID < heightOfLSP; hID++ )
+  void operator()( const Range& range ) const
+  {
+    //the default length of the band is the line length.
+    float dL[2];  //line direction cos(dir), sin(dir)
+    float dO[2];  //the clockwise orthogonal vector of line direction.
+    short heightOfLSP = (short) ( widthOfBand * NUM_OF_BANDS );  //the height of line support region;
+    short descriptor_size = NUM_OF_BANDS * 8;  //each band, we compute the m( pgdL, ngdL,  pgdO, ngdO) and std( pgdL, ngdL,  pgdO, ngdO);
+    float pgdLRowSum;  //the summation of {g_dL |g_dL>0 } for each row of the region;
+    float ngdLRowSum;  //the summation of {g_dL |g_dL<0 } for each row of the region;
+    float pgdORowSum;  //the summation of {g_dO |g_dO>0 } for each row of the region;
+    float ngdORowSum;  //the summation of {g_dO |g_dO<0 } for each row of the region;
+
+    /* the summations of {pgdL, ngdL, pgdO, ngdO} of a row and of each band of the region, and of their squares */
+    float rowSum[4], row2Sum[4];
+    float bandSum[NUM_OF_BANDS * 4], band2Sum[NUM_OF_BANDS * 4];
+
+    short lengthOfLSP;  //the length of line support region, varies with lines
+    short halfHeight = ( heightOfLSP - 1 ) / 2;
+    short halfWidth;
+    short bandID;
+    float coefInGaussion;
+    float lineMiddlePointX, lineMiddlePointY;
+    float sCorX, sCorY, sCorX0, sCorY0;
+    short tempCor, xCor, yCor;  //pixel coordinates in image plane
+    short dx, dy;
+    float gDL;  //store the gradient projection of pixels in support region along dL vector
+    float gDO;  //store the gradient projection of pixels in support region along dO vector
+    short imageWidth, imageHeight;
+    float *desVec;
+
+    /* loop over list of LineVec */
+    for ( int lineIDInScaleVec = range.start; lineIDInScaleVec < range.end; lineIDInScaleVec++ )
+    {
+      short sameLineSize = (short) ( keyLines[lineIDInScaleVec].size() );
+      /* loop over current LineVec's lines */
+      for ( short lineIDInSameLine = 0; lineIDInSameLine < sameLineSize; lineIDInSameLine++ )
       {
-        /*initialization */
-        sCorX = sCorX0;
-        sCorY = sCorY0;
+        /* get a line in current LineVec and its original ID in its octave */
+        OctaveSingleLine* pSingleLine = & ( keyLines[lineIDInScaleVec][lineIDInSameLine] );
+        int octaveCount = (int) pSingleLine->octaveCount;
+
+        /* retrieve associated dxImg and dyImg, and the size to work on */
+        const Mat& dxOctave = dxImg[octaveCount];
+        const Mat& dyOctave = dyImg[octaveCount];
+        imageWidth = (short) ( dxOctave.cols - 1 );
+        imageHeight = (short) ( dxOctave.rows - 1 );
+
+        /* initialize memory areas */
+        memset( bandSum, 0, sizeof( bandSum ) );
+        memset( band2Sum, 0, sizeof( band2Sum ) );
+
+        /* get length of line and its half */
+        lengthOfLSP = (short) pSingleLine->numOfPixels;
+        halfWidth = ( lengthOfLSP - 1 ) / 2;
+
+        /* get middlepoint of line */
+        lineMiddlePointX = (float) ( 0.5 * ( pSingleLine->sPointInOctaveX + pSingleLine->ePointInOctaveX ) );
+        lineMiddlePointY = (float) ( 0.5 * ( pSingleLine->sPointInOctaveY + pSingleLine->ePointInOctaveY ) );
+
+        /*1.rotate the local coordinate system to the line direction (direction is the angle
+         between positive line direction and positive X axis)
+         *2.compute the gradient projection of pixels in line support region*/
+
+        /* get the vector representing original image reference system after rotation to aligh with
+         line's direction */
+        dL[0] = cos( pSingleLine->direction );
+        dL[1] = sin( pSingleLine->direction );
+
+        /* set the clockwise orthogonal vector of line direction */
+        dO[0] = -dL[1];
+        dO[1] = dL[0];
+
+        /* get rotated reference frame */
+        sCorX0 = -dL[0] * halfWidth + dL[1] * halfHeight + lineMiddlePointX;  //hID =0; wID = 0;
+        sCorY0 = -dL[1] * halfWidth - dL[0] * halfHeight + lineMiddlePointY;
+
+        for ( short hID = 0; hID < heightOfLSP; hID++ )
+        {
+          /*initialization */
+          sCorX = sCorX0;
+          sCorY = sCorY0;
 
-        pgdLRowSum = 0;
-        ngdLRowSum = 0;
-        pgdORowSum = 0;
-        ngdORowSum = 0;
+          pgdLRowSum = 0;
+          ngdLRowSum = 0;
+          pgdORowSum = 0;
+          ngdORowSum = 0;
 
-        for ( short wID = 0; wID < lengthOfLSP; wID++ )
-        {
-          tempCor = (short) round( sCorX );
-          xCor = ( tempCor < 0 ) ? 0 : ( tempCor > imageWidth ) ? imageWidth : tempCor;
-          tempCor = (short) round( sCorY );
-          yCor = ( tempCor < 0 ) ? 0 : ( tempCor > imageHeight ) ? imageHeight : tempCor;
-
-          /* To achieve rotation invariance, each simple gradient is rotated aligned with
-           * the line direction and clockwise orthogonal direction.*/
-          dx = pdxImg[yCor * realWidth + xCor];
-          dy = pdyImg[yCor * realWidth + xCor];
-          gDL = dx * dL[0] + dy * dL[1];
-          gDO = dx * dO[0] + dy * dO[1];
-          if( gDL > 0 )
-          {
-            pgdLRowSum += gDL;
-          }
-          else
+          for ( short wID = 0; wID < lengthOfLSP; wID++ )
           {
-            ngdLRowSum -= gDL;
+            tempCor = (short) round( sCorX );
+            xCor = ( tempCor < 0 ) ? 0 : ( tempCor > imageWidth ) ? imageWidth : tempCor;
+            tempCor = (short) round( sCorY );
+            yCor = ( tempCor < 0 ) ? 0 : ( tempCor > imageHeight ) ? imageHeight : tempCor;
+
+            /* To achieve rotation invariance, each simple gradient is rotated aligned with
+             * the line direction and clockwise orthogonal direction.*/
+            dx = dxOctave.ptr<short>( yCor )[xCor];
+            dy = dyOctave.ptr<short>( yCor )[xCor];
+            gDL = dx * dL[0] + dy * dL[1];
+            gDO = dx * dO[0] + dy * dO[1];
+            if( gDL > 0 )
+            {
+              pgdLRowSum += gDL;
+            }
+            else
+            {
+              ngdLRowSum -= gDL;
+            }
+            if( gDO > 0 )
+            {
+              pgdORowSum += gDO;
+            }
+            else
+            {
+              ngdORowSum -= gDO;
+            }
+            sCorX += dL[0];
+            sCorY += dL[1];
           }
-          if( gDO > 0 )
-          {
-            pgdORowSum += gDO;
+          sCorX0 -= dL[1];
+          sCorY0 += dL[0];
+          coefInGaussion = (float) gaussCoefG[hID];
+          rowSum[0] = coefInGaussion * pgdLRowSum;
+          rowSum[1] = coefInGaussion * ngdLRowSum;
+          rowSum[2] = coefInGaussion * pgdORowSum;
+          rowSum[3] = coefInGaussion * ngdORowSum;
+          for ( int i = 0; i < 4; i++ )
+            row2Sum[i] = rowSum[i] * rowSum[i];
+
+          /* compute {g_dL |g_dL>0 }, {g_dL |g_dL<0 },
+           {g_dO |g_dO>0 }, {g_dO |g_dO<0 } of each band in the line support region
+           first, current row belong to current band */
+          bandID = (short) ( hID / widthOfBand );
+          coefInGaussion = (float) ( gaussCoefL[hID % widthOfBand + widthOfBand] );
+          accumulateBandSums( bandSum + bandID * 4, band2Sum + bandID * 4, coefInGaussion, rowSum, row2Sum );
+
+          /* In order to reduce boundary effect along the line gradient direction,
+           * a row's gradient will contribute not only to its current band, but also
+           * to its nearest upper and down band with gaussCoefL_.*/
+          bandID--;
+          if( bandID >= 0 )
+          {/* the band above the current band */
+            coefInGaussion = (float) ( gaussCoefL[hID % widthOfBand + 2 * widthOfBand] );
+            accumulateBandSums( bandSum + bandID * 4, band2Sum + bandID * 4, coefInGaussion, rowSum, row2Sum );
           }
-          else
-          {
-            ngdORowSum -= gDO;
+          bandID = bandID + 2;
+          if( bandID < NUM_OF_BANDS )
+          {/*the band below the current band */
+            coefInGaussion = (float) ( gaussCoefL[hID % widthOfBand] );
+            accumulateBandSums( bandSum + bandID * 4, band2Sum + bandID * 4, coefInGaussion, rowSum, row2Sum );
           }
-          sCorX += dL[0];
-          sCorY += dL[1];
-          /* gDLMat[hID][wID] = gDL; */
-        }
-        sCorX0 -= dL[1];
-        sCorY0 += dL[0];
-        coefInGaussion = (float) gaussCoefG_[hID];
-        pgdLRowSum = coefInGaussion * pgdLRowSum;
-        ngdLRowSum = coefInGaussion * ngdLRowSum;
-        pgdL2RowSum = pgdLRowSum * pgdLRowSum;
-        ngdL2RowSum = ngdLRowSum * ngdLRowSum;
-        pgdORowSum = coefInGaussion * pgdORowSum;
-        ngdORowSum = coefInGaussion * ngdORowSum;
-        pgdO2RowSum = pgdORowSum * pgdORowSum;
-        ngdO2RowSum = ngdORowSum * ngdORowSum;
-
-        /* compute {g_dL |g_dL>0 }, {g_dL |g_dL<0 },
-         {g_dO |g_dO>0 }, {g_dO |g_dO<0 } of each band in the line support region
-         first, current row belong to current band */
-        bandID = (short) ( hID / params.widthOfBand_ );
-        coefInGaussion = (float) ( gaussCoefL_[hID % params.widthOfBand_ + params.widthOfBand_] );
-        pgdLBandSum[bandID] += coefInGaussion * pgdLRowSum;
-        ngdLBandSum[bandID] += coefInGaussion * ngdLRowSum;
-        pgdL2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdL2RowSum;
-        ngdL2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdL2RowSum;
-        pgdOBandSum[bandID] += coefInGaussion * pgdORowSum;
-        ngdOBandSum[bandID] += coefInGaussion * ngdORowSum;
-        pgdO2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdO2RowSum;
-        ngdO2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdO2RowSum;
-
-        /* In order to reduce boundary effect along the line gradient direction,
-         * a row's gradient will contribute not only to its current band, but also
-         * to its nearest upper and down band with gaussCoefL_.*/
-        bandID--;
-        if( bandID >= 0 )
-        {/* the band above the current band */
-          coefInGaussion = (float) ( gaussCoefL_[hID % params.widthOfBand_ + 2 * params.widthOfBand_] );
-          pgdLBandSum[bandID] += coefInGaussion * pgdLRowSum;
-          ngdLBandSum[bandID] += coefInGaussion * ngdLRowSum;
-          pgdL2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdL2RowSum;
-          ngdL2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdL2RowSum;
-          pgdOBandSum[bandID] += coefInGaussion * pgdORowSum;
-          ngdOBandSum[bandID] += coefInGaussion * ngdORowSum;
-          pgdO2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdO2RowSum;
-          ngdO2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdO2RowSum;
         }
-        bandID = bandID + 2;
-        if( bandID < NUM_OF_BANDS )
-        {/*the band below the current band */
-          coefInGaussion = (float) ( gaussCoefL_[hID % params.widthOfBand_] );
-          pgdLBandSum[bandID] += coefInGaussion * pgdLRowSum;
-          ngdLBandSum[bandID] += coefInGaussion * ngdLRowSum;
-          pgdL2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdL2RowSum;
-          ngdL2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdL2RowSum;
-          pgdOBandSum[bandID] += coefInGaussion * pgdORowSum;
-          ngdOBandSum[bandID] += coefInGaussion * ngdORowSum;
-          pgdO2BandSum[bandID] += coefInGaussion * coefInGaussion * pgdO2RowSum;
-          ngdO2BandSum[bandID] += coefInGaussion * coefInGaussion * ngdO2RowSum;
-        }
-      }
-      /* gDLMat.Save("gDLMat.txt");
-       return 0; */
-
-      /* construct line descriptor */
-      pSingleLine->descriptor.resize( descriptor_size );
-      desVec = &pSingleLine->descriptor.front();
 
-      short desID;
+        /* construct line descriptor */
+        pSingleLine->descriptor.resize( descriptor_size );
+        desVec = &pSingleLine->descriptor.front();
 
-      /*Note that the first and last bands only have (lengthOfLSP * widthOfBand_ * 2.0) pixels
-       * which are counted. */
-      float invN2 = (float) ( 1.0 / ( params.widthOfBand_ * 2.0 ) );
-      float invN3 = (float) ( 1.0 / ( params.widthOfBand_ * 3.0 ) );
-      float invN, temp;
-      for ( bandID = 0; bandID < NUM_OF_BANDS; bandID++ )
-      {
-        if( bandID == 0 || bandID == NUM_OF_BANDS - 1 )
+        /*Note that the first and last bands only have (lengthOfLSP * widthOfBand_ * 2.0) pixels
+         * which are counted. */
+        float invN2 = (float) ( 1.0 / ( widthOfBand * 2.0 ) );
+        float invN3 = (float) ( 1.0 / ( widthOfBand * 3.0 ) );
+        float temp;
+        for ( bandID = 0; bandID < NUM_OF_BANDS; bandID++ )
         {
-          invN = invN2;
+          float invN = ( bandID == 0 || bandID == NUM_OF_BANDS - 1 ) ? invN2 : invN3;
+          bandDescriptor( desVec + bandID * 8, bandSum + bandID * 4, band2Sum + bandID * 4, invN );
         }
-        else
+
+        // normalize;
+        float tempM, tempS;
+        tempM = 0;
+        tempS = 0;
+
+        int base = 0;
+        for ( short i = 0; i < (short) ( NUM_OF_BANDS * 8 ); ++base, i = (short) ( base * 8 ) )
         {
-          invN = invN3;
+          tempM += * ( desVec + i ) * * ( desVec + i );  //desVec[8*i+0] * desVec[8*i+0];
+          tempM += * ( desVec + i + 1 ) * * ( desVec + i + 1 );  //desVec[8*i+1] * desVec[8*i+1];
+          tempM += * ( desVec + i + 2 ) * * ( desVec + i + 2 );  //desVec[8*i+2] * desVec[8*i+2];
+          tempM += * ( desVec + i + 3 ) * * ( desVec + i + 3 );  //desVec[8*i+3] * desVec[8*i+3];
+          tempS += * ( desVec + i + 4 ) * * ( desVec + i + 4 );  //desVec[8*i+4] * desVec[8*i+4];
+          tempS += * ( desVec + i + 5 ) * * ( desVec + i + 5 );  //desVec[8*i+5] * desVec[8*i+5];
+          tempS += * ( desVec + i + 6 ) * * ( desVec + i + 6 );  //desVec[8*i+6] * desVec[8*i+6];
+          tempS += * ( desVec + i + 7 ) * * ( desVec + i + 7 );  //desVec[8*i+7] * desVec[8*i+7];
         }
-        desID = bandID * 8;
-        temp = pgdLBandSum[bandID] * invN;
-        desVec[desID] = temp;/* mean value of pgdL; */
-        desVec[desID + 4] = sqrt( pgdL2BandSum[bandID] * invN - temp * temp );  //std value of pgdL;
-        temp = ngdLBandSum[bandID] * invN;
-        desVec[desID + 1] = temp;  //mean value of ngdL;
-        desVec[desID + 5] = sqrt( ngdL2BandSum[bandID] * invN - temp * temp );  //std value of ngdL;
-
-        temp = pgdOBandSum[bandID] * invN;
-        desVec[desID + 2] = temp;  //mean value of pgdO;
-        desVec[desID + 6] = sqrt( pgdO2BandSum[bandID] * invN - temp * temp );  //std value of pgdO;
-        temp = ngdOBandSum[bandID] * invN;
-        desVec[desID + 3] = temp;  //mean value of ngdO;
-        desVec[desID + 7] = sqrt( ngdO2BandSum[bandID] * invN - temp * temp );  //std value of ngdO;
-      }
-
-      // normalize;
-      float tempM, tempS;
-      tempM = 0;
-      tempS = 0;
-      desVec = &pSingleLine->descriptor.front();
 
-      int base = 0;
-      for ( short i = 0; i < (short) ( NUM_OF_BANDS * 8 ); ++base, i = (short) ( base * 8 ) )
-      {
-        tempM += * ( desVec + i ) * * ( desVec + i );  //desVec[8*i+0] * desVec[8*i+0];
-        tempM += * ( desVec + i + 1 ) * * ( desVec + i + 1 );  //desVec[8*i+1] * desVec[8*i+1];
-        tempM += * ( desVec + i + 2 ) * * ( desVec + i + 2 );  //desVec[8*i+2] * desVec[8*i+2];
-        tempM += * ( desVec + i + 3 ) * * ( desVec + i + 3 );  //desVec[8*i+3] * desVec[8*i+3];
-        tempS += * ( desVec + i + 4 ) * * ( desVec + i + 4 );  //desVec[8*i+4] * desVec[8*i+4];
-        tempS += * ( desVec + i + 5 ) * * ( desVec + i + 5 );  //desVec[8*i+5] * desVec[8*i+5];
-        tempS += * ( desVec + i + 6 ) * * ( desVec + i + 6 );  //desVec[8*i+6] * desVec[8*i+6];
-        tempS += * ( desVec + i + 7 ) * * ( desVec + i + 7 );  //desVec[8*i+7] * desVec[8*i+7];
-      }
+        tempM = 1 / sqrt( tempM );
+        tempS = 1 / sqrt( tempS );
+        base = 0;
+        for ( short i = 0; i < (short) ( NUM_OF_BANDS * 8 ); ++base, i = (short) ( base * 8 ) )
+        {
+          * ( desVec + i ) = * ( desVec + i ) * tempM;  //desVec[8*i] =  desVec[8*i] * tempM;
+          * ( desVec + 1 + i ) = * ( desVec + 1 + i ) * tempM;  //desVec[8*i+1] =  desVec[8*i+1] * tempM;
+          * ( desVec + 2 + i ) = * ( desVec + 2 + i ) * tempM;  //desVec[8*i+2] =  desVec[8*i+2] * tempM;
+          * ( desVec + 3 + i ) = * ( desVec + 3 + i ) * tempM;  //desVec[8*i+3] =  desVec[8*i+3] * tempM;
+          * ( desVec + 4 + i ) = * ( desVec + 4 + i ) * tempS;  //desVec[8*i+4] =  desVec[8*i+4] * tempS;
+          * ( desVec + 5 + i ) = * ( desVec + 5 + i ) * tempS;  //desVec[8*i+5] =  desVec[8*i+5] * tempS;
+          * ( desVec + 6 + i ) = * ( desVec + 6 + i ) * tempS;  //desVec[8*i+6] =  desVec[8*i+6] * tempS;
+          * ( desVec + 7 + i ) = * ( desVec + 7 + i ) * tempS;  //desVec[8*i+7] =  desVec[8*i+7] * tempS;
+        }
 
-      tempM = 1 / sqrt( tempM );
-      tempS = 1 / sqrt( tempS );
-      desVec = &pSingleLine->descriptor.front();
-      base = 0;
-      for ( short i = 0; i < (short) ( NUM_OF_BANDS * 8 ); ++base, i = (short) ( base * 8 ) )
-      {
-        * ( desVec + i ) = * ( desVec + i ) * tempM;  //desVec[8*i] =  desVec[8*i] * tempM;
-        * ( desVec + 1 + i ) = * ( desVec + 1 + i ) * tempM;  //desVec[8*i+1] =  desVec[8*i+1] * tempM;
-        * ( desVec + 2 + i ) = * ( desVec + 2 + i ) * tempM;  //desVec[8*i+2] =  desVec[8*i+2] * tempM;
-        * ( desVec + 3 + i ) = * ( desVec + 3 + i ) * tempM;  //desVec[8*i+3] =  desVec[8*i+3] * tempM;
-        * ( desVec + 4 + i ) = * ( desVec + 4 + i ) * tempS;  //desVec[8*i+4] =  desVec[8*i+4] * tempS;
-        * ( desVec + 5 + i ) = * ( desVec + 5 + i ) * tempS;  //desVec[8*i+5] =  desVec[8*i+5] * tempS;
-        * ( desVec + 6 + i ) = * ( desVec + 6 + i ) * tempS;  //desVec[8*i+6] =  desVec[8*i+6] * tempS;
-        * ( desVec + 7 + i ) = * ( desVec + 7 + i ) * tempS;  //desVec[8*i+7] =  desVec[8*i+7] * tempS;
-      }
+        /* In order to reduce the influence of non-linear illumination,
+         * a threshold is used to limit the value of element in the unit feature
+         * vector no larger than this threshold. In Z.Wang's work, a value of 0.4 is found
+         * empirically to be a proper threshold.*/
+        for ( short i = 0; i < descriptor_size; i++ )
+        {
+          if( desVec[i] > 0.4 )
+          {
+            desVec[i] = (float) 0.4;
+          }
+        }
 
-      /* In order to reduce the influence of non-linear illumination,
-       * a threshold is used to limit the value of element in the unit feature
-       * vector no larger than this threshold. In Z.Wang's work, a value of 0.4 is found
-       * empirically to be a proper threshold.*/
-      desVec = &pSingleLine->descriptor.front();
-      for ( short i = 0; i < descriptor_size; i++ )
-      {
-        if( desVec[i] > 0.4 )
+        //re-normalize desVec;
+        temp = 0;
+        for ( short i = 0; i < descriptor_size; i++ )
         {
-          desVec[i] = (float) 0.4;
+          temp += desVec[i] * desVec[i];
         }
-      }
 
-      //re-normalize desVec;
-      temp = 0;
-      for ( short i = 0; i < descriptor_size; i++ )
-      {
-        temp += desVec[i] * desVec[i];
-      }
+        temp = 1 / sqrt( temp );
+        for ( short i = 0; i < descriptor_size; i++ )
+        {
+          desVec[i] = desVec[i] * temp;
+        }
+      }/* end for(short lineIDInSameLine = 0; lineIDInSameLine<sameLineSize;
+       lineIDInSameLine++) */
+    }
+  }
 
-      temp = 1 / sqrt( temp );
-      for ( short i = 0; i < descriptor_size; i++ )
-      {
-        desVec[i] = desVec[i] * temp;
-      }
-    }/* end for(short lineIDInSameLine = 0; lineIDInSameLine<sameLineSize;
-     lineIDInSameLine++) */
+private:
+  ScaleLines& keyLines;
+  const std::vector<Mat>& dxImg;
+  const std::vector<Mat>& dyImg;
+  int widthOfBand;
+  const std::vector<double>& gaussCoefG;
+  const std::vector<double>& gaussCoefL;
+};
 
-    cv::Mat appoggio = cv::Mat( 1, 32, CV_32FC1 );
-    float* pointerToRow = appoggio.ptr<float>( 0 );
-    for ( int g = 0; g < 32; g++ )
+int BinaryDescriptor::computeLBD( ScaleLines &keyLines, bool useDetectionData )
+{
+  /* retrieve gradient images of every octave */
+  std::vector<Mat> dxImg, dyImg;
+  if( useDetectionData )
+  {
+    for ( size_t octaveCount = 0; octaveCount < edLineVec_.size(); octaveCount++ )
     {
-      /* get LBD data */
-      float* des_Vec = &keyLines[lineIDInScaleVec][0].descriptor.front();
-      *pointerToRow = des_Vec[g];
-      pointerToRow++;
-
+      dxImg.push_back( edLineVec_[octaveCount]->dxImg_ );
+      dyImg.push_back( edLineVec_[octaveCount]->dyImg_ );
     }
+  }
 
-  }/* end for(short lineIDInScaleVec = 0;
-   lineIDInScaleVec<numOfFinalLine; lineIDInScaleVec++) */
+  else
+  {
+    dxImg = dxImg_vector;
+    dyImg = dyImg_vector;
+  }
 
-  delete[] dL;
-  delete[] dO;
-  delete[] pgdLBandSum;
-  delete[] ngdLBandSum;
-  delete[] pgdL2BandSum;
-  delete[] ngdL2BandSum;
-  delete[] pgdOBandSum;
-  delete[] ngdOBandSum;
-  delete[] pgdO2BandSum;
-  delete[] ngdO2BandSum;
+  /* lines are independent, the ones detected in different octaves
+   (most of them short) are spread across threads */
+  parallel_for_( Range( 0, (int) keyLines.size() ),
+                 ComputeLBDInvoker( keyLines, dxImg, dyImg, params.widthOfBand_, gaussCoefG_, gaussCoefL_ ) );
 
   return 1;
 
@@ -2252,8 +2248,8 @@ int BinaryDescriptor::EDLineDetector::EdgeDrawing( cv::Mat &image, EdgeChains &e
 int BinaryDescriptor::EDLineDetector::EDline( cv::Mat &image, LineChains &lines )
 {
 
-  //first, call EdgeDrawing function to extract edges
-  EdgeChains edges;
+  //first, call EdgeDrawing function to extract edges (their storage is reused across images)
+  EdgeChains& edges = edges_;
   if( ( EdgeDrawing( image, edges ) ) != 1 )
   {
     std::cout << "Line Detection not finished" << std::endl;
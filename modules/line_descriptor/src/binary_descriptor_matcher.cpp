@@ -39,11 +39,11 @@
  //
  //M*/
 
+
 #include "precomp.hpp"
 
-#define MAX_B 37
-double ARRAY_RESIZE_FACTOR = 1.1;    // minimum is 1.0
-double ARRAY_RESIZE_ADD_FACTOR = 4;  // minimum is 1
+/* bucket offsets are stored densely, so that key length is limited */
+#define MAX_B 24
 
 //using namespace cv;
 namespace cv
@@ -73,7 +73,11 @@ void BinaryDescriptorMatcher::add( const std::vector<Mat>& descriptors )
   {
     descriptorsMat.push_back( descriptors[i] );
 
-    indexesMap.insert( std::pair<int, int>( nextAddedIndex, numImages ) );
+    /* an image without descriptors begins where the next one does, only
+     the images with descriptors can be found from a descriptor's index */
+    if( descriptors[i].rows > 0 )
+      indexesMap.insert( std::pair<int, int>( nextAddedIndex, numImages ) );
+    imagesRanges.push_back( std::pair<int, int>( nextAddedIndex, descriptors[i].rows ) );
     nextAddedIndex += descriptors[i].rows;
     numImages++;
   }
@@ -85,22 +89,65 @@ void BinaryDescriptorMatcher::train()
   if( !dataset )
     dataset = Ptr<Mihasher>(new Mihasher( 256, 32 ));
 
+  /* new descriptors are appended to the ones already in dataset,
+   so that their indexes agree with indexesMap */
   if( descriptorsMat.rows > 0 )
-    dataset->populate( descriptorsMat, descriptorsMat.rows, descriptorsMat.cols );
+    dataset->append( descriptorsMat );
 
-  descrInDS = descriptorsMat.rows;
+  descrInDS = (int) dataset->N;
   descriptorsMat.release();
 }
 
+/* remove from dataset the descriptors of an image */
+void BinaryDescriptorMatcher::remove( int imgIdx )
+{
+  CV_Assert( imgIdx >= 0 && imgIdx < numImages );
+
+  /* descriptors of the image may still be stored locally */
+  train();
+
+  const std::pair<int, int>& range = imagesRanges[imgIdx];
+  dataset->remove( (UINT32) range.first, (UINT32) range.second );
+}
+
 /* clear dataset and internal data */
 void BinaryDescriptorMatcher::clear()
 {
   descriptorsMat.release();
   indexesMap.clear();
+  imagesRanges.clear();
   dataset.release();
   nextAddedIndex = 0;
   numImages = 0;
   descrInDS = 0;
+
+  AutoLock lock( trainIndexMutex );
+  trainIndex.release();
+}
+
+/* get an index of train descriptors: comparing them to the ones of previous
+ call is much cheaper than building the hash tables again, when the same
+ train descriptors are matched against several sets of queries */
+Ptr<BinaryDescriptorMatcher::Mihasher> BinaryDescriptorMatcher::getTrainIndex( const Mat& trainDescriptors ) const
+{
+  AutoLock lock( trainIndexMutex );
+
+  bool sameTrain = !trainIndex.empty() && trainIndex->codes.rows == trainDescriptors.rows && trainIndex->codes.cols == trainDescriptors.cols
+      && trainIndex->codes.type() == trainDescriptors.type();
+
+  size_t rowSize = trainDescriptors.cols * trainDescriptors.elemSize();
+  for ( int i = 0; i < trainDescriptors.rows && sameTrain; i++ )
+    sameTrain = memcmp( trainIndex->codes.ptr( i ), trainDescriptors.ptr( i ), rowSize ) == 0;
+
+  if( !sameTrain )
+  {
+    /* build a new index, while queries still running on the old one keep it alive */
+    Ptr<Mihasher> mh = Ptr<Mihasher>( new Mihasher( 256, 32 ) );
+    mh->populate( trainDescriptors.clone() );
+    trainIndex = mh;
+  }
+
+  return trainIndex;
 }
 
 /* retrieve Hamming distances */
@@ -144,18 +191,19 @@ void BinaryDescriptorMatcher::match( const Mat& queryDescriptors, std::vector<DM
   /* add new descriptors to dataset, if needed */
   train();
 
-  /* set number of requested matches to return for each query */
-  dataset->setK( 1 );
-
   /* prepare structures for query */
   UINT32 *results = new UINT32[queryDescriptors.rows];
   UINT32 * numres = new UINT32[ ( 256 + 1 ) * ( queryDescriptors.rows )];
 
-  /* execute query */
-  dataset->batchquery( results, numres, queryDescriptors, queryDescriptors.rows, queryDescriptors.cols );
+  /* execute query, requesting 1 match for each descriptor */
+  dataset->batchquery( results, numres, queryDescriptors, 1 );
   /* compose matches */
   for ( int counter = 0; counter < queryDescriptors.rows; counter++ )
   {
+    /* no descriptor in dataset within search radius */
+    if( results[counter] == 0 )
+      continue;
+
     /* create a map iterator */
     std::map<int, int>::iterator itup;
 
@@ -211,27 +259,22 @@ void BinaryDescriptorMatcher::match( const Mat& queryDescriptors, const Mat& tra
     return;
   }
 
-  /* create a new mihasher object */
-  Mihasher *mh = new Mihasher( 256, 32 );
-
-  /* populate mihasher */
-  cv::Mat copy = trainDescriptors.clone();
-  mh->populate( copy, copy.rows, copy.cols );
-  mh->setK( 1 );
+  /* get the index of train descriptors */
+  Ptr<Mihasher> mh = getTrainIndex( trainDescriptors );
 
   /* prepare structures for query */
   UINT32 *results = new UINT32[queryDescriptors.rows];
   UINT32 * numres = new UINT32[ ( 256 + 1 ) * ( queryDescriptors.rows )];
 
   /* execute query */
-  mh->batchquery( results, numres, queryDescriptors, queryDescriptors.rows, queryDescriptors.cols );
+  mh->batchquery( results, numres, queryDescriptors, 1 );
 
   /* compose matches */
   for ( int counter = 0; counter < queryDescriptors.rows; counter++ )
   {
     /* create a DMatch object if required by mask or if there is
      no mask at all */
-    if( mask.empty() || ( !mask.empty() && mask.at < uchar > ( counter ) != 0 ) )
+    if( results[counter] != 0 && ( mask.empty() || ( !mask.empty() && mask.at < uchar > ( counter ) != 0 ) ) )
     {
       std::vector<int> k_distances;
       checkKDistances( numres, 1, k_distances, counter, 256 );
@@ -247,7 +290,6 @@ void BinaryDescriptorMatcher::match( const Mat& queryDescriptors, const Mat& tra
   }
 
   /* delete data */
-  delete mh;
   delete[] results;
   delete[] numres;
 
@@ -273,22 +315,15 @@ void BinaryDescriptorMatcher::knnMatch( const Mat& queryDescriptors, const Mat&
     return;
   }
 
-  /* create a new mihasher object */
-  Mihasher *mh = new Mihasher( 256, 32 );
-
-  /* populate mihasher */
-  cv::Mat copy = trainDescriptors.clone();
-  mh->populate( copy, copy.rows, copy.cols );
-
-  /* set K */
-  mh->setK( k );
+  /* get the index of train descriptors */
+  Ptr<Mihasher> mh = getTrainIndex( trainDescriptors );
 
   /* prepare structures for query */
   UINT32 *results = new UINT32[k * queryDescriptors.rows];
   UINT32 * numres = new UINT32[ ( 256 + 1 ) * ( queryDescriptors.rows )];
 
   /* execute query */
-  mh->batchquery( results, numres, queryDescriptors, queryDescriptors.rows, queryDescriptors.cols );
+  mh->batchquery( results, numres, queryDescriptors, k );
 
   /* compose matches */
   int index = 0;
@@ -310,7 +345,9 @@ void BinaryDescriptorMatcher::knnMatch( const Mat& queryDescriptors, const Mat&
     {
       std::vector<int> k_distances;
       checkKDistances( numres, k, k_distances, counter, 256 );
-      for ( int j = index; j < index + k; j++ )
+
+      /* less than k results are returned if dataset is small */
+      for ( int j = index; j < index + k && results[j] != 0; j++ )
       {
         DMatch dm;
         dm.queryIdx = counter;
@@ -329,7 +366,6 @@ void BinaryDescriptorMatcher::knnMatch( const Mat& queryDescriptors, const Mat&
   }
 
   /* delete data */
-  delete mh;
   delete[] results;
   delete[] numres;
 }
@@ -358,15 +394,12 @@ void BinaryDescriptorMatcher::knnMatch( const Mat& queryDescriptors, std::vector
   /* add new descriptors to dataset, if needed */
   train();
 
-  /* set number of requested matches to return for each query */
-  dataset->setK( k );
-
   /* prepare structures for query */
   UINT32 *results = new UINT32[k * queryDescriptors.rows];
   UINT32 * numres = new UINT32[ ( 256 + 1 ) * ( queryDescriptors.rows )];
 
-  /* execute query */
-  dataset->batchquery( results, numres, queryDescriptors, queryDescriptors.rows, queryDescriptors.cols );
+  /* execute query, requesting k matches for each descriptor */
+  dataset->batchquery( results, numres, queryDescriptors, k );
 
   /* compose matches */
   int index = 0;
@@ -375,8 +408,13 @@ void BinaryDescriptorMatcher::knnMatch( const Mat& queryDescriptors, std::vector
     /* create a void vector of matches */
     std::vector < DMatch > tempVector;
 
-    /* loop over k results returned for every query */
-    for ( int j = index; j < index + k; j++ )
+    /* retrieve distances of returned matches */
+    std::vector<int> k_distances;
+    checkKDistances( numres, k, k_distances, counter, 256 );
+
+    /* loop over k results returned for every query (less than
+     k are returned if dataset is small) */
+    for ( int j = index; j < index + k && results[j] != 0; j++ )
     {
       /* retrieve which image returned index refers to */
       int currentIndex = results[j] - 1;
@@ -390,6 +428,8 @@ void BinaryDescriptorMatcher::knnMatch( const Mat& queryDescriptors, std::vector
         std::cout << "Error: mask " << itup->second << " in knnMatch function " << "should have " << queryDescriptors.rows << " and "
             << "1 column. Program will be terminated" << std::endl;
 
+        delete[] results;
+        delete[] numres;
         return;
       }
 
@@ -397,9 +437,6 @@ void BinaryDescriptorMatcher::knnMatch( const Mat& queryDescriptors, std::vector
        considered */
       else if( masks.size() == 0 || masks[itup->second].at < uchar > ( counter ) != 0 )
       {
-        std::vector<int> k_distances;
-        checkKDistances( numres, k, k_distances, counter, 256 );
-
         DMatch dm;
         dm.queryIdx = counter;
         dm.trainIdx = results[j] - 1;
@@ -444,23 +481,15 @@ void BinaryDescriptorMatcher::radiusMatch( const Mat& queryDescriptors, const Ma
     return;
   }
 
-  /* create a new Mihasher */
-  Mihasher* mh = new Mihasher( 256, 32 );
-
-  /* populate Mihasher */
-  //Mat copy = queryDescriptors.clone();
-  Mat copy = trainDescriptors.clone();
-  mh->populate( copy, copy.rows, copy.cols );
-
-  /* set K */
-  mh->setK( trainDescriptors.rows );
+  /* get the index of train descriptors */
+  Ptr<Mihasher> mh = getTrainIndex( trainDescriptors );
 
   /* prepare structures for query */
   UINT32 *results = new UINT32[trainDescriptors.rows * queryDescriptors.rows];
   UINT32 * numres = new UINT32[ ( 256 + 1 ) * ( queryDescriptors.rows )];
 
-  /* execute query */
-  mh->batchquery( results, numres, queryDescriptors, queryDescriptors.rows, queryDescriptors.cols );
+  /* execute query, requesting all the descriptors within search radius */
+  mh->batchquery( results, numres, queryDescriptors, trainDescriptors.rows );
 
   /* compose matches */
   int index = 0;
@@ -470,7 +499,7 @@ void BinaryDescriptorMatcher::radiusMatch( const Mat& queryDescriptors, const Ma
     checkKDistances( numres, trainDescriptors.rows, k_distances, i, 256 );
 
     std::vector < DMatch > tempVector;
-    for ( int j = index; j < index + trainDescriptors.rows; j++ )
+    for ( int j = index; j < index + trainDescriptors.rows && results[j] != 0; j++ )
     {
 //      if( numres[j] <= maxDistance )
       if( k_distances[j - index] <= maxDistance )
@@ -498,7 +527,6 @@ void BinaryDescriptorMatcher::radiusMatch( const Mat& queryDescriptors, const Ma
   }
 
   /* delete data */
-  delete mh;
   delete[] results;
   delete[] numres;
 }
@@ -527,26 +555,23 @@ void BinaryDescriptorMatcher::radiusMatch( const Mat& queryDescriptors, std::vec
   /* populate dataset */
   train();
 
-  /* set K */
-  dataset->setK( descrInDS );
-
   /* prepare structures for query */
   UINT32 *results = new UINT32[descrInDS * queryDescriptors.rows];
   UINT32 * numres = new UINT32[ ( 256 + 1 ) * ( queryDescriptors.rows )];
 
-  /* execute query */
-  dataset->batchquery( results, numres, queryDescriptors, queryDescriptors.rows, queryDescriptors.cols );
+  /* execute query, requesting all the descriptors within search radius */
+  dataset->batchquery( results, numres, queryDescriptors, descrInDS );
 
   /* compose matches */
   int index = 0;
   for ( int counter = 0; counter < queryDescriptors.rows; counter++ )
   {
+    std::vector<int> k_distances;
+    checkKDistances( numres, descrInDS, k_distances, counter, 256 );
+
     std::vector < DMatch > tempVector;
-    for ( int j = index; j < index + descrInDS; j++ )
+    for ( int j = index; j < index + descrInDS && results[j] != 0; j++ )
     {
-      std::vector<int> k_distances;
-      checkKDistances( numres, descrInDS, k_distances, counter, 256 );
-
       if( k_distances[j - index] <= maxDistance )
       {
         int currentIndex = results[j] - 1;
@@ -560,6 +585,8 @@ void BinaryDescriptorMatcher::radiusMatch( const Mat& queryDescriptors, std::vec
           std::cout << "Error: mask " << itup->second << " in radiusMatch function " << "should have " << queryDescriptors.rows << " and "
               << "1 column. Program will be terminated" << std::endl;
 
+          delete[] results;
+          delete[] numres;
           return;
         }
 
@@ -592,45 +619,50 @@ void BinaryDescriptorMatcher::radiusMatch( const Mat& queryDescriptors, std::vec
 
 }
 
-/* execute a batch query */
-void BinaryDescriptorMatcher::Mihasher::batchquery( UINT32 * results, UINT32 *numres, const cv::Mat & queries, UINT32 numq, int dim1queries )
+/* queries are independent: every thread runs them with its own scratch memory,
+ writing to its own part of results, so that output does not depend on the number of threads */
+class BinaryDescriptorMatcher::Mihasher::BatchQueryInvoker : public ParallelLoopBody
 {
-  /* create and initialize a bitarray */
-  counter = makePtr<bitarray>();
-  counter->init( N );
-
-  UINT32 *res = new UINT32[K * ( D + 1 )];
-  UINT64 *chunks = new UINT64[m];
-  UINT32 * presults = results;
-  UINT32 *pnumres = numres;
-
-  /* make a copy of input queries */
-  cv::Mat queries_clone = queries.clone();
-
-  /* set a pointer to first query (row) */
-  UINT8 *pq = queries_clone.ptr();
+public:
+  BatchQueryInvoker( const Mihasher& _mh, UINT32* _results, UINT32* _numres, const cv::Mat& _queries, int _K ) :
+      mh( _mh ), results( _results ), numres( _numres ), queries( _queries ), K( _K )
+  {
+  }
 
-  /* loop over number of descriptors */
-  for ( size_t i = 0; i < numq; i++ )
+  void operator()( const Range& range ) const
   {
-    /* for every descriptor, query database */
-    query( presults, pnumres, pq, chunks, res );
+    /* scratch memory is kept by every thread from a range to the next, and only grows */
+    QueryBuffers& buffers = *mh.queryBuffers.get();
+    if( (UINT64) buffers.counter.length * 32 < mh.N )
+      buffers.counter.init( mh.N );
+    buffers.chunks.resize( mh.m );
+    size_t resSize = (size_t) ( K ? K : mh.N ) * ( mh.D + 1 ) + 1;
+    if( buffers.res.size() < resSize )
+      buffers.res.resize( resSize );
 
-    /* move pointer to write next K indeces */
-    presults += K;
-    pnumres += B + 1;
+    for ( int i = range.start; i < range.end; i++ )
+      mh.query( results + (size_t) i * K, numres + (size_t) i * ( mh.B + 1 ), queries.ptr( i ), K, buffers );
+  }
 
-    /* move forward pointer to current row in descriptors matrix */
-    pq += dim1queries;
+private:
+  const Mihasher& mh;
+  UINT32* results;
+  UINT32* numres;
+  const cv::Mat& queries;
+  int K;
+};
 
-  }
+/* execute a batch query */
+void BinaryDescriptorMatcher::Mihasher::batchquery( UINT32 * results, UINT32 *numres, const cv::Mat & queries, int K ) const
+{
+  CV_Assert( queries.type() == CV_8U && queries.cols == B_over_8 );
 
-  delete[] res;
-  delete[] chunks;
+  /* a few dozens queries per stripe keep the setup of scratch memory negligible */
+  parallel_for_( Range( 0, queries.rows ), BatchQueryInvoker( *this, results, numres, queries, K ), queries.rows / 32.0 );
 }
 
 /* execute a single query */
-void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres, UINT8 * Query, UINT64 *chunks, UINT32 *res )
+void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres, const UINT8 * Query, int K, QueryBuffers& buffers ) const
 {
   /* if K == 0 that means we want everything to be processed.
    So maxres = N in that case. Otherwise K limits the results processed */
@@ -647,14 +679,23 @@ void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres,
   UINT32 nl = 0;
 
   UINT32 nd = 0;
-  UINT32 *arr;
+  const UINT32 *arr;
   int size = 0;
   UINT32 index;
   int hammd;
 
-  counter->erase();
+  UINT64 *chunks = &buffers.chunks[0];
+  UINT32 *res = &buffers.res[0];
+  int *power = buffers.power;
+  bitarray& counter = buffers.counter;
+
+  /* only the flags of the N codes are cleared, the counter may be longer */
+  memset( counter.arr, 0, (size_t) ( ( N + 31 ) / 32 ) * sizeof(UINT32) );
   memset( numres, 0, ( B + 1 ) * sizeof ( *numres ) );
 
+  /* slots not filled (there are less than K codes within search radius) are left to 0 */
+  memset( results, 0, K * sizeof ( *results ) );
+
   split( chunks, Query, m, mplus, b );
 
   /* the growing search radius per substring */
@@ -710,14 +751,17 @@ void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres,
             for ( int c = 0; c < size; c++ )
             {
               index = arr[c];
-              if( !counter->get( index ) )
+              if( !counter.get( index ) )
               { /* if it is not a duplicate */
-                counter->set( index );
+                counter.set( index );
+                if( removed[index] )
+                  continue;
+
                 hammd = cv::line_descriptor::match( codes.ptr() + (UINT64) index * ( B_over_8 ), Query, B_over_8 );
 
                 nc++;
                 if( hammd <= D && numres[hammd] < maxres )
-                  res[hammd * K + numres[hammd]] = index + 1;
+                  res[hammd * maxres + numres[hammd]] = index + 1;
 
                 numres[hammd]++;
               }
@@ -745,7 +789,7 @@ void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres,
   for ( s = 0; s <= D && (int) n < K; s++ )
   {
     for ( int c = 0; c < (int) numres[s] && (int) n < K; c++ )
-      results[n++] = res[s * K + c];
+      results[n++] = res[s * maxres + c];
   }
 
 }
@@ -757,6 +801,7 @@ BinaryDescriptorMatcher::Mihasher::Mihasher( int B_val, int _m )
   B_over_8 = B / 8;
   m = _m;
   b = (int) ceil( (double) B / m );
+  N = 0;
 
   /* assuming that B/2 is large enough radius to include
    all of the k nearest neighbors */
@@ -781,37 +826,68 @@ BinaryDescriptorMatcher::Mihasher::Mihasher( int B_val, int _m )
     H[i].init( b - 1 );
 }
 
-/* K setter */
-void BinaryDescriptorMatcher::Mihasher::setK( int K_val )
-{
-  K = K_val;
-}
-
 /* desctructor */
 BinaryDescriptorMatcher::Mihasher::~Mihasher()
 {
 }
 
 /* populate tables */
-void BinaryDescriptorMatcher::Mihasher::populate( cv::Mat & _codes, UINT32 N_val, int dim1codes )
+void BinaryDescriptorMatcher::Mihasher::populate( const cv::Mat & _codes )
 {
-  N = N_val;
+  CV_Assert( _codes.type() == CV_8U && _codes.cols == B_over_8 );
+
   codes = _codes;
-  UINT64 * chunks = new UINT64[m];
+  N = codes.rows;
+  removed.assign( (size_t) N, 0 );
 
-  UINT8 * pcodes = codes.ptr();
-  for ( UINT64 i = 0; i < N; i++, pcodes += dim1codes )
-  {
-    split( chunks, pcodes, m, mplus, b );
+  buildTables();
+}
 
-    for ( int k = 0; k < m; k++ )
-      H[k].insert( chunks[k], (UINT32) i );
+/* append codes and insert them in tables */
+void BinaryDescriptorMatcher::Mihasher::append( const cv::Mat & newCodes )
+{
+  if( newCodes.rows == 0 )
+    return;
 
-    if( i % (int) ceil( N / 1000.0 ) == 0 )
-      fflush (stdout);
-  }
+  CV_Assert( newCodes.type() == CV_8U && newCodes.cols == B_over_8 );
 
-  delete[] chunks;
+  UINT32 first = (UINT32) N;
+  if( codes.empty() )
+    codes = newCodes.clone();
+  else
+    codes.push_back( newCodes );
+
+  N = codes.rows;
+  removed.resize( (size_t) N, 0 );
+
+  /* only the new codes are split, the entries already in tables are moved bucket by bucket */
+  std::vector<UINT64> newChunks( (size_t) newCodes.rows * m + 1 );
+  for ( int i = 0; i < newCodes.rows; i++ )
+    split( &newChunks[(size_t) i * m], newCodes.ptr( i ), m, mplus, b );
+
+  for ( int k = 0; k < m; k++ )
+    H[k].insert( &newChunks[k], first, (UINT32) newCodes.rows, m );
+}
+
+/* mark codes as removed */
+void BinaryDescriptorMatcher::Mihasher::remove( UINT32 first, UINT32 count )
+{
+  CV_Assert( (UINT64) first + count <= N );
+
+  if( count > 0 )
+    memset( &removed[first], 1, count );
+}
+
+/* build hash tables */
+void BinaryDescriptorMatcher::Mihasher::buildTables()
+{
+  /* split all codes first, so that every table is then filled by a single counting sort */
+  std::vector<UINT64> allChunks( (size_t) N * m + 1 );
+  for ( UINT64 i = 0; i < N; i++ )
+    split( &allChunks[(size_t) i * m], codes.ptr( (int) i ), m, mplus, b );
+
+  for ( int k = 0; k < m; k++ )
+    H[k].build( &allChunks[k], (UINT32) N, m );
 }
 
 /* constructor */
@@ -829,8 +905,9 @@ int BinaryDescriptorMatcher::SparseHashtable::init( int _b )
   if( b < 5 || b > MAX_B || b > (int) ( sizeof(UINT64) * 8 ) )
     return 1;
 
-  size = UINT64_1 << ( b - 5 );  // size = 2 ^ b
-  table = std::vector<BucketGroup>((size_t)size, BucketGroup(false));
+  size = UINT64_1 << b;  // size = 2 ^ b
+  offsets = std::vector<UINT32>( (size_t) size + 1, 0 );
+  entries.clear();
 
   return 0;
 
@@ -841,128 +918,68 @@ BinaryDescriptorMatcher::SparseHashtable::~SparseHashtable()
 {
 }
 
-/* insert data */
-void BinaryDescriptorMatcher::SparseHashtable::insert( UINT64 index, UINT32 data )
+/* build the table */
+void BinaryDescriptorMatcher::SparseHashtable::build( const UINT64* keys, UINT32 N, int stride )
 {
-  table[(size_t)(index >> 5)].insert( (int) ( index & 31 ), data );
+  /* count entries of every bucket */
+  std::fill( offsets.begin(), offsets.end(), 0 );
+  for ( UINT32 i = 0; i < N; i++ )
+    offsets[(size_t) keys[(size_t) i * stride] + 1]++;
+
+  for ( size_t j = 1; j < offsets.size(); j++ )
+    offsets[j] += offsets[j - 1];
+
+  /* codes are visited by increasing index, so that
+   every bucket lists them in insertion order */
+  std::vector<UINT32> next( offsets.begin(), offsets.end() - 1 );
+  entries.resize( N );
+  for ( UINT32 i = 0; i < N; i++ )
+    entries[next[(size_t) keys[(size_t) i * stride]]++] = i;
 }
 
-/* query data */
-UINT32* BinaryDescriptorMatcher::SparseHashtable::query( UINT64 index, int *Size )
+/* insert new codes in the table */
+void BinaryDescriptorMatcher::SparseHashtable::insert( const UINT64* keys, UINT32 first, UINT32 N, int stride )
 {
-  return table[(size_t)(index >> 5)].query( (int) ( index & 31 ), Size );
-}
+  /* added[j] is the number of new codes in the buckets before j */
+  std::vector<UINT32> added( offsets.size(), 0 );
+  for ( UINT32 i = 0; i < N; i++ )
+    added[(size_t) keys[(size_t) i * stride] + 1]++;
 
-/* constructor */
-BinaryDescriptorMatcher::BucketGroup::BucketGroup(bool needAllocateGroup)
-{
-  empty = 0;
-  if (needAllocateGroup)
-    group = std::vector < uint32_t > ( 2, 0 );
-  else
-    group = std::vector < uint32_t > ( 0, 0 );
-}
-
-/* destructor */
-BinaryDescriptorMatcher::BucketGroup::~BucketGroup()
-{
-}
+  for ( size_t j = 1; j < added.size(); j++ )
+    added[j] += added[j - 1];
 
-void BinaryDescriptorMatcher::BucketGroup::insert_value( std::vector<uint32_t>& vec, int index, UINT32 data )
-{
-  if( vec.size() > 1 )
+  /* new codes have greater indexes than the ones in the table, so they go
+   at the end of their bucket, as they would with a build of all the codes */
+  std::vector<UINT32> merged( entries.size() + N );
+  std::vector<UINT32> next( offsets.size() - 1 );
+  for ( size_t j = 0; j + 1 < offsets.size(); j++ )
   {
-    if( vec[0] == vec[1] )
-    {
-      vec[1] = (UINT32) ceil( vec[0] * 1.1 );
-      for ( int i = 0; i < (int) ( 2 + vec[1] - vec.size() ); i++ )
-        vec.push_back( 0 );
-
-    }
-
-    vec.insert( vec.begin() + 2 + index, data );
-    vec[2 + index] = data;
-    vec[0]++;
+    UINT32 count = offsets[j + 1] - offsets[j];
+    if( count > 0 )
+      memcpy( &merged[offsets[j] + added[j]], &entries[offsets[j]], count * sizeof(UINT32) );
+    next[j] = offsets[j] + added[j] + count;
   }
 
-  else
-  {
-    vec = std::vector < uint32_t > ( 3, 0 );
-    vec[0] = 1;
-    vec[1] = 1;
-    vec[2] = data;
-  }
-}
+  for ( UINT32 i = 0; i < N; i++ )
+    merged[next[(size_t) keys[(size_t) i * stride]]++] = first + i;
 
-void BinaryDescriptorMatcher::BucketGroup::push_value( std::vector<uint32_t>& vec, UINT32 Data )
-{
-  if( vec.size() > 0 )
-  {
-    if( vec[0] == vec[1] )
-    {
-      vec[1] = (UINT32) std::max( ceil( vec[1] * ARRAY_RESIZE_FACTOR ), vec[1] + ARRAY_RESIZE_ADD_FACTOR );
-      for ( int i = 0; i < (int) ( 2 + vec[1] - vec.size() ); i++ )
-        vec.push_back( 0 );
-    }
-
-    vec[2 + vec[0]] = Data;
-    vec[0]++;
-
-  }
-
-  else
-  {
-    vec = std::vector < uint32_t > ( 2 + (uint32_t) ARRAY_RESIZE_ADD_FACTOR, 0 );
-    vec[0] = 1;
-    vec[1] = 1;
-    vec[2] = Data;
-  }
-}
-
-/* insert data into the bucket */
-void BinaryDescriptorMatcher::BucketGroup::insert( int subindex, UINT32 data )
-{
-  if( group.size() == 0 )
-  {
-    push_value( group, 0 );
-  }
-
-  UINT32 lowerbits = ( (UINT32) 1 << subindex ) - 1;
-  int end = popcnt( empty & lowerbits );
-
-  if( ! ( empty & ( (UINT32) 1 << subindex ) ) )
-  {
-    insert_value( group, end, group[end + 2] );
-    empty |= (UINT32) 1 << subindex;
-  }
-
-  int totones = popcnt( empty );
-  insert_value( group, totones + 1 + group[2 + end + 1], data );
-
-  for ( int i = end + 1; i < totones + 1; i++ )
-    group[2 + i]++;
+  for ( size_t j = 0; j < offsets.size(); j++ )
+    offsets[j] += added[j];
+  entries.swap( merged );
 }
 
-/* perform a query to the bucket */
-UINT32* BinaryDescriptorMatcher::BucketGroup::query( int subindex, int *size )
+/* query data */
+const UINT32* BinaryDescriptorMatcher::SparseHashtable::query( UINT64 index, int *Size ) const
 {
-  if( empty & ( (UINT32) 1 << subindex ) )
+  if( offsets.empty() || entries.empty() )
   {
-    UINT32 lowerbits = ( (UINT32) 1 << subindex ) - 1;
-    int end = popcnt( empty & lowerbits );
-    int totones = popcnt( empty );
-
-    *size = group[2 + end + 1] - group[2 + end];
-    return & ( * ( group.begin() + 2 + totones + 1 + (int) group[2 + end] ) );
-  }
-
-  else
-  {
-    *size = 0;
+    *Size = 0;
     return NULL;
   }
+
+  *Size = (int) ( offsets[(size_t) index + 1] - offsets[(size_t) index] );
+  return &entries[0] + offsets[(size_t) index];
 }
 
 }
 }
-
@@ -44,6 +44,7 @@
 #define __OPENCV_BITOPTS_HPP
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/hal.hpp"
 
 #ifdef _MSC_VER
 # include <intrin.h>
@@ -54,49 +55,19 @@
 
 #endif
 
-/* LUT */
-const int lookup[] =
-{
-    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
-    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-    3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-    3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-    3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-    3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-    4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8
-};
-
 namespace cv
 {
 namespace line_descriptor
 {
-/*matching function */
-inline int match( UINT8*P, UINT8*Q, int codelb )
+/* matching function: Hamming distance between two codes of codelb bytes, computed by the
+ popcount kernels of core (vectorized where the platform allows it) */
+inline int match( const UINT8*P, const UINT8*Q, int codelb )
 {
-    int i, output = 0;
-    for( i = 0; i <= codelb - 16; i += 16 )
-    {
-        output += popcnt( *(UINT32*) (P+i) ^ *(UINT32*) (Q+i) ) +
-                  popcnt( *(UINT32*) (P+i+4) ^ *(UINT32*) (Q+i+4) ) +
-                  popcnt( *(UINT32*) (P+i+8) ^ *(UINT32*) (Q+i+8) ) +
-                  popcnt( *(UINT32*) (P+i+12) ^ *(UINT32*) (Q+i+12) );
-    }
-    for( ; i < codelb; i++ )
-        output += lookup[P[i] ^ Q[i]];
-    return output;
+    return cv::hal::normHamming( P, Q, codelb );
 }
 
 /* splitting function (b <= 64) */
-inline void split( UINT64 *chunks, UINT8 *code, int m, int mplus, int b )
+inline void split( UINT64 *chunks, const UINT8 *code, int m, int mplus, int b )
 {
   UINT64 temp = 0x0;
   int nbits = 0;
@@ -387,3 +387,42 @@ TEST( BinaryDescriptor, no_lines_found )
   binDescriptor->detect(Image, keyLines);
   ASSERT_EQ(keyLines.size(), 0u);
 }
+
+/* octaves and lines are processed in parallel, and line detectors are reused across
+ calls: lines and descriptors must not depend on the number of threads or on previous calls */
+TEST( BinaryDescriptor, threads_and_reuse )
+{
+  std::string imgFilename = std::string( cvtest::TS::ptr()->get_data_path() ) + LINE_DESCRIPTOR_DIR + "/" + IMAGE_FILENAME;
+  Mat img = imread( imgFilename, IMREAD_GRAYSCALE );
+  ASSERT_FALSE( img.empty() ) << "Unable to load " << imgFilename;
+
+  Ptr<BinaryDescriptor> bd = BinaryDescriptor::createBinaryDescriptor();
+  std::vector<KeyLine> keylines, keylinesSingle;
+  Mat descriptors, descriptorsSingle;
+
+  /* a first call on a different image fills the buffers of line detectors */
+  Mat other;
+  resize( img, other, Size(), 0.5, 0.5 );
+  ( *bd )( other, Mat(), keylines, descriptors );
+
+  ( *bd )( img, Mat(), keylines, descriptors );
+
+  int threads = getNumThreads();
+  setNumThreads( 1 );
+  Ptr<BinaryDescriptor> bdSingle = BinaryDescriptor::createBinaryDescriptor();
+  ( *bdSingle )( img, Mat(), keylinesSingle, descriptorsSingle );
+  setNumThreads( threads );
+
+  ASSERT_FALSE( keylines.empty() );
+  ASSERT_EQ( keylinesSingle.size(), keylines.size() );
+  for ( size_t i = 0; i < keylines.size(); i++ )
+  {
+    EXPECT_EQ( keylinesSingle[i].octave, keylines[i].octave );
+    EXPECT_EQ( keylinesSingle[i].class_id, keylines[i].class_id );
+    EXPECT_EQ( keylinesSingle[i].startPointX, keylines[i].startPointX );
+    EXPECT_EQ( keylinesSingle[i].startPointY, keylines[i].startPointY );
+    EXPECT_EQ( keylinesSingle[i].endPointX, keylines[i].endPointX );
+    EXPECT_EQ( keylinesSingle[i].endPointY, keylines[i].endPointY );
+  }
+  EXPECT_EQ( 0, cvtest::norm( descriptors, descriptorsSingle, NORM_HAMMING ) );
+}
@@ -577,3 +577,109 @@ TEST( BinaryDescriptor_Matcher, regression)
   CV_BinaryDescriptorMatcherTest test( 0.01f );
   test.safe_run();
 }
+
+/* descriptors added after a training keep the indexes given by add(), and removed images are not matched anymore */
+TEST( BinaryDescriptor_Matcher, incremental_add_remove )
+{
+  RNG rng( 0 );
+  Mat first( 100, 32, CV_8UC1 ), second( 100, 32, CV_8UC1 );
+  rng.fill( first, RNG::UNIFORM, Scalar( 0 ), Scalar( 256 ) );
+  rng.fill( second, RNG::UNIFORM, Scalar( 0 ), Scalar( 256 ) );
+
+  Ptr<BinaryDescriptorMatcher> matcher = BinaryDescriptorMatcher::createBinaryDescriptorMatcher();
+  std::vector<Mat> descriptors( 1, first );
+  matcher->add( descriptors );
+  matcher->train();
+  descriptors[0] = second;
+  matcher->add( descriptors );
+
+  std::vector<DMatch> matches;
+  matcher->match( second, matches );
+  ASSERT_EQ( second.rows, (int) matches.size() );
+  for ( int i = 0; i < (int) matches.size(); i++ )
+  {
+    EXPECT_EQ( i, matches[i].queryIdx );
+    EXPECT_EQ( first.rows + i, matches[i].trainIdx );
+    EXPECT_EQ( 1, matches[i].imgIdx );
+    EXPECT_EQ( 0.f, matches[i].distance );
+  }
+
+  matcher->remove( 1 );
+  matches.clear();
+  matcher->match( second, matches );
+  for ( int i = 0; i < (int) matches.size(); i++ )
+  {
+    EXPECT_EQ( 0, matches[i].imgIdx );
+    EXPECT_LT( matches[i].trainIdx, first.rows );
+    EXPECT_GT( matches[i].distance, 0.f );
+  }
+}
+
+/* an image without descriptors does not take the descriptors of the next image, and removing any image only
+ removes its own descriptors */
+TEST( BinaryDescriptor_Matcher, remove_with_empty_image )
+{
+  RNG rng( 0 );
+  Mat first( 100, 32, CV_8UC1 ), second( 100, 32, CV_8UC1 );
+  rng.fill( first, RNG::UNIFORM, Scalar( 0 ), Scalar( 256 ) );
+  rng.fill( second, RNG::UNIFORM, Scalar( 0 ), Scalar( 256 ) );
+  Mat query;
+  vconcat( first, second, query );
+
+  std::vector<Mat> descriptors;
+  descriptors.push_back( first );
+  descriptors.push_back( Mat( 0, 32, CV_8UC1 ) );
+  descriptors.push_back( second );
+
+  /* images 0 and 2 are the ones with descriptors */
+  for ( int removedImg = -1; removedImg < 3; removedImg++ )
+  {
+    Ptr<BinaryDescriptorMatcher> matcher = BinaryDescriptorMatcher::createBinaryDescriptorMatcher();
+    matcher->add( descriptors );
+    matcher->train();
+    if( removedImg >= 0 )
+      matcher->remove( removedImg );
+
+    std::vector<DMatch> matches;
+    matcher->match( query, matches );
+    int found[3] = { 0, 0, 0 };
+    for ( int i = 0; i < (int) matches.size(); i++ )
+    {
+      const DMatch& dm = matches[i];
+      ASSERT_TRUE( dm.imgIdx == 0 || dm.imgIdx == 2 ) << "removed image " << removedImg;
+      EXPECT_NE( removedImg, dm.imgIdx );
+      EXPECT_EQ( dm.imgIdx == 0, dm.trainIdx < first.rows ) << "removed image " << removedImg;
+      if( dm.distance == 0.f )
+      {
+        EXPECT_EQ( dm.queryIdx, dm.trainIdx );
+        found[dm.imgIdx]++;
+      }
+    }
+    EXPECT_EQ( removedImg == 0 ? 0 : first.rows, found[0] ) << "removed image " << removedImg;
+    EXPECT_EQ( removedImg == 2 ? 0 : second.rows, found[2] ) << "removed image " << removedImg;
+  }
+}
+
+/* the index built on train descriptors is reused only while they do not change */
+TEST( BinaryDescriptor_Matcher, train_index_reuse )
+{
+  RNG rng( 0 );
+  Mat query( 50, 32, CV_8UC1 );
+  rng.fill( query, RNG::UNIFORM, Scalar( 0 ), Scalar( 256 ) );
+  Mat train = query.clone();
+
+  Ptr<BinaryDescriptorMatcher> matcher = BinaryDescriptorMatcher::createBinaryDescriptorMatcher();
+  std::vector<DMatch> matches;
+  matcher->match( query, train, matches );
+  ASSERT_EQ( query.rows, (int) matches.size() );
+  EXPECT_EQ( 0, matches[0].trainIdx );
+  EXPECT_EQ( 0.f, matches[0].distance );
+
+  /* change train descriptors in place */
+  train.at<uchar>( 0, 0 ) ^= 0xFF;
+  matches.clear();
+  matcher->match( query, train, matches );
+  ASSERT_EQ( query.rows, (int) matches.size() );
+  EXPECT_EQ( 0, matches[0].trainIdx );
+  EXPECT_EQ( 8.f, matches[0].distance );
+}
@@ -233,6 +233,14 @@ class CvHaarEvaluator : public CvFeatureEvaluator
     float getInitMean() const;
     float getInitSigma() const;
 
+    /** @brief Appends the rectangle corners of the feature to a flat evaluation table
+    @param imgSize Size of the samples the table will be used on
+    @param step Row step of the samples, in elements
+    @param ofs Receives four corner offsets (relative to the sample origin) per area
+    @param weights Receives one weight per area
+     */
+    void compile( Size imgSize, size_t step, std::vector<int>& ofs, std::vector<float>& weights ) const;
+
    private:
     int m_type;
     int m_numAreas;
@@ -273,6 +281,39 @@ class CvHaarEvaluator : public CvFeatureEvaluator
 
   virtual void generateFeatures( int numFeatures );
 
+  /** @brief Features compiled into a flat table of corner offsets and area weights.
+
+  The table is valid for every sample sharing the size, row step and depth it was compiled for,
+  e.g. all the ROIs taken by a sampler from the same frame-level integral image.
+   */
+  struct FeatureTable
+  {
+    Size imgSize;
+    size_t step;
+    int depth;
+    std::vector<int> ofs;        //!< 4 corner offsets per area
+    std::vector<float> weights;  //!< scaled weight per area
+    std::vector<int> areaStart;  //!< index of the first area of each feature, size is numFeatures + 1
+  };
+
+  /** @brief Compiles a subset of the features for samples laid out like sample
+  @param featureIdx Indices of the features to compile, all the features if empty
+  @param sample A sample (integral image or ROI of an integral image)
+  @param table The compiled table
+   */
+  void compileFeatures( const std::vector<int>& featureIdx, const Mat& sample, FeatureTable& table ) const;
+
+  /** @brief Checks whether a compiled table can be used on a sample */
+  static bool isCompatible( const FeatureTable& table, const Mat& sample );
+
+  /** @brief Evaluates all the features of a compiled table on a sample
+  @param table The compiled table
+  @param sample The sample, must be compatible with the table
+  @param result Output responses, one per compiled feature
+  @param resultStep Distance between two consecutive responses in result, in elements
+   */
+  static void evalFeatures( const FeatureTable& table, const Mat& sample, float* result, size_t resultStep = 1 );
+
  protected:
   bool isIntegral;
 
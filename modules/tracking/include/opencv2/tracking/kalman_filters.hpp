@@ -114,6 +114,23 @@ public:
     * @param z_k - measurement vector.
     */
     virtual void measurementFunction( const Mat& x_k, const Mat& n_k, Mat& z_k ) = 0;
+
+    /** The function for computing the next states of all the sigma points in one call.
+    * The default implementation calls stateConversionFunction for each column.
+    * Override it to evaluate the whole set at once.
+    * @param X_k - previous states, one sigma point per column,
+    * @param u_k - control vector,
+    * @param V_k - noise vectors, one per column, or a single column shared by all the sigma points,
+    * @param X_kplus1 - next states, one per column, preallocated with the same number of columns as X_k.
+    */
+    virtual void stateConversionFunctionBatch( const Mat& X_k, const Mat& u_k, const Mat& V_k, Mat& X_kplus1 );
+    /** The function for computing the measurements of all the sigma points in one call.
+    * The default implementation calls measurementFunction for each column.
+    * @param X_k - states, one sigma point per column,
+    * @param N_k - noise vectors, one per column, or a single column shared by all the sigma points,
+    * @param Z_k - measurements, one per column, preallocated with the same number of columns as X_k.
+    */
+    virtual void measurementFunctionBatch( const Mat& X_k, const Mat& N_k, Mat& Z_k );
 };
 
 
@@ -222,6 +239,26 @@ CV_EXPORTS Ptr<UnscentedKalmanFilter> createUnscentedKalmanFilter( const Unscent
 */
 CV_EXPORTS Ptr<UnscentedKalmanFilter> createAugmentedUnscentedKalmanFilter( const AugmentedUnscentedKalmanFilterParams &params );
 
+/** @brief Performs the prediction step of a set of independent filters in parallel.
+
+* Useful when one small filter is run per tracked object. A model shared by several filters
+* must be safe to call from several threads at once.
+* @param filters - the filters,
+* @param controls - the control vectors, one per filter, or empty if the filters take no control,
+* @param states - the predicted estimates of the states, one per filter.
+*/
+CV_EXPORTS void predictFilters( const std::vector<Ptr<UnscentedKalmanFilter> >& filters, const std::vector<Mat>& controls,
+                                std::vector<Mat>& states );
+
+/** @brief Performs the correction step of a set of independent filters in parallel.
+
+* @param filters - the filters,
+* @param measurements - the current measurement vectors, one per filter,
+* @param states - the corrected estimates of the states, one per filter.
+*/
+CV_EXPORTS void correctFilters( const std::vector<Ptr<UnscentedKalmanFilter> >& filters, const std::vector<Mat>& measurements,
+                                std::vector<Mat>& states );
+
 } // tracking
 } // cv
 
@@ -1294,6 +1294,17 @@ public:
 
   CV_WRAP static Ptr<TrackerGOTURN> create();
 
+  /** @brief Updates a set of GOTURN trackers on the same frame with a single batched forward pass
+
+  The target and search patches of all the trackers are stacked into one batch and evaluated by the
+  network of the first tracker, instead of running one forward pass per tracker.
+  @param trackers Initialized GOTURN trackers
+  @param image The current frame
+  @param boundingBoxes The bounding boxes predicted for the trackers, in the same order
+  @return false if the image is empty or any tracker is not initialized
+   */
+  static bool updateBatch( const std::vector<Ptr<TrackerGOTURN> >& trackers, InputArray image, std::vector<Rect2d>& boundingBoxes );
+
   virtual ~TrackerGOTURN() {}
 };
 
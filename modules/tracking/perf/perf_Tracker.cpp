@@ -413,3 +413,53 @@ PERF_TEST_P(tracking, GOTURN, testing::Combine(TESTSET_NAMES, SEGMENTS))
   SANITY_CHECK(bbs_mat, 15, ERROR_RELATIVE);
 
 }
+
+//GOTURN needs goturn.prototxt and goturn.caffemodel in the working directory, see samples/goturnTracker.cpp
+#define GOTURN_TARGETS testing::Values(1, 4, 16)
+
+typedef perf::TestBaseWithParam<int> goturn_targets;
+
+static void initGoturnTargets( int numTargets, Mat& frame, vector<Ptr<TrackerGOTURN> >& trackers )
+{
+  frame.create( 480, 640, CV_8UC3 );
+  randu( frame, Scalar::all( 0 ), Scalar::all( 255 ) );
+  RNG rng( 0 );
+  for ( int i = 0; i < numTargets; i++ )
+  {
+    Rect2d bb( rng.uniform( 40, 520 ), rng.uniform( 40, 360 ), 60, 60 );
+    Ptr<TrackerGOTURN> tracker = TrackerGOTURN::create();
+    ASSERT_TRUE( tracker->init( frame, bb ) );
+    trackers.push_back( tracker );
+  }
+}
+
+PERF_TEST_P(goturn_targets, DISABLED_goturn_sequential, GOTURN_TARGETS)
+{
+  Mat frame;
+  vector<Ptr<TrackerGOTURN> > trackers;
+  initGoturnTargets( GetParam(), frame, trackers );
+  vector<Rect2d> bbs( trackers.size() );
+
+  TEST_CYCLE()
+  {
+    for ( size_t i = 0; i < trackers.size(); i++ )
+      trackers[i]->update( frame, bbs[i] );
+  }
+
+  SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(goturn_targets, DISABLED_goturn_batched, GOTURN_TARGETS)
+{
+  Mat frame;
+  vector<Ptr<TrackerGOTURN> > trackers;
+  initGoturnTargets( GetParam(), frame, trackers );
+  vector<Rect2d> bbs;
+
+  TEST_CYCLE()
+  {
+    TrackerGOTURN::updateBatch( trackers, frame, bbs );
+  }
+
+  SANITY_CHECK_NOTHING();
+}
@@ -0,0 +1,172 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2016, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "perf_precomp.hpp"
+#include "perf_mat_allocator.hpp"
+#include <algorithm>
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+
+/*
+ * End-to-end tracker benchmark on a synthetic moving-object sequence.
+ *
+ * Every TEST_CYCLE iteration is the update on one frame, so the perf framework reports per-frame timing.
+ * Throughput, per-frame latency percentiles, Mat allocations per frame and accuracy against the known
+ * ground truth are attached as test properties, available in the XML report (--gtest_output=xml).
+ */
+
+#define BENCHMARK_TRACKERS testing::Values("KCF", "MIL", "BOOSTING", "MEDIAN_FLOW", "TLD")
+
+typedef perf::TestBaseWithParam<string> tracker_benchmark;
+
+static Ptr<Tracker> createBenchmarkTracker( const string& name )
+{
+  if( name == "KCF" )
+    return TrackerKCF::create();
+  if( name == "MIL" )
+    return TrackerMIL::create();
+  if( name == "BOOSTING" )
+    return TrackerBoosting::create();
+  if( name == "MEDIAN_FLOW" )
+    return TrackerMedianFlow::create();
+  if( name == "TLD" )
+    return TrackerTLD::create();
+  if( name == "GOTURN" )
+    return TrackerGOTURN::create();
+  CV_Error( Error::StsBadArg, "Unknown tracker " + name );
+  return Ptr<Tracker>();
+}
+
+/* A textured object moving along a Lissajous path over a static textured background */
+static void generateSequence( int numFrames, Size frameSize, Size objectSize, vector<Mat>& frames, vector<Rect2d>& gt )
+{
+  RNG rng( 12345 );
+  Mat background( frameSize, CV_8UC3 );
+  rng.fill( background, RNG::UNIFORM, Scalar::all( 0 ), Scalar::all( 255 ) );
+  GaussianBlur( background, background, Size( 9, 9 ), 3 );
+
+  Mat object( objectSize, CV_8UC3 );
+  rng.fill( object, RNG::UNIFORM, Scalar::all( 0 ), Scalar::all( 255 ) );
+  GaussianBlur( object, object, Size( 3, 3 ), 1 );
+  rectangle( object, Rect( Point(), objectSize ), Scalar( 0, 0, 255 ), 3 );
+
+  Point2d center( frameSize.width / 2.0, frameSize.height / 2.0 );
+  Point2d amplitude( ( frameSize.width - objectSize.width ) / 2.0 - 10, ( frameSize.height - objectSize.height ) / 2.0 - 10 );
+  for ( int i = 0; i < numFrames; i++ )
+  {
+    double t = i * 0.02;
+    Point tl( cvRound( center.x + amplitude.x * sin( 3 * t ) - objectSize.width / 2.0 ),
+              cvRound( center.y + amplitude.y * sin( 2 * t ) - objectSize.height / 2.0 ) );
+    Mat frame = background.clone();
+    object.copyTo( frame( Rect( tl, objectSize ) ) );
+    frames.push_back( frame );
+    gt.push_back( Rect2d( tl.x, tl.y, objectSize.width, objectSize.height ) );
+  }
+}
+
+static double overlap( const Rect2d& a, const Rect2d& b )
+{
+  double unionArea = ( a | b ).area();
+  return unionArea > 0 ? ( a & b ).area() / unionArea : 0;
+}
+
+static void runTrackerBenchmark( TestBase& test, const string& trackerName, int numFrames )
+{
+  vector<Mat> frames;
+  vector<Rect2d> gt;
+  generateSequence( numFrames + 1, Size( 640, 480 ), Size( 60, 80 ), frames, gt );
+
+  Ptr<Tracker> tracker = createBenchmarkTracker( trackerName );
+  ASSERT_TRUE( tracker->init( frames[0], gt[0] ) );
+
+  vector<double> latencies;
+  double sumIoU = 0;
+  int failures = 0;
+  int frameIdx = 1;
+  Rect2d bb;
+
+  MatAllocationScope allocationScope;
+  TEST_CYCLE_N( numFrames )
+  {
+    int64 t = getTickCount();
+    bool found = tracker->update( frames[frameIdx], bb );
+    latencies.push_back( ( getTickCount() - t ) * 1000. / getTickFrequency() );
+
+    double iou = found ? overlap( bb, gt[frameIdx] ) : 0;
+    sumIoU += iou;
+    failures += iou > 0 ? 0 : 1;
+    frameIdx = frameIdx % numFrames + 1;
+  }
+  int allocations = allocationScope.counter.count;
+
+  int n = (int) latencies.size();
+  ASSERT_GT( n, 0 );
+  double total = 0;
+  for ( int i = 0; i < n; i++ )
+    total += latencies[i];
+  std::sort( latencies.begin(), latencies.end() );
+
+  test.RecordProperty( "tracker", trackerName.c_str() );
+  test.RecordProperty( "frames", n );
+  test.RecordProperty( "fps", format( "%.2f", n * 1000. / total ).c_str() );
+  test.RecordProperty( "latency_p50_ms", format( "%.3f", latencies[n / 2] ).c_str() );
+  test.RecordProperty( "latency_p99_ms", format( "%.3f", latencies[std::min( n - 1, n * 99 / 100 )] ).c_str() );
+  test.RecordProperty( "allocs_per_frame", format( "%.2f", (double) allocations / n ).c_str() );
+  test.RecordProperty( "mean_iou", format( "%.4f", sumIoU / n ).c_str() );
+  test.RecordProperty( "failure_rate", format( "%.4f", (double) failures / n ).c_str() );
+}
+
+PERF_TEST_P(tracker_benchmark, synthetic, BENCHMARK_TRACKERS)
+{
+  runTrackerBenchmark( *this, GetParam(), 200 );
+
+  SANITY_CHECK_NOTHING();
+}
+
+//GOTURN needs goturn.prototxt and goturn.caffemodel in the working directory
+PERF_TEST_P(tracker_benchmark, DISABLED_synthetic_goturn, testing::Values("GOTURN"))
+{
+  runTrackerBenchmark( *this, GetParam(), 200 );
+
+  SANITY_CHECK_NOTHING();
+}
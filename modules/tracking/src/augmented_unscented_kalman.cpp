@@ -125,8 +125,9 @@ class AugmentedUnscentedKalmanFilterImpl: public UnscentedKalmanFilter
     Mat transitionSPFuncValsCenter;             // set of state function values at sigma points minus estimate of state ( fc_i, i = 1..2*DP+1 ), DP x 2*DP+1
     Mat measurementSPFuncValsCenter;            // set of measurement function values at sigma points minus estimate of measurement ( hc_i, i = 1..2*DP+1 ), MP x 2*DP+1
 
-    Mat Wm;                                     // vector of weights for estimate mean, 2*DP+1 x 1
-    Mat Wc;                                     // matrix of weights for estimate covariance, 2*DP+1 x 2*DP+1
+    Mat Wm;                                     // vector of weights for estimate mean, 2*DAug+1 x 1
+    double Wc0;                                 // weight of the central sigma point for estimate covariance,
+    double Wci;                                 // weight of the other sigma points, Wc = diag( Wc0, Wci, ..., Wci )
 
     Mat gain;                                   // Kalman gain matrix (K), DP x MP
     Mat xyCov;                                  // estimate of the covariance between x* and y* (Sxy), DP x MP
@@ -135,7 +136,7 @@ class AugmentedUnscentedKalmanFilterImpl: public UnscentedKalmanFilter
     Mat r;                                      // zero vector of process noise for getting transitionSPFuncVals,
     Mat q;                                      // zero vector of measurement noise for getting measurementSPFuncVals
 
-    Mat getSigmaPoints(const Mat& mean, const Mat& covMatrix, double coef);
+    Mat covMatrixL;                             // Cholesky factor of the augmented error covariance used for sigma points, DAug x DAug
 
 public:
 
@@ -207,18 +208,16 @@ AugmentedUnscentedKalmanFilterImpl::AugmentedUnscentedKalmanFilterImpl(const Aug
     double tmp2Lambda = 0.5/tmpLambda;
 
     Wm = tmp2Lambda * Mat::ones( 2*DAug+1, 1, dataType );
-    Wc = tmp2Lambda * Mat::eye( 2*DAug+1, 2*DAug+1, dataType );
+    Wci = tmp2Lambda;
+    Wc0 = lambda/tmpLambda + 1.0 - alpha*alpha + beta;
 
     if ( dataType == CV_64F )
-    {
         Wm.at<double>(0,0) = lambda/tmpLambda;
-        Wc.at<double>(0,0) = lambda/tmpLambda + 1.0 - alpha*alpha + beta;
-    }
     else
-    {
         Wm.at<float>(0,0) = (float)(lambda/tmpLambda);
-        Wc.at<float>(0,0) = (float)(lambda/tmpLambda + 1.0 - alpha*alpha + beta);
-    }
+
+    sigmaPoints = Mat::zeros( DAug, 2*DAug+1, dataType );
+    covMatrixL = Mat::zeros( DAug, DAug, dataType );
 
 }
 
@@ -244,7 +243,7 @@ AugmentedUnscentedKalmanFilterImpl::~AugmentedUnscentedKalmanFilterImpl()
     measurementSPFuncValsCenter.release();
 
     Wm.release();
-    Wc.release();
+    covMatrixL.release();
 
     gain.release();
     xyCov.release();
@@ -255,66 +254,29 @@ AugmentedUnscentedKalmanFilterImpl::~AugmentedUnscentedKalmanFilterImpl()
 
 }
 
-Mat AugmentedUnscentedKalmanFilterImpl::getSigmaPoints(const Mat &mean, const Mat &covMatrix, double coef)
-{
-// x_0 = mean
-// x_i = mean + coef * cholesky( covMatrix ), i = 1..n
-// x_(i+n) = mean - coef * cholesky( covMatrix ), i = 1..n
-
-    int n = mean.rows;
-    Mat points = repeat(mean, 1, 2*n+1);
-
-    Mat covMatrixL = covMatrix.clone();
-
-// covMatrixL = cholesky( covMatrix )
-    if ( dataType == CV_64F )
-        choleskyDecomposition<double>(
-                    covMatrix.ptr<double>(), covMatrix.step, covMatrix.rows,
-                    covMatrixL.ptr<double>(), covMatrixL.step );
-    else if ( dataType == CV_32F )
-        choleskyDecomposition<float>(
-                    covMatrix.ptr<float>(), covMatrix.step, covMatrix.rows,
-                    covMatrixL.ptr<float>(), covMatrixL.step );
-
-    covMatrixL = coef * covMatrixL;
-
-    Mat p_plus = points( Rect( 1, 0, n, n ) );
-    Mat p_minus = points( Rect( n+1, 0, n, n ) );
-
-    add(p_plus, covMatrixL, p_plus);
-    subtract(p_minus, covMatrixL, p_minus);
-
-    return points;
-}
-
 Mat AugmentedUnscentedKalmanFilterImpl::predict(InputArray _control)
 {
     Mat control = _control.getMat();
 // get sigma points from xa* and Pa
-    sigmaPoints = getSigmaPoints( stateAug, errorCovAug, sqrt( tmpLambda ) );
+    computeSigmaPoints( stateAug, errorCovAug, sqrt( tmpLambda ), covMatrixL, sigmaPoints );
 
 // compute f-function values at sigma points
 // f_i = f(x_i[0:DP-1], control, x_i[DP:2*DP-1]), i = 0..2*DAug
-    Mat x, fx;
-    for ( int i = 0; i<2*DAug+1; i++)
-    {
-        x = sigmaPoints( Rect( i, 0, 1, DP) );
-        q = sigmaPoints( Rect( i, DP, 1, DP) );
-        fx = transitionSPFuncVals( Rect( i, 0, 1, DP) );
-        model->stateConversionFunction( x, control, q, fx );
-    }
+    Mat x = sigmaPoints( Rect( 0, 0, 2*DAug+1, DP ) );
+    q = sigmaPoints( Rect( 0, DP, 2*DAug+1, DP ) );
+    model->stateConversionFunctionBatch( x, control, q, transitionSPFuncVals );
 
 // compute the estimate of state as mean f-function value at sigma point
 // x* = SUM_{i=0}^{2*DAug}( Wm[i]*f_i )
-    state = transitionSPFuncVals * Wm;
+    gemm( transitionSPFuncVals, Wm, 1, noArray(), 0, state );
 
 // compute f-function values at sigma points minus estimate of state
 // fc_i = f_i - x*, i = 0..2*DAug
-    subtract(transitionSPFuncVals, repeat( state, 1, 2*DAug+1 ), transitionSPFuncValsCenter);
+    subtractColumnMean( transitionSPFuncVals, state, transitionSPFuncValsCenter );
 
 // compute the estimate of the state cross-covariance matrix
 // P = SUM_{i=0}^{2*DAug}( Wc[i]*fc_i*fc_i.t )
-    errorCov = transitionSPFuncValsCenter * Wc * transitionSPFuncValsCenter.t();
+    weightedSPCovariance( transitionSPFuncValsCenter, transitionSPFuncValsCenter, Wc0, Wci, errorCov );
 
     return state.clone();
 }
@@ -323,35 +285,28 @@ Mat AugmentedUnscentedKalmanFilterImpl::correct(InputArray _measurement)
 {
     Mat measurement = _measurement.getMat();
 // get sigma points from xa* and Pa
-    sigmaPoints = getSigmaPoints( stateAug, errorCovAug, sqrt( tmpLambda ) );
+    computeSigmaPoints( stateAug, errorCovAug, sqrt( tmpLambda ), covMatrixL, sigmaPoints );
 
 // compute h-function values at sigma points
 // h_i = h(x_i[0:DP-1], x_i[2*DP:DAug-1]), i = 0..2*DAug
-    Mat x, hx;
-    measurementEstimate.setTo(0);
-    for ( int i = 0; i<2*DAug+1; i++)
-    {
-        x = transitionSPFuncVals( Rect( i, 0, 1, DP) );
-        r = sigmaPoints( Rect( i, 2*DP, 1, MP) );
-        hx = measurementSPFuncVals( Rect( i, 0, 1, MP) );
-        model->measurementFunction( x, r, hx );
-    }
+    r = sigmaPoints( Rect( 0, 2*DP, 2*DAug+1, MP ) );
+    model->measurementFunctionBatch( transitionSPFuncVals, r, measurementSPFuncVals );
 
 // compute the estimate of measurement as mean h-function value at sigma point
 // y* = SUM_{i=0}^{2*DAug}( Wm[i]*h_i )
-    measurementEstimate = measurementSPFuncVals * Wm;
+    gemm( measurementSPFuncVals, Wm, 1, noArray(), 0, measurementEstimate );
 
 // compute h-function values at sigma points minus estimate of state
 // hc_i = h_i - y*, i = 0..2*DAug
-    subtract(measurementSPFuncVals, repeat( measurementEstimate, 1, 2*DAug+1 ), measurementSPFuncValsCenter);
+    subtractColumnMean( measurementSPFuncVals, measurementEstimate, measurementSPFuncValsCenter );
 
 // compute the estimate of the y* cross-covariance matrix
 // Syy = SUM_{i=0}^{2*DAug}( Wc[i]*hc_i*hc_i.t )
-    yyCov = measurementSPFuncValsCenter * Wc * measurementSPFuncValsCenter.t();
+    weightedSPCovariance( measurementSPFuncValsCenter, measurementSPFuncValsCenter, Wc0, Wci, yyCov );
 
 // compute the estimate of the covariance between x* and y*
 // Sxy = SUM_{i=0}^{2*DAug}( Wc[i]*fc_i*hc_i.t )
-    xyCov = transitionSPFuncValsCenter * Wc * measurementSPFuncValsCenter.t();
+    weightedSPCovariance( transitionSPFuncValsCenter, measurementSPFuncValsCenter, Wc0, Wci, xyCov );
 
 // compute the Kalman gain matrix
 // K = Sxy * Syy^(-1)
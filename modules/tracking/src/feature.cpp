@@ -754,6 +754,31 @@ float CvHaarEvaluator::FeatureHaar::getSum( const Mat& image, Rect imageROI ) co
   return value;
 }
 
+void CvHaarEvaluator::FeatureHaar::compile( Size imgSize, size_t step, std::vector<int>& ofs, std::vector<float>& weights ) const
+{
+  for ( int curArea = 0; curArea < m_numAreas; curArea++ )
+  {
+    const Rect& area = m_areas[curArea];
+    int OriginX = area.x;
+    int OriginY = area.y;
+
+    // same clipping as getSum
+    int Width = area.width;
+    int Height = area.height;
+    if( OriginX + Width >= imgSize.width - 1 )
+      Width = ( imgSize.width - 1 ) - OriginX;
+    if( OriginY + Height >= imgSize.height - 1 )
+      Height = ( imgSize.height - 1 ) - OriginY;
+
+    int top = (int) ( OriginY * step ), bottom = (int) ( ( OriginY + Height ) * step );
+    ofs.push_back( bottom + OriginX + Width );
+    ofs.push_back( top + OriginX );
+    ofs.push_back( top + OriginX + Width );
+    ofs.push_back( bottom + OriginX );
+    weights.push_back( m_scaleWeights[curArea] );
+  }
+}
+
 int CvHaarEvaluator::FeatureHaar::getNumAreas()
 {
   return m_numAreas;
@@ -769,6 +794,81 @@ const std::vector<Rect>& CvHaarEvaluator::FeatureHaar::getAreas() const
   return m_areas;
 }
 
+void CvHaarEvaluator::compileFeatures( const std::vector<int>& featureIdx, const Mat& sample, FeatureTable& table ) const
+{
+  CV_Assert( sample.channels() == 1 && ( sample.depth() == CV_32S || sample.depth() == CV_32F || sample.depth() == CV_64F ) );
+
+  table.imgSize = sample.size();
+  table.depth = sample.depth();
+  table.step = sample.step1();
+  table.ofs.clear();
+  table.weights.clear();
+  table.areaStart.clear();
+
+  int n = featureIdx.empty() ? (int) features.size() : (int) featureIdx.size();
+  table.ofs.reserve( n * 4 * 4 );
+  table.weights.reserve( n * 4 );
+  table.areaStart.reserve( n + 1 );
+  for ( int j = 0; j < n; j++ )
+  {
+    table.areaStart.push_back( (int) table.weights.size() );
+    const FeatureHaar& feature = features[featureIdx.empty() ? j : featureIdx[j]];
+    feature.compile( table.imgSize, table.step, table.ofs, table.weights );
+  }
+  table.areaStart.push_back( (int) table.weights.size() );
+}
+
+bool CvHaarEvaluator::isCompatible( const FeatureTable& table, const Mat& sample )
+{
+  return sample.depth() == table.depth && sample.size() == table.imgSize && sample.step1() == table.step && sample.channels() == 1;
+}
+
+template<typename T>
+static void evalFeaturesT( const CvHaarEvaluator::FeatureTable& table, const Mat& sample, float* result, size_t resultStep )
+{
+  const T* origin = sample.ptr<T>();
+  const int* ofs = &table.ofs[0];
+  const float* weights = &table.weights[0];
+  int n = (int) table.areaStart.size() - 1;
+
+  for ( int j = 0; j < n; j++ )
+  {
+    float res = 0.0f;
+    for ( int a = table.areaStart[j]; a < table.areaStart[j + 1]; a++ )
+    {
+      const int* o = ofs + a * 4;
+      res += static_cast<float>( origin[o[0]] + origin[o[1]] - origin[o[2]] - origin[o[3]] ) * weights[a];
+    }
+    result[j * resultStep] = res;
+  }
+}
+
+void CvHaarEvaluator::evalFeatures( const FeatureTable& table, const Mat& sample, float* result, size_t resultStep )
+{
+  CV_DbgAssert( isCompatible( table, sample ) );
+  if( table.weights.empty() )
+  {
+    for ( size_t j = 0; j + 1 < table.areaStart.size(); j++ )
+      result[j * resultStep] = 0.0f;
+    return;
+  }
+
+  switch ( table.depth )
+  {
+    case CV_32S:
+      evalFeaturesT<int>( table, sample, result, resultStep );
+      break;
+    case CV_32F:
+      evalFeaturesT<float>( table, sample, result, resultStep );
+      break;
+    case CV_64F:
+      evalFeaturesT<double>( table, sample, result, resultStep );
+      break;
+    default:
+      CV_Error( Error::StsUnsupportedFormat, "Integral image depth must be CV_32S, CV_32F or CV_64F" );
+  }
+}
+
 CvHOGFeatureParams::CvHOGFeatureParams()
 {
   maxCatCount = 0;
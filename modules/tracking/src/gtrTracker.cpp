@@ -130,19 +130,46 @@ bool TrackerGOTURNImpl::initImpl(const Mat& image, const Rect2d& boundingBox)
     return true;
 }
 
-bool TrackerGOTURNImpl::updateImpl(const Mat& image, Rect2d& boundingBox)
+static const int INPUT_SIZE = 227;
+
+//Crops rect from frame as if the frame was padded with BORDER_REPLICATE, padding only the patch instead of the whole frame
+static void getPatchReplicate(const Mat& frame, const Rect& rect, Mat& patch)
+{
+    Rect inner = rect & Rect(0, 0, frame.cols, frame.rows);
+    if (inner.area() == 0)
+    {
+        Mat framePadded;
+        int padX = std::max(-rect.x, rect.br().x - frame.cols) + 1;
+        int padY = std::max(-rect.y, rect.br().y - frame.rows) + 1;
+        copyMakeBorder(frame, framePadded, padY, padY, padX, padX, BORDER_REPLICATE);
+        framePadded(rect + Point(padX, padY)).copyTo(patch);
+        return;
+    }
+    copyMakeBorder(frame(inner), patch, inner.y - rect.y, rect.br().y - inner.br().y, inner.x - rect.x, rect.br().x - inner.br().x,
+                   BORDER_REPLICATE | BORDER_ISOLATED);
+}
+
+//Writes the patch into slot n of a N x 3 x H x W blob, same layout as dnn::blobFromImage(patch)
+static void patchToBlob(const Mat& patch, Mat& blob, int n)
+{
+    CV_Assert((patch.channels() == 3 || patch.channels() == 4) &&
+              blob.dims == 4 && blob.size[2] == patch.rows && blob.size[3] == patch.cols);
+    Mat image;
+    patch.convertTo(image, CV_32F);
+    // the alpha channel of BGRA frames goes to ch[3], which is not part of the blob
+    Mat ch[4];
+    for (int j = 0; j < 3; j++)
+        ch[2 - j] = Mat(patch.rows, patch.cols, CV_32F, blob.ptr(n, j));
+    split(image, ch);
+}
+
+void TrackerGOTURNImpl::preparePatches(const Mat& curFrame, Mat& tBlob, Mat& sBlob, int n, Rect2f& targetPatchRect)
 {
-    int INPUT_SIZE = 227;
-    //Using prevFrame & prevBB from model and curFrame GOTURN calculating curBB
-    Mat curFrame = image.clone();
     Mat prevFrame = ((TrackerGOTURNModel*)static_cast<TrackerModel*>(model))->getImage();
     Rect2d prevBB = ((TrackerGOTURNModel*)static_cast<TrackerModel*>(model))->getBoundingBox();
-    Rect2d curBB;
 
     float padTargetPatch = 2.0;
-    Rect2f searchPatchRect, targetPatchRect;
-    Point2f currCenter, prevCenter;
-    Mat prevFramePadded, curFramePadded;
+    Point2f prevCenter;
     Mat searchPatch, targetPatch;
 
     prevCenter.x = (float)(prevBB.x + prevBB.width / 2);
@@ -153,11 +180,10 @@ bool TrackerGOTURNImpl::updateImpl(const Mat& image, Rect2d& boundingBox)
     targetPatchRect.x = (float)(prevCenter.x - prevBB.width*padTargetPatch / 2.0 + targetPatchRect.width);
     targetPatchRect.y = (float)(prevCenter.y - prevBB.height*padTargetPatch / 2.0 + targetPatchRect.height);
 
-    copyMakeBorder(prevFrame, prevFramePadded, (int)targetPatchRect.height, (int)targetPatchRect.height, (int)targetPatchRect.width, (int)targetPatchRect.width, BORDER_REPLICATE);
-    targetPatch = prevFramePadded(targetPatchRect).clone();
-
-    copyMakeBorder(curFrame, curFramePadded, (int)targetPatchRect.height, (int)targetPatchRect.height, (int)targetPatchRect.width, (int)targetPatchRect.width, BORDER_REPLICATE);
-    searchPatch = curFramePadded(targetPatchRect).clone();
+    //targetPatchRect is expressed in the frame padded by its own size
+    Rect patchRect = Rect(targetPatchRect) - Point((int)targetPatchRect.width, (int)targetPatchRect.height);
+    getPatchReplicate(prevFrame, patchRect, targetPatch);
+    getPatchReplicate(curFrame, patchRect, searchPatch);
 
     //Preprocess
     //Resize
@@ -169,31 +195,119 @@ bool TrackerGOTURNImpl::updateImpl(const Mat& image, Rect2d& boundingBox)
     searchPatch = searchPatch - 128;
 
     //Convert to Float type
-    Mat targetBlob = dnn::blobFromImage(targetPatch);
-    Mat searchBlob = dnn::blobFromImage(searchPatch);
+    patchToBlob(targetPatch, tBlob, n);
+    patchToBlob(searchPatch, sBlob, n);
+}
 
-    net.setBlob(".data1", targetBlob);
-    net.setBlob(".data2", searchBlob);
+Mat TrackerGOTURNImpl::forward(const Mat& tBlob, const Mat& sBlob)
+{
+    net.setBlob(".data1", tBlob);
+    net.setBlob(".data2", sBlob);
 
     net.forward();
-    Mat resMat = net.getBlob("scale").reshape(1, 1);
-
-    curBB.x = targetPatchRect.x + (resMat.at<float>(0) * targetPatchRect.width / INPUT_SIZE) - targetPatchRect.width;
-    curBB.y = targetPatchRect.y + (resMat.at<float>(1) * targetPatchRect.height / INPUT_SIZE) - targetPatchRect.height;
-    curBB.width = (resMat.at<float>(2) - resMat.at<float>(0)) * targetPatchRect.width / INPUT_SIZE;
-    curBB.height = (resMat.at<float>(3) - resMat.at<float>(1)) * targetPatchRect.height / INPUT_SIZE;
+    return net.getBlob("scale").reshape(1, tBlob.size[0]);
+}
 
-    //Predicted BB
-    boundingBox = curBB;
+Rect2d TrackerGOTURNImpl::applyPrediction(const float* res, const Rect2f& targetPatchRect, const Mat& curFrame)
+{
+    Rect2d curBB;
+    curBB.x = targetPatchRect.x + (res[0] * targetPatchRect.width / INPUT_SIZE) - targetPatchRect.width;
+    curBB.y = targetPatchRect.y + (res[1] * targetPatchRect.height / INPUT_SIZE) - targetPatchRect.height;
+    curBB.width = (res[2] - res[0]) * targetPatchRect.width / INPUT_SIZE;
+    curBB.height = (res[3] - res[1]) * targetPatchRect.height / INPUT_SIZE;
 
     //Set new model image and BB from current frame
     ((TrackerGOTURNModel*)static_cast<TrackerModel*>(model))->setImage(curFrame);
     ((TrackerGOTURNModel*)static_cast<TrackerModel*>(model))->setBoudingBox(curBB);
 
+    return curBB;
+}
+
+bool TrackerGOTURNImpl::updateImpl(const Mat& image, Rect2d& boundingBox)
+{
+    //Using prevFrame & prevBB from model and curFrame GOTURN calculating curBB
+    int sz[] = { 1, 3, INPUT_SIZE, INPUT_SIZE };
+    targetBlob.create(4, sz, CV_32F);
+    searchBlob.create(4, sz, CV_32F);
+
+    Rect2f targetPatchRect;
+    preparePatches(image, targetBlob, searchBlob, 0, targetPatchRect);
+
+    Mat resMat = forward(targetBlob, searchBlob);
+
+    //Predicted BB
+    boundingBox = applyPrediction(resMat.ptr<float>(0), targetPatchRect, image);
+
     return true;
 }
 
+class PreparePatchesInvoker : public ParallelLoopBody
+{
+public:
+    PreparePatchesInvoker(const std::vector<TrackerGOTURNImpl*>& _trackers, const Mat& _image, Mat& _targetBlob, Mat& _searchBlob,
+                          std::vector<Rect2f>& _rects) :
+        trackers(_trackers), image(_image), targetBlob(_targetBlob), searchBlob(_searchBlob), rects(_rects)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        for (int i = range.start; i < range.end; i++)
+            trackers[i]->preparePatches(image, targetBlob, searchBlob, i, rects[i]);
+    }
+
+private:
+    const std::vector<TrackerGOTURNImpl*>& trackers;
+    const Mat& image;
+    Mat& targetBlob;
+    Mat& searchBlob;
+    std::vector<Rect2f>& rects;
+};
+
 }
 #endif // OPENCV_HAVE_DNN
 
+bool TrackerGOTURN::updateBatch(const std::vector<Ptr<TrackerGOTURN> >& trackers, InputArray _image, std::vector<Rect2d>& boundingBoxes)
+{
+#ifdef HAVE_OPENCV_DNN
+    boundingBoxes.clear();
+    if (_image.empty())
+        return false;
+    if (trackers.empty())
+        return true;
+
+    std::vector<gtr::TrackerGOTURNImpl*> impls(trackers.size());
+    for (size_t i = 0; i < trackers.size(); i++)
+    {
+        impls[i] = dynamic_cast<gtr::TrackerGOTURNImpl*>(trackers[i].get());
+        if (!impls[i] || !impls[i]->isInitialized())
+            return false;
+    }
+
+    //All the patches go through the network of the first tracker, the GOTURN weights are the same for every tracker
+    gtr::TrackerGOTURNImpl* first = impls[0];
+    Mat image = _image.getMat();
+    int n = (int)impls.size();
+    int sz[] = { n, 3, gtr::INPUT_SIZE, gtr::INPUT_SIZE };
+    first->targetBlob.create(4, sz, CV_32F);
+    first->searchBlob.create(4, sz, CV_32F);
+
+    std::vector<Rect2f> rects(n);
+    parallel_for_(Range(0, n), gtr::PreparePatchesInvoker(impls, image, first->targetBlob, first->searchBlob, rects));
+
+    Mat resMat = first->forward(first->targetBlob, first->searchBlob);
+
+    boundingBoxes.resize(n);
+    for (int i = 0; i < n; i++)
+        boundingBoxes[i] = impls[i]->applyPrediction(resMat.ptr<float>(i), rects[i], image);
+
+    return true;
+#else
+    (void)(trackers);
+    (void)(_image);
+    (void)(boundingBoxes);
+    CV_ErrorNoReturn(cv::Error::StsNotImplemented , "to use GOTURN, the tracking module needs to be built with opencv_dnn !");
+#endif
+}
+
 }
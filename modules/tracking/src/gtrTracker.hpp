@@ -69,9 +69,21 @@ public:
     bool initImpl(const Mat& image, const Rect2d& boundingBox);
     bool updateImpl(const Mat& image, Rect2d& boundingBox);
 
+    bool isInitialized() const { return isInit; }
+
+    //Crops, resizes and normalizes the target and search patches of the current frame into slot n of the input blobs
+    void preparePatches(const Mat& curFrame, Mat& targetBlob, Mat& searchBlob, int n, Rect2f& targetPatchRect);
+    //Converts the network output to the new bounding box and updates the model
+    Rect2d applyPrediction(const float* res, const Rect2f& targetPatchRect, const Mat& curFrame);
+    //Sets the input blobs and returns the network output, one row per batch element
+    Mat forward(const Mat& targetBlob, const Mat& searchBlob);
+
     TrackerGOTURN::Params params;
 
     dnn::Net net;
+
+    //Input blobs reused across frames, N x 3 x INPUT_SIZE x INPUT_SIZE
+    Mat targetBlob, searchBlob;
 };
 
 }
@@ -135,61 +135,97 @@ void ClfMilBoost::init( const ClfMilBoost::Params &parameters )
   _counter = 0;
 }
 
-void ClfMilBoost::update( const Mat& posx, const Mat& negx )
+class Parallel_trainWeakClassifiers : public cv::ParallelLoopBody
 {
-  int numneg = negx.rows;
-  int numpos = posx.rows;
-
-  // compute ftrs
-  //if( !posx.ftrsComputed() )
-  //  Ftr::compute( posx, _ftrs );
-  //if( !negx.ftrsComputed() )
-  //  Ftr::compute( negx, _ftrs );
-
-  // initialize H
-  static std::vector<float> Hpos, Hneg;
-  Hpos.clear();
-  Hneg.clear();
-  Hpos.resize( posx.rows, 0.0f ), Hneg.resize( negx.rows, 0.0f );
-
-  _selectors.clear();
-  std::vector<float> posw( posx.rows ), negw( negx.rows );
-  std::vector<std::vector<float> > pospred( _weakclf.size() ), negpred( _weakclf.size() );
+ private:
+  std::vector<ClfOnlineStump*>& weakclf;
+  const Mat& posx;
+  const Mat& negx;
+  std::vector<std::vector<float> >& pospred;
+  std::vector<std::vector<float> >& negpred;
+ public:
+  Parallel_trainWeakClassifiers( std::vector<ClfOnlineStump*>& clf, const Mat& pos, const Mat& neg, std::vector<std::vector<float> >& ppred,
+                                 std::vector<std::vector<float> >& npred ) :
+      weakclf( clf ),
+      posx( pos ),
+      negx( neg ),
+      pospred( ppred ),
+      negpred( npred )
+  {
+  }
 
-  // train all weak classifiers without weights
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-  for ( int m = 0; m < _myParams._numFeat; m++ )
+  virtual void operator()( const cv::Range &r ) const
   {
-    _weakclf[m]->update( posx, negx );
-    pospred[m] = _weakclf[m]->classifySetF( posx );
-    negpred[m] = _weakclf[m]->classifySetF( negx );
+    for ( int m = r.start; m < r.end; m++ )
+    {
+      weakclf[m]->update( posx, negx );
+      pospred[m] = weakclf[m]->classifySetF( posx );
+      negpred[m] = weakclf[m]->classifySetF( negx );
+    }
   }
+};
 
-  // pick the best features
-  for ( int s = 0; s < _myParams._numSel; s++ )
+class Parallel_likelihood : public cv::ParallelLoopBody
+{
+ private:
+  const std::vector<float>& Hpos;
+  const std::vector<float>& Hneg;
+  const std::vector<std::vector<float> >& pospred;
+  const std::vector<std::vector<float> >& negpred;
+  std::vector<float>& likl;
+  ClfMilBoost& boost;
+ public:
+  Parallel_likelihood( ClfMilBoost& b, const std::vector<float>& hpos, const std::vector<float>& hneg, const std::vector<std::vector<float> >& ppred,
+                       const std::vector<std::vector<float> >& npred, std::vector<float>& l ) :
+      Hpos( hpos ),
+      Hneg( hneg ),
+      pospred( ppred ),
+      negpred( npred ),
+      likl( l ),
+      boost( b )
   {
+  }
 
-    // compute errors/likl for all weak clfs
-    std::vector<float> poslikl( _weakclf.size(), 1.0f ), neglikl( _weakclf.size() ), likl( _weakclf.size() );
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-    for ( int w = 0; w < (int) _weakclf.size(); w++ )
+  virtual void operator()( const cv::Range &r ) const
+  {
+    int numpos = (int) Hpos.size();
+    int numneg = (int) Hneg.size();
+    for ( int w = r.start; w < r.end; w++ )
     {
       float lll = 1.0f;
       for ( int j = 0; j < numpos; j++ )
-        lll *= ( 1 - sigmoid( Hpos[j] + pospred[w][j] ) );
-      poslikl[w] = (float) -log( 1 - lll + 1e-5 );
+        lll *= ( 1 - boost.sigmoid( Hpos[j] + pospred[w][j] ) );
+      float poslikl = (float) -log( 1 - lll + 1e-5 );
 
       lll = 0.0f;
       for ( int j = 0; j < numneg; j++ )
-        lll += (float) -log( 1e-5f + 1 - sigmoid( Hneg[j] + negpred[w][j] ) );
-      neglikl[w] = lll;
+        lll += (float) -log( 1e-5f + 1 - boost.sigmoid( Hneg[j] + negpred[w][j] ) );
+      float neglikl = lll;
 
-      likl[w] = poslikl[w] / numpos + neglikl[w] / numneg;
+      likl[w] = poslikl / numpos + neglikl / numneg;
     }
+  }
+};
+
+void ClfMilBoost::update( const Mat& posx, const Mat& negx )
+{
+  // initialize H
+  std::vector<float> Hpos( posx.rows, 0.0f ), Hneg( negx.rows, 0.0f );
+
+  _selectors.clear();
+  std::vector<std::vector<float> > pospred( _weakclf.size() ), negpred( _weakclf.size() );
+
+  // train all weak classifiers without weights
+  parallel_for_( Range( 0, _myParams._numFeat ), Parallel_trainWeakClassifiers( _weakclf, posx, negx, pospred, negpred ) );
+
+  // pick the best features
+  std::vector<float> likl( _weakclf.size() );
+  for ( int s = 0; s < _myParams._numSel; s++ )
+  {
+
+    // compute errors/likl for all weak clfs
+    likl.resize( _weakclf.size() );
+    parallel_for_( Range( 0, (int) _weakclf.size() ), Parallel_likelihood( *this, Hpos, Hneg, pospred, negpred, likl ) );
 
     // pick best weak clf
     std::vector<int> order;
@@ -204,14 +240,8 @@ void ClfMilBoost::update( const Mat& posx, const Mat& negx )
       }
 
     // update H = H + h_m
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
     for ( int k = 0; k < posx.rows; k++ )
       Hpos[k] += pospred[_selectors[s]][k];
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
     for ( int k = 0; k < negx.rows; k++ )
       Hneg[k] += negpred[_selectors[s]][k];
 
@@ -235,9 +265,6 @@ std::vector<float> ClfMilBoost::classify( const Mat& x, bool logR )
   for ( uint w = 0; w < _selectors.size(); w++ )
   {
     tr = _weakclf[_selectors[w]]->classifySetF( x );
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
     for ( int j = 0; j < numsamples; j++ )
     {
       res[j] += tr[j];
@@ -247,9 +274,6 @@ std::vector<float> ClfMilBoost::classify( const Mat& x, bool logR )
   // return probabilities or log odds ratio
   if( !logR )
   {
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
     for ( int j = 0; j < (int) res.size(); j++ )
     {
       res[j] = sigmoid( res[j] );
@@ -368,9 +392,6 @@ inline std::vector<float> ClfOnlineStump::classifySetF( const Mat& x )
 {
   std::vector<float> res( x.rows );
 
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
   for ( int k = 0; k < (int) res.size(); k++ )
   {
     res[k] = classifyF( x, k );
@@ -101,6 +101,23 @@ namespace cv
         return success;
     }
 
+    /* Sigma points of the unscented transform
+     The function fills the preallocated n x 2*n+1 matrix points with
+     x_0 = mean, x_i = mean + coef*L_i, x_(i+n) = mean - coef*L_i, i = 1..n,
+     where L_i are the columns of the Cholesky factor of covMatrix, computed in the preallocated covMatrixL.
+    */
+    void computeSigmaPoints( const Mat& mean, const Mat& covMatrix, double coef, Mat& covMatrixL, Mat& points );
+
+    /* Weighted sum of outer products of the centered sigma point function values
+     dst = SUM_{i}( Wc[i]*a_i*b_i.t ), with the diagonal weights Wc = diag( w0, w, ..., w ).
+     The sum is computed as w*A*B.t plus a rank-one correction for the central point,
+     so the dense (2*n+1) x (2*n+1) weight matrix is never built.
+    */
+    void weightedSPCovariance( const Mat& A, const Mat& B, double w0, double w, Mat& dst );
+
+    /* dst_i = src_i - mean for each column i of src */
+    void subtractColumnMean( const Mat& src, const Mat& mean, Mat& dst );
+
     } // tracking
 } // cv
 
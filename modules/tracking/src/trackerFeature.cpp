@@ -195,75 +195,102 @@ bool TrackerFeatureHAAR::swapFeature( int source, int target )
   return true;
 }
 
-bool TrackerFeatureHAAR::extractSelected( const std::vector<int> selFeatures, const std::vector<Mat>& images, Mat& response )
-{
-  if( images.empty() )
-  {
-    return false;
-  }
-
-  int numFeatures = featureEvaluator->getNumFeatures();
-  int numSelFeatures = (int)selFeatures.size();
-
-  //response = Mat_<float>( Size( images.size(), numFeatures ) );
-  response.create( Size( (int)images.size(), numFeatures ), CV_32F );
-  response.setTo( 0 );
-
-  //double t = getTickCount();
-  //for each sample compute #n_feature -> put each feature (n Rect) in response
-  for ( size_t i = 0; i < images.size(); i++ )
-  {
-    int c = images[i].cols;
-    int r = images[i].rows;
-    for ( int j = 0; j < numSelFeatures; j++ )
-    {
-      float res = 0;
-      //const feat
-      CvHaarEvaluator::FeatureHaar& feature = featureEvaluator->getFeatures( selFeatures[j] );
-      feature.eval( images[i], Rect( 0, 0, c, r ), &res );
-      //( Mat_<float>( response ) )( j, i ) = res;
-      response.at<float>( selFeatures[j], (int)i ) = res;
-    }
-  }
-  //t = ( (double) getTickCount() - t ) / getTickFrequency();
-  //std::cout << "StrongClassifierDirectSelection time " << t << std::endl;
-
-  return true;
-}
-
 class Parallel_compute : public cv::ParallelLoopBody
 {
  private:
   Ptr<CvHaarEvaluator> featureEvaluator;
-  std::vector<Mat> images;
-  Mat response;
-  //std::vector<CvHaarEvaluator::FeatureHaar> features;
+  const CvHaarEvaluator::FeatureTable& table;
+  const std::vector<int>& selFeatures;
+  const std::vector<Mat>& images;
+  Mat& response;
  public:
-  Parallel_compute( Ptr<CvHaarEvaluator>& fe, const std::vector<Mat>& img, Mat& resp ) :
+  Parallel_compute( Ptr<CvHaarEvaluator>& fe, const CvHaarEvaluator::FeatureTable& t, const std::vector<int>& sel, const std::vector<Mat>& img,
+                    Mat& resp ) :
       featureEvaluator( fe ),
+      table( t ),
+      selFeatures( sel ),
       images( img ),
       response( resp )
   {
-
-    //features = featureEvaluator->getFeatures();
   }
 
   virtual void operator()( const cv::Range &r ) const
   {
-    for ( register int jf = r.start; jf != r.end; ++jf )
+    int numSelFeatures = (int) table.areaStart.size() - 1;
+    if( numSelFeatures <= 0 )
+      return;
+    size_t respStep = response.step1();
+    std::vector<float> buf( numSelFeatures );
+    for ( int jf = r.start; jf != r.end; ++jf )
     {
-      int cols = images[jf].cols;
-      int rows = images[jf].rows;
-      for ( int j = 0; j < featureEvaluator->getNumFeatures(); j++ )
+      const Mat& img = images[jf];
+      if( CvHaarEvaluator::isCompatible( table, img ) )
+      {
+        if( selFeatures.empty() )
+        {
+          // responses of sample jf are the column jf of the response
+          CvHaarEvaluator::evalFeatures( table, img, response.ptr<float>( 0 ) + jf, respStep );
+          continue;
+        }
+        CvHaarEvaluator::evalFeatures( table, img, &buf[0] );
+      }
+      else
       {
-        float res = 0;
-        featureEvaluator->getFeatures()[j].eval( images[jf], Rect( 0, 0, cols, rows ), &res );
-        ( Mat_<float>( response ) )( j, jf ) = res;
+        // samples not laid out like the first one (e.g. not an integral image ROI) go through the generic path
+        for ( int j = 0; j < numSelFeatures; j++ )
+        {
+          int idx = selFeatures.empty() ? j : selFeatures[j];
+          featureEvaluator->getFeatures( idx ).eval( img, Rect( 0, 0, img.cols, img.rows ), &buf[j] );
+        }
       }
+      for ( int j = 0; j < numSelFeatures; j++ )
+        response.at<float>( selFeatures.empty() ? j : selFeatures[j], jf ) = buf[j];
     }
   }
 };
 
+/* Compiles the features once for the layout of the first sample: every sample taken from the same
+ * frame-level integral image shares it, so the responses reduce to lookups in a flat offset table. */
+static void computeHaarResponses( Ptr<CvHaarEvaluator>& featureEvaluator, const std::vector<int>& selFeatures, const std::vector<Mat>& images,
+                                  Mat& response )
+{
+  CvHaarEvaluator::FeatureTable table;
+  const Mat& first = images[0];
+  int depth = first.depth();
+  if( first.channels() == 1 && ( depth == CV_32S || depth == CV_32F || depth == CV_64F ) )
+  {
+    featureEvaluator->compileFeatures( selFeatures, first, table );
+  }
+  else
+  {
+    // no compatible layout, keep only the number of features
+    table.depth = -1;
+    table.step = 0;
+    table.areaStart.assign( ( selFeatures.empty() ? featureEvaluator->getNumFeatures() : (int) selFeatures.size() ) + 1, 0 );
+  }
+
+  parallel_for_( Range( 0, (int) images.size() ), Parallel_compute( featureEvaluator, table, selFeatures, images, response ) );
+}
+
+bool TrackerFeatureHAAR::extractSelected( const std::vector<int> selFeatures, const std::vector<Mat>& images, Mat& response )
+{
+  if( images.empty() )
+  {
+    return false;
+  }
+
+  int numFeatures = featureEvaluator->getNumFeatures();
+
+  response.create( Size( (int)images.size(), numFeatures ), CV_32F );
+  response.setTo( 0 );
+
+  //for each sample compute the selected features -> put each feature (n Rect) in response
+  if( !selFeatures.empty() )
+    computeHaarResponses( featureEvaluator, selFeatures, images, response );
+
+  return true;
+}
+
 bool TrackerFeatureHAAR::computeImpl( const std::vector<Mat>& images, Mat& response )
 {
   if( images.empty() )
@@ -275,21 +302,8 @@ bool TrackerFeatureHAAR::computeImpl( const std::vector<Mat>& images, Mat& respo
 
   response = Mat_<float>( Size( (int)images.size(), numFeatures ) );
 
-  std::vector<CvHaarEvaluator::FeatureHaar> f = featureEvaluator->getFeatures();
   //for each sample compute #n_feature -> put each feature (n Rect) in response
-  parallel_for_( Range( 0, (int)images.size() ), Parallel_compute( featureEvaluator, images, response ) );
-
-  /*for ( size_t i = 0; i < images.size(); i++ )
-  {
-    int c = images[i].cols;
-    int r = images[i].rows;
-    for ( int j = 0; j < numFeatures; j++ )
-    {
-      float res = 0;
-      featureEvaluator->getFeatures( j ).eval( images[i], Rect( 0, 0, c, r ), &res );
-      ( Mat_<float>( response ) )( j, i ) = res;
-    }
-  }*/
+  computeHaarResponses( featureEvaluator, std::vector<int>(), images, response );
 
   return true;
 }
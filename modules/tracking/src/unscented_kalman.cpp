@@ -78,6 +78,127 @@ UnscentedKalmanFilterParams::
     init( dp, mp, cp, processNoiseCovDiag, measurementNoiseCovDiag, dynamicalSystem, type );
 }
 
+void UkfSystemModel::stateConversionFunctionBatch( const Mat& X_k, const Mat& u_k, const Mat& V_k, Mat& X_kplus1 )
+{
+    CV_Assert( X_kplus1.cols == X_k.cols && ( V_k.cols == 1 || V_k.cols == X_k.cols ) );
+    Mat x, v, fx;
+    for ( int i = 0; i < X_k.cols; i++ )
+    {
+        x = X_k.col( i );
+        v = V_k.cols == 1 ? V_k : V_k.col( i );
+        fx = X_kplus1.col( i );
+        stateConversionFunction( x, u_k, v, fx );
+    }
+}
+
+void UkfSystemModel::measurementFunctionBatch( const Mat& X_k, const Mat& N_k, Mat& Z_k )
+{
+    CV_Assert( Z_k.cols == X_k.cols && ( N_k.cols == 1 || N_k.cols == X_k.cols ) );
+    Mat x, n, hx;
+    for ( int i = 0; i < X_k.cols; i++ )
+    {
+        x = X_k.col( i );
+        n = N_k.cols == 1 ? N_k : N_k.col( i );
+        hx = Z_k.col( i );
+        measurementFunction( x, n, hx );
+    }
+}
+
+template<typename _Tp> static void
+fillSigmaPoints( const Mat& mean, const Mat& L, _Tp coef, Mat& points )
+{
+    int n = mean.rows;
+    for ( int i = 0; i < n; i++ )
+    {
+        _Tp m = mean.at<_Tp>( i, 0 );
+        const _Tp* l = L.ptr<_Tp>( i );
+        _Tp* p = points.ptr<_Tp>( i );
+        p[0] = m;
+        for ( int j = 0; j < n; j++ )
+        {
+            _Tp d = coef*l[j];
+            p[1 + j] = m + d;
+            p[1 + n + j] = m - d;
+        }
+    }
+}
+
+void computeSigmaPoints( const Mat& mean, const Mat& covMatrix, double coef, Mat& covMatrixL, Mat& points )
+{
+// x_0 = mean
+// x_i = mean + coef * cholesky( covMatrix ), i = 1..n
+// x_(i+n) = mean - coef * cholesky( covMatrix ), i = 1..n
+
+    int n = mean.rows;
+    int type = mean.type();
+    CV_Assert( covMatrix.rows == n && covMatrix.cols == n && covMatrix.type() == type );
+    covMatrixL.create( n, n, type );
+    points.create( n, 2*n+1, type );
+
+// covMatrixL = cholesky( covMatrix )
+    covMatrix.copyTo( covMatrixL );
+    if ( type == CV_64F )
+    {
+        choleskyDecomposition<double>(
+                    covMatrix.ptr<double>(), covMatrix.step, covMatrix.rows,
+                    covMatrixL.ptr<double>(), covMatrixL.step );
+        fillSigmaPoints<double>( mean, covMatrixL, coef, points );
+    }
+    else
+    {
+        choleskyDecomposition<float>(
+                    covMatrix.ptr<float>(), covMatrix.step, covMatrix.rows,
+                    covMatrixL.ptr<float>(), covMatrixL.step );
+        fillSigmaPoints<float>( mean, covMatrixL, (float)coef, points );
+    }
+}
+
+template<typename _Tp> static void
+addCentralOuterProduct( const Mat& A, const Mat& B, _Tp w, Mat& dst )
+{
+    for ( int i = 0; i < A.rows; i++ )
+    {
+        _Tp a = w*A.at<_Tp>( i, 0 );
+        _Tp* d = dst.ptr<_Tp>( i );
+        for ( int j = 0; j < B.rows; j++ )
+            d[j] += a*B.at<_Tp>( j, 0 );
+    }
+}
+
+void weightedSPCovariance( const Mat& A, const Mat& B, double w0, double w, Mat& dst )
+{
+// dst = w*SUM_{i}( a_i*b_i.t ) + ( w0 - w )*a_0*b_0.t
+    CV_Assert( A.cols == B.cols && A.type() == B.type() );
+    gemm( A, B, w, noArray(), 0, dst, GEMM_2_T );
+    if ( A.type() == CV_64F )
+        addCentralOuterProduct<double>( A, B, w0 - w, dst );
+    else
+        addCentralOuterProduct<float>( A, B, (float)( w0 - w ), dst );
+}
+
+template<typename _Tp> static void
+subtractColumnMeanImpl( const Mat& src, const Mat& mean, Mat& dst )
+{
+    for ( int i = 0; i < src.rows; i++ )
+    {
+        _Tp m = mean.at<_Tp>( i, 0 );
+        const _Tp* s = src.ptr<_Tp>( i );
+        _Tp* d = dst.ptr<_Tp>( i );
+        for ( int j = 0; j < src.cols; j++ )
+            d[j] = s[j] - m;
+    }
+}
+
+void subtractColumnMean( const Mat& src, const Mat& mean, Mat& dst )
+{
+    CV_Assert( mean.rows == src.rows && mean.cols == 1 && mean.type() == src.type() );
+    dst.create( src.size(), src.type() );
+    if ( src.type() == CV_64F )
+        subtractColumnMeanImpl<double>( src, mean, dst );
+    else
+        subtractColumnMeanImpl<float>( src, mean, dst );
+}
+
 class UnscentedKalmanFilterImpl: public UnscentedKalmanFilter
 {
 
@@ -114,7 +235,8 @@ class UnscentedKalmanFilterImpl: public UnscentedKalmanFilter
     Mat measurementSPFuncValsCenter;            // set of measurement function values at sigma points minus estimate of measurement ( hc_i, i = 1..2*DP+1 ), MP x 2*DP+1
 
     Mat Wm;                                     // vector of weights for estimate mean, 2*DP+1 x 1
-    Mat Wc;                                     // matrix of weights for estimate covariance, 2*DP+1 x 2*DP+1
+    double Wc0;                                 // weight of the central sigma point for estimate covariance,
+    double Wci;                                 // weight of the other sigma points, Wc = diag( Wc0, Wci, ..., Wci )
 
     Mat gain;                                   // Kalman gain matrix (K), DP x MP
     Mat xyCov;                                  // estimate of the covariance between x* and y* (Sxy), DP x MP
@@ -123,7 +245,7 @@ class UnscentedKalmanFilterImpl: public UnscentedKalmanFilter
     Mat r;                                      // zero vector of process noise for getting transitionSPFuncVals,
     Mat q;                                      // zero vector of measurement noise for getting measurementSPFuncVals
 
-    Mat getSigmaPoints( const Mat& mean, const Mat& covMatrix, double coef );
+    Mat covMatrixL;                             // Cholesky factor of the error covariance used for sigma points, DP x DP
 
 public:
 
@@ -191,18 +313,16 @@ UnscentedKalmanFilterImpl::UnscentedKalmanFilterImpl(const UnscentedKalmanFilter
     double tmp2Lambda = 0.5/tmpLambda;
 
     Wm = tmp2Lambda * Mat::ones( 2*DP+1, 1, dataType );
-    Wc = tmp2Lambda * Mat::eye( 2*DP+1, 2*DP+1, dataType );
+    Wci = tmp2Lambda;
+    Wc0 = lambda/tmpLambda + 1.0 - alpha*alpha + beta;
 
     if ( dataType == CV_64F )
-    {
         Wm.at<double>(0,0) = lambda/tmpLambda;
-        Wc.at<double>(0,0) = lambda/tmpLambda + 1.0 - alpha*alpha + beta;
-    }
     else
-    {
         Wm.at<float>(0,0) = (float)(lambda/tmpLambda);
-        Wc.at<float>(0,0) = (float)(lambda/tmpLambda + 1.0 - alpha*alpha + beta);
-    }
+
+    sigmaPoints = Mat::zeros( DP, 2*DP+1, dataType );
+    covMatrixL = Mat::zeros( DP, DP, dataType );
 }
 
 UnscentedKalmanFilterImpl::~UnscentedKalmanFilterImpl()
@@ -224,7 +344,7 @@ UnscentedKalmanFilterImpl::~UnscentedKalmanFilterImpl()
     measurementSPFuncValsCenter.release();
 
     Wm.release();
-    Wc.release();
+    covMatrixL.release();
 
     gain.release();
     xyCov.release();
@@ -234,64 +354,28 @@ UnscentedKalmanFilterImpl::~UnscentedKalmanFilterImpl()
     q.release();
 }
 
-Mat UnscentedKalmanFilterImpl::getSigmaPoints(const Mat &mean, const Mat &covMatrix, double coef)
-{
-// x_0 = mean
-// x_i = mean + coef * cholesky( covMatrix ), i = 1..n
-// x_(i+n) = mean - coef * cholesky( covMatrix ), i = 1..n
-
-    int n = mean.rows;
-    Mat points = repeat(mean, 1, 2*n+1);
-
-    Mat covMatrixL = covMatrix.clone();
-
-// covMatrixL = cholesky( covMatrix )
-    if ( dataType == CV_64F )
-        choleskyDecomposition<double>(
-                    covMatrix.ptr<double>(), covMatrix.step, covMatrix.rows,
-                    covMatrixL.ptr<double>(), covMatrixL.step );
-    else if ( dataType == CV_32F )
-        choleskyDecomposition<float>(
-                    covMatrix.ptr<float>(), covMatrix.step, covMatrix.rows,
-                    covMatrixL.ptr<float>(), covMatrixL.step );
-
-    covMatrixL = coef * covMatrixL;
-
-    Mat p_plus = points( Rect( 1, 0, n, n ) );
-    Mat p_minus = points( Rect( n+1, 0, n, n ) );
-
-    add(p_plus, covMatrixL, p_plus);
-    subtract(p_minus, covMatrixL, p_minus);
-
-    return points;
-}
-
 Mat UnscentedKalmanFilterImpl::predict(InputArray _control)
 {
     Mat control = _control.getMat();
 // get sigma points from x* and P
-    sigmaPoints = getSigmaPoints( state, errorCov, sqrt( tmpLambda ) );
+    computeSigmaPoints( state, errorCov, sqrt( tmpLambda ), covMatrixL, sigmaPoints );
 
 // compute f-function values at sigma points
 // f_i = f(x_i, control, 0), i = 0..2*DP
-    Mat x, fx;
-    for ( int i = 0; i<2*DP+1; i++)
-    {
-        x = sigmaPoints( Rect( i, 0, 1, DP) );
-        fx = transitionSPFuncVals( Rect( i, 0, 1, DP) );
-        model->stateConversionFunction( x, control, q, fx );
-    }
+    model->stateConversionFunctionBatch( sigmaPoints, control, q, transitionSPFuncVals );
+
 // compute the estimate of state as mean f-function value at sigma point
 // x* = SUM_{i=0}^{2*DP}( Wm[i]*f_i )
-    state = transitionSPFuncVals * Wm;
+    gemm( transitionSPFuncVals, Wm, 1, noArray(), 0, state );
 
 // compute f-function values at sigma points minus estimate of state
 // fc_i = f_i - x*, i = 0..2*DP
-    subtract(transitionSPFuncVals, repeat( state, 1, 2*DP+1 ), transitionSPFuncValsCenter);
+    subtractColumnMean( transitionSPFuncVals, state, transitionSPFuncValsCenter );
 
 // compute the estimate of the state cross-covariance matrix
 // P = SUM_{i=0}^{2*DP}( Wc[i]*fc_i*fc_i.t ) + Q
-    errorCov = transitionSPFuncValsCenter * Wc * transitionSPFuncValsCenter.t() + processNoiseCov;
+    weightedSPCovariance( transitionSPFuncValsCenter, transitionSPFuncValsCenter, Wc0, Wci, errorCov );
+    add( errorCov, processNoiseCov, errorCov );
 
     return state.clone();
 }
@@ -300,33 +384,28 @@ Mat UnscentedKalmanFilterImpl::correct(InputArray _measurement)
 {
     Mat measurement = _measurement.getMat();
 // get sigma points from x* and P
-    sigmaPoints = getSigmaPoints( state, errorCov, sqrt( tmpLambda ) );
+    computeSigmaPoints( state, errorCov, sqrt( tmpLambda ), covMatrixL, sigmaPoints );
 
 // compute h-function values at sigma points
 // h_i = h(x_i, 0), i = 0..2*DP
-    Mat x, hx;
-    for ( int i = 0; i<2*DP+1; i++)
-    {
-        x = sigmaPoints( Rect( i, 0, 1, DP) );
-        hx = measurementSPFuncVals( Rect( i, 0, 1, MP) );
-        model->measurementFunction( x, r, hx );
-    }
+    model->measurementFunctionBatch( sigmaPoints, r, measurementSPFuncVals );
 
 // compute the estimate of measurement as mean h-function value at sigma point
 // y* = SUM_{i=0}^{2*DP}( Wm[i]*h_i )
-    measurementEstimate = measurementSPFuncVals * Wm;
+    gemm( measurementSPFuncVals, Wm, 1, noArray(), 0, measurementEstimate );
 
 // compute h-function values at sigma points minus estimate of state
 // hc_i = h_i - y*, i = 0..2*DP
-    subtract(measurementSPFuncVals, repeat( measurementEstimate, 1, 2*DP+1 ), measurementSPFuncValsCenter);
+    subtractColumnMean( measurementSPFuncVals, measurementEstimate, measurementSPFuncValsCenter );
 
 // compute the estimate of the y* cross-covariance matrix
 // Syy = SUM_{i=0}^{2*DP}( Wc[i]*hc_i*hc_i.t ) + R
-    yyCov = measurementSPFuncValsCenter * Wc * measurementSPFuncValsCenter.t() + measurementNoiseCov;
+    weightedSPCovariance( measurementSPFuncValsCenter, measurementSPFuncValsCenter, Wc0, Wci, yyCov );
+    add( yyCov, measurementNoiseCov, yyCov );
 
 // compute the estimate of the covariance between x* and y*
 // Sxy = SUM_{i=0}^{2*DP}( Wc[i]*fc_i*hc_i.t )
-    xyCov = transitionSPFuncValsCenter * Wc * measurementSPFuncValsCenter.t();
+    weightedSPCovariance( transitionSPFuncValsCenter, measurementSPFuncValsCenter, Wc0, Wci, xyCov );
 
 // compute the Kalman gain matrix
 // K = Sxy * Syy^(-1)
@@ -369,5 +448,61 @@ Ptr<UnscentedKalmanFilter> createUnscentedKalmanFilter(const UnscentedKalmanFilt
     return kfu;
 }
 
+class PredictFiltersInvoker : public ParallelLoopBody
+{
+public:
+    PredictFiltersInvoker( const std::vector<Ptr<UnscentedKalmanFilter> >& _filters, const std::vector<Mat>& _controls,
+                           std::vector<Mat>& _states ) :
+        filters( _filters ), controls( _controls ), states( _states )
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        for ( int i = range.start; i < range.end; i++ )
+            states[i] = controls.empty() ? filters[i]->predict() : filters[i]->predict( controls[i] );
+    }
+
+private:
+    const std::vector<Ptr<UnscentedKalmanFilter> >& filters;
+    const std::vector<Mat>& controls;
+    std::vector<Mat>& states;
+};
+
+class CorrectFiltersInvoker : public ParallelLoopBody
+{
+public:
+    CorrectFiltersInvoker( const std::vector<Ptr<UnscentedKalmanFilter> >& _filters, const std::vector<Mat>& _measurements,
+                           std::vector<Mat>& _states ) :
+        filters( _filters ), measurements( _measurements ), states( _states )
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        for ( int i = range.start; i < range.end; i++ )
+            states[i] = filters[i]->correct( measurements[i] );
+    }
+
+private:
+    const std::vector<Ptr<UnscentedKalmanFilter> >& filters;
+    const std::vector<Mat>& measurements;
+    std::vector<Mat>& states;
+};
+
+void predictFilters( const std::vector<Ptr<UnscentedKalmanFilter> >& filters, const std::vector<Mat>& controls, std::vector<Mat>& states )
+{
+    CV_Assert( controls.empty() || controls.size() == filters.size() );
+    states.resize( filters.size() );
+    parallel_for_( Range( 0, (int)filters.size() ), PredictFiltersInvoker( filters, controls, states ) );
+}
+
+void correctFilters( const std::vector<Ptr<UnscentedKalmanFilter> >& filters, const std::vector<Mat>& measurements, std::vector<Mat>& states )
+{
+    CV_Assert( measurements.size() == filters.size() );
+    states.resize( filters.size() );
+    parallel_for_( Range( 0, (int)filters.size() ), CorrectFiltersInvoker( filters, measurements, states ) );
+}
+
 } // tracking
 } // cv
@@ -0,0 +1,84 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2016, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "test_precomp.hpp"
+#include "opencv2/tracking/feature.hpp"
+
+using namespace cv;
+
+TEST(TRACKER_HAAR, compiled_table_matches_eval)
+{
+  RNG rng( 0 );
+  Mat frame( 240, 320, CV_8UC1 );
+  rng.fill( frame, RNG::UNIFORM, 0, 256 );
+  Mat ii;
+  integral( frame, ii, CV_32F );
+
+  Size patchSize( 40, 30 );
+  CvHaarFeatureParams haarParams;
+  haarParams.numFeatures = 100;
+  haarParams.isIntegral = true;
+  Ptr<CvHaarEvaluator> evaluator = CvFeatureEvaluator::create( CvFeatureParams::HAAR ).staticCast<CvHaarEvaluator>();
+  evaluator->init( &haarParams, 1, patchSize );
+
+  // samples are ROIs of a single frame-level integral image
+  Mat first = ii( Rect( 0, 0, patchSize.width, patchSize.height ) );
+  CvHaarEvaluator::FeatureTable table;
+  evaluator->compileFeatures( std::vector<int>(), first, table );
+  ASSERT_EQ( haarParams.numFeatures + 1, (int)table.areaStart.size() );
+
+  std::vector<float> res( haarParams.numFeatures );
+  for ( int i = 0; i < 20; i++ )
+  {
+    Rect roi( rng.uniform( 0, ii.cols - patchSize.width ), rng.uniform( 0, ii.rows - patchSize.height ), patchSize.width, patchSize.height );
+    Mat sample = ii( roi );
+    ASSERT_TRUE( CvHaarEvaluator::isCompatible( table, sample ) );
+    CvHaarEvaluator::evalFeatures( table, sample, &res[0] );
+    for ( int j = 0; j < haarParams.numFeatures; j++ )
+    {
+      float expected = 0;
+      evaluator->getFeatures( j ).eval( sample, Rect( 0, 0, sample.cols, sample.rows ), &expected );
+      EXPECT_NEAR( expected, res[j], 1e-3 );
+    }
+  }
+}
+
+/* End of file. */
@@ -432,3 +432,41 @@ TEST(UKF, DISABLED_ungm_mean_squared_error)
 
     ASSERT_GE( mse_treshold, average_error );
 }
+
+TEST(UKF, parallel_filters_match_sequential)
+{
+    const int nFilters = 64;
+    const int nIterations = 20;
+    int DP = 1, MP = 1, CP = 0;
+
+    Ptr<UnivariateNonstationaryGrowthModel> model( new UnivariateNonstationaryGrowthModel() );
+    UnscentedKalmanFilterParams params( DP, MP, CP, 1.0, 1.0, model );
+    params.alpha = 1.5;
+
+    std::vector<Ptr<UnscentedKalmanFilter> > filters, reference;
+    for ( int i = 0; i < nFilters; i++ )
+    {
+        params.stateInit.at<double>(0, 0) = 0.1*i;
+        filters.push_back( createUnscentedKalmanFilter( params ) );
+        reference.push_back( createUnscentedKalmanFilter( params ) );
+    }
+
+    RNG rng( 216 );
+    std::vector<Mat> controls( nFilters ), measurements( nFilters ), states;
+    for ( int it = 0; it < nIterations; it++ )
+    {
+        for ( int i = 0; i < nFilters; i++ )
+        {
+            controls[i] = Mat( 1, 1, CV_64F, Scalar( (double)it ) );
+            measurements[i] = Mat( 1, 1, CV_64F, Scalar( rng.uniform( 0.0, 10.0 ) ) );
+        }
+
+        predictFilters( filters, controls, states );
+        for ( int i = 0; i < nFilters; i++ )
+            ASSERT_LE( norm( reference[i]->predict( controls[i] ), states[i], NORM_INF ), 1e-12 );
+
+        correctFilters( filters, measurements, states );
+        for ( int i = 0; i < nFilters; i++ )
+            ASSERT_LE( norm( reference[i]->correct( measurements[i] ), states[i], NORM_INF ), 1e-12 );
+    }
+}
@@ -224,6 +224,29 @@ public:
      */
     virtual void compute( InputArray image, OutputArray descriptors ) = 0;
 
+    /** @brief Receives the dense descriptors computed tile by tile, see
+    DAISY::compute( InputArray, Size, DAISY::TileCallback& ).
+     */
+    class CV_EXPORTS TileCallback
+    {
+    public:
+        virtual ~TileCallback() { }
+        /** @brief Called once per tile, tiles are processed in raster order.
+
+        @param tile region of the image covered by the tile
+        @param descriptors descriptors of the tile pixels in row-major order, the buffer is
+        reused for the next tile
+         */
+        virtual void process( const Rect& tile, const Mat& descriptors ) = 0;
+    };
+
+    /**@overload
+     * @param image image to extract descriptors
+     * @param tileSize size of the tiles the image is processed by, memory use is bounded by it
+     * @param callback receives the descriptors of all image pixels, tile by tile
+     */
+    virtual void compute( InputArray image, Size tileSize, TileCallback& callback ) = 0;
+
     /**
      * @param y position y on image
      * @param x position x on image
@@ -0,0 +1,46 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::xfeatures2d;
+using namespace perf;
+
+typedef perf::TestBaseWithParam<std::string> affine_feature2d;
+
+#define AFFINE_IMAGES \
+    "cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png",\
+    "stitching/a3.png"
+
+// The affine adaptation of the keypoints runs in parallel, compare with --perf_threads=1
+PERF_TEST_P(affine_feature2d, detect_harris_laplace, testing::Values(AFFINE_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    declare.in(frame).time(90);
+
+    Ptr<AffineFeature2D> detector = AffineFeature2D::create(HarrisLaplaceFeatureDetector::create());
+
+    vector<Elliptic_KeyPoint> points;
+    TEST_CYCLE() detector->detect(frame, points);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(affine_feature2d, detect_and_compute_sift, testing::Values(AFFINE_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    declare.in(frame).time(90);
+
+    Ptr<AffineFeature2D> affine = AffineFeature2D::create(HarrisLaplaceFeatureDetector::create(), SIFT::create());
+
+    vector<Elliptic_KeyPoint> points;
+    Mat descriptors;
+    TEST_CYCLE() affine->detectAndCompute(frame, noArray(), points, descriptors);
+
+    SANITY_CHECK_NOTHING();
+}
@@ -0,0 +1,66 @@
+#include "perf_precomp.hpp"
+#include "opencv2/imgproc.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::xfeatures2d;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+enum { BINARY_ORB, BINARY_LATCH, BINARY_LUCID, BINARY_FREAK };
+CV_ENUM(BinaryDescriptorType, BINARY_ORB, BINARY_LATCH, BINARY_LUCID, BINARY_FREAK)
+
+typedef std::tr1::tuple<std::string, BinaryDescriptorType> BinaryDescriptorParams;
+typedef perf::TestBaseWithParam<BinaryDescriptorParams> binary_descriptor;
+
+#define BINARY_DESCRIPTOR_IMAGES \
+    "cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png",\
+    "stitching/a3.png"
+
+// all the extractors describe the same oriented keypoints, as a visual odometry front-end would
+PERF_TEST_P(binary_descriptor, extract,
+            testing::Combine(testing::Values(BINARY_DESCRIPTOR_IMAGES), BinaryDescriptorType::all()))
+{
+    string filename = getDataPath(get<0>(GetParam()));
+    int type = get<1>(GetParam());
+    Mat color = imread(filename, IMREAD_COLOR);
+    ASSERT_FALSE(color.empty()) << "Unable to load source image " << filename;
+
+    Mat frame;
+    cvtColor(color, frame, COLOR_BGR2GRAY);
+
+    Ptr<ORB> detector = ORB::create(5000);
+    vector<KeyPoint> points;
+    detector->detect(frame, points);
+
+    Ptr<Feature2D> descriptor;
+    Mat input = frame;
+    switch (type)
+    {
+    case BINARY_ORB:
+        descriptor = detector;
+        break;
+    case BINARY_LATCH:
+        descriptor = LATCH::create();
+        break;
+    case BINARY_LUCID:
+        descriptor = LUCID::create();
+        input = color;
+        break;
+    case BINARY_FREAK:
+        descriptor = FREAK::create();
+        break;
+    }
+    declare.in(input).time(90);
+
+    Mat descriptors;
+    TEST_CYCLE()
+    {
+        // extractors may drop keypoints close to the border
+        vector<KeyPoint> kps = points;
+        descriptor->compute(input, kps, descriptors);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
@@ -0,0 +1,38 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::xfeatures2d;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+CV_ENUM(BoostDescType, BoostDesc::BGM, BoostDesc::LBGM, BoostDesc::BINBOOST_256)
+
+typedef std::tr1::tuple<std::string, BoostDescType> BoostDescParams;
+typedef perf::TestBaseWithParam<BoostDescParams> boostdesc;
+
+#define BOOSTDESC_IMAGES \
+    "cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png",\
+    "stitching/a3.png"
+
+PERF_TEST_P(boostdesc, extract, testing::Combine(testing::Values(BOOSTDESC_IMAGES), BoostDescType::all()))
+{
+    string filename = getDataPath(get<0>(GetParam()));
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    Mat mask;
+    declare.in(frame).time(90);
+
+    Ptr<KAZE> detector = KAZE::create();
+    vector<KeyPoint> points;
+    detector->detect(frame, points, mask);
+
+    Ptr<BoostDesc> descriptor = BoostDesc::create(get<1>(GetParam()));
+    Mat descriptors;
+    // compute keypoints descriptor
+    TEST_CYCLE() descriptor->compute(frame, points, descriptors);
+
+    SANITY_CHECK_NOTHING();
+}
@@ -31,3 +31,28 @@ PERF_TEST_P(daisy, extract, testing::Values(DAISY_IMAGES))
 
     SANITY_CHECK_NOTHING();
 }
+
+class DAISYTilesSink : public DAISY::TileCallback
+{
+public:
+    DAISYTilesSink() : count(0) {}
+    void process(const Rect&, const Mat& descriptors) { count += descriptors.rows; }
+    int count;
+};
+
+PERF_TEST_P(daisy, extract_tiles, testing::Values(DAISY_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    declare.in(frame).time(90);
+
+    Ptr<DAISY> descriptor = DAISY::create();
+
+    DAISYTilesSink sink;
+    // compute all daisies in image, by tiles
+    TEST_CYCLE() descriptor->compute(frame, Size(256, 256), sink);
+
+    SANITY_CHECK_NOTHING();
+}
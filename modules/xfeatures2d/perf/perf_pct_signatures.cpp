@@ -0,0 +1,51 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::xfeatures2d;
+using namespace perf;
+
+typedef perf::TestBaseWithParam<std::string> pct_signatures;
+
+#define PCT_IMAGES \
+    "cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png",\
+    "stitching/a3.png"
+
+PERF_TEST_P(pct_signatures, compute, testing::Values(PCT_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    declare.in(frame).time(90);
+
+    Ptr<PCTSignatures> pct = PCTSignatures::create(2000, 400);
+
+    Mat signature;
+    TEST_CYCLE() pct->computeSignature(frame, signature);
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef perf::TestBaseWithParam<int> pct_signatures_sqfd;
+
+PERF_TEST_P(pct_signatures_sqfd, distances, testing::Values(PCTSignatures::L1, PCTSignatures::L2, PCTSignatures::L5))
+{
+    // signatures of a few hundred centroids, as computed with the default settings
+    RNG rng(0);
+    Mat source(300, 8, CV_32F);
+    rng.fill(source, RNG::UNIFORM, Scalar::all(0), Scalar::all(1));
+    vector<Mat> images(64);
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        images[i].create(200 + (int)i, 8, CV_32F);
+        rng.fill(images[i], RNG::UNIFORM, Scalar::all(0), Scalar::all(1));
+    }
+
+    Ptr<PCTSignaturesSQFD> sqfd = PCTSignaturesSQFD::create(GetParam(), PCTSignatures::HEURISTIC, 1.f);
+
+    vector<float> distances;
+    TEST_CYCLE() sqfd->computeQuadraticFormDistances(source, images, distances);
+
+    SANITY_CHECK_NOTHING();
+}
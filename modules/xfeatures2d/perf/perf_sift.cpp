@@ -0,0 +1,43 @@
+#include "perf_precomp.hpp"
+#include "opencv2/imgproc.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::xfeatures2d;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+typedef std::tr1::tuple<std::string, int> File_Threads_t;
+typedef perf::TestBaseWithParam<File_Threads_t> sift;
+
+#define SIFT_IMAGES \
+    "cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png",\
+    "stitching/a3.png"
+
+PERF_TEST_P(sift, detectAndCompute_12MP, testing::Combine(testing::Values(SIFT_IMAGES), testing::Values(1, 2, 4, 8)))
+{
+    string filename = getDataPath(get<0>(GetParam()));
+    int threads = get<1>(GetParam());
+    Mat src = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(src.empty()) << "Unable to load source image " << filename;
+
+    // 4000x3000, the resolution of a typical camera
+    Mat frame;
+    resize(src, frame, Size(4000, 3000), 0, 0, INTER_LINEAR);
+
+    Mat mask;
+    declare.in(frame).time(600);
+    Ptr<SIFT> detector = SIFT::create();
+    vector<KeyPoint> points;
+    Mat descriptors;
+
+    int prevThreads = getNumThreads();
+    setNumThreads(threads);
+
+    TEST_CYCLE_N(1) detector->detectAndCompute(frame, mask, points, descriptors, false);
+
+    setNumThreads(prevThreads);
+
+    SANITY_CHECK_NOTHING();
+}
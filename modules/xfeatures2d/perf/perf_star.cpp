@@ -0,0 +1,50 @@
+#include "perf_precomp.hpp"
+#include "opencv2/imgproc.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::xfeatures2d;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+enum { DETECTOR_STAR, DETECTOR_FAST, DETECTOR_ORB };
+CV_ENUM(DetectorType, DETECTOR_STAR, DETECTOR_FAST, DETECTOR_ORB)
+
+typedef std::tr1::tuple<DetectorType, Size> DetectorParams;
+typedef perf::TestBaseWithParam<DetectorParams> star;
+
+// Star against the usual tracking front-ends on HD frames
+PERF_TEST_P(star, detect, testing::Combine(DetectorType::all(), testing::Values(sz720p, sz1080p)))
+{
+    int type = get<0>(GetParam());
+    Size sz = get<1>(GetParam());
+
+    string filename = getDataPath("stitching/a3.png");
+    Mat src = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(src.empty()) << "Unable to load source image " << filename;
+
+    Mat frame;
+    resize(src, frame, sz, 0, 0, INTER_LINEAR);
+
+    Ptr<Feature2D> detector;
+    switch (type)
+    {
+    case DETECTOR_STAR:
+        detector = StarDetector::create();
+        break;
+    case DETECTOR_FAST:
+        detector = FastFeatureDetector::create();
+        break;
+    case DETECTOR_ORB:
+        detector = ORB::create(5000);
+        break;
+    }
+    declare.in(frame).time(90);
+
+    vector<KeyPoint> points;
+    TEST_CYCLE() detector->detect(frame, points);
+
+    RecordProperty("keypoints", (int)points.size());
+    SANITY_CHECK_NOTHING();
+}
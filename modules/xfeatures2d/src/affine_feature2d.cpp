@@ -27,6 +27,7 @@ float selIntegrationScale(const Mat & image, float si, Point c);
 float selDifferentiationScale(const Mat & image, Mat & Lxm2smooth, Mat & Lxmysmooth, Mat & Lym2smooth, float si, Point c);
 float calcSecondMomentSqrt(const Mat & dx2, const Mat & dxy, const Mat & dy2, Point p, Matx22f& Mk);
 float normMaxEval(Matx22f & U, Mat& uVal, Mat& uVect);
+bool isSimilarRegion(const Elliptic_KeyPoint & kp1, const Elliptic_KeyPoint & kp2, float maxDiff);
 
 /*
  * Calculates second moments matrix in point p
@@ -445,45 +446,110 @@ float selDifferentiationScale(const Mat & img, Mat & Lxm2smooth, Mat & Lxmysmoot
     return sdk;
 }
 
+/*
+ * Performs the affine adaptation of a range of keypoints
+ */
+class AffineAdaptationInvoker : public ParallelLoopBody
+{
+public:
+    AffineAdaptationInvoker(const Mat & _image, const std::vector<KeyPoint> & _keypoints,
+            std::vector<Elliptic_KeyPoint> & _regions, std::vector<uchar> & _adapted)
+        : image(_image), keypoints(_keypoints), regions(_regions), adapted(_adapted) {}
+
+    void operator()(const Range & range) const
+    {
+        for (int i = range.start; i < range.end; ++i)
+        {
+            const KeyPoint & kp = keypoints[i];
+            Elliptic_KeyPoint ex(kp.pt, 0, Size_<float> (kp.size / 2, kp.size / 2), kp.size,
+                    kp.size / 6);
+
+            adapted[i] = calcAffineAdaptation(image, ex);
+            if (adapted[i])
+                regions[i] = ex;
+        }
+    }
+
+private:
+    const Mat & image;
+    const std::vector<KeyPoint> & keypoints;
+    std::vector<Elliptic_KeyPoint> & regions;
+    std::vector<uchar> & adapted;
+};
+
+/*
+ * Checks if kp2 is a duplicate of the region kp1 detected before it
+ */
+bool isSimilarRegion(const Elliptic_KeyPoint & kp1, const Elliptic_KeyPoint & kp2, float maxDiff)
+{
+    if (norm(kp1.pt - kp2.pt) > maxDiff)
+        return false;
+
+    float phi1, phi2;
+    Size axes1, axes2;
+    float si1, si2;
+    phi1 = kp1.angle;
+    phi2 = kp2.angle;
+    axes1 = kp1.axes;
+    axes2 = kp2.axes;
+    si1 = kp1.si;
+    si2 = kp2.si;
+    return std::abs(phi1-phi2)<15 && std::max(si1,si2)/std::min(si1,si2)<1.4f && axes1.width-axes2.width<5 && axes1.height-axes2.height<5;
+}
+
 void calcAffineCovariantRegions(const Mat & image, const std::vector<KeyPoint> & keypoints,
         std::vector<Elliptic_KeyPoint> & affRegions)
 {
+    std::vector<Elliptic_KeyPoint> regions(keypoints.size());
+    std::vector<uchar> adapted(keypoints.size());
+    parallel_for_(Range(0, (int)keypoints.size()), AffineAdaptationInvoker(image, keypoints, regions, adapted));
+
     for (size_t i = 0; i < keypoints.size(); ++i)
     {
-        KeyPoint kp = keypoints[i];
-        Elliptic_KeyPoint ex(kp.pt, 0, Size_<float> (kp.size / 2, kp.size / 2), kp.size,
-                kp.size / 6);
-
-        if (calcAffineAdaptation(image, ex))
-            affRegions.push_back(ex);
+        if (adapted[i])
+            affRegions.push_back(regions[i]);
     }
-    //Erase similar keypoint
-    float maxDiff = 4;
-    Mat colorimg;
-    for (size_t i = 0; i < affRegions.size(); i++)
+    if (affRegions.empty())
+        return;
+
+    //Erase similar keypoint: a region is kept if none of the regions kept before it is similar.
+    //The kept regions are binned in a grid of maxDiff cells, so only the neighbour cells are searched,
+    //and are moved to the front of the vector as they are found.
+    const float maxDiff = 4;
+    Point2f minPt = affRegions[0].pt, maxPt = affRegions[0].pt;
+    for (size_t i = 1; i < affRegions.size(); i++)
     {
-        Elliptic_KeyPoint kp1 = affRegions[i];
-        for (size_t j = i+1; j < affRegions.size(); j++){
-
-            Elliptic_KeyPoint kp2 = affRegions[j];
-
-            if(norm(kp1.pt-kp2.pt)<=maxDiff){
-                float phi1, phi2;
-                Size axes1, axes2;
-                float si1, si2;
-                phi1 = kp1.angle;
-                phi2 = kp2.angle;
-                axes1 = kp1.axes;
-                axes2 = kp2.axes;
-                si1 = kp1.si;
-                si2 = kp2.si;
-                if(std::abs(phi1-phi2)<15 && std::max(si1,si2)/std::min(si1,si2)<1.4f && axes1.width-axes2.width<5 && axes1.height-axes2.height<5){
-                    affRegions.erase(affRegions.begin()+j);
-                    j--;
-                }
-            }
-        }
+        minPt.x = std::min(minPt.x, affRegions[i].pt.x);
+        minPt.y = std::min(minPt.y, affRegions[i].pt.y);
+        maxPt.x = std::max(maxPt.x, affRegions[i].pt.x);
+        maxPt.y = std::max(maxPt.y, affRegions[i].pt.y);
+    }
+    int gridCols = cvFloor((maxPt.x - minPt.x) / maxDiff) + 1;
+    int gridRows = cvFloor((maxPt.y - minPt.y) / maxDiff) + 1;
+    std::vector<int> cellHead((size_t)gridCols * gridRows, -1), nextInCell(affRegions.size(), -1);
+
+    size_t nkept = 0;
+    for (size_t j = 0; j < affRegions.size(); j++)
+    {
+        const Elliptic_KeyPoint & kp2 = affRegions[j];
+        int gx = std::min(cvFloor((kp2.pt.x - minPt.x) / maxDiff), gridCols - 1);
+        int gy = std::min(cvFloor((kp2.pt.y - minPt.y) / maxDiff), gridRows - 1);
+
+        bool duplicate = false;
+        for (int y = std::max(gy - 1, 0); y <= std::min(gy + 1, gridRows - 1) && !duplicate; y++)
+            for (int x = std::max(gx - 1, 0); x <= std::min(gx + 1, gridCols - 1) && !duplicate; x++)
+                for (int i = cellHead[y * gridCols + x]; i >= 0 && !duplicate; i = nextInCell[i])
+                    duplicate = isSimilarRegion(affRegions[i], kp2, maxDiff);
+        if (duplicate)
+            continue;
+
+        if (nkept != j)
+            affRegions[nkept] = kp2;
+        nextInCell[nkept] = cellHead[gy * gridCols + gx];
+        cellHead[gy * gridCols + gx] = (int)nkept;
+        nkept++;
     }
+    affRegions.resize(nkept);
 }
 
 void calcAffineCovariantDescriptors(const Ptr<DescriptorExtractor>& dextractor, const Mat& img,
@@ -160,6 +160,10 @@ protected:
     Mat m_wl_y_min, m_wl_y_max;
     Mat m_wl_alpha, m_wl_beta;
 
+    // integral image offsets
+    // of the weak learner boxes
+    Mat m_wl_offsets;
+
 private:
 
     /*
@@ -180,10 +184,14 @@ private:
 // -------------------------------------------------
 /* BoostDesc internal routines */
 
-static void computeGradientMaps( const Mat& im,
-                                 const int gradAssignType,
-                                 const int orientQuant,
-                                 vector<Mat>& gradMap )
+// gradient maps of the patch and their integral images in a single pass,
+// the row b < orientQuant of integralMap holds the integral image of the
+// orientation bin b and the row orientQuant the one of all the bins
+static void computeIntegralGradientMaps( const Mat& im,
+                                         const int gradAssignType,
+                                         const int orientQuant,
+                                         Mat& derivx, Mat& derivy,
+                                         Mat& integralMap )
 {
     enum Assign
     {
@@ -194,28 +202,44 @@ static void computeGradientMaps( const Mat& im,
       ASSIGN_SOFT_MAGN = 4
     };
 
-    Mat derivx( im.size(), CV_32FC1 );
-    Mat derivy( im.size(), CV_32FC1 );
+    Sobel( im, derivx, CV_32F, 1, 0 );
+    Sobel( im, derivy, CV_32F, 0, 1 );
+
+    const int rows = im.rows;
+    const int cols = im.cols;
+    const int width = cols + 1;
 
-    Sobel( im, derivx, derivx.depth(), 1, 0 );
-    Sobel( im, derivy, derivy.depth(), 0, 1 );
+    integralMap.create( orientQuant + 1, ( rows + 1 ) * width, CV_32S );
+    for ( int k = 0; k <= orientQuant; k++ )
+      memset( integralMap.ptr<int>( k ), 0, width * sizeof(int) );
 
-    for ( int i = 0; i < orientQuant; i++ )
-      gradMap.push_back( Mat::zeros( im.size(), CV_8UC1 ) );
+    // gradient map values of one pixel and running row sums
+    AutoBuffer<uchar> _gradBins( orientQuant );
+    AutoBuffer<int> _rowSums( orientQuant + 1 );
+    uchar* gradBins = _gradBins;
+    int* rowSums = _rowSums;
 
     int index, index2;
     double binCenter, weight;
     double binSize = (2 * CV_PI) / orientQuant;
 
-    // fill in temp matrices with
-    // respones to edge detection
-    const float* pDerivx = derivx.ptr<float>();
-    const float* pDerivy = derivy.ptr<float>();
-
-    for ( int i = 0; i < im.rows; i++ )
+    for ( int i = 0; i < rows; i++ )
     {
-      for ( int j = 0; j < im.cols; j++ )
+      // fill in temp matrices with
+      // respones to edge detection
+      const float* pDerivx = derivx.ptr<float>( i );
+      const float* pDerivy = derivy.ptr<float>( i );
+
+      for ( int k = 0; k <= orientQuant; k++ )
+      {
+        rowSums[k] = 0;
+        integralMap.ptr<int>( k )[( i + 1 ) * width] = 0;
+      }
+
+      for ( int j = 0; j < cols; j++ )
       {
+        memset( gradBins, 0, orientQuant );
+
         float gradMagnitude = sqrt( (*pDerivx) * (*pDerivx)
                                   + (*pDerivy) * (*pDerivy) );
         if ( gradMagnitude > 20 )
@@ -228,11 +252,11 @@ static void computeGradientMaps( const Mat& im,
           switch ( gradAssignType )
           {
             case ASSIGN_HARD:
-              gradMap[index].at<uchar>(i,j) = 1;
+              gradBins[index] = 1;
               break;
 
             case ASSIGN_HARD_MAGN:
-              gradMap[index].at<uchar>(i,j) = (uchar) cvRound( gradMagnitude );
+              gradBins[index] = (uchar) cvRound( gradMagnitude );
               break;
 
             case ASSIGN_BILINEAR:
@@ -240,8 +264,8 @@ static void computeGradientMaps( const Mat& im,
               index2 = ( index2 == orientQuant ) ? 0 : index2;
               binCenter  = ( index + 0.5f ) * binSize;
               weight = 1 - abs( theta - binCenter ) / binSize;
-              gradMap[index ].at<uchar>(i,j) = (uchar) cvRound( 255 * weight );
-              gradMap[index2].at<uchar>(i,j) = (uchar) cvRound( 255 * ( 1 - weight ) );
+              gradBins[index ] = (uchar) cvRound( 255 * weight );
+              gradBins[index2] = (uchar) cvRound( 255 * ( 1 - weight ) );
               break;
 
             case ASSIGN_SOFT:
@@ -251,7 +275,7 @@ static void computeGradientMaps( const Mat& im,
                 binCenter = ( index2 + 0.5f ) * binSize;
                 weight = cos( theta - binCenter );
                 weight = ( weight < 0 ) ? 0 : weight;
-                gradMap[index2].at<uchar>(i,j) = (uchar) cvRound( 255 * weight );
+                gradBins[index2] = (uchar) cvRound( 255 * weight );
               }
               break;
 
@@ -262,74 +286,48 @@ static void computeGradientMaps( const Mat& im,
                 binCenter = ( index2 + 0.5f ) * binSize;
                 weight = cos( theta - binCenter );
                 weight = ( weight < 0 ) ? 0 : weight;
-                gradMap[index2].at<uchar>(i,j) = (uchar) cvRound( gradMagnitude * weight );
+                gradBins[index2] = (uchar) cvRound( gradMagnitude * weight );
               }
               break;
           } // end switch
         }
         ++pDerivy;
         ++pDerivx;
-      }
-    }
-}
 
-static void computeIntegrals( const vector<Mat>& gradMap,
-                              const int orientQuant,
-                              vector<Mat>& integralMap )
-{
-    // init integral images
-    int rows = gradMap[0].rows;
-    int cols = gradMap[0].cols;
-
-    for ( int i = 0; i < orientQuant+1; i++ )
-      integralMap.push_back( Mat::zeros( rows+1, cols+1, CV_8UC1 ) );
-
-    // generate corresponding integral images
-    for( int i = 0; i < orientQuant; i++ )
-      integral( gradMap[i], integralMap[i] );
-
-    // copy the values from the first quantization bin
-    integralMap[0].copyTo( integralMap[orientQuant] );
-
-    int* ptrSum, *ptr;
-    for ( int k = 1; k < orientQuant; k++ )
-    {
-      ptr    = (int*) integralMap[k].ptr<int>();
-      ptrSum = (int*) integralMap[orientQuant].ptr<int>();
-      for (int i=0; i<(rows+1)*(cols+1); ++i)
-      {
-        *ptrSum += *ptr;
-        ++ptrSum;
-        ++ptr;
+        // accumulate the integral images
+        const int ofs = ( i + 1 ) * width + j + 1;
+        int total = 0;
+        for ( int k = 0; k < orientQuant; k++ )
+        {
+          int* ptr = integralMap.ptr<int>( k ) + ofs;
+          rowSums[k] += gradBins[k];
+          total += gradBins[k];
+          ptr[0] = ptr[-width] + rowSums[k];
+        }
+        int* ptrSum = integralMap.ptr<int>( orientQuant ) + ofs;
+        rowSums[orientQuant] += total;
+        ptrSum[0] = ptrSum[-width] + rowSums[orientQuant];
       }
     }
 }
 
-static float computeWLResponse( const int x_min,  const int x_max,
-                                const int y_min,  const int y_max,
-                                const int orient, const float thresh,
-                                const int orientQuant,
-                                const vector<Mat>& integralMap )
+static inline float computeWLResponse( const Vec4i& offsets,
+                                       const int orient, const float thresh,
+                                       const int orientQuant,
+                                       const Mat& integralMap )
 {
-    const int width = integralMap[0].cols;
-
-    const int idx1 = (y_min    ) * width + x_min;
-    const int idx2 = (y_min    ) * width + x_max + 1;
-    const int idx3 = (y_max + 1) * width + x_min;
-    const int idx4 = (y_max + 1) * width + x_max + 1;
-
-    const int* ptr = integralMap[orient].ptr<int>();
+    const int* ptr = integralMap.ptr<int>( orient );
 
     int A, B ,C, D;
-    A = ptr[idx1]; B = ptr[idx2];
-    C = ptr[idx3]; D = ptr[idx4];
+    A = ptr[offsets[0]]; B = ptr[offsets[1]];
+    C = ptr[offsets[2]]; D = ptr[offsets[3]];
 
     const float current = float(D + A - B - C);
 
-    ptr = integralMap[orientQuant].ptr<int>();
+    ptr = integralMap.ptr<int>( orientQuant );
 
-    A = ptr[idx1]; B = ptr[idx2];
-    C = ptr[idx3]; D = ptr[idx4];
+    A = ptr[offsets[0]]; B = ptr[offsets[1]];
+    C = ptr[offsets[2]]; D = ptr[offsets[3]];
 
     const float total = float(D + A - B - C);
 
@@ -373,36 +371,27 @@ static void rectifyPatch( const Mat& image, const KeyPoint& kp,
 
 struct ComputeBoostDescInvoker : ParallelLoopBody
 {
-    ComputeBoostDescInvoker( const Mat& _image, Mat* _descriptors,
-                        const vector<KeyPoint>& _keypoints,
+    ComputeBoostDescInvoker( const Mat& _image, Mat* _descriptors, Mat* _responses,
+                        const vector<KeyPoint>& _keypoints, const int _first,
                         const int _desc_type, const int _grad_atype,
                         const int _orient_q, const int _patch_size,
                         const int _nWLs, const int _Dims,
-                        const Mat& _wl_x_min, const Mat& _wl_x_max,
-                        const Mat& _wl_y_min, const Mat& _wl_y_max,
+                        const Mat& _wl_offsets,
                         const Mat& _wl_thresh, const Mat& _wl_orient,
-                        const Mat& _wl_alpha, const Mat& _wl_beta,
+                        const Mat& _wl_beta,
                         const bool _use_scale_orientation,
                         const float _scale_factor )
+      : image( _image ), descriptors( _descriptors ), responses( _responses ),
+        keypoints( _keypoints ), first( _first ),
+        wl_offsets( _wl_offsets ), wl_thresh( _wl_thresh ),
+        wl_orient( _wl_orient ), wl_beta( _wl_beta )
     {
       nWLs = _nWLs;
       Dims = _Dims;
-      image = _image;
       orient_q = _orient_q;
       desc_type = _desc_type;
-      keypoints = _keypoints;
       grad_atype = _grad_atype;
       patch_size = _patch_size;
-      descriptors = _descriptors;
-
-      wl_beta = _wl_beta;
-      wl_alpha = _wl_alpha;
-      wl_x_min = _wl_x_min;
-      wl_x_max = _wl_x_max;
-      wl_y_min = _wl_y_min;
-      wl_y_max = _wl_y_max;
-      wl_thresh = _wl_thresh;
-      wl_orient = _wl_orient;
 
       scale_factor = _scale_factor;
       use_scale_orientation  = _use_scale_orientation;
@@ -410,8 +399,8 @@ struct ComputeBoostDescInvoker : ParallelLoopBody
 
     void operator ()( const cv::Range& range ) const
     {
-      // maps
-      vector<Mat> gradMap, integralMap;
+      // maps, reused over the keypoints of the range
+      Mat patch, derivx, derivy, integralMap;
 
       // small binary map
       uchar binLookUp[8];
@@ -421,14 +410,13 @@ struct ComputeBoostDescInvoker : ParallelLoopBody
       for ( int i = range.start; i < range.end; i++ )
       {
 
-        Mat patch;
         // rectify the patch around a given keypoint
         rectifyPatch( image, keypoints[i], patch_size,
                       patch, use_scale_orientation, scale_factor );
 
         // compute gradient maps (and integral gradient maps)
-        computeGradientMaps( patch, grad_atype, orient_q, gradMap );
-        computeIntegrals( gradMap, orient_q, integralMap );
+        computeIntegralGradientMaps( patch, grad_atype, orient_q,
+                                     derivx, derivy, integralMap );
 
         float WLR;
 
@@ -440,12 +428,14 @@ struct ComputeBoostDescInvoker : ParallelLoopBody
              ( desc_type == BGM_BILINEAR )
            )
         {
+          const Vec4i* offsets = wl_offsets.ptr<Vec4i>(0);
+          const int* orient = wl_orient.ptr<int>(0);
+          const float* thresh = wl_thresh.ptr<float>(0);
+
           uchar* desc = descriptors->ptr<uchar>(i);
           for ( int j = 0; j < nWLs; j++ )
           {
-            WLR = computeWLResponse( wl_x_min.at<int>(0,j), wl_x_max.at<int>(0,j),
-                                     wl_y_min.at<int>(0,j), wl_y_max.at<int>(0,j),
-                                     wl_orient.at<int>(0,j), wl_thresh.at<float>(0,j),
+            WLR = computeWLResponse( offsets[j], orient[j], thresh[j],
                                      orient_q, integralMap );
             desc[j/8] |=  ( WLR >= 0 ) ? binLookUp[ j % 8 ] : 0;
           }
@@ -456,24 +446,17 @@ struct ComputeBoostDescInvoker : ParallelLoopBody
          */
         if ( desc_type == LBGM )
         {
-          std::bitset<512> wlResponses;
+          const Vec4i* offsets = wl_offsets.ptr<Vec4i>(0);
+          const int* orient = wl_orient.ptr<int>(0);
+          const float* thresh = wl_thresh.ptr<float>(0);
 
+          // signed responses, projected by beta for all the keypoints at once
+          float* resp = responses->ptr<float>( i - first );
           for ( int j = 0; j < nWLs; j++ )
           {
-            WLR = computeWLResponse( wl_x_min.at<int>(0,j), wl_x_max.at<int>(0,j),
-                                     wl_y_min.at<int>(0,j), wl_y_max.at<int>(0,j),
-                                     wl_orient.at<int>(0,j), wl_thresh.at<float>(0,j),
+            WLR = computeWLResponse( offsets[j], orient[j], thresh[j],
                                      orient_q, integralMap );
-            wlResponses[j] = ( WLR >= 0 ) ? 1 : 0;
-        }
-
-          float* desc = descriptors->ptr<float>(i);
-          for ( int d = 0; d < Dims; d++ )
-          {
-            for ( int wl = 0; wl < nWLs; wl++ )
-            {
-              desc[d] += ( wlResponses[wl] ) ? wl_beta.at<float>(wl,d) : -wl_beta.at<float>(wl,d);
-            }
+            resp[j] = ( WLR >= 0 ) ? 1.f : -1.f;
           }
         } // end LBGM
 
@@ -486,27 +469,25 @@ struct ComputeBoostDescInvoker : ParallelLoopBody
            )
         {
           float resp;
+          uchar* desc = descriptors->ptr<uchar>(i);
           for ( int d = 0; d < Dims; d++ )
           {
+            const Vec4i* offsets = wl_offsets.ptr<Vec4i>(d);
+            const int* orient = wl_orient.ptr<int>(d);
+            const float* thresh = wl_thresh.ptr<float>(d);
+            const float* beta = wl_beta.ptr<float>(d);
+
             resp = 0;
-            uchar* desc = descriptors->ptr<uchar>(i);
             for ( int wl = 0; wl < nWLs; wl++ )
             {
-              WLR = computeWLResponse( wl_x_min.at<int>(d,wl), wl_x_max.at<int>(d,wl),
-                                       wl_y_min.at<int>(d,wl), wl_y_max.at<int>(d,wl),
-                                       wl_orient.at<int>(d,wl), wl_thresh.at<float>(d,wl),
+              WLR = computeWLResponse( offsets[wl], orient[wl], thresh[wl],
                                        orient_q, integralMap );
-              resp += ( WLR >= 0 ) ? wl_beta.at<float>(d,wl) : -wl_beta.at<float>(d,wl);
+              resp += ( WLR >= 0 ) ? beta[wl] : -beta[wl];
             }
             desc[d/8] |= ( resp >= 0 ) ? binLookUp[d%8] : 0;
           }
         } // end BINBOOST
 
-        // clean-up
-        patch.release();
-        gradMap.clear();
-        integralMap.clear();
-
       } // end for loop
     } // end operator
 
@@ -516,14 +497,17 @@ struct ComputeBoostDescInvoker : ParallelLoopBody
     int desc_type;
     int patch_size;
     int grad_atype;
-    int patch_szie;
 
-    Mat image;
+    const Mat& image;
     Mat *descriptors;
-    vector<KeyPoint> keypoints;
+    Mat *responses;
+    const vector<KeyPoint>& keypoints;
+    const int first;
 
-    Mat wl_x_min, wl_x_max, wl_y_min, wl_y_max;
-    Mat wl_thresh, wl_orient, wl_alpha, wl_beta;
+    const Mat& wl_offsets;
+    const Mat& wl_thresh;
+    const Mat& wl_orient;
+    const Mat& wl_beta;
 
     float scale_factor;
     bool use_scale_orientation;
@@ -561,14 +545,39 @@ void BoostDesc_Impl::compute( InputArray _image, vector<KeyPoint>& keypoints, Ou
     // descriptor storage
     Mat descriptors = _descriptors.getMat();
 
-    parallel_for_( Range( 0, (int) keypoints.size() ),
-        ComputeBoostDescInvoker( m_image, &descriptors, keypoints,
-                            m_desc_type, m_grad_atype, m_orient_q,
-                            m_patch_size, m_nWLs, m_Dims,
-                            m_wl_x_min, m_wl_x_max, m_wl_y_min, m_wl_y_max,
-                            m_wl_thresh, m_wl_orient, m_wl_alpha, m_wl_beta,
-                            m_use_scale_orientation, m_scale_factor )
-    );
+    if ( m_desc_type != LBGM )
+    {
+      parallel_for_( Range( 0, (int) keypoints.size() ),
+          ComputeBoostDescInvoker( m_image, &descriptors, NULL, keypoints, 0,
+                              m_desc_type, m_grad_atype, m_orient_q,
+                              m_patch_size, m_nWLs, m_Dims, m_wl_offsets,
+                              m_wl_thresh, m_wl_orient, m_wl_beta,
+                              m_use_scale_orientation, m_scale_factor )
+      );
+      return;
+    }
+
+    // LBGM: weak learner responses of a block of keypoints,
+    // projected by beta with a single product per block
+    const int nkeypoints = (int) keypoints.size();
+    const int blockSize = 1024;
+    Mat responses;
+    for ( int first = 0; first < nkeypoints; first += blockSize )
+    {
+      const int count = std::min( blockSize, nkeypoints - first );
+      responses.create( count, m_nWLs, CV_32F );
+
+      parallel_for_( Range( first, first + count ),
+          ComputeBoostDescInvoker( m_image, &descriptors, &responses, keypoints, first,
+                              m_desc_type, m_grad_atype, m_orient_q,
+                              m_patch_size, m_nWLs, m_Dims, m_wl_offsets,
+                              m_wl_thresh, m_wl_orient, m_wl_beta,
+                              m_use_scale_orientation, m_scale_factor )
+      );
+
+      Mat block = descriptors.rowRange( first, first + count );
+      gemm( responses, m_wl_beta, 1.0, noArray(), 0.0, block );
+    }
 }
 
 void BoostDesc_Impl::ini_params( const int orientQuant, const int patchSize,
@@ -624,6 +633,21 @@ void BoostDesc_Impl::ini_params( const int orientQuant, const int patchSize,
     m_wl_y_min  = Mat( dim0, dim1, CV_32S, const_cast<int *>(y_min ) );
     m_wl_y_max  = Mat( dim0, dim1, CV_32S, const_cast<int *>(y_max ) );
 
+    // box corners in the integral images of the patch
+    const int width = patchSize + 1;
+    m_wl_offsets.create( dim0, dim1, CV_32SC4 );
+    for ( int i = 0; i < dim0; i++ )
+    {
+      for ( int j = 0; j < dim1; j++ )
+      {
+        const int k = i * dim1 + j;
+        m_wl_offsets.at<Vec4i>( i, j ) = Vec4i( (y_min[k]    ) * width + x_min[k],
+                                                (y_min[k]    ) * width + x_max[k] + 1,
+                                                (y_max[k] + 1) * width + x_min[k],
+                                                (y_max[k] + 1) * width + x_max[k] + 1 );
+      }
+    }
+
     // no beta
     if ( beta == NULL ) return;
 
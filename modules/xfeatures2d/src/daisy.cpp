@@ -135,6 +135,13 @@ public:
      */
     virtual void compute( InputArray image, OutputArray descriptors );
 
+    /** @overload
+     * @param image image to extract descriptors
+     * @param tileSize size of the tiles the image is processed by
+     * @param callback receives the descriptors of each tile
+     */
+    virtual void compute( InputArray image, Size tileSize, TileCallback& callback );
+
     /**
      * @param y position y on image
      * @param x position x on image
@@ -236,6 +243,13 @@ protected:
     // n>= 1; layer[0] is the layered_gradient
     std::vector<Mat> m_smoothed_gradient_layers;
 
+    // memory of the layers, kept across images and tiles; a layer
+    // is remapped to histograms over the memory of the previous one
+    std::vector<Mat> m_layers_storage;
+
+    // memory of the image and descriptors of a tile
+    Mat m_tile_image_storage, m_tile_descriptors_storage;
+
     // hold the scales of the pixels
     Mat m_scale_map;
 
@@ -322,6 +336,9 @@ private:
 
     inline void update_selected_cubes();
 
+    // margin around a tile needed to compute its descriptors as on the whole image
+    inline int tile_margin() const;
+
 }; // END DAISY_Impl CLASS
 
 
@@ -344,11 +361,29 @@ inline void DAISY_Impl::release_auxiliary()
 {
     reset();
 
+    m_layers_storage.clear();
+    m_tile_image_storage.release();
+    m_tile_descriptors_storage.release();
+
     m_cube_sigmas.release();
     m_grid_points.release();
     m_oriented_grid_points.release();
 }
 
+// header of a float array over the given storage,
+// which is reallocated only when it is too small
+static Mat storage_header( Mat& storage, int ndims, const int* dims )
+{
+    size_t total = 1;
+    for( int i=0; i<ndims; i++ )
+      total *= dims[i];
+
+    if( storage.total() < total )
+      storage.create( 1, (int)total, CV_32F );
+
+    return Mat( ndims, dims, CV_32F, storage.ptr<float>() );
+}
+
 static int filter_size( double sigma, double factor )
 {
     int fsz = (int)( factor * sigma );
@@ -993,6 +1028,7 @@ struct ComputeDescriptorsInvoker : ParallelLoopBody
     {
       x_off = _roi->x;
       x_end = _roi->x + _roi->width;
+      y_off = _roi->y;
       image = _image;
       layers = _layers;
       th_q_no = _th_q_no;
@@ -1010,7 +1046,7 @@ struct ComputeDescriptorsInvoker : ParallelLoopBody
       {
         for( int x = x_off; x < x_end; x++ )
         {
-          index = y*image->cols + x;
+          index = (y - y_off)*(x_end - x_off) + (x - x_off);
           orientation = 0;
           if( !orientation_map->empty() )
               orientation = (int) orientation_map->at<ushort>( y, x );
@@ -1024,7 +1060,7 @@ struct ComputeDescriptorsInvoker : ParallelLoopBody
     }
 
     int th_q_no;
-    int x_off, x_end;
+    int x_off, x_end, y_off;
     std::vector<Mat>* layers;
     Mat *descriptors;
     Mat *orientation_map;
@@ -1099,10 +1135,11 @@ inline void DAISY_Impl::initialize()
     // (m_rad_q_no + 1) cubes
     // 3 dims tensor (idhist, img_y, img_x);
     m_smoothed_gradient_layers.resize( m_rad_q_no + 1 );
+    m_layers_storage.resize( m_rad_q_no + 1 );
 
     int dims[3] = { m_hist_th_q_no, m_image.rows, m_image.cols };
     for ( int c=0; c<=m_rad_q_no; c++)
-      m_smoothed_gradient_layers[c] = Mat( 3, dims, CV_32F );
+      m_smoothed_gradient_layers[c] = storage_header( m_layers_storage[c], 3, dims );
 
     layered_gradient( m_image, &m_smoothed_gradient_layers[0] );
 
@@ -1175,12 +1212,10 @@ inline void DAISY_Impl::compute_histograms()
       int m_y = m_smoothed_gradient_layers.at(r).size[1];
       int m_x = m_smoothed_gradient_layers.at(r).size[2];
 
-      // empty targeted cube
-      m_smoothed_gradient_layers.at(r).release();
-
-      // recreate cube space
+      // recreate cube space over the targeted cube,
+      // it was only needed to smooth the next one
       int dims[3] = { m_y, m_x, m_h };
-      m_smoothed_gradient_layers.at(r) = Mat( 3, dims, CV_32F );
+      m_smoothed_gradient_layers.at(r) = storage_header( m_layers_storage[r], 3, dims );
 
       // copy backward all cubes and realign structure
       parallel_for_( Range(0, m_image.rows), ComputeHistogramsInvoker( &m_smoothed_gradient_layers, r ) );
@@ -1449,6 +1484,33 @@ inline void DAISY_Impl::set_parameters( )
     compute_grid_points();
 }
 
+inline int DAISY_Impl::tile_margin() const
+{
+    // gradient: 5x5 gaussian and 3x1 derivative kernels
+    int margin = 2 + 1;
+
+    // layers smoothing to sigma_init
+    float sigma = (float)sqrt(g_sigma_init*g_sigma_init-0.25f);
+    margin += filter_size( sigma, 5.0f ) / 2;
+
+    // incremental smoothing of the cubes
+    for( int r=0; r<m_rad_q_no; r++ )
+    {
+      double sigma_r;
+      if( r == 0 )
+        sigma_r = m_cube_sigmas.at<double>(0);
+      else
+        sigma_r = sqrt( m_cube_sigmas.at<double>(r  ) * m_cube_sigmas.at<double>(r  )
+                      - m_cube_sigmas.at<double>(r-1) * m_cube_sigmas.at<double>(r-1) );
+      margin += filter_size( sigma_r, 5.0f ) / 2;
+    }
+
+    // outer petals and their bilinear interpolation
+    margin += cvCeil( m_rad ) + 2;
+
+    return margin;
+}
+
 // set/convert image array for daisy internal routines
 // daisy internals use CV_32F image with norm to 1.0f
 inline void DAISY_Impl::set_image( InputArray _image )
@@ -1588,6 +1650,63 @@ void DAISY_Impl::compute( InputArray _image, OutputArray _descriptors )
     normalize_descriptors( &descriptors );
 }
 
+// full scope by tiles
+void DAISY_Impl::compute( InputArray _image, Size tileSize, TileCallback& callback )
+{
+    // do nothing if no image
+    if( _image.getMat().empty() )
+      return;
+
+    CV_Assert( m_h_matrix.empty() );
+    CV_Assert( ! m_use_orientation );
+    CV_Assert( tileSize.width > 0 && tileSize.height > 0 );
+
+    set_image( _image );
+    set_parameters();
+
+    // the whole image, m_image holds the tiles
+    Mat image = m_image;
+    Rect bounds( 0, 0, image.cols, image.rows );
+
+    // the layers of a tile are computed over the tile and its margin:
+    // the margin absorbs the borders of the smoothing kernels and holds
+    // the petals, tiles give the descriptors of the whole image
+    const int margin = tile_margin();
+
+    for( int ty=0; ty<image.rows; ty+=tileSize.height )
+    {
+      for( int tx=0; tx<image.cols; tx+=tileSize.width )
+      {
+        Rect tile( tx, ty, std::min( tileSize.width,  image.cols - tx ),
+                           std::min( tileSize.height, image.rows - ty ) );
+        Rect region = Rect( tile.x - margin, tile.y - margin,
+                            tile.width + 2*margin, tile.height + 2*margin ) & bounds;
+
+        // isolated copy, borders are replicated at the margin as on the image
+        int idims[2] = { region.height, region.width };
+        m_image = storage_header( m_tile_image_storage, 2, idims );
+        image( region ).copyTo( m_image );
+
+        m_roi = Rect( tile.x - region.x, tile.y - region.y, tile.width, tile.height );
+
+        initialize_single_descriptor_mode();
+
+        int ddims[2] = { tile.width*tile.height, m_descriptor_size };
+        Mat descriptors = storage_header( m_tile_descriptors_storage, 2, ddims );
+
+        // compute tile desc
+        compute_descriptors( &descriptors );
+        normalize_descriptors( &descriptors );
+
+        callback.process( tile, descriptors );
+      }
+    }
+
+    // layers of the last tile are not usable
+    // in single descriptor mode, drop them
+    reset();
+}
+
 // constructor
 DAISY_Impl::DAISY_Impl( float _radius, int _q_radius, int _q_theta, int _q_hist,
              int _norm, InputArray _H, bool _interpolation, bool _use_orientation )
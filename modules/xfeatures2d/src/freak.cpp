@@ -31,6 +31,7 @@
 //  the use of this software, even if advised of the possibility of such damage.
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <fstream>
 #include <stdlib.h>
 #include <algorithm>
@@ -46,6 +47,8 @@ namespace cv
 namespace xfeatures2d
 {
 
+template <typename srcMatType, typename iiMatType> class FREAKDescriptorInvoker;
+
 /*!
  FREAK implementation
  */
@@ -91,15 +94,20 @@ protected:
 
     void buildPattern();
 
+    template <typename srcMatType, typename iiMatType> friend class FREAKDescriptorInvoker;
+
     template <typename imgType, typename iiType>
-    imgType meanIntensity( InputArray image, InputArray integral, const float kp_x, const float kp_y,
-                          const unsigned int scale, const unsigned int rot, const unsigned int point );
+    imgType meanIntensity( const Mat& image, const Mat& integral, const float kp_x, const float kp_y,
+                          const unsigned int scale, const unsigned int rot, const unsigned int point ) const;
 
     template <typename srcMatType, typename iiMatType>
     void computeDescriptors( InputArray image, std::vector<KeyPoint>& keypoints, OutputArray descriptors );
 
+    template <typename srcMatType, typename iiMatType>
+    void computeKeypointDescriptor( const Mat& image, const Mat& imgIntegral, KeyPoint& kp, int scaleIdx, uchar* desc ) const;
+
     template <typename srcMatType>
-    void extractDescriptor(srcMatType *pointsValue, void ** ptr);
+    void extractDescriptor(const srcMatType *pointsValue, uchar* desc) const;
 
     bool orientationNormalized; //true if the orientation is normalized, false otherwise
     bool scaleNormalized; //true if the scale is normalized, false otherwise
@@ -147,6 +155,33 @@ static const int FREAK_NB_SCALES = FREAK::NB_SCALES;
 static const int FREAK_NB_PAIRS = FREAK::NB_PAIRS;
 static const int FREAK_NB_ORIENPAIRS = FREAK::NB_ORIENPAIRS;
 
+/*!
+ Computes the orientations and the descriptors of a range of keypoints
+ */
+template <typename srcMatType, typename iiMatType>
+class FREAKDescriptorInvoker : public ParallelLoopBody
+{
+public:
+    FREAKDescriptorInvoker( const FREAK_Impl& _freak, const Mat& _image, const Mat& _imgIntegral,
+                            std::vector<KeyPoint>& _keypoints, const std::vector<int>& _kpScaleIdx, Mat& _descriptors )
+        : freak(_freak), image(_image), imgIntegral(_imgIntegral),
+          keypoints(_keypoints), kpScaleIdx(_kpScaleIdx), descriptors(_descriptors) {}
+
+    void operator()( const Range& range ) const
+    {
+        for( int k = range.start; k < range.end; ++k )
+            freak.computeKeypointDescriptor<srcMatType, iiMatType>(image, imgIntegral, keypoints[k], kpScaleIdx[k], descriptors.ptr(k));
+    }
+
+private:
+    const FREAK_Impl& freak;
+    const Mat& image;
+    const Mat& imgIntegral;
+    std::vector<KeyPoint>& keypoints;
+    const std::vector<int>& kpScaleIdx;
+    Mat& descriptors;
+};
+
 // default pairs
 static const int FREAK_DEF_PAIRS[FREAK_Impl::NB_PAIRS] =
 {
@@ -363,11 +398,11 @@ void FREAK_Impl::compute( InputArray _image, std::vector<KeyPoint>& keypoints, O
 }
 
 template <typename srcMatType>
-void FREAK_Impl::extractDescriptor(srcMatType *pointsValue, void ** ptr)
+void FREAK_Impl::extractDescriptor(const srcMatType *pointsValue, uchar* desc) const
 {
-    std::bitset<FREAK_NB_PAIRS>** ptrScalar = (std::bitset<FREAK_NB_PAIRS>**) ptr;
+    std::bitset<FREAK_NB_PAIRS>* ptrScalar = (std::bitset<FREAK_NB_PAIRS>*) desc;
 
-    // extracting descriptor preserving the order of SSE version
+    // extracting descriptor preserving the order of SIMD version
     int cnt = 0;
     for( int n = 7; n < FREAK_NB_PAIRS; n += 128)
     {
@@ -376,70 +411,39 @@ void FREAK_Impl::extractDescriptor(srcMatType *pointsValue, void ** ptr)
             int nm = n-m;
             for(int kk = nm+15*8; kk >= nm; kk-=8, ++cnt)
             {
-                (*ptrScalar)->set(kk, pointsValue[descriptionPairs[cnt].i] >= pointsValue[descriptionPairs[cnt].j]);
+                ptrScalar->set(kk, pointsValue[descriptionPairs[cnt].i] >= pointsValue[descriptionPairs[cnt].j]);
             }
         }
     }
-    --(*ptrScalar);
 }
 
-#if CV_SSE2
+#if CV_SIMD128
 template <>
-void FREAK_Impl::extractDescriptor(uchar *pointsValue, void ** ptr)
+void FREAK_Impl::extractDescriptor(const uchar *pointsValue, uchar* desc) const
 {
-    __m128i** ptrSSE = (__m128i**) ptr;
-
     // note that comparisons order is modified in each block (but first 128 comparisons remain globally the same-->does not affect the 128,384 bits segmanted matching strategy)
     int cnt = 0;
-    for( int n = FREAK_NB_PAIRS/128; n-- ; )
+    for( int n = FREAK_NB_PAIRS/128; n-- ; desc += 16 )
     {
-        __m128i result128 = _mm_setzero_si128();
+        v_uint8x16 result128 = v_setzero_u8();
         for( int m = 128/16; m--; cnt += 16 )
         {
-            __m128i operand1 = _mm_set_epi8(pointsValue[descriptionPairs[cnt+0].i],
-                                            pointsValue[descriptionPairs[cnt+1].i],
-                                            pointsValue[descriptionPairs[cnt+2].i],
-                                            pointsValue[descriptionPairs[cnt+3].i],
-                                            pointsValue[descriptionPairs[cnt+4].i],
-                                            pointsValue[descriptionPairs[cnt+5].i],
-                                            pointsValue[descriptionPairs[cnt+6].i],
-                                            pointsValue[descriptionPairs[cnt+7].i],
-                                            pointsValue[descriptionPairs[cnt+8].i],
-                                            pointsValue[descriptionPairs[cnt+9].i],
-                                            pointsValue[descriptionPairs[cnt+10].i],
-                                            pointsValue[descriptionPairs[cnt+11].i],
-                                            pointsValue[descriptionPairs[cnt+12].i],
-                                            pointsValue[descriptionPairs[cnt+13].i],
-                                            pointsValue[descriptionPairs[cnt+14].i],
-                                            pointsValue[descriptionPairs[cnt+15].i]);
-
-            __m128i operand2 = _mm_set_epi8(pointsValue[descriptionPairs[cnt+0].j],
-                                            pointsValue[descriptionPairs[cnt+1].j],
-                                            pointsValue[descriptionPairs[cnt+2].j],
-                                            pointsValue[descriptionPairs[cnt+3].j],
-                                            pointsValue[descriptionPairs[cnt+4].j],
-                                            pointsValue[descriptionPairs[cnt+5].j],
-                                            pointsValue[descriptionPairs[cnt+6].j],
-                                            pointsValue[descriptionPairs[cnt+7].j],
-                                            pointsValue[descriptionPairs[cnt+8].j],
-                                            pointsValue[descriptionPairs[cnt+9].j],
-                                            pointsValue[descriptionPairs[cnt+10].j],
-                                            pointsValue[descriptionPairs[cnt+11].j],
-                                            pointsValue[descriptionPairs[cnt+12].j],
-                                            pointsValue[descriptionPairs[cnt+13].j],
-                                            pointsValue[descriptionPairs[cnt+14].j],
-                                            pointsValue[descriptionPairs[cnt+15].j]);
-
-            __m128i workReg = _mm_min_epu8(operand1, operand2); // emulated "not less than" for 8-bit UNSIGNED integers
-            workReg = _mm_cmpeq_epi8(workReg, operand2);        // emulated "not less than" for 8-bit UNSIGNED integers
-
-            workReg = _mm_and_si128(_mm_set1_epi16(short(0x8080 >> m)), workReg); // merge the last 16 bits with the 128bits std::vector until full
-            result128 = _mm_or_si128(result128, workReg);
+            // the pairs fill the lanes from the last one to the first one
+            uchar operand1_buf[16], operand2_buf[16];
+            for( int l = 0; l < 16; ++l )
+            {
+                operand1_buf[15-l] = pointsValue[descriptionPairs[cnt+l].i];
+                operand2_buf[15-l] = pointsValue[descriptionPairs[cnt+l].j];
+            }
+            v_uint8x16 operand1 = v_load(operand1_buf);
+            v_uint8x16 operand2 = v_load(operand2_buf);
+
+            v_uint8x16 workReg = v_min(operand1, operand2) == operand2; // "not less than" for 8-bit UNSIGNED integers
+
+            result128 |= workReg & v_setall_u8((uchar)(0x80 >> m)); // merge the last 16 bits with the 128bits std::vector until full
         }
-        (**ptrSSE) = result128;
-        ++(*ptrSSE);
+        v_store(desc, result128);
     }
-    (*ptrSSE) -= 8;
 }
 #endif
 
@@ -453,10 +457,6 @@ void FREAK_Impl::computeDescriptors( InputArray _image, std::vector<KeyPoint>& k
     const std::vector<int>::iterator ScaleIdxBegin = kpScaleIdx.begin(); // used in std::vector erase function
     const std::vector<cv::KeyPoint>::iterator kpBegin = keypoints.begin(); // used in std::vector erase function
     const float sizeCst = static_cast<float>(FREAK_NB_SCALES/(FREAK_LOG2* nOctaves));
-    srcMatType pointsValue[FREAK_NB_POINTS];
-    int thetaIdx = 0;
-    int direction0;
-    int direction1;
 
     // compute the scale index corresponding to the keypoint size and remove keypoints close to the border
     if( scaleNormalized )
@@ -502,142 +502,95 @@ void FREAK_Impl::computeDescriptors( InputArray _image, std::vector<KeyPoint>& k
     }
 
     // allocate descriptor memory, estimate orientations, extract descriptors
-    if( !extAll )
-    {
-        // extract the best comparisons only
-        _descriptors.create((int)keypoints.size(), FREAK_NB_PAIRS/8, CV_8U);
-        _descriptors.setTo(Scalar::all(0));
-        Mat descriptors = _descriptors.getMat();
-
-        void *ptr = descriptors.data+(keypoints.size()-1)*descriptors.step[0];
-
-        for( size_t k = keypoints.size(); k--; ) {
-            // estimate orientation (gradient)
-            if( !orientationNormalized )
-            {
-                thetaIdx = 0; // assign 0° to all keypoints
-                keypoints[k].angle = 0.0;
-            }
-            else
-            {
-                // get the points intensity value in the un-rotated pattern
-                for( int i = FREAK_NB_POINTS; i--; ) {
-                    pointsValue[i] = meanIntensity<srcMatType, iiMatType>(image, imgIntegral,
-                                                                          keypoints[k].pt.x, keypoints[k].pt.y,
-                                                                          kpScaleIdx[k], 0, i);
-                }
-                direction0 = 0;
-                direction1 = 0;
-                for( int m = 45; m--; )
-                {
-                    //iterate through the orientation pairs
-                    const int delta = (pointsValue[ orientationPairs[m].i ]-pointsValue[ orientationPairs[m].j ]);
-                    direction0 += delta*(orientationPairs[m].weight_dx)/2048;
-                    direction1 += delta*(orientationPairs[m].weight_dy)/2048;
-                }
-
-                keypoints[k].angle = static_cast<float>(atan2((float)direction1,(float)direction0)*(180.0/CV_PI));//estimate orientation
-
-                if(keypoints[k].angle < 0.f)
-                    thetaIdx = int(FREAK_NB_ORIENTATION*keypoints[k].angle*(1/360.0)-0.5);
-                else
-                    thetaIdx = int(FREAK_NB_ORIENTATION*keypoints[k].angle*(1/360.0)+0.5);
+    _descriptors.create((int)keypoints.size(), extAll ? 128 : FREAK_NB_PAIRS/8, CV_8U);
+    _descriptors.setTo(Scalar::all(0));
+    Mat descriptors = _descriptors.getMat();
 
-                if( thetaIdx < 0 )
-                    thetaIdx += FREAK_NB_ORIENTATION;
+    // keypoints are independent, each one only writes its angle and its descriptor row
+    parallel_for_(Range(0, (int)keypoints.size()),
+                  FREAKDescriptorInvoker<srcMatType, iiMatType>(*this, image, imgIntegral, keypoints, kpScaleIdx, descriptors));
+}
 
-                if( thetaIdx >= FREAK_NB_ORIENTATION )
-                    thetaIdx -= FREAK_NB_ORIENTATION;
-            }
-            // extract descriptor at the computed orientation
-            for( int i = FREAK_NB_POINTS; i--; ) {
-                pointsValue[i] = meanIntensity<srcMatType, iiMatType>(image, imgIntegral,
-                                                                      keypoints[k].pt.x, keypoints[k].pt.y,
-                                                                      kpScaleIdx[k], thetaIdx, i);
-            }
+template <typename srcMatType, typename iiMatType>
+void FREAK_Impl::computeKeypointDescriptor( const Mat& image, const Mat& imgIntegral, KeyPoint& kp, int scaleIdx, uchar* desc ) const
+{
+    srcMatType pointsValue[FREAK_NB_POINTS];
+    int thetaIdx = 0;
 
-            // Extract descriptor
-            extractDescriptor<srcMatType>(pointsValue, &ptr);
-        }
+    // estimate orientation (gradient)
+    if( !orientationNormalized )
+    {
+        thetaIdx = 0; // assign 0° to all keypoints
+        kp.angle = 0.0;
     }
-    else // extract all possible comparisons for selection
+    else
     {
-        _descriptors.create((int)keypoints.size(), 128, CV_8U);
-        _descriptors.setTo(Scalar::all(0));
-        Mat descriptors = _descriptors.getMat();
-        std::bitset<1024>* ptr = (std::bitset<1024>*) (descriptors.data+(keypoints.size()-1)*descriptors.step[0]);
-
-        for( size_t k = keypoints.size(); k--; )
+        // get the points intensity value in the un-rotated pattern
+        for( int i = FREAK_NB_POINTS; i--; ) {
+            pointsValue[i] = meanIntensity<srcMatType, iiMatType>(image, imgIntegral,
+                                                                  kp.pt.x, kp.pt.y,
+                                                                  scaleIdx, 0, i);
+        }
+        int direction0 = 0;
+        int direction1 = 0;
+        for( int m = 45; m--; )
         {
-            //estimate orientation (gradient)
-            if( !orientationNormalized )
-            {
-                thetaIdx = 0;//assign 0° to all keypoints
-                keypoints[k].angle = 0.0;
-            }
-            else
-            {
-                //get the points intensity value in the un-rotated pattern
-                for( int i = FREAK_NB_POINTS;i--; )
-                    pointsValue[i] = meanIntensity<srcMatType, iiMatType>(image, imgIntegral,
-                                                                          keypoints[k].pt.x,keypoints[k].pt.y,
-                                                                          kpScaleIdx[k], 0, i);
-
-                direction0 = 0;
-                direction1 = 0;
-                for( int m = 45; m--; )
-                {
-                    //iterate through the orientation pairs
-                    const int delta = (pointsValue[ orientationPairs[m].i ]-pointsValue[ orientationPairs[m].j ]);
-                    direction0 += delta*(orientationPairs[m].weight_dx)/2048;
-                    direction1 += delta*(orientationPairs[m].weight_dy)/2048;
-                }
+            //iterate through the orientation pairs
+            const int delta = (pointsValue[ orientationPairs[m].i ]-pointsValue[ orientationPairs[m].j ]);
+            direction0 += delta*(orientationPairs[m].weight_dx)/2048;
+            direction1 += delta*(orientationPairs[m].weight_dy)/2048;
+        }
 
-                keypoints[k].angle = static_cast<float>(atan2((float)direction1,(float)direction0)*(180.0/CV_PI)); //estimate orientation
+        kp.angle = static_cast<float>(atan2((float)direction1,(float)direction0)*(180.0/CV_PI));//estimate orientation
 
-                if(keypoints[k].angle < 0.f)
-                    thetaIdx = int(FREAK_NB_ORIENTATION*keypoints[k].angle*(1/360.0)-0.5);
-                else
-                    thetaIdx = int(FREAK_NB_ORIENTATION*keypoints[k].angle*(1/360.0)+0.5);
+        if(kp.angle < 0.f)
+            thetaIdx = int(FREAK_NB_ORIENTATION*kp.angle*(1/360.0)-0.5);
+        else
+            thetaIdx = int(FREAK_NB_ORIENTATION*kp.angle*(1/360.0)+0.5);
 
-                if( thetaIdx < 0 )
-                    thetaIdx += FREAK_NB_ORIENTATION;
+        if( thetaIdx < 0 )
+            thetaIdx += FREAK_NB_ORIENTATION;
 
-                if( thetaIdx >= FREAK_NB_ORIENTATION )
-                    thetaIdx -= FREAK_NB_ORIENTATION;
-            }
-            // get the points intensity value in the rotated pattern
-            for( int i = FREAK_NB_POINTS; i--; ) {
-                pointsValue[i] = meanIntensity<srcMatType, iiMatType>(image, imgIntegral,
-                                                                      keypoints[k].pt.x, keypoints[k].pt.y,
-                                                                      kpScaleIdx[k], thetaIdx, i);
-            }
+        if( thetaIdx >= FREAK_NB_ORIENTATION )
+            thetaIdx -= FREAK_NB_ORIENTATION;
+    }
+    // get the points intensity value in the rotated pattern
+    for( int i = FREAK_NB_POINTS; i--; ) {
+        pointsValue[i] = meanIntensity<srcMatType, iiMatType>(image, imgIntegral,
+                                                              kp.pt.x, kp.pt.y,
+                                                              scaleIdx, thetaIdx, i);
+    }
 
-            int cnt(0);
-            for( int i = 1; i < FREAK_NB_POINTS; ++i )
+    if( !extAll )
+    {
+        // extract the best comparisons only
+        extractDescriptor<srcMatType>(pointsValue, desc);
+    }
+    else // extract all possible comparisons for selection
+    {
+        std::bitset<1024>* ptr = (std::bitset<1024>*) desc;
+        int cnt(0);
+        for( int i = 1; i < FREAK_NB_POINTS; ++i )
+        {
+            //(generate all the pairs)
+            for( int j = 0; j < i; ++j )
             {
-                //(generate all the pairs)
-                for( int j = 0; j < i; ++j )
-                {
-                    ptr->set(cnt, pointsValue[i] >= pointsValue[j] );
-                    ++cnt;
-                }
+                ptr->set(cnt, pointsValue[i] >= pointsValue[j] );
+                ++cnt;
             }
-            --ptr;
         }
     }
 }
 
 // simply take average on a square patch, not even gaussian approx
 template <typename imgType, typename iiType>
-imgType FREAK_Impl::meanIntensity( InputArray _image, InputArray _integral,
+imgType FREAK_Impl::meanIntensity( const Mat& image, const Mat& integral,
                               const float kp_x,
                               const float kp_y,
                               const unsigned int scale,
                               const unsigned int rot,
-                              const unsigned int point)
+                              const unsigned int point) const
 {
-    Mat image = _image.getMat(), integral = _integral.getMat();
     // get point position in image
     const PatternPoint& FreakPoint = patternLookup[scale*FREAK_NB_ORIENTATION*FREAK_NB_POINTS + rot*FREAK_NB_POINTS + point];
     const float xf = FreakPoint.x+kp_x;
@@ -123,6 +123,19 @@ void Pyramid::build(const Mat& img, bool DOG)
     /* standard deviation of previous layer*/
     float sigma_prev = sigma;
 
+    /* smoothing applied on the previous layer to get each layer, the same in every octave
+       (only the first layer of the first octave depends on the presmoothing) */
+    std::vector<float> layerSigma(layersN);
+    std::vector<int> layerGsize(layersN);
+    for (layer = 1; layer < layersN; layer++)
+    {
+        sigma_curr = getSigma(layer);
+        layerSigma[layer] = sqrt(powf(sigma_curr, 2) - powf(sigma_prev, 2));
+        layerGsize[layer] = int(ceil(layerSigma[layer] * 3)) * 2 + 1;
+        sigma_prev = sigma_curr;
+    }
+    sigma_prev = sigma;
+
     if (omin < 0)
     {
         omin = -1;
@@ -135,30 +148,24 @@ void Pyramid::build(const Mat& img, bool DOG)
 
         for (layer = 1; layer < layersN; layer++)
         {
-            sigma_curr = getSigma(layer);
-            sigma = sqrt(powf(sigma_curr, 2) - powf(sigma_prev, 2));
             Mat prev_lay = layers[layer - 1], curr_lay, DOG_lay;
             /* smoothing is applied on previous layer so sigma_curr^2 = sigma^2 + sigma_prev^2 */
-            gsize = int(ceil(sigma * 3)) * 2 + 1;
-            GaussianBlur(prev_lay, curr_lay, Size(gsize,gsize), sigma);
+            GaussianBlur(prev_lay, curr_lay, Size(layerGsize[layer],layerGsize[layer]), layerSigma[layer]);
             layers.push_back(curr_lay);
             if (DOG)
             {
                 absdiff(curr_lay, prev_lay, DOG_lay);
                 DOG_layers.push_back(DOG_lay);
             }
-            sigma_prev = sigma_curr;
 
         }
-        Octave tmp_oct(layers);
-        octaves.push_back(tmp_oct);
-        layers.clear();
+        octaves.push_back(Octave());
+        octaves.back().layers.swap(layers);
 
         if (DOG)
         {
-            DOGOctave tmp_DOG_Oct(DOG_layers);
-            DOG_octaves.push_back(tmp_DOG_Oct);
-            DOG_layers.clear();
+            DOG_octaves.push_back(DOGOctave());
+            DOG_octaves.back().layers.swap(DOG_layers);
         }
 
     }
@@ -182,12 +189,17 @@ void Pyramid::build(const Mat& img, bool DOG)
     {
         for (layer = 1; layer < layersN; layer++)
         {
-            sigma_curr = getSigma(layer);
-            sigma = sqrt(powf(sigma_curr, 2) - powf(sigma_prev, 2));
-
             Mat prev_lay = layers[layer - 1], curr_lay, DOG_lay;
-            gsize = int(ceil(sigma * 3)) * 2 + 1;
-            GaussianBlur(prev_lay, curr_lay, Size(gsize,gsize), sigma);
+            if (layer == 1 && sigma_prev != sigma0)
+            {
+                /* first layer smoothed from the presmoothed image */
+                sigma_curr = getSigma(layer);
+                sigma = sqrt(powf(sigma_curr, 2) - powf(sigma_prev, 2));
+                gsize = int(ceil(sigma * 3)) * 2 + 1;
+                GaussianBlur(prev_lay, curr_lay, Size(gsize,gsize), sigma);
+            }
+            else
+                GaussianBlur(prev_lay, curr_lay, Size(layerGsize[layer],layerGsize[layer]), layerSigma[layer]);
             layers.push_back(curr_lay);
 
             if (DOG)
@@ -195,22 +207,19 @@ void Pyramid::build(const Mat& img, bool DOG)
                 absdiff(curr_lay, prev_lay, DOG_lay);
                 DOG_layers.push_back(DOG_lay);
             }
-            sigma_prev = sigma_curr;
         }
 
         Mat resized_lay;
         resize(layers[down_lay], resized_lay, ksize, 1.0f / 2, 1.0f / 2, INTER_AREA);
 
-        Octave tmp_oct(layers);
-        octaves.push_back(tmp_oct);
+        octaves.push_back(Octave());
+        octaves.back().layers.swap(layers);
         if (DOG)
         {
-            DOGOctave tmp_DOG_Oct(DOG_layers);
-            DOG_octaves.push_back(tmp_DOG_Oct);
-            DOG_layers.clear();
+            DOG_octaves.push_back(DOGOctave());
+            DOG_octaves.back().layers.swap(DOG_layers);
         }
         sigma_curr = sigma_prev = sigma0;
-        layers.clear();
         layers.push_back(resized_lay);
 
     }
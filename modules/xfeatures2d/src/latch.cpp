@@ -44,6 +44,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <algorithm>
 #include <vector>
 
@@ -75,10 +76,8 @@ namespace cv
             virtual void compute(InputArray image, std::vector<KeyPoint>& keypoints, OutputArray descriptors);
 
         protected:
-            typedef void(*PixelTestFn)(const Mat& input_image, const std::vector<KeyPoint>& keypoints, OutputArray, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size);
             void setSamplingPoints();
             int bytes_;
-            PixelTestFn test_fn_;
             bool rotationInvariance_;
             int half_ssd_size_;
 
@@ -90,349 +89,162 @@ namespace cv
         {
             return makePtr<LATCHDescriptorExtractorImpl>(bytes, rotationInvariance, half_ssd_size);
         }
-        void CalcuateSums(int count, const std::vector<int> &points, bool rotationInvariance, const Mat &grayImage, const KeyPoint &pt, int &suma, int &sumc, float cos_theta, float sin_theta, int half_ssd_size);
 
-
-        static void pixelTests1(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
-        {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 1; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
-            }
-        }
-
-
-        static void pixelTests2(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void checkDescriptorSize(int bytes)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 2; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
-            }
+            if (bytes != 1 && bytes != 2 && bytes != 4 && bytes != 8 && bytes != 16 && bytes != 32 && bytes != 64)
+                CV_Error(Error::StsBadArg, "descriptorSize must be 1,2, 4, 8, 16, 32, or 64");
         }
 
-
-        static void pixelTests4(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        /*
+        * Sums of squared differences of the a-b and c-b patches of one triplet, the patches being given
+        * by their top-left pixels. When simd is set, the rows are read by blocks of 8 pixels, the lanes
+        * past the patch width being masked out, so up to 7 pixels past each patch row must be readable.
+        */
+        static inline void tripletSSD(const uchar* a, const uchar* b, const uchar* c, size_t step, int w,
+                                      bool simd, int& suma, int& sumc)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            int sa = 0, sc = 0;
+#if CV_SIMD128
+            if (simd)
             {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 4; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
+                short mask_buf[8];
+                for (int i = 0; i < 8; i++)
+                    mask_buf[i] = (short)(i < (w & 7) ? -1 : 0);
+                const v_int16x8 tail_mask = v_load(mask_buf);
 
-                        count += 6;
+                v_int32x4 va = v_setzero_s32(), vc = v_setzero_s32();
+                for (int iy = 0; iy < w; iy++, a += step, b += step, c += step)
+                {
+                    int ix = 0;
+                    for (; ix <= w - 8; ix += 8)
+                    {
+                        v_int16x8 pb = v_reinterpret_as_s16(v_load_expand(b + ix));
+                        v_int16x8 da = v_reinterpret_as_s16(v_load_expand(a + ix)) - pb;
+                        v_int16x8 dc = v_reinterpret_as_s16(v_load_expand(c + ix)) - pb;
+                        va += v_dotprod(da, da);
+                        vc += v_dotprod(dc, dc);
                     }
-                }
-            }
-        }
-
-
-
-        static void pixelTests8(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
-        {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 8; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
+                    if (ix < w)
+                    {
+                        v_int16x8 pb = v_reinterpret_as_s16(v_load_expand(b + ix));
+                        v_int16x8 da = (v_reinterpret_as_s16(v_load_expand(a + ix)) - pb) & tail_mask;
+                        v_int16x8 dc = (v_reinterpret_as_s16(v_load_expand(c + ix)) - pb) & tail_mask;
+                        va += v_dotprod(da, da);
+                        vc += v_dotprod(dc, dc);
                     }
                 }
+                suma = v_reduce_sum(va);
+                sumc = v_reduce_sum(vc);
+                return;
             }
-        }
-
-
-        static void pixelTests16(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
-        {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+#else
+            (void)simd;
+#endif
+            for (int iy = 0; iy < w; iy++, a += step, b += step, c += step)
             {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 16; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
+                for (int ix = 0; ix < w; ix++)
+                {
+                    int difa = a[ix] - b[ix];
+                    sa += difa*difa;
 
-                        count += 6;
-                    }
+                    int difc = c[ix] - b[ix];
+                    sc += difc*difc;
                 }
             }
+            suma = sa;
+            sumc = sc;
         }
 
-
-        static void pixelTests32(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static inline int clampCoord(int v)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 32; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
-            }
+            return std::min(std::max(v, -24), 24);
         }
 
-
-        static void pixelTests64(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        /*
+        * Computes the descriptors of a range of keypoints. The triplets of the sampling pattern are
+        * rotated once per keypoint and turned into offsets of the top-left pixels of their patches.
+        */
+        class LATCHPixelTestsInvoker : public ParallelLoopBody
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+        public:
+            LATCHPixelTestsInvoker(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors,
+                                   const std::vector<int>& points, bool rotationInvariance, int half_ssd_size, int bytes) :
+                grayImage_(grayImage), keypoints_(keypoints), descriptors_(descriptors), points_(points),
+                rotationInvariance_(rotationInvariance), half_ssd_size_(half_ssd_size), bytes_(bytes)
             {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 64; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
+                CV_Assert((int)points.size() >= bytes*8*6);
             }
-        }
-
-        void CalcuateSums(int count, const std::vector<int> &points, bool rotationInvariance, const Mat &grayImage, const KeyPoint &pt, int &suma, int &sumc, float cos_theta, float sin_theta, int half_ssd_size)
-
-        {
-            int ax = points[count];
-            int ay = points[count + 1];
-
-            int	bx = points[count + 2];
-            int	by = points[count + 3];
-
-            int cx = points[count + 4];
-            int cy = points[count + 5];
-
-            int ax2 = ax;
-            int ay2 = ay;
-            int bx2 = bx;
-            int by2 = by;
-            int cx2 = cx;
-            int cy2 = cy;
-
-            if (rotationInvariance){
-
-
-                ax2 =(int)(((float)ax)*cos_theta - ((float)ay)*sin_theta);
-                ay2 = (int)(((float)ax)*sin_theta + ((float)ay)*cos_theta);
-                bx2 = (int)(((float)bx)*cos_theta - ((float)by)*sin_theta);
-                by2 = (int)(((float)bx)*sin_theta + ((float)by)*cos_theta);
-                cx2 = (int)(((float)cx)*cos_theta - ((float)cy)*sin_theta);
-                cy2 = (int)(((float)cx)*sin_theta + ((float)cy)*cos_theta);
-
-
-                if (ax2 > 24)
-                    ax2 = 24;
-                if (ax2<-24)
-                    ax2 = -24;
-
-                if (ay2>24)
-                    ay2 = 24;
-                if (ay2<-24)
-                    ay2 = -24;
 
-                if (bx2>24)
-                    bx2 = 24;
-                if (bx2<-24)
-                    bx2 = -24;
-
-                if (by2>24)
-                    by2 = 24;
-                if (by2<-24)
-                    by2 = -24;
-
-                if (cx2>24)
-                    cx2 = 24;
-                if (cx2<-24)
-                    cx2 = -24;
-
-                if (cy2>24)
-                    cy2 = 24;
-                if (cy2 < -24)
-                    cy2 = -24;
-
-            }
-
-
-            ax2 += (int)(pt.pt.x + 0.5);
-            ay2 += (int)(pt.pt.y + 0.5);
-
-            bx2 += (int)(pt.pt.x + 0.5);
-            by2 += (int)(pt.pt.y + 0.5);
-
-            cx2 += (int)(pt.pt.x + 0.5);
-            cy2 += (int)(pt.pt.y + 0.5);
-
-
-            int K = half_ssd_size;
-            for (int iy = -K; iy <= K; iy++)
+            void operator()(const Range& range) const
             {
-                const uchar * Mi_a = grayImage.ptr<uchar>(ay2 + iy);
-                const uchar * Mi_b = grayImage.ptr<uchar>(by2 + iy);
-                const uchar * Mi_c = grayImage.ptr<uchar>(cy2 + iy);
-
-                for (int ix = -K; ix <= K; ix++)
+                const int K = half_ssd_size_;
+                const int w = 2*K + 1;
+                const int ntests = bytes_*8;
+                const size_t step = grayImage_.step;
+                const int* points = &points_[0];
+                std::vector<int> offsets(ntests*3);
+
+                for (int i = range.start; i < range.end; ++i)
                 {
-                    double difa = Mi_a[ax2 + ix] - Mi_b[bx2 + ix];
-                    suma += (int)((difa)*(difa));
+                    uchar* desc = descriptors_.ptr(i);
+                    const KeyPoint& pt = keypoints_[i];
+                    const int kx = (int)(pt.pt.x + 0.5);
+                    const int ky = (int)(pt.pt.y + 0.5);
+
+                    //handling keypoint orientation
+                    float angle = pt.angle;
+                    angle *= (float)(CV_PI / 180.f);
+                    float cos_theta = cos(angle);
+                    float sin_theta = sin(angle);
+
+                    for (int t = 0; t < ntests*3; t++)
+                    {
+                        int x = points[t*2], y = points[t*2 + 1];
+                        if (rotationInvariance_)
+                        {
+                            int x2 = (int)(((float)x)*cos_theta - ((float)y)*sin_theta);
+                            int y2 = (int)(((float)x)*sin_theta + ((float)y)*cos_theta);
+                            x = clampCoord(x2);
+                            y = clampCoord(y2);
+                        }
+                        offsets[t] = (ky + y - K)*(int)step + kx + x - K;
+                    }
 
-                    double difc = Mi_c[cx2 + ix] - Mi_b[bx2 + ix];
-                    sumc += (int)((difc)*(difc));
+                    // the blocks of 8 pixels read past the right border of the patches must stay in the image
+                    const uchar* data = grayImage_.data;
+                    bool simd = data + (size_t)(ky + 24 + K)*step + kx + 24 + K + 8 <= grayImage_.dataend;
+
+                    const int* offs = &offsets[0];
+                    for (int ix = 0; ix < bytes_; ix++)
+                    {
+                        int byte = 0;
+                        for (int j = 7; j >= 0; j--, offs += 3)
+                        {
+                            int suma, sumc;
+                            tripletSSD(data + offs[0], data + offs[1], data + offs[2], step, w, simd, suma, sumc);
+                            byte |= (suma < sumc) << j;
+                        }
+                        desc[ix] = (uchar)byte;
+                    }
                 }
             }
 
-        }
-
+        private:
+            const Mat& grayImage_;
+            const std::vector<KeyPoint>& keypoints_;
+            Mat& descriptors_;
+            const std::vector<int>& points_;
+            bool rotationInvariance_;
+            int half_ssd_size_;
+            int bytes_;
+        };
 
 
         LATCHDescriptorExtractorImpl::LATCHDescriptorExtractorImpl(int bytes, bool rotationInvariance, int half_ssd_size) :
-            bytes_(bytes), test_fn_(NULL), rotationInvariance_(rotationInvariance), half_ssd_size_(half_ssd_size)
+            bytes_(bytes), rotationInvariance_(rotationInvariance), half_ssd_size_(half_ssd_size)
         {
-            switch (bytes)
-            {
-            case 1:
-                test_fn_ = pixelTests1;
-                break;
-            case 2:
-                test_fn_ = pixelTests2;
-                break;
-            case 4:
-                test_fn_ = pixelTests4;
-                break;
-            case 8:
-                test_fn_ = pixelTests8;
-                break;
-            case 16:
-                test_fn_ = pixelTests16;
-                break;
-            case 32:
-                test_fn_ = pixelTests32;
-                break;
-            case 64:
-                test_fn_ = pixelTests64;
-                break;
-            default:
-                CV_Error(Error::StsBadArg, "descriptorSize must be 1,2, 4, 8, 16, 32, or 64");
-            }
-
+            checkDescriptorSize(bytes);
             setSamplingPoints();
         }
 
@@ -454,32 +266,7 @@ namespace cv
         void LATCHDescriptorExtractorImpl::read(const FileNode& fn)
         {
             int dSize = fn["descriptorSize"];
-            switch (dSize)
-            {
-            case 1:
-                test_fn_ = pixelTests1;
-                break;
-            case 2:
-                test_fn_ = pixelTests2;
-                break;
-            case 4:
-                test_fn_ = pixelTests4;
-                break;
-            case 8:
-                test_fn_ = pixelTests8;
-                break;
-            case 16:
-                test_fn_ = pixelTests16;
-                break;
-            case 32:
-                test_fn_ = pixelTests32;
-                break;
-            case 64:
-                test_fn_ = pixelTests64;
-                break;
-            default:
-                CV_Error(Error::StsBadArg, "descriptorSize must be 1,2, 4, 8, 16, 32, or 64");
-            }
+            checkDescriptorSize(dSize);
             bytes_ = dSize;
         }
 
@@ -531,7 +318,8 @@ namespace cv
             //Mat descriptors = _descriptors.getMat();
 
 
-            test_fn_(grayImage, keypoints, descriptors, sampling_points_, rotationInvariance_, half_ssd_size_);
+            parallel_for_(Range(0, (int)keypoints.size()),
+                          LATCHPixelTestsInvoker(grayImage, keypoints, descriptors, sampling_points_, rotationInvariance_, half_ssd_size_, bytes_));
         }
 
 
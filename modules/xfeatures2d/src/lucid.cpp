@@ -47,6 +47,7 @@ the use of this software, even if advised of the possibility of such damage.
 */
 
 #include "precomp.hpp"
+#include <algorithm>
 
 namespace cv {
     namespace xfeatures2d {
@@ -97,6 +98,51 @@ namespace cv {
             return NORM_HAMMING;
         }
 
+        /*!
+         Fills and sorts the descriptors of a range of keypoints, each descriptor being the sorted
+         color values of the (2*l_kernel+1)x(2*l_kernel+1) patch around its keypoint
+         */
+        class LUCIDInvoker : public ParallelLoopBody {
+            public:
+                LUCIDInvoker(const Mat_<Vec3b> &_src, const std::vector<KeyPoint> &_keypoints, Mat_<uchar> &_desc, int _l_kernel)
+                    : src(_src), keypoints(_keypoints), desc(_desc), l_kernel(_l_kernel) {}
+
+                void operator()(const Range &range) const {
+                    const int width = src.cols, height = src.rows, side = l_kernel*2+1, m = side*side*3;
+
+                    for (int i = range.start; i < range.end; ++i) {
+                        const int x = static_cast<int>(keypoints[i].pt.x)-l_kernel, y = static_cast<int>(keypoints[i].pt.y)-l_kernel;
+                        uchar *d = desc.ptr(i);
+
+                        for (int r = y; r < y+side; ++r) {
+                            const int yy = (r < 0 ? height+r : r >= height ? r-height : r);
+
+                            // rows of the patch inside the image are copied at once
+                            if (x >= 0 && x+side <= width)
+                                memcpy(d, src.ptr(yy, x), side*3);
+                            else {
+                                for (int c = x; c < x+side; ++c) {
+                                    const Vec3b &pix = src(yy, (c < 0 ? width+c : c >= width ? c-width : c));
+                                    d[(c-x)*3] = pix[0];
+                                    d[(c-x)*3+1] = pix[1];
+                                    d[(c-x)*3+2] = pix[2];
+                                }
+                            }
+                            d += side*3;
+                        }
+
+                        d = desc.ptr(i);
+                        std::sort(d, d+m);
+                    }
+                }
+
+            private:
+                const Mat_<Vec3b> &src;
+                const std::vector<KeyPoint> &keypoints;
+                Mat_<uchar> &desc;
+                int l_kernel;
+        };
+
         // gliese581h suggested filling a cv::Mat with descriptors to enable BFmatcher compatibility
         // speed-ups and enhancements by gliese581h
         void LUCIDImpl::compute(InputArray _src, std::vector<KeyPoint> &keypoints, OutputArray _desc) {
@@ -105,38 +151,18 @@ namespace cv {
                 return;
             CV_Assert(src_input.depth() == CV_8U && src_input.channels() == 3);
 
+            if (!_desc.needed())
+                return;
+
             Mat_<Vec3b> src;
 
             blur(src_input, src, cv::Size(b_kernel, b_kernel));
 
-            int x, y, j, d, p, m = (l_kernel*2+1)*(l_kernel*2+1)*3, width = src.cols, height = src.rows, r, c;
-
-            Mat_<uchar> desc(static_cast<int>(keypoints.size()), m);
-
-            for (std::size_t i = 0; i < keypoints.size(); ++i) {
-                x = static_cast<int>(keypoints[i].pt.x)-l_kernel, y = static_cast<int>(keypoints[i].pt.y)-l_kernel, d = x+2*l_kernel, p = y+2*l_kernel, j = x, r = static_cast<int>(i), c = 0;
-
-                while (x <= d) {
-                    Vec3b &pix = src((y < 0 ? height+y : y >= height ? y-height : y), (x < 0 ? width+x : x >= width ? x-width : x));
-
-                    desc(r, c++) = pix[0];
-                    desc(r, c++) = pix[1];
-                    desc(r, c++) = pix[2];
-
-                    ++x;
-                    if (x > d) {
-                        if (y < p) {
-                            ++y;
-                            x = j;
-                        }
-                        else
-                            break;
-                    }
-                }
-            }
+            _desc.create(static_cast<int>(keypoints.size()), descriptorSize(), CV_8U);
+            Mat_<uchar> desc = _desc.getMat();
 
-            if (_desc.needed())
-                sort(desc, _desc, SORT_EVERY_ROW | SORT_ASCENDING);
+            // descriptors are independent, each one is sorted in place
+            parallel_for_(Range(0, static_cast<int>(keypoints.size())), LUCIDInvoker(src, keypoints, desc, l_kernel));
         }
     }
 } // END NAMESPACE CV
@@ -63,6 +63,7 @@ References:
 
 #ifdef __cplusplus
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #include "constants.hpp"
 
@@ -74,13 +75,12 @@ namespace cv
         {
 
             static inline float distanceL0_25(
-                const Mat& points1, int idx1,
-                const Mat& points2, int idx2)
+                const float* point1, const float* point2)
             {
                 float result = (float)0.0;
                 for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
                 {
-                    float difference = points1.at<float>(idx1, d) - points2.at<float>(idx2, d);
+                    float difference = point1[d] - point2[d];
                     result += std::sqrt(std::sqrt(std::abs(difference)));
                 }
                 result *= result;
@@ -89,13 +89,12 @@ namespace cv
 
 
             static inline float distanceL0_5(
-                const Mat& points1, int idx1,
-                const Mat& points2, int idx2)
+                const float* point1, const float* point2)
             {
                 float result = (float)0.0;
                 for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
                 {
-                    float difference = points1.at<float>(idx1, d) - points2.at<float>(idx2, d);
+                    float difference = point1[d] - point2[d];
                     result += std::sqrt(std::abs(difference));
                 }
                 return result * result;
@@ -103,13 +102,12 @@ namespace cv
 
 
             static inline float distanceL1(
-                const Mat& points1, int idx1,
-                const Mat& points2, int idx2)
+                const float* point1, const float* point2)
             {
                 float result = (float)0.0;
                 for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
                 {
-                    float difference = points1.at<float>(idx1, d) - points2.at<float>(idx2, d);
+                    float difference = point1[d] - point2[d];
                     result += std::abs(difference);
                 }
                 return result;
@@ -117,13 +115,12 @@ namespace cv
 
 
             static inline float distanceL2(
-                const Mat& points1, int idx1,
-                const Mat& points2, int idx2)
+                const float* point1, const float* point2)
             {
                 float result = (float)0.0;
                 for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
                 {
-                    float difference = points1.at<float>(idx1, d) - points2.at<float>(idx2, d);
+                    float difference = point1[d] - point2[d];
                     result += difference * difference;
                 }
                 return (float)std::sqrt(result);
@@ -131,13 +128,12 @@ namespace cv
 
 
             static inline float distanceL2Squared(
-                const Mat& points1, int idx1,
-                const Mat& points2, int idx2)
+                const float* point1, const float* point2)
             {
                 float result = (float)0.0;
                 for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
                 {
-                    float difference = points1.at<float>(idx1, d) - points2.at<float>(idx2, d);
+                    float difference = point1[d] - point2[d];
                     result += difference * difference;
                 }
                 return result;
@@ -145,13 +141,12 @@ namespace cv
 
 
             static inline float distanceL5(
-                const Mat& points1, int idx1,
-                const Mat& points2, int idx2)
+                const float* point1, const float* point2)
             {
                 float result = (float)0.0;
                 for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
                 {
-                    float difference = points1.at<float>(idx1, d) - points2.at<float>(idx2, d);
+                    float difference = point1[d] - point2[d];
                     result += std::abs(difference) * difference * difference * difference * difference;
                 }
                 return std::pow(result, (float)0.2);
@@ -159,13 +154,12 @@ namespace cv
 
 
             static inline float distanceLInfinity(
-                const Mat& points1, int idx1,
-                const Mat& points2, int idx2)
+                const float* point1, const float* point2)
             {
                 float result = (float)0.0;
                 for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
                 {
-                    float difference = points1.at<float>(idx1, d) - points2.at<float>(idx2, d);
+                    float difference = point1[d] - point2[d];
                     if (difference > result)
                     {
                         result = difference;
@@ -175,6 +169,41 @@ namespace cv
             }
 
 
+            /**
+            * @brief Computed distance between two centroids using given distance function.
+            * @param distanceFunction Distance function selector.
+            * @param point1 The first centroid - one row of a signature.
+            * @param point2 The second centroid - one row of a signature.
+            * @note The first column of a signature contains weights,
+            *       so only columns 1 to SIGNATURE_DIMENSION are used.
+            */
+            static inline float computeDistance(
+                const int distanceFunction,
+                const float* point1, const float* point2)
+            {
+                switch (distanceFunction)
+                {
+                case PCTSignatures::L0_25:
+                    return distanceL0_25(point1, point2);
+                case PCTSignatures::L0_5:
+                    return distanceL0_5(point1, point2);
+                case PCTSignatures::L1:
+                    return distanceL1(point1, point2);
+                case PCTSignatures::L2:
+                    return distanceL2(point1, point2);
+                case PCTSignatures::L2SQUARED:
+                    return distanceL2Squared(point1, point2);
+                case PCTSignatures::L5:
+                    return distanceL5(point1, point2);
+                case PCTSignatures::L_INFINITY:
+                    return distanceLInfinity(point1, point2);
+                default:
+                    CV_Error(Error::StsBadArg, "Distance function not implemented!");
+                    return -1;
+                }
+            }
+
+
             /**
             * @brief Computed distance between two centroids using given distance function.
             * @param distanceFunction Distance function selector.
@@ -190,26 +219,122 @@ namespace cv
                 const Mat& points1, int idx1,
                 const Mat& points2, int idx2)
             {
+                return computeDistance(distanceFunction, points1.ptr<float>(idx1), points2.ptr<float>(idx2));
+            }
+
+
+            /**
+            * @brief Transposes the centroid coordinates into a structure of arrays layout,
+            *       where row d-1 holds the coordinate d of all the centroids.
+            *       The number of columns is padded to a multiple of 4 with zeros.
+            * @param points Signature matrix - one centroid in each row.
+            * @param pointsSoA Output transposed coordinates.
+            */
+            static inline void transposePoints(const Mat& points, Mat& pointsSoA)
+            {
+                pointsSoA.create(SIGNATURE_DIMENSION - 1, (points.rows + 3) & ~3, CV_32F);
+                pointsSoA = Scalar::all(0);
+                for (int i = 0; i < points.rows; i++)
+                {
+                    const float* point = points.ptr<float>(i);
+                    for (int d = 1; d < SIGNATURE_DIMENSION; d++)
+                    {
+                        pointsSoA.at<float>(d - 1, i) = point[d];
+                    }
+                }
+            }
+
+
+            /**
+            * @brief Computes the distances between one centroid and 4 consecutive transposed centroids.
+            *       The dimensions are accumulated in the same order as computeDistance,
+            *       so the results are identical.
+            * @param distanceFunction Distance function selector.
+            * @param point1 The first centroid - one row of a signature.
+            * @param points2SoA The other centroids transposed by transposePoints.
+            * @param idx2 Index of the first of the 4 centroids (multiple of 4).
+            * @param distances Output distances (4 values).
+            */
+            static inline void computeDistances4(
+                const int distanceFunction,
+                const float* point1,
+                const Mat& points2SoA, int idx2,
+                float* distances)
+            {
+#if CV_SIMD128
+                v_float32x4 result = v_setzero_f32();
                 switch (distanceFunction)
                 {
                 case PCTSignatures::L0_25:
-                    return distanceL0_25(points1, idx1, points2, idx2);
+                    for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
+                    {
+                        v_float32x4 difference = v_setall_f32(point1[d]) - v_load(points2SoA.ptr<float>(d - 1) + idx2);
+                        result += v_sqrt(v_sqrt(v_abs(difference)));
+                    }
+                    result *= result;
+                    result *= result;
+                    break;
                 case PCTSignatures::L0_5:
-                    return distanceL0_5(points1, idx1, points2, idx2);
+                    for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
+                    {
+                        v_float32x4 difference = v_setall_f32(point1[d]) - v_load(points2SoA.ptr<float>(d - 1) + idx2);
+                        result += v_sqrt(v_abs(difference));
+                    }
+                    result *= result;
+                    break;
                 case PCTSignatures::L1:
-                    return distanceL1(points1, idx1, points2, idx2);
+                    for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
+                    {
+                        v_float32x4 difference = v_setall_f32(point1[d]) - v_load(points2SoA.ptr<float>(d - 1) + idx2);
+                        result += v_abs(difference);
+                    }
+                    break;
                 case PCTSignatures::L2:
-                    return distanceL2(points1, idx1, points2, idx2);
                 case PCTSignatures::L2SQUARED:
-                    return distanceL2Squared(points1, idx1, points2, idx2);
+                    for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
+                    {
+                        v_float32x4 difference = v_setall_f32(point1[d]) - v_load(points2SoA.ptr<float>(d - 1) + idx2);
+                        result += difference * difference;
+                    }
+                    if (distanceFunction == PCTSignatures::L2)
+                    {
+                        result = v_sqrt(result);
+                    }
+                    break;
                 case PCTSignatures::L5:
-                    return distanceL5(points1, idx1, points2, idx2);
+                    for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
+                    {
+                        v_float32x4 difference = v_setall_f32(point1[d]) - v_load(points2SoA.ptr<float>(d - 1) + idx2);
+                        result += v_abs(difference) * difference * difference * difference * difference;
+                    }
+                    v_store(distances, result);
+                    for (int l = 0; l < 4; l++)
+                    {
+                        distances[l] = std::pow(distances[l], (float)0.2);
+                    }
+                    return;
                 case PCTSignatures::L_INFINITY:
-                    return distanceLInfinity(points1, idx1, points2, idx2);
+                    for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
+                    {
+                        v_float32x4 difference = v_setall_f32(point1[d]) - v_load(points2SoA.ptr<float>(d - 1) + idx2);
+                        result = v_select(difference > result, difference, result);
+                    }
+                    break;
                 default:
                     CV_Error(Error::StsBadArg, "Distance function not implemented!");
-                    return -1;
                 }
+                v_store(distances, result);
+#else
+                for (int l = 0; l < 4; l++)
+                {
+                    float point2[SIGNATURE_DIMENSION];
+                    for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
+                    {
+                        point2[d] = points2SoA.at<float>(d - 1, idx2 + l);
+                    }
+                    distances[l] = computeDistance(distanceFunction, point1, point2);
+                }
+#endif
             }
         }
     }
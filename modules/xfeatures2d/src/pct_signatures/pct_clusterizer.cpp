@@ -68,6 +68,122 @@ namespace cv
     {
         namespace pct_signatures
         {
+            /**
+            * @brief Class implementing parallel search of the closest cluster of each sample.
+            *       The samples are processed by blocks of 4, one distance kernel call
+            *       computing the distances of a whole block to one cluster.
+            */
+            class Parallel_findClosestClusters : public ParallelLoopBody
+            {
+            private:
+                const Mat* mClusters;
+                const Mat* mSamplesSoA;
+                std::vector<int>* mClosest;
+                int mDistanceFunction;
+
+            public:
+                Parallel_findClosestClusters(
+                    const Mat* clusters,
+                    const Mat* samplesSoA,
+                    std::vector<int>* closest,
+                    int distanceFunction)
+                    : mClusters(clusters),
+                    mSamplesSoA(samplesSoA),
+                    mClosest(closest),
+                    mDistanceFunction(distanceFunction)
+                {
+                }
+
+                void operator()(const Range& range) const
+                {
+                    int sampleCount = (int)mClosest->size();
+                    for (int iBlock = range.start; iBlock < range.end; iBlock++)
+                    {
+                        int iSample = iBlock * 4;
+                        float minDistance[4], distance[4];
+                        int iClosest[4] = { 0, 0, 0, 0 };
+                        computeDistances4(mDistanceFunction, mClusters->ptr<float>(0), *mSamplesSoA, iSample, minDistance);
+
+                        for (int iCluster = 1; iCluster < mClusters->rows; iCluster++)
+                        {
+                            computeDistances4(mDistanceFunction, mClusters->ptr<float>(iCluster), *mSamplesSoA, iSample, distance);
+                            for (int l = 0; l < 4; l++)
+                            {
+                                if (distance[l] < minDistance[l])
+                                {
+                                    iClosest[l] = iCluster;
+                                    minDistance[l] = distance[l];
+                                }
+                            }
+                        }
+
+                        for (int l = 0; l < 4 && iSample + l < sampleCount; l++)
+                        {
+                            (*mClosest)[iSample + l] = iClosest[l];
+                        }
+                    }
+                }
+            };
+
+
+            /**
+            * @brief Class implementing parallel search of the clusters to be joined.
+            *       A cluster is joined if a following cluster with non-zero weight is close enough.
+            *       The weights are only read here, so every cluster can be checked independently.
+            */
+            class Parallel_findJoinedClusters : public ParallelLoopBody
+            {
+            private:
+                const Mat* mClusters;
+                const Mat* mClustersSoA;
+                std::vector<uchar>* mJoined;
+                int mDistanceFunction;
+                float mJoiningDistance;
+
+            public:
+                Parallel_findJoinedClusters(
+                    const Mat* clusters,
+                    const Mat* clustersSoA,
+                    std::vector<uchar>* joined,
+                    int distanceFunction,
+                    float joiningDistance)
+                    : mClusters(clusters),
+                    mClustersSoA(clustersSoA),
+                    mJoined(joined),
+                    mDistanceFunction(distanceFunction),
+                    mJoiningDistance(joiningDistance)
+                {
+                }
+
+                void operator()(const Range& range) const
+                {
+                    const Mat& clusters = *mClusters;
+                    for (int i = range.start; i < range.end; i++)
+                    {
+                        (*mJoined)[i] = 0;
+                        if (clusters.at<float>(i, WEIGHT_IDX) == 0)
+                        {
+                            continue;
+                        }
+
+                        float distance[4];
+                        for (int jBlock = (i + 1) & ~3; jBlock < clusters.rows && !(*mJoined)[i]; jBlock += 4)
+                        {
+                            computeDistances4(mDistanceFunction, clusters.ptr<float>(i), *mClustersSoA, jBlock, distance);
+                            for (int l = std::max(i + 1 - jBlock, 0); l < 4 && jBlock + l < clusters.rows; l++)
+                            {
+                                if (clusters.at<float>(jBlock + l, WEIGHT_IDX) > 0 && distance[l] <= mJoiningDistance)
+                                {
+                                    (*mJoined)[i] = 1;
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                }
+            };
+
+
             class PCTClusterizer_Impl : public PCTClusterizer
             {
             public:
@@ -141,6 +257,11 @@ namespace cv
                     dropLightPoints(clusters);
 
 
+                    // Samples are transposed once, so that the distances to 4 samples are computed at once.
+                    Mat samplesSoA;
+                    transposePoints(samples, samplesSoA);
+                    std::vector<int> closest(samples.rows);
+
                     // Main iterations cycle. Our implementation has fixed number of iterations.
                     for (int iteration = 0; iteration < mIterationCount; iteration++)
                     {
@@ -151,10 +272,14 @@ namespace cv
                         // Clear weights for new iteration.
                         clusters(Rect(WEIGHT_IDX, 0, 1, clusters.rows)) = 0;
 
-                        // Compute affiliation of points and sum new coordinates for centroids.
+                        // Compute affiliation of points in parallel.
+                        parallel_for_(Range(0, (samples.rows + 3) / 4),
+                            Parallel_findClosestClusters(&clusters, &samplesSoA, &closest, mDistanceFunction));
+
+                        // Sum new coordinates for centroids, in the order of the samples so that the result does not depend on threads.
                         for (int iSample = 0; iSample < samples.rows; iSample++)
                         {
-                            int iClosest = findClosestCluster(clusters, samples, iSample);
+                            int iClosest = closest[iSample];
                             for (int iDimension = 1; iDimension < SIGNATURE_DIMENSION; iDimension++)
                             {
                                 tmpCentroids.at<float>(iClosest, iDimension) += samples.at<float>(iSample, iDimension);
@@ -217,21 +342,19 @@ namespace cv
                 */
                 void joinCloseClusters(Mat& clusters)
                 {
-                    for (int i = 0; i < clusters.rows - 1; i++)
-                    {
-                        if (clusters.at<float>(i, WEIGHT_IDX) == 0)
-                        {
-                            continue;
-                        }
+                    // Only the weights of the clusters before j are changed when j is checked,
+                    // so all the clusters are checked against the weights before joining.
+                    Mat clustersSoA;
+                    transposePoints(clusters, clustersSoA);
+                    std::vector<uchar> joined(clusters.rows);
+                    parallel_for_(Range(0, clusters.rows),
+                        Parallel_findJoinedClusters(&clusters, &clustersSoA, &joined, mDistanceFunction, mJoiningDistance));
 
-                        for (int j = i + 1; j < clusters.rows; j++)
+                    for (int i = 0; i < clusters.rows; i++)
+                    {
+                        if (joined[i])
                         {
-                            if (clusters.at<float>(j, WEIGHT_IDX) > 0
-                                && computeDistance(mDistanceFunction, clusters, i, clusters, j) <= mJoiningDistance)
-                            {
-                                clusters.at<float>(i, WEIGHT_IDX) = 0;
-                                break;
-                            }
+                            clusters.at<float>(i, WEIGHT_IDX) = 0;
                         }
                     }
                 }
@@ -269,31 +392,6 @@ namespace cv
                 }
 
 
-                /**
-                * @brief Find closest cluster to selected point.
-                * @param clusters List of cluster centroids.
-                * @param points List of points.
-                * @param pointIdx Index to the list of points (the point for which the closest cluster is being found).
-                * @return Index to clusters list pointing at the closest cluster.
-                */
-                int findClosestCluster(const Mat& clusters, const Mat& points, const int pointIdx) const    // HOT PATH: 35%
-                {
-                    int iClosest = 0;
-                    float minDistance = computeDistance(mDistanceFunction, clusters, 0, points, pointIdx);
-
-                    for (int iCluster = 1; iCluster < clusters.rows; iCluster++)
-                    {
-                        float distance = computeDistance(mDistanceFunction, clusters, iCluster, points, pointIdx);
-                        if (distance < minDistance)
-                        {
-                            iClosest = iCluster;
-                            minDistance = distance;
-                        }
-                    }
-                    return iClosest;
-                }
-
-
                 /**
                 * @brief Make sure that the number of clusters does not exceed maxClusters parameter.
                 *       If it does, the clusters are sorted by their weights and the smallest clusters
@@ -104,6 +104,32 @@ namespace cv
 
 
 
+            /**
+            * @brief Computes the similarity of two centroids from their distance.
+            * @param similarity Similarity function selector.
+            * @param similarityParameter Parameter of the similarity function.
+            * @param distance Distance of the centroids computed by computeDistance.
+            */
+            static inline float computeSimilarityFromDistance(
+                const int similarity,
+                const float similarityParameter,
+                const float distance)
+            {
+                switch (similarity)
+                {
+                case PCTSignatures::MINUS:
+                    return -distance;
+                case PCTSignatures::GAUSSIAN:
+                    return exp(-similarityParameter + distance * distance);
+                case PCTSignatures::HEURISTIC:
+                    return 1 / (similarityParameter + distance);
+                default:
+                    CV_Error(Error::StsNotImplemented, "Similarity function not implemented!");
+                    return -1;
+                }
+            }
+
+
             static inline float computeSimilarity(
                 const int distancefunction,
                 const int similarity,
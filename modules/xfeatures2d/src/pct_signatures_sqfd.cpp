@@ -91,6 +91,16 @@ namespace cv
                     const std::vector<Mat>& imageSignatures,
                     std::vector<float>& distances) const;
 
+                /**
+                * @brief Computes SQFD of two checked signatures, the partial SQFD of the first
+                *       signature with itself being given, so that it is computed once for many images.
+                */
+                float computeQuadraticFormDistance(
+                    const Mat& signature0,
+                    float partialSQFD00,
+                    const Mat& signature1) const;
+
+
 
             private:
                 int mDistanceFunction;
@@ -104,25 +114,45 @@ namespace cv
             };
 
 
+            /**
+            * @brief Checks the format of a non-empty signature.
+            */
+            static void checkSignatureFormat(const Mat& signature)
+            {
+                if (signature.cols != SIGNATURE_DIMENSION)
+                {
+                    CV_Error_(Error::StsBadArg, ("Signature dimension must be %d!", SIGNATURE_DIMENSION));
+                }
+
+                if (signature.rows <= 0)
+                {
+                    CV_Error(Error::StsBadArg, "Signature count must be greater than 0!");
+                }
+            }
+
+
             /**
             * @brief Class implementing parallel computing of SQFD distance for multiple images.
             */
             class Parallel_computeSQFDs : public ParallelLoopBody
             {
             private:
-                const PCTSignaturesSQFD* mPctSignaturesSQFDAlgorithm;
+                const PCTSignaturesSQFD_Impl* mPctSignaturesSQFDAlgorithm;
                 const Mat* mSourceSignature;
+                float mSourcePartialSQFD;
                 const std::vector<Mat>* mImageSignatures;
                 std::vector<float>* mDistances;
 
             public:
                 Parallel_computeSQFDs(
-                    const PCTSignaturesSQFD* pctSignaturesSQFDAlgorithm,
+                    const PCTSignaturesSQFD_Impl* pctSignaturesSQFDAlgorithm,
                     const Mat* sourceSignature,
+                    float sourcePartialSQFD,
                     const std::vector<Mat>* imageSignatures,
                     std::vector<float>* distances)
                     : mPctSignaturesSQFDAlgorithm(pctSignaturesSQFDAlgorithm),
                     mSourceSignature(sourceSignature),
+                    mSourcePartialSQFD(sourcePartialSQFD),
                     mImageSignatures(imageSignatures),
                     mDistances(distances)
                 {
@@ -131,20 +161,17 @@ namespace cv
 
                 void operator()(const Range& range) const
                 {
-                    if (mSourceSignature->empty())
-                    {
-                        CV_Error(Error::StsBadArg, "Source signature is empty!");
-                    }
-
                     for (int i = range.start; i < range.end; i++)
                     {
-                        if (mImageSignatures[i].empty())
+                        const Mat& imageSignature = (*mImageSignatures)[i];
+                        if (imageSignature.empty())
                         {
                             CV_Error_(Error::StsBadArg, ("Signature ID: %d is empty!", i));
                         }
 
+                        checkSignatureFormat(imageSignature);
                         (*mDistances)[i] = mPctSignaturesSQFDAlgorithm->computeQuadraticFormDistance(
-                            *mSourceSignature, (*mImageSignatures)[i]);
+                            *mSourceSignature, mSourcePartialSQFD, imageSignature);
                     }
                 }
             };
@@ -163,19 +190,20 @@ namespace cv
                 Mat signature0 = _signature0.getMat();
                 Mat signature1 = _signature1.getMat();
 
-                if (signature0.cols != SIGNATURE_DIMENSION || signature1.cols != SIGNATURE_DIMENSION)
-                {
-                    CV_Error_(Error::StsBadArg, ("Signature dimension must be %d!", SIGNATURE_DIMENSION));
-                }
+                checkSignatureFormat(signature0);
+                checkSignatureFormat(signature1);
 
-                if (signature0.rows <= 0 || signature1.rows <= 0)
-                {
-                    CV_Error(Error::StsBadArg, "Signature count must be greater than 0!");
-                }
+                return computeQuadraticFormDistance(signature0, computePartialSQFD(signature0, signature0), signature1);
+            }
 
+            float PCTSignaturesSQFD_Impl::computeQuadraticFormDistance(
+                      const Mat& signature0,
+                      float partialSQFD00,
+                      const Mat& signature1) const
+            {
                 // compute sqfd
                 float result = 0;
-                result += computePartialSQFD(signature0, signature0);
+                result += partialSQFD00;
                 result += computePartialSQFD(signature1, signature1);
                 result -= computePartialSQFD(signature0, signature1) * 2;
 
@@ -187,21 +215,40 @@ namespace cv
                       const std::vector<Mat>& imageSignatures,
                       std::vector<float>& distances) const
             {
+                if (sourceSignature.empty())
+                {
+                    CV_Error(Error::StsBadArg, "Source signature is empty!");
+                }
+                checkSignatureFormat(sourceSignature);
+
+                // the partial SQFD of the source signature is shared by all the images
+                float sourcePartialSQFD = computePartialSQFD(sourceSignature, sourceSignature);
                 parallel_for_(Range(0, (int)imageSignatures.size()),
-                    Parallel_computeSQFDs(this, &sourceSignature, &imageSignatures, &distances));
+                    Parallel_computeSQFDs(this, &sourceSignature, sourcePartialSQFD, &imageSignatures, &distances));
             }
 
             float PCTSignaturesSQFD_Impl::computePartialSQFD(
                       const Mat& signature0,
                       const Mat& signature1) const
             {
+                // the distances of a centroid to 4 centroids of the other signature are computed at once,
+                // the sum is still accumulated in the order of the centroids
+                Mat signature1SoA;
+                transposePoints(signature1, signature1SoA);
+
                 float result = 0;
+                float distances[4];
                 for (int i = 0; i < signature0.rows; i++)
                 {
-                    for (int j = 0; j < signature1.rows; j++)
+                    const float* point0 = signature0.ptr<float>(i);
+                    for (int j = 0; j < signature1.rows; j += 4)
                     {
-                        result += signature0.at<float>(i, WEIGHT_IDX) * signature1.at<float>(j, WEIGHT_IDX)
-                            * computeSimilarity(mDistanceFunction, mSimilarityFunction, mSimilarityParameter, signature0, i, signature1, j);
+                        computeDistances4(mDistanceFunction, point0, signature1SoA, j, distances);
+                        for (int l = 0; l < 4 && j + l < signature1.rows; l++)
+                        {
+                            result += point0[WEIGHT_IDX] * signature1.at<float>(j + l, WEIGHT_IDX)
+                                * computeSimilarityFromDistance(mSimilarityFunction, mSimilarityParameter, distances[l]);
+                        }
                     }
                 }
                 return result;
@@ -106,6 +106,7 @@
 #include <iostream>
 #include <stdarg.h>
 #include <opencv2/core/hal/hal.hpp>
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv
 {
@@ -173,6 +174,12 @@ static const float SIFT_INIT_SIGMA = 0.5f;
 // width of border in which to ignore keypoints
 static const int SIFT_IMG_BORDER = 5;
 
+// number of rows of the DoG layers searched for extrema by a single task
+static const int SIFT_EXTREMA_TILE_ROWS = 32;
+
+// number of rows of the stripes blurred by a single task
+static const int SIFT_BLUR_STRIPE_ROWS = 64;
+
 // maximum steps of keypoint interpolation before failure
 static const int SIFT_MAX_INTERP_STEPS = 5;
 
@@ -197,7 +204,8 @@ static const float SIFT_DESCR_MAG_THR = 0.2f;
 // factor used to convert floating-point descriptor to unsigned char
 static const float SIFT_INT_DESCR_FCTR = 512.f;
 
-#if 0
+#define DoG_TYPE_SHORT 0
+#if DoG_TYPE_SHORT
 // intermediate type used for DoG pyramids
 typedef short sift_wt;
 static const int SIFT_FIXPT_SCALE = 48;
@@ -216,6 +224,48 @@ unpackOctave(const KeyPoint& kpt, int& octave, int& layer, float& scale)
     scale = octave >= 0 ? 1.f/(1 << octave) : (float)(1 << -octave);
 }
 
+// Blurs horizontal stripes of the image. Filtering a ROI reads the rows around it
+// from the parent image, so the stripes join exactly as if the whole image was blurred.
+class GaussianBlurComputer : public ParallelLoopBody
+{
+public:
+    GaussianBlurComputer(
+        const Mat& _src,
+        Mat& _dst,
+        double _sigma)
+        : src(_src),
+          dst(_dst),
+          sigma(_sigma) { }
+
+    void operator()( const cv::Range& range ) const
+    {
+        Mat dstStripe = dst.rowRange(range);
+        GaussianBlur(src.rowRange(range), dstStripe, Size(), sigma, sigma);
+    }
+
+private:
+    const Mat& src;
+    Mat& dst;
+    double sigma;
+};
+
+static void parallelGaussianBlur( const Mat& src, Mat& dst, double sigma )
+{
+    CV_Assert( src.data != dst.data );
+#ifdef HAVE_IPP
+    // IPP blurs submatrices as separate images, without the rows around them
+    if( ipp::useIPP() )
+    {
+        GaussianBlur(src, dst, Size(), sigma, sigma);
+        return;
+    }
+#endif
+    dst.create(src.size(), src.type());
+    // the stripes depend on the image size only, not on the number of threads
+    int nstripes = std::max(src.rows / SIFT_BLUR_STRIPE_ROWS, 1);
+    parallel_for_(Range(0, src.rows), GaussianBlurComputer(src, dst, sigma), nstripes);
+}
+
 static Mat createInitialImage( const Mat& img, bool doubleImageSize, float sigma )
 {
     Mat gray, gray_fpt;
@@ -232,16 +282,17 @@ static Mat createInitialImage( const Mat& img, bool doubleImageSize, float sigma
     if( doubleImageSize )
     {
         sig_diff = sqrtf( std::max(sigma * sigma - SIFT_INIT_SIGMA * SIFT_INIT_SIGMA * 4, 0.01f) );
-        Mat dbl;
+        Mat dbl, base;
         resize(gray_fpt, dbl, Size(gray_fpt.cols*2, gray_fpt.rows*2), 0, 0, INTER_LINEAR);
-        GaussianBlur(dbl, dbl, Size(), sig_diff, sig_diff);
-        return dbl;
+        parallelGaussianBlur(dbl, base, sig_diff);
+        return base;
     }
     else
     {
         sig_diff = sqrtf( std::max(sigma * sigma - SIFT_INIT_SIGMA * SIFT_INIT_SIGMA, 0.01f) );
-        GaussianBlur(gray_fpt, gray_fpt, Size(), sig_diff, sig_diff);
-        return gray_fpt;
+        Mat base;
+        parallelGaussianBlur(gray_fpt, base, sig_diff);
+        return base;
     }
 }
 
@@ -279,7 +330,7 @@ void SIFT_Impl::buildGaussianPyramid( const Mat& base, std::vector<Mat>& pyr, in
             else
             {
                 const Mat& src = pyr[o*(nOctaveLayers + 3) + i-1];
-                GaussianBlur(src, dst, Size(), sig[i], sig[i]);
+                parallelGaussianBlur(src, dst, sig[i]);
             }
         }
     }
@@ -569,92 +620,196 @@ static bool adjustLocalExtrema( const std::vector<Mat>& dog_pyr, KeyPoint& kpt,
 }
 
 
-//
-// Detects features at extrema in DoG scale space.  Bad features are discarded
-// based on contrast and ratio of principal curvatures.
-void SIFT_Impl::findScaleSpaceExtrema( const std::vector<Mat>& gauss_pyr, const std::vector<Mat>& dog_pyr,
-                                  std::vector<KeyPoint>& keypoints ) const
+// Checks if the pixel is an extremum of its 3x3x3 neighbourhood in the DoG scale space
+static inline bool isLocalExtremum( const sift_wt* currptr, const sift_wt* prevptr, const sift_wt* nextptr,
+                                    int c, int step, int threshold )
 {
-    int nOctaves = (int)gauss_pyr.size()/(nOctaveLayers + 3);
-    int threshold = cvFloor(0.5 * contrastThreshold / nOctaveLayers * 255 * SIFT_FIXPT_SCALE);
-    const int n = SIFT_ORI_HIST_BINS;
-    float hist[n];
-    KeyPoint kpt;
+    sift_wt val = currptr[c];
+    return std::abs(val) > threshold &&
+       ((val > 0 && val >= currptr[c-1] && val >= currptr[c+1] &&
+         val >= currptr[c-step-1] && val >= currptr[c-step] && val >= currptr[c-step+1] &&
+         val >= currptr[c+step-1] && val >= currptr[c+step] && val >= currptr[c+step+1] &&
+         val >= nextptr[c] && val >= nextptr[c-1] && val >= nextptr[c+1] &&
+         val >= nextptr[c-step-1] && val >= nextptr[c-step] && val >= nextptr[c-step+1] &&
+         val >= nextptr[c+step-1] && val >= nextptr[c+step] && val >= nextptr[c+step+1] &&
+         val >= prevptr[c] && val >= prevptr[c-1] && val >= prevptr[c+1] &&
+         val >= prevptr[c-step-1] && val >= prevptr[c-step] && val >= prevptr[c-step+1] &&
+         val >= prevptr[c+step-1] && val >= prevptr[c+step] && val >= prevptr[c+step+1]) ||
+        (val < 0 && val <= currptr[c-1] && val <= currptr[c+1] &&
+         val <= currptr[c-step-1] && val <= currptr[c-step] && val <= currptr[c-step+1] &&
+         val <= currptr[c+step-1] && val <= currptr[c+step] && val <= currptr[c+step+1] &&
+         val <= nextptr[c] && val <= nextptr[c-1] && val <= nextptr[c+1] &&
+         val <= nextptr[c-step-1] && val <= nextptr[c-step] && val <= nextptr[c-step+1] &&
+         val <= nextptr[c+step-1] && val <= nextptr[c+step] && val <= nextptr[c+step+1] &&
+         val <= prevptr[c] && val <= prevptr[c-1] && val <= prevptr[c+1] &&
+         val <= prevptr[c-step-1] && val <= prevptr[c-step] && val <= prevptr[c-step+1] &&
+         val <= prevptr[c+step-1] && val <= prevptr[c+step] && val <= prevptr[c+step+1]));
+}
 
-    keypoints.clear();
+// Searches tiles of rows of the DoG layers for extrema, each tile into its own buffer
+class findScaleSpaceExtremaComputer : public ParallelLoopBody
+{
+public:
+    findScaleSpaceExtremaComputer(
+        const std::vector<Mat>& _gauss_pyr,
+        const std::vector<Mat>& _dog_pyr,
+        const std::vector<Vec3i>& _tiles,
+        std::vector<std::vector<KeyPoint> >& _tileKeypoints,
+        int _nOctaveLayers,
+        int _threshold,
+        float _contrastThreshold,
+        float _edgeThreshold,
+        float _sigma)
+        : gauss_pyr(_gauss_pyr),
+          dog_pyr(_dog_pyr),
+          tiles(_tiles),
+          tileKeypoints(_tileKeypoints),
+          nOctaveLayers(_nOctaveLayers),
+          threshold(_threshold),
+          contrastThreshold(_contrastThreshold),
+          edgeThreshold(_edgeThreshold),
+          sigma(_sigma) { }
 
-    for( int o = 0; o < nOctaves; o++ )
-        for( int i = 1; i <= nOctaveLayers; i++ )
+    void operator()( const cv::Range& range ) const
+    {
+        for( int t = range.start; t < range.end; t++ )
         {
+            const int o = tiles[t][0], i = tiles[t][1];
             int idx = o*(nOctaveLayers+2)+i;
             const Mat& img = dog_pyr[idx];
             const Mat& prev = dog_pyr[idx-1];
             const Mat& next = dog_pyr[idx+1];
             int step = (int)img.step1();
             int rows = img.rows, cols = img.cols;
+            int rowBegin = tiles[t][2];
+            int rowEnd = std::min(rowBegin + SIFT_EXTREMA_TILE_ROWS, rows-SIFT_IMG_BORDER);
+            std::vector<KeyPoint>& keypoints = tileKeypoints[t];
 
-            for( int r = SIFT_IMG_BORDER; r < rows-SIFT_IMG_BORDER; r++)
+            for( int r = rowBegin; r < rowEnd; r++)
             {
                 const sift_wt* currptr = img.ptr<sift_wt>(r);
                 const sift_wt* prevptr = prev.ptr<sift_wt>(r);
                 const sift_wt* nextptr = next.ptr<sift_wt>(r);
-
-                for( int c = SIFT_IMG_BORDER; c < cols-SIFT_IMG_BORDER; c++)
+                int c = SIFT_IMG_BORDER;
+
+#if CV_SIMD128 && !DoG_TYPE_SHORT
+                // rejects the blocks of pixels without any extremum, the candidates
+                // are then checked one by one
+                const int offsets[9] = { -step-1, -step, -step+1, -1, 0, 1, step-1, step, step+1 };
+                const v_float32x4 vthreshold = v_setall_f32((float)threshold), vzero = v_setzero_f32();
+                for( ; c <= cols-SIFT_IMG_BORDER-4; c += 4 )
                 {
-                    sift_wt val = currptr[c];
-
-                    // find local extrema with pixel accuracy
-                    if( std::abs(val) > threshold &&
-                       ((val > 0 && val >= currptr[c-1] && val >= currptr[c+1] &&
-                         val >= currptr[c-step-1] && val >= currptr[c-step] && val >= currptr[c-step+1] &&
-                         val >= currptr[c+step-1] && val >= currptr[c+step] && val >= currptr[c+step+1] &&
-                         val >= nextptr[c] && val >= nextptr[c-1] && val >= nextptr[c+1] &&
-                         val >= nextptr[c-step-1] && val >= nextptr[c-step] && val >= nextptr[c-step+1] &&
-                         val >= nextptr[c+step-1] && val >= nextptr[c+step] && val >= nextptr[c+step+1] &&
-                         val >= prevptr[c] && val >= prevptr[c-1] && val >= prevptr[c+1] &&
-                         val >= prevptr[c-step-1] && val >= prevptr[c-step] && val >= prevptr[c-step+1] &&
-                         val >= prevptr[c+step-1] && val >= prevptr[c+step] && val >= prevptr[c+step+1]) ||
-                        (val < 0 && val <= currptr[c-1] && val <= currptr[c+1] &&
-                         val <= currptr[c-step-1] && val <= currptr[c-step] && val <= currptr[c-step+1] &&
-                         val <= currptr[c+step-1] && val <= currptr[c+step] && val <= currptr[c+step+1] &&
-                         val <= nextptr[c] && val <= nextptr[c-1] && val <= nextptr[c+1] &&
-                         val <= nextptr[c-step-1] && val <= nextptr[c-step] && val <= nextptr[c-step+1] &&
-                         val <= nextptr[c+step-1] && val <= nextptr[c+step] && val <= nextptr[c+step+1] &&
-                         val <= prevptr[c] && val <= prevptr[c-1] && val <= prevptr[c+1] &&
-                         val <= prevptr[c-step-1] && val <= prevptr[c-step] && val <= prevptr[c-step+1] &&
-                         val <= prevptr[c+step-1] && val <= prevptr[c+step] && val <= prevptr[c+step+1])))
+                    v_float32x4 val = v_load(currptr + c);
+                    v_float32x4 vmax = v_load(currptr + c - 1), vmin = vmax;
+                    for( int k = 0; k < 9; k++ )
                     {
-                        int r1 = r, c1 = c, layer = i;
-                        if( !adjustLocalExtrema(dog_pyr, kpt, o, layer, r1, c1,
-                                                nOctaveLayers, (float)contrastThreshold,
-                                                (float)edgeThreshold, (float)sigma) )
-                            continue;
-                        float scl_octv = kpt.size*0.5f/(1 << o);
-                        float omax = calcOrientationHist(gauss_pyr[o*(nOctaveLayers+3) + layer],
-                                                         Point(c1, r1),
-                                                         cvRound(SIFT_ORI_RADIUS * scl_octv),
-                                                         SIFT_ORI_SIG_FCTR * scl_octv,
-                                                         hist, n);
-                        float mag_thr = (float)(omax * SIFT_ORI_PEAK_RATIO);
-                        for( int j = 0; j < n; j++ )
+                        v_float32x4 vp = v_load(prevptr + c + offsets[k]);
+                        v_float32x4 vn = v_load(nextptr + c + offsets[k]);
+                        vmax = v_max(vmax, v_max(vp, vn));
+                        vmin = v_min(vmin, v_min(vp, vn));
+                        if( k != 4 )
                         {
-                            int l = j > 0 ? j - 1 : n - 1;
-                            int r2 = j < n-1 ? j + 1 : 0;
-
-                            if( hist[j] > hist[l]  &&  hist[j] > hist[r2]  &&  hist[j] >= mag_thr )
-                            {
-                                float bin = j + 0.5f * (hist[l]-hist[r2]) / (hist[l] - 2*hist[j] + hist[r2]);
-                                bin = bin < 0 ? n + bin : bin >= n ? bin - n : bin;
-                                kpt.angle = 360.f - (float)((360.f/n) * bin);
-                                if(std::abs(kpt.angle - 360.f) < FLT_EPSILON)
-                                    kpt.angle = 0.f;
-                                keypoints.push_back(kpt);
-                            }
+                            v_float32x4 vc = v_load(currptr + c + offsets[k]);
+                            vmax = v_max(vmax, vc);
+                            vmin = v_min(vmin, vc);
                         }
                     }
+                    v_float32x4 mask = (v_abs(val) > vthreshold) &
+                                       (((val > vzero) & (val >= vmax)) | ((val < vzero) & (val <= vmin)));
+                    int m = v_signmask(mask);
+                    for( int k = 0; m != 0; k++, m >>= 1 )
+                        if( (m & 1) && isLocalExtremum(currptr, prevptr, nextptr, c + k, step, threshold) )
+                            addExtremum(o, i, r, c + k, keypoints);
                 }
+#endif
+                for( ; c < cols-SIFT_IMG_BORDER; c++)
+                {
+                    // find local extrema with pixel accuracy
+                    if( isLocalExtremum(currptr, prevptr, nextptr, c, step, threshold) )
+                        addExtremum(o, i, r, c, keypoints);
+                }
+            }
+        }
+    }
+
+private:
+    // Refines the extremum and adds a keypoint for each dominant orientation
+    void addExtremum( int o, int i, int r, int c, std::vector<KeyPoint>& keypoints ) const
+    {
+        const int n = SIFT_ORI_HIST_BINS;
+        float hist[n];
+        KeyPoint kpt;
+
+        int r1 = r, c1 = c, layer = i;
+        if( !adjustLocalExtrema(dog_pyr, kpt, o, layer, r1, c1,
+                                nOctaveLayers, contrastThreshold,
+                                edgeThreshold, sigma) )
+            return;
+        float scl_octv = kpt.size*0.5f/(1 << o);
+        float omax = calcOrientationHist(gauss_pyr[o*(nOctaveLayers+3) + layer],
+                                         Point(c1, r1),
+                                         cvRound(SIFT_ORI_RADIUS * scl_octv),
+                                         SIFT_ORI_SIG_FCTR * scl_octv,
+                                         hist, n);
+        float mag_thr = (float)(omax * SIFT_ORI_PEAK_RATIO);
+        for( int j = 0; j < n; j++ )
+        {
+            int l = j > 0 ? j - 1 : n - 1;
+            int r2 = j < n-1 ? j + 1 : 0;
+
+            if( hist[j] > hist[l]  &&  hist[j] > hist[r2]  &&  hist[j] >= mag_thr )
+            {
+                float bin = j + 0.5f * (hist[l]-hist[r2]) / (hist[l] - 2*hist[j] + hist[r2]);
+                bin = bin < 0 ? n + bin : bin >= n ? bin - n : bin;
+                kpt.angle = 360.f - (float)((360.f/n) * bin);
+                if(std::abs(kpt.angle - 360.f) < FLT_EPSILON)
+                    kpt.angle = 0.f;
+                keypoints.push_back(kpt);
             }
         }
+    }
+
+    const std::vector<Mat>& gauss_pyr;
+    const std::vector<Mat>& dog_pyr;
+    const std::vector<Vec3i>& tiles;
+    std::vector<std::vector<KeyPoint> >& tileKeypoints;
+    int nOctaveLayers;
+    int threshold;
+    float contrastThreshold;
+    float edgeThreshold;
+    float sigma;
+};
+
+//
+// Detects features at extrema in DoG scale space.  Bad features are discarded
+// based on contrast and ratio of principal curvatures.
+void SIFT_Impl::findScaleSpaceExtrema( const std::vector<Mat>& gauss_pyr, const std::vector<Mat>& dog_pyr,
+                                  std::vector<KeyPoint>& keypoints ) const
+{
+    int nOctaves = (int)gauss_pyr.size()/(nOctaveLayers + 3);
+    int threshold = cvFloor(0.5 * contrastThreshold / nOctaveLayers * 255 * SIFT_FIXPT_SCALE);
+
+    // tiles of rows of all the layers of all the octaves, in the order of a serial scan
+    std::vector<Vec3i> tiles;
+    for( int o = 0; o < nOctaves; o++ )
+        for( int i = 1; i <= nOctaveLayers; i++ )
+        {
+            int rows = dog_pyr[o*(nOctaveLayers+2)+i].rows;
+            for( int r = SIFT_IMG_BORDER; r < rows-SIFT_IMG_BORDER; r += SIFT_EXTREMA_TILE_ROWS )
+                tiles.push_back(Vec3i(o, i, r));
+        }
+
+    std::vector<std::vector<KeyPoint> > tileKeypoints(tiles.size());
+    parallel_for_(Range(0, (int)tiles.size()),
+                  findScaleSpaceExtremaComputer(gauss_pyr, dog_pyr, tiles, tileKeypoints,
+                                                nOctaveLayers, threshold, (float)contrastThreshold,
+                                                (float)edgeThreshold, (float)sigma));
+
+    // concatenating the buffers in the order of the tiles gives the same keypoints
+    // in the same order whatever the number of threads
+    keypoints.clear();
+    for( size_t t = 0; t < tileKeypoints.size(); t++ )
+        keypoints.insert(keypoints.end(), tileKeypoints[t].begin(), tileKeypoints[t].end());
 }
 
 
@@ -40,6 +40,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv
 {
@@ -138,11 +139,143 @@ computeIntegralImages( const Mat& matI, Mat& matS, Mat& matT, Mat& _FT,
     }
 }
 
+static const int STAR_MAX_PATTERN = 17;
+
+template <typename iiMatType> struct StarFeature
+{
+    int area;
+    iiMatType* p[8];
+};
+
+/*
+ Bi-level filter responses of a range of rows: the best response over the scales and its size.
+ */
+template <typename iiMatType> class StarDetectorResponsesInvoker : public ParallelLoopBody
+{
+public:
+    StarDetectorResponsesInvoker( Mat& _responses, Mat& _sizes, const StarFeature<iiMatType>* _f,
+                                  const int (*_pairs)[2], const float (*_invSizes)[2], const int* _sizes1,
+                                  int _npatterns, int _maxIdx, int _border, int _step, bool _useSIMD )
+        : responses(_responses), sizes(_sizes), f(_f), pairs(_pairs), invSizes(_invSizes), sizes1(_sizes1),
+          npatterns(_npatterns), maxIdx(_maxIdx), border(_border), step(_step), useSIMD(_useSIMD)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int cols = responses.cols;
+
+#if CV_SIMD128
+        v_float32x4 invSizes4[STAR_MAX_PATTERN][2];
+        v_float32x4 sizes1_4[STAR_MAX_PATTERN];
+        if( useSIMD )
+        {
+            for(int i = 0; i < npatterns; i++ )
+            {
+                invSizes4[i][0] = v_setall_f32(invSizes[i][0]);
+                invSizes4[i][1] = v_setall_f32(invSizes[i][1]);
+            }
+
+            for(int i = 0; i <= maxIdx; i++ )
+                sizes1_4[i] = v_setall_f32((float)sizes1[i]);
+        }
+#endif
+
+        for( int y = range.start; y < range.end; y++ )
+        {
+            int x = border;
+            float* r_ptr = responses.ptr<float>(y);
+            short* s_ptr = sizes.ptr<short>(y);
+
+            memset( r_ptr, 0, border*sizeof(r_ptr[0]));
+            memset( s_ptr, 0, border*sizeof(s_ptr[0]));
+            memset( r_ptr + cols - border, 0, border*sizeof(r_ptr[0]));
+            memset( s_ptr + cols - border, 0, border*sizeof(s_ptr[0]));
+
+#if CV_SIMD128
+            // only for the 32-bit integral images
+            if( useSIMD )
+            {
+                for( ; x <= cols - border - 4; x += 4 )
+                {
+                    int ofs = y*step + x;
+                    v_float32x4 vals[STAR_MAX_PATTERN];
+                    v_float32x4 bestResponse = v_setzero_f32();
+                    v_float32x4 bestSize = v_setzero_f32();
+
+                    for(int i = 0; i <= maxIdx; i++ )
+                    {
+                        const iiMatType* const* p = f[i].p;
+                        v_int32x4 r0 = v_load((const int*)(p[0] + ofs)) - v_load((const int*)(p[1] + ofs));
+                        v_int32x4 r1 = v_load((const int*)(p[3] + ofs)) - v_load((const int*)(p[2] + ofs));
+                        v_int32x4 r2 = v_load((const int*)(p[4] + ofs)) - v_load((const int*)(p[5] + ofs));
+                        v_int32x4 r3 = v_load((const int*)(p[7] + ofs)) - v_load((const int*)(p[6] + ofs));
+                        vals[i] = v_cvt_f32((r0 + r1) + (r2 + r3));
+                    }
+
+                    for(int i = 0; i < npatterns; i++ )
+                    {
+                        v_float32x4 inner_sum = vals[pairs[i][1]];
+                        v_float32x4 outer_sum = vals[pairs[i][0]] - inner_sum;
+                        v_float32x4 response = inner_sum*invSizes4[i][1] - outer_sum*invSizes4[i][0];
+                        v_float32x4 swapmask = v_abs(response) > v_abs(bestResponse);
+                        bestResponse = v_select(swapmask, response, bestResponse);
+                        bestSize = v_select(swapmask, sizes1_4[pairs[i][0]], bestSize);
+                    }
+
+                    v_store(r_ptr + x, bestResponse);
+                    v_int32x4 isize = v_round(bestSize);
+                    v_store_low(s_ptr + x, v_pack(isize, isize));
+                }
+            }
+#endif
+            for( ; x < cols - border; x++ )
+            {
+                int ofs = y*step + x;
+                int vals[STAR_MAX_PATTERN];
+                float bestResponse = 0;
+                int bestSize = 0;
+
+                for(int i = 0; i <= maxIdx; i++ )
+                {
+                    const iiMatType* const* p = f[i].p;
+                    vals[i] = (int)(p[0][ofs] - p[1][ofs] - p[2][ofs] + p[3][ofs] +
+                        p[4][ofs] - p[5][ofs] - p[6][ofs] + p[7][ofs]);
+                }
+                for(int i = 0; i < npatterns; i++ )
+                {
+                    int inner_sum = vals[pairs[i][1]];
+                    int outer_sum = vals[pairs[i][0]] - inner_sum;
+                    float response = inner_sum*invSizes[i][1] - outer_sum*invSizes[i][0];
+                    if( fabs(response) > fabs(bestResponse) )
+                    {
+                        bestResponse = response;
+                        bestSize = sizes1[pairs[i][0]];
+                    }
+                }
+
+                r_ptr[x] = bestResponse;
+                s_ptr[x] = (short)bestSize;
+            }
+        }
+    }
+
+private:
+    Mat& responses;
+    Mat& sizes;
+    const StarFeature<iiMatType>* f;
+    const int (*pairs)[2];
+    const float (*invSizes)[2];
+    const int* sizes1;
+    int npatterns, maxIdx, border, step;
+    bool useSIMD;
+};
+
 template <typename iiMatType> static int
 StarDetectorComputeResponses( const Mat& img, Mat& responses, Mat& sizes,
                               int maxSize, int iiType )
 {
-    const int MAX_PATTERN = 17;
+    const int MAX_PATTERN = STAR_MAX_PATTERN;
     static const int sizes0[] = {1, 2, 3, 4, 6, 8, 11, 12, 16, 22, 23, 32, 45, 46, 64, 90, 128, -1};
     static const int pairs[12][2] = {{1, 0}, {3, 1}, {4, 2}, {5, 3}, {7, 4}, {8, 5}, {9, 6},
                                      {11, 8}, {13, 10}, {14, 11}, {15, 12}, {16, 14}};
@@ -150,21 +283,10 @@ StarDetectorComputeResponses( const Mat& img, Mat& responses, Mat& sizes,
     float invSizes[MAX_PATTERN][2];
     int sizes1[MAX_PATTERN];
 
-#if CV_SSE2
-    __m128 invSizes4[MAX_PATTERN][2];
-    __m128 sizes1_4[MAX_PATTERN];
-    union { int i; float f; } absmask;
-    absmask.i = 0x7fffffff;
-    volatile bool useSIMD = cv::checkHardwareSupport(CV_CPU_SSE2) && iiType == CV_32S;
-#endif
-
-    struct StarFeature
-    {
-        int area;
-        iiMatType* p[8];
-    };
+    // the vectorized responses need 32-bit integral images
+    bool useSIMD = iiType == CV_32S;
 
-    StarFeature f[MAX_PATTERN];
+    StarFeature<iiMatType> f[MAX_PATTERN];
 
     Mat sum, tilted, flatTilted;
     int y, rows = img.rows, cols = img.cols;
@@ -232,20 +354,6 @@ StarDetectorComputeResponses( const Mat& img, Mat& responses, Mat& sizes,
         invSizes[i][1] = 1.f/innerArea;
     }
 
-#if CV_SSE2
-    if( useSIMD )
-    {
-        for(int i = 0; i < npatterns; i++ )
-        {
-            _mm_store_ps((float*)&invSizes4[i][0], _mm_set1_ps(invSizes[i][0]));
-            _mm_store_ps((float*)&invSizes4[i][1], _mm_set1_ps(invSizes[i][1]));
-        }
-
-        for(int i = 0; i <= maxIdx; i++ )
-            _mm_store_ps((float*)&sizes1_4[i], _mm_set1_ps((float)sizes1[i]));
-    }
-#endif
-
     for( y = 0; y < border; y++ )
     {
         float* r_ptr = responses.ptr<float>(y);
@@ -259,92 +367,11 @@ StarDetectorComputeResponses( const Mat& img, Mat& responses, Mat& sizes,
         memset( s_ptr2, 0, cols*sizeof(s_ptr2[0]));
     }
 
-    for( y = border; y < rows - border; y++ )
-    {
-        int x = border;
-        float* r_ptr = responses.ptr<float>(y);
-        short* s_ptr = sizes.ptr<short>(y);
-
-        memset( r_ptr, 0, border*sizeof(r_ptr[0]));
-        memset( s_ptr, 0, border*sizeof(s_ptr[0]));
-        memset( r_ptr + cols - border, 0, border*sizeof(r_ptr[0]));
-        memset( s_ptr + cols - border, 0, border*sizeof(s_ptr[0]));
-
-#if CV_SSE2
-        if( useSIMD )
-        {
-            __m128 absmask4 = _mm_set1_ps(absmask.f);
-            for( ; x <= cols - border - 4; x += 4 )
-            {
-                int ofs = y*step + x;
-                __m128 vals[MAX_PATTERN];
-                __m128 bestResponse = _mm_setzero_ps();
-                __m128 bestSize = _mm_setzero_ps();
-
-                for(int i = 0; i <= maxIdx; i++ )
-                {
-                    const iiMatType** p = (const iiMatType**)&f[i].p[0];
-                    __m128i r0 = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(p[0]+ofs)),
-                                               _mm_loadu_si128((const __m128i*)(p[1]+ofs)));
-                    __m128i r1 = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(p[3]+ofs)),
-                                               _mm_loadu_si128((const __m128i*)(p[2]+ofs)));
-                    __m128i r2 = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(p[4]+ofs)),
-                                               _mm_loadu_si128((const __m128i*)(p[5]+ofs)));
-                    __m128i r3 = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(p[7]+ofs)),
-                                               _mm_loadu_si128((const __m128i*)(p[6]+ofs)));
-                    r0 = _mm_add_epi32(_mm_add_epi32(r0,r1), _mm_add_epi32(r2,r3));
-                    _mm_store_ps((float*)&vals[i], _mm_cvtepi32_ps(r0));
-                }
-
-                for(int i = 0; i < npatterns; i++ )
-                {
-                    __m128 inner_sum = vals[pairs[i][1]];
-                    __m128 outer_sum = _mm_sub_ps(vals[pairs[i][0]], inner_sum);
-                    __m128 response = _mm_sub_ps(_mm_mul_ps(inner_sum, invSizes4[i][1]),
-                        _mm_mul_ps(outer_sum, invSizes4[i][0]));
-                    __m128 swapmask = _mm_cmpgt_ps(_mm_and_ps(response,absmask4),
-                        _mm_and_ps(bestResponse,absmask4));
-                    bestResponse = _mm_xor_ps(bestResponse,
-                        _mm_and_ps(_mm_xor_ps(response,bestResponse), swapmask));
-                    bestSize = _mm_xor_ps(bestSize,
-                        _mm_and_ps(_mm_xor_ps(sizes1_4[pairs[i][0]], bestSize), swapmask));
-                }
-
-                _mm_storeu_ps(r_ptr + x, bestResponse);
-                _mm_storel_epi64((__m128i*)(s_ptr + x),
-                    _mm_packs_epi32(_mm_cvtps_epi32(bestSize),_mm_setzero_si128()));
-            }
-        }
-#endif
-        for( ; x < cols - border; x++ )
-        {
-            int ofs = y*step + x;
-            int vals[MAX_PATTERN];
-            float bestResponse = 0;
-            int bestSize = 0;
-
-            for(int i = 0; i <= maxIdx; i++ )
-            {
-                const iiMatType** p = (const iiMatType**)&f[i].p[0];
-                vals[i] = (int)(p[0][ofs] - p[1][ofs] - p[2][ofs] + p[3][ofs] +
-                    p[4][ofs] - p[5][ofs] - p[6][ofs] + p[7][ofs]);
-            }
-            for(int i = 0; i < npatterns; i++ )
-            {
-                int inner_sum = vals[pairs[i][1]];
-                int outer_sum = vals[pairs[i][0]] - inner_sum;
-                float response = inner_sum*invSizes[i][1] - outer_sum*invSizes[i][0];
-                if( fabs(response) > fabs(bestResponse) )
-                {
-                    bestResponse = response;
-                    bestSize = sizes1[pairs[i][0]];
-                }
-            }
-
-            r_ptr[x] = bestResponse;
-            s_ptr[x] = (short)bestSize;
-        }
-    }
+    // rows are independent, all the scales of a pixel are evaluated together
+    if( rows - border > border )
+        parallel_for_( Range(border, rows - border),
+                       StarDetectorResponsesInvoker<iiMatType>( responses, sizes, f, pairs, invSizes, sizes1,
+                                                                npatterns, maxIdx, border, step, useSIMD ) );
 
     return border;
 }
@@ -388,87 +415,139 @@ static bool StarDetectorSuppressLines( const Mat& responses, const Mat& sizes, P
 }
 
 
-static void
-StarDetectorSuppressNonmax( const Mat& responses, const Mat& sizes,
-                            std::vector<KeyPoint>& keypoints, int border,
-                            int responseThreshold,
-                            int lineThresholdProjected,
-                            int lineThresholdBinarized,
-                            int suppressNonmaxSize )
+/*
+ Non-maxima suppression of a row of (delta+1)x(delta+1) tiles starting at row y,
+ the extrema of each tile are kept if they dominate their neighborhood and are not on a line.
+ */
+class StarDetectorSuppressNonmaxInvoker : public ParallelLoopBody
 {
-    int x, y, x1, y1, delta = suppressNonmaxSize/2;
-    int rows = responses.rows, cols = responses.cols;
-    const float* r_ptr = responses.ptr<float>();
-    int rstep = (int)(responses.step/sizeof(r_ptr[0]));
-    const short* s_ptr = sizes.ptr<short>();
-    int sstep = (int)(sizes.step/sizeof(s_ptr[0]));
-    short featureSize = 0;
+public:
+    StarDetectorSuppressNonmaxInvoker( const Mat& _responses, const Mat& _sizes,
+                                       std::vector<std::vector<KeyPoint> >& _tileKeypoints, int _border,
+                                       int _responseThreshold, int _lineThresholdProjected,
+                                       int _lineThresholdBinarized, int _suppressNonmaxSize )
+        : responses(_responses), sizes(_sizes), tileKeypoints(_tileKeypoints), border(_border),
+          responseThreshold(_responseThreshold), lineThresholdProjected(_lineThresholdProjected),
+          lineThresholdBinarized(_lineThresholdBinarized), suppressNonmaxSize(_suppressNonmaxSize)
+    {
+    }
 
-    for( y = border; y < rows - border; y += delta+1 )
-        for( x = border; x < cols - border; x += delta+1 )
+    void operator()( const Range& range ) const
+    {
+        int x, x1, y1, delta = suppressNonmaxSize/2;
+        int rows = responses.rows, cols = responses.cols;
+        const float* r_ptr = responses.ptr<float>();
+        int rstep = (int)(responses.step/sizeof(r_ptr[0]));
+        const short* s_ptr = sizes.ptr<short>();
+        int sstep = (int)(sizes.step/sizeof(s_ptr[0]));
+        short featureSize = 0;
+
+        for( int t = range.start; t < range.end; t++ )
         {
-            float maxResponse = (float)responseThreshold;
-            float minResponse = (float)-responseThreshold;
-            Point maxPt(-1, -1), minPt(-1, -1);
-            int tileEndY = MIN(y + delta, rows - border - 1);
-            int tileEndX = MIN(x + delta, cols - border - 1);
-
-            for( y1 = y; y1 <= tileEndY; y1++ )
-                for( x1 = x; x1 <= tileEndX; x1++ )
-                {
-                    float val = r_ptr[y1*rstep + x1];
-                    if( maxResponse < val )
-                    {
-                        maxResponse = val;
-                        maxPt = Point(x1, y1);
-                    }
-                    else if( minResponse > val )
-                    {
-                        minResponse = val;
-                        minPt = Point(x1, y1);
-                    }
-                }
+            int y = border + t*(delta+1);
+            std::vector<KeyPoint>& keypoints = tileKeypoints[t];
 
-            if( maxPt.x >= 0 )
+            for( x = border; x < cols - border; x += delta+1 )
             {
-                for( y1 = maxPt.y - delta; y1 <= maxPt.y + delta; y1++ )
-                    for( x1 = maxPt.x - delta; x1 <= maxPt.x + delta; x1++ )
+                float maxResponse = (float)responseThreshold;
+                float minResponse = (float)-responseThreshold;
+                Point maxPt(-1, -1), minPt(-1, -1);
+                int tileEndY = MIN(y + delta, rows - border - 1);
+                int tileEndX = MIN(x + delta, cols - border - 1);
+
+                for( y1 = y; y1 <= tileEndY; y1++ )
+                    for( x1 = x; x1 <= tileEndX; x1++ )
                     {
                         float val = r_ptr[y1*rstep + x1];
-                        if( val >= maxResponse && (y1 != maxPt.y || x1 != maxPt.x))
-                            goto skip_max;
+                        if( maxResponse < val )
+                        {
+                            maxResponse = val;
+                            maxPt = Point(x1, y1);
+                        }
+                        else if( minResponse > val )
+                        {
+                            minResponse = val;
+                            minPt = Point(x1, y1);
+                        }
                     }
 
-                if( (featureSize = s_ptr[maxPt.y*sstep + maxPt.x]) >= 4 &&
-                    !StarDetectorSuppressLines( responses, sizes, maxPt, lineThresholdProjected,
-                                                lineThresholdBinarized ))
+                if( maxPt.x >= 0 )
                 {
-                    KeyPoint kpt((float)maxPt.x, (float)maxPt.y, featureSize, -1, maxResponse);
-                    keypoints.push_back(kpt);
-                }
-            }
-        skip_max:
-            if( minPt.x >= 0 )
-            {
-                for( y1 = minPt.y - delta; y1 <= minPt.y + delta; y1++ )
-                    for( x1 = minPt.x - delta; x1 <= minPt.x + delta; x1++ )
+                    for( y1 = maxPt.y - delta; y1 <= maxPt.y + delta; y1++ )
+                        for( x1 = maxPt.x - delta; x1 <= maxPt.x + delta; x1++ )
+                        {
+                            float val = r_ptr[y1*rstep + x1];
+                            if( val >= maxResponse && (y1 != maxPt.y || x1 != maxPt.x))
+                                goto skip_max;
+                        }
+
+                    if( (featureSize = s_ptr[maxPt.y*sstep + maxPt.x]) >= 4 &&
+                        !StarDetectorSuppressLines( responses, sizes, maxPt, lineThresholdProjected,
+                                                    lineThresholdBinarized ))
                     {
-                        float val = r_ptr[y1*rstep + x1];
-                        if( val <= minResponse && (y1 != minPt.y || x1 != minPt.x))
-                            goto skip_min;
+                        KeyPoint kpt((float)maxPt.x, (float)maxPt.y, featureSize, -1, maxResponse);
+                        keypoints.push_back(kpt);
                     }
-
-                if( (featureSize = s_ptr[minPt.y*sstep + minPt.x]) >= 4 &&
-                    !StarDetectorSuppressLines( responses, sizes, minPt,
-                                               lineThresholdProjected, lineThresholdBinarized))
+                }
+            skip_max:
+                if( minPt.x >= 0 )
                 {
-                    KeyPoint kpt((float)minPt.x, (float)minPt.y, featureSize, -1, maxResponse);
-                    keypoints.push_back(kpt);
+                    for( y1 = minPt.y - delta; y1 <= minPt.y + delta; y1++ )
+                        for( x1 = minPt.x - delta; x1 <= minPt.x + delta; x1++ )
+                        {
+                            float val = r_ptr[y1*rstep + x1];
+                            if( val <= minResponse && (y1 != minPt.y || x1 != minPt.x))
+                                goto skip_min;
+                        }
+
+                    if( (featureSize = s_ptr[minPt.y*sstep + minPt.x]) >= 4 &&
+                        !StarDetectorSuppressLines( responses, sizes, minPt,
+                                                   lineThresholdProjected, lineThresholdBinarized))
+                    {
+                        KeyPoint kpt((float)minPt.x, (float)minPt.y, featureSize, -1, maxResponse);
+                        keypoints.push_back(kpt);
+                    }
                 }
+            skip_min:
+                ;
             }
-        skip_min:
-            ;
         }
+    }
+
+private:
+    const Mat& responses;
+    const Mat& sizes;
+    std::vector<std::vector<KeyPoint> >& tileKeypoints;
+    int border;
+    int responseThreshold;
+    int lineThresholdProjected;
+    int lineThresholdBinarized;
+    int suppressNonmaxSize;
+};
+
+
+static void
+StarDetectorSuppressNonmax( const Mat& responses, const Mat& sizes,
+                            std::vector<KeyPoint>& keypoints, int border,
+                            int responseThreshold,
+                            int lineThresholdProjected,
+                            int lineThresholdBinarized,
+                            int suppressNonmaxSize )
+{
+    int delta = suppressNonmaxSize/2;
+    int rows = responses.rows;
+    int ntileRows = rows - 2*border > 0 ? (rows - 2*border + delta)/(delta + 1) : 0;
+
+    // the rows of tiles are suppressed in parallel, their keypoints
+    // are appended in the order of the sequential scan
+    std::vector<std::vector<KeyPoint> > tileKeypoints(ntileRows);
+    parallel_for_( Range(0, ntileRows),
+                   StarDetectorSuppressNonmaxInvoker( responses, sizes, tileKeypoints, border,
+                                                      responseThreshold, lineThresholdProjected,
+                                                      lineThresholdBinarized, suppressNonmaxSize ) );
+
+    for( int t = 0; t < ntileRows; t++ )
+        keypoints.insert( keypoints.end(), tileKeypoints[t].begin(), tileKeypoints[t].end() );
 }
 
 StarDetectorImpl::StarDetectorImpl(int _maxSize, int _responseThreshold,
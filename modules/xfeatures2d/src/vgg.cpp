@@ -54,6 +54,7 @@
  */
 
 #include "precomp.hpp"
+#include <algorithm>
 
 
 
@@ -131,8 +132,10 @@ protected:
     // image
     Mat m_image;
 
-    // pool regions & proj
-    Mat m_PRFilters, m_Proj;
+    // pool regions (non-zero weights row by row) & proj
+    vector<int> m_PRRowOfs, m_PRCols;
+    vector<float> m_PRWeights;
+    Mat m_Proj;
 
 private:
 
@@ -168,111 +171,102 @@ static inline void get_patch( const KeyPoint kp, Mat& Patch, const Mat& image,
   const float half_rows = (float)Patch.rows / 2.0f;
 
   // sample form original image
-  for ( int x = 0; x < Patch.cols; x++ )
+  for ( int y = 0; y < Patch.rows; y++ )
   {
-    for ( int y = 0; y < Patch.rows; y++ )
+    float* dst = Patch.ptr<float>( y );
+    const float yoff = y - half_rows;
+    for ( int x = 0; x < Patch.cols; x++ )
     {
+      const float xoff = x - half_cols;
+      int img_x, img_y;
       if ( use_scale_orientation )
       {
-        const float xoff = x - half_cols;
-        const float yoff = y - half_rows;
         // the rotation shifts & scale
-        int img_x = int( (kp.pt.x + 0.5f) + xoff*tcos - yoff*tsin );
-        int img_y = int( (kp.pt.y + 0.5f) + xoff*tsin + yoff*tcos );
-        // sample only within image
-        if ( ( img_x < image.cols ) && ( img_x >= 0 )
-          && ( img_y < image.rows ) && ( img_y >= 0 ) )
-          Patch.at<float>( y, x ) = image.at<float>( img_y, img_x );
-        else
-          Patch.at<float>( y, x ) = 0.0f;
+        img_x = int( (kp.pt.x + 0.5f) + xoff*tcos - yoff*tsin );
+        img_y = int( (kp.pt.y + 0.5f) + xoff*tsin + yoff*tcos );
       }
       else
       {
-        const float xoff = x - half_cols;
-        const float yoff = y - half_rows;
         // the samples from image
-        int img_x = int( kp.pt.x + 0.5f + xoff );
-        int img_y = int( kp.pt.y + 0.5f + yoff );
-        // sample only within image
-        if ( ( img_x < image.cols ) && ( img_x >= 0 )
-          && ( img_y < image.rows ) && ( img_y >= 0 ) )
-          Patch.at<float>( y, x ) = image.at<float>( img_y, img_x );
-        else
-          Patch.at<float>( y, x ) = 0.0f;
+        img_x = int( kp.pt.x + 0.5f + xoff );
+        img_y = int( kp.pt.y + 0.5f + yoff );
       }
+      // sample only within image
+      if ( ( img_x < image.cols ) && ( img_x >= 0 )
+        && ( img_y < image.rows ) && ( img_y >= 0 ) )
+        dst[x] = image.ptr<float>( img_y )[img_x];
+      else
+        dst[x] = 0.0f;
     }
   }
 }
 
-// get descriptor given 64x64 image patch
-static void get_desc( const Mat Patch, Mat& PatchTrans, int anglebins, bool img_normalize )
+// soft-assign the gradients of a 64x64 image patch to the orientation bins,
+// for each pixel (in the column-major order of the transposed patch) the two
+// bins it votes for and the weighted gradient magnitude voted to each of them
+static void get_desc( const Mat& Patch, Mat& Bins, Mat& Votes, int anglebins, bool img_normalize )
 {
-    Mat Ix, Iy;
-    // % compute gradient
-    float kparam[3] = { -1,  0,  1 };
-    Mat Kernel( 1, 3, CV_32F, &kparam );
-    filter2D( Patch, Ix, CV_32F, Kernel,     Point( -1, -1 ), 0, BORDER_REPLICATE );
-    filter2D( Patch, Iy, CV_32F, Kernel.t(), Point( -1, -1 ), 0, BORDER_REPLICATE );
-
-    Mat GMag, GAngle;
-
-    // % gradient magnitude
-    // % GMag = sqrt(Ix .^ 2 + Iy .^ 2);
-    magnitude( Ix, Iy, GMag );
-
-    // % gradient orientation: [0; 2 * pi]
-    // % GAngle = atan2(Iy, Ix) + pi;
-    //phase( Ix, Iy, GAngle, false ); //<- opencv is buggy
-    GAngle = Mat( GMag.rows, GMag.cols, CV_32F );
-    for ( int i = 0; i < (int)GAngle.total(); i++ )
-      GAngle.at<float>(i) = atan2( Iy.at<float>(i), Ix.at<float>(i) ) + (float)CV_PI;
-
-    // % soft-assignment of gradients to the orientation histogram
-    float AngleStep = 2.0f * (float) CV_PI / (float) anglebins;
-    Mat GAngleRatio = GAngle / AngleStep - 0.5f;
+    const int rows = Patch.rows;
+    const int cols = Patch.cols;
+    const int total = (int)Patch.total();
 
-    // % Offset1 = mod(GAngleRatio, 1);
-    Mat Offset1( GAngleRatio.rows, GAngleRatio.cols, CV_32F );
-    for ( int i = 0; i < (int)GAngleRatio.total(); i++ )
-      Offset1.at<float>(i) = GAngleRatio.at<float>(i) - floor( GAngleRatio.at<float>(i) );
+    Bins.create( 2, total, CV_8U );
+    Votes.create( 2, total, CV_32F );
 
-    Mat w1 = 1.0f - Offset1.t();
-    Mat w2 = Offset1.t();
+    uchar* Bin1 = Bins.ptr<uchar>(0);
+    uchar* Bin2 = Bins.ptr<uchar>(1);
+    // hold GMag and Offset1 until the votes are known
+    float* Vote1 = Votes.ptr<float>(0);
+    float* Vote2 = Votes.ptr<float>(1);
 
-    Mat Bin1( GAngleRatio.rows, GAngleRatio.cols, CV_8U );
-    Mat Bin2( GAngleRatio.rows, GAngleRatio.cols, CV_8U );
+    // % soft-assignment of gradients to the orientation histogram
+    const float AngleStep = 2.0f * (float) CV_PI / (float) anglebins;
 
-    // % Bin1 = ceil(GAngleRatio);
-    // % Bin1(Bin1 == 0) = Params.nAngleBins;
-    for ( int i = 0; i < (int)GAngleRatio.total(); i++ )
+    for ( int y = 0; y < rows; y++ )
     {
-      if ( ceil( GAngleRatio.at<float>(i) - 1.0f) == -1.0f )
-        Bin1.at<uchar>(i) = (uchar) anglebins - 1;
-      else
-        Bin1.at<uchar>(i) = (uchar) ceil( GAngleRatio.at<float>(i) - 1.0f );
-    }
+      // % compute gradient
+      // [-1 0 1] kernels with replicated border
+      const float* prev = Patch.ptr<float>( std::max( y - 1, 0 ) );
+      const float* curr = Patch.ptr<float>( y );
+      const float* next = Patch.ptr<float>( std::min( y + 1, rows - 1 ) );
 
-    // % Bin2 = Bin1 + 1;
-    // % Bin2(Bin2 > Params.nAngleBins) = 1;
-    for ( int i = 0; i < (int)GAngleRatio.total(); i++ )
-    {
-      if ( ( Bin1.at<uchar>(i) + 1 ) > anglebins - 1 )
-        Bin2.at<uchar>(i) = 0;
-      else
-        Bin2.at<uchar>(i) = Bin1.at<uchar>(i) + 1;
+      for ( int x = 0; x < cols; x++ )
+      {
+        const float Ix = curr[std::min( x + 1, cols - 1 )] - curr[std::max( x - 1, 0 )];
+        const float Iy = next[x] - prev[x];
+        const int p = x * rows + y;
+
+        // % gradient magnitude
+        // % GMag = sqrt(Ix .^ 2 + Iy .^ 2);
+        Vote1[p] = std::sqrt( Ix * Ix + Iy * Iy );
+
+        // % gradient orientation: [0; 2 * pi]
+        // % GAngle = atan2(Iy, Ix) + pi;
+        const float GAngle = atan2( Iy, Ix ) + (float)CV_PI;
+        const float GAngleRatio = GAngle / AngleStep - 0.5f;
+
+        // % Offset1 = mod(GAngleRatio, 1);
+        Vote2[p] = GAngleRatio - floor( GAngleRatio );
+
+        // % Bin1 = ceil(GAngleRatio);
+        // % Bin1(Bin1 == 0) = Params.nAngleBins;
+        const int b1 = (int) ceil( GAngleRatio - 1.0f );
+        Bin1[p] = (uchar) ( ( b1 == -1 ) ? anglebins - 1 : b1 );
+
+        // % Bin2 = Bin1 + 1;
+        // % Bin2(Bin2 > Params.nAngleBins) = 1;
+        Bin2[p] = (uchar) ( ( Bin1[p] + 1 > anglebins - 1 ) ? 0 : Bin1[p] + 1 );
+      }
     }
 
     // normalize
+    float scale = 1.0f;
     if ( img_normalize )
     {
       // % Quantile = 0.8;
       float q = 0.8f;
 
-      // % T = quantile(GMag(:), Quantile);
-      Mat GMagSorted;
-      sort( GMag.reshape( 0, 1 ), GMagSorted, SORT_ASCENDING );
-
-      int n = GMagSorted.cols;
+      int n = total;
       // scipy/stats/mstats_basic.py#L1718 mquantiles()
       // m = alphap + p*(1.-alphap-betap)
       // alphap = 0.5 betap = 0.5 => (m = 0.5)
@@ -285,84 +279,106 @@ static void get_desc( const Mat Patch, Mat& PatchTrans, int anglebins, bool img_
       float gamma = aleph - k;
       if ( gamma >= 1.0f ) gamma = 1.0f;
       if ( gamma <= 0.0f ) gamma = 0.0f;
+
+      // % T = quantile(GMag(:), Quantile);
+      // only the k-th and (k+1)-th smallest magnitudes are needed, no full sort
+      AutoBuffer<float> _GMagSorted( n );
+      float* GMagSorted = _GMagSorted;
+      memcpy( GMagSorted, Vote1, n * sizeof(float) );
+      std::nth_element( GMagSorted, GMagSorted + k, GMagSorted + n );
+      const float GMagLower = *std::max_element( GMagSorted, GMagSorted + k );
+
       // quantile out from distribution
-      float T = ( 1.0f - gamma ) * GMagSorted.at<float>( k - 1 )
-              + gamma * GMagSorted.at<float>( k );
+      float T = ( 1.0f - gamma ) * GMagLower
+              + gamma * GMagSorted[k];
 
       // avoid NaN
-      if ( T != 0.0f ) GMag /= ( T / anglebins );
+      if ( T != 0.0f ) scale = (float) ( 1.0 / ( T / anglebins ) );
     }
 
-    Mat Bin1T = Bin1.t();
-    Mat Bin2T = Bin2.t();
-    Mat GMagT = GMag.t();
-
     // % feature channels
-    PatchTrans = Mat( (int)Patch.total(), anglebins, CV_32F, Scalar::all(0) );
+    for ( int p = 0; p < total; p++ )
+    {
+      const float GMag = Vote1[p] * scale;
+      const float Offset1 = Vote2[p];
+      Vote1[p] = ( 1.0f - Offset1 ) * GMag;
+      Vote2[p] = Offset1 * GMag;
+    }
+}
+
+// pool the feature channels of a patch, one row of sparse weights per pool region
+static void pool_desc( const Mat& Bins, const Mat& Votes,
+                       const vector<int>& PRRowOfs, const vector<int>& PRCols,
+                       const vector<float>& PRWeights, int anglebins, float* Desc )
+{
+    const uchar* Bin1 = Bins.ptr<uchar>(0);
+    const uchar* Bin2 = Bins.ptr<uchar>(1);
+    const float* Vote1 = Votes.ptr<float>(0);
+    const float* Vote2 = Votes.ptr<float>(1);
 
-    for ( int i = 0; i < anglebins; i++ )
+    const int nregions = (int)PRRowOfs.size() - 1;
+    for ( int r = 0; r < nregions; r++ )
     {
-      for ( int p = 0; p < (int)Patch.total(); p++ )
+      float* D = Desc + r * anglebins;
+      for ( int i = 0; i < anglebins; i++ )
+        D[i] = 0.0f;
+
+      for ( int j = PRRowOfs[r]; j < PRRowOfs[r+1]; j++ )
       {
-        if ( Bin1T.at<uchar>(p) == i )
-          PatchTrans.at<float>(p,i) = w1.at<float>(p) * GMagT.at<float>(p);
-        if ( Bin2T.at<uchar>(p) == i )
-          PatchTrans.at<float>(p,i) = w2.at<float>(p) * GMagT.at<float>(p);
+        const int p = PRCols[j];
+        const float w = PRWeights[j];
+        D[Bin1[p]] += w * Vote1[p];
+        D[Bin2[p]] += w * Vote2[p];
       }
+
+      // crop
+      for ( int i = 0; i < anglebins; i++ )
+        D[i] = std::min( D[i], 1.0f );
     }
 }
 
 // -------------------------------------------------
 /* VGG interface implementation */
 
+// pooled features of a block of keypoints, the projection is done for the whole block
 struct ComputeVGGInvoker : ParallelLoopBody
 {
-    ComputeVGGInvoker( const Mat& _image, Mat* _descriptors,
-                        const vector<KeyPoint>& _keypoints,
-                        const Mat& _PRFilters, const Mat& _Proj,
-                        const int _anglebins, const bool _img_normalize,
-                        const bool _use_scale_orientation, const float _scale_factor )
+    ComputeVGGInvoker( const Mat& _image, const vector<KeyPoint>& _keypoints,
+                       const int _first, Mat& _features,
+                       const vector<int>& _PRRowOfs, const vector<int>& _PRCols,
+                       const vector<float>& _PRWeights,
+                       const int _anglebins, const bool _img_normalize,
+                       const bool _use_scale_orientation, const float _scale_factor )
+      : image( _image ), keypoints( _keypoints ), first( _first ), features( _features ),
+        PRRowOfs( _PRRowOfs ), PRCols( _PRCols ), PRWeights( _PRWeights ),
+        anglebins( _anglebins ), scale_factor( _scale_factor ),
+        img_normalize( _img_normalize ), use_scale_orientation( _use_scale_orientation )
     {
-      image = _image;
-      keypoints = _keypoints;
-      descriptors = _descriptors;
-
-      Proj = _Proj;
-      PRFilters = _PRFilters;
-
-      anglebins = _anglebins;
-      scale_factor = _scale_factor;
-      img_normalize = _img_normalize;
-      use_scale_orientation  = _use_scale_orientation;
     }
 
     void operator ()(const cv::Range& range) const
     {
-      Mat Desc, PatchTrans;
+      Mat Bins, Votes;
       Mat Patch( 64, 64, CV_32F );
       for (int k = range.start; k < range.end; k++)
       {
         // sample patch from image
-        get_patch( keypoints[k], Patch, image, use_scale_orientation, scale_factor );
+        get_patch( keypoints[first + k], Patch, image, use_scale_orientation, scale_factor );
         // compute transform
-        get_desc( Patch, PatchTrans, anglebins, img_normalize );
+        get_desc( Patch, Bins, Votes, anglebins, img_normalize );
         // pool features
-        Desc = PRFilters * PatchTrans;
-        // crop
-        min( Desc, 1.0f, Desc );
-        // reshape
-        Desc = Desc.reshape( 1, (int)Desc.total() );
-        // project
-        descriptors->row( k ) = Desc.t() * Proj.t();
+        pool_desc( Bins, Votes, PRRowOfs, PRCols, PRWeights, anglebins, features.ptr<float>( k ) );
       }
     }
 
-    Mat image;
-    Mat *descriptors;
-    vector<KeyPoint> keypoints;
+    const Mat& image;
+    const vector<KeyPoint>& keypoints;
+    const int first;
+    Mat& features;
 
-    Mat Proj;
-    Mat PRFilters;
+    const vector<int>& PRRowOfs;
+    const vector<int>& PRCols;
+    const vector<float>& PRWeights;
 
     int anglebins;
     float scale_factor;
@@ -400,13 +416,31 @@ void VGG_Impl::compute( InputArray _image, vector<KeyPoint>& keypoints, OutputAr
 
     // prepare descriptors
     Mat descriptors = _descriptors.getMat();
-    descriptors.setTo( Scalar(0) );
 
-    parallel_for_( Range( 0, (int) keypoints.size() ),
-        ComputeVGGInvoker( m_image, &descriptors, keypoints, m_PRFilters, m_Proj,
-                            m_anglebins, m_img_normalize, m_use_scale_orientation,
-                            m_scale_factor )
-    );
+    const int nkeypoints = (int) keypoints.size();
+    const int nfeatures = ( (int) m_PRRowOfs.size() - 1 ) * m_anglebins;
+    CV_Assert( m_Proj.cols == nfeatures );
+
+    // keypoints are pooled in blocks bounding the temporary
+    // storage, each block is projected with a single product
+    const int blockSize = 1024;
+    Mat features;
+    for ( int first = 0; first < nkeypoints; first += blockSize )
+    {
+      const int count = std::min( blockSize, nkeypoints - first );
+      features.create( count, nfeatures, CV_32F );
+
+      parallel_for_( Range( 0, count ),
+          ComputeVGGInvoker( m_image, keypoints, first, features,
+                              m_PRRowOfs, m_PRCols, m_PRWeights,
+                              m_anglebins, m_img_normalize, m_use_scale_orientation,
+                              m_scale_factor )
+      );
+
+      // project
+      Mat block = descriptors.rowRange( first, first + count );
+      gemm( features, m_Proj, 1.0, noArray(), 0.0, block, GEMM_2_T );
+    }
 
     // normalize desc
     if ( m_dsc_normalize )
@@ -425,8 +459,11 @@ void VGG_Impl::ini_params( const int PRrows, const int PRcols,
 {
     int idx;
 
+    // pool regions sample the 64x64 patch
+    CV_Assert( PRcols == 64 * 64 );
+
     // initialize pool-region matrix
-    m_PRFilters = Mat::zeros( PRrows, PRcols, CV_32F );
+    Mat PRFilters = Mat::zeros( PRrows, PRcols, CV_32F );
     // initialize projection matrix
     m_Proj = Mat::zeros( PJrows, PJcols, CV_32F );
 
@@ -437,11 +474,27 @@ void VGG_Impl::ini_params( const int PRrows, const int PRcols,
       for ( size_t k = 0; k < PRidx[i+1]; k++ )
       {
         // expand floats from hex blobs
-        m_PRFilters.at<float>( PRidx[i] + (int)k ) = *(float *)&PR[idx];
+        PRFilters.at<float>( PRidx[i] + (int)k ) = *(float *)&PR[idx];
         idx++;
       }
     }
 
+    // keep only the non-zero weights of each pool region
+    m_PRRowOfs.assign( 1, 0 );
+    m_PRCols.clear();
+    m_PRWeights.clear();
+    for ( int r = 0; r < PRrows; r++ )
+    {
+      const float* w = PRFilters.ptr<float>( r );
+      for ( int c = 0; c < PRcols; c++ )
+      {
+        if ( w[c] == 0.0f ) continue;
+        m_PRCols.push_back( c );
+        m_PRWeights.push_back( w[c] );
+      }
+      m_PRRowOfs.push_back( (int) m_PRCols.size() );
+    }
+
     idx = 0;
     // fill sparse projection matrix
     for ( size_t i = 0; i < PJidxSize; i=i+2 )
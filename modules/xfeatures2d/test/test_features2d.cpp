@@ -1015,6 +1015,60 @@ TEST( Features2d_Detector_Harris_Laplace_Affine, regression )
     test.safe_run();
 }
 
+static void detectAffineRegions( const Mat& image, vector<Elliptic_KeyPoint>& regions, Mat& descriptors )
+{
+    Ptr<AffineFeature2D> affine = AffineFeature2D::create(HarrisLaplaceFeatureDetector::create(), SIFT::create());
+    affine->detectAndCompute(image, noArray(), regions, descriptors);
+}
+
+TEST( Features2d_Detector_Harris_Laplace_Affine, threads_match_sequential )
+{
+    Mat image = imread(string(cvtest::TS::ptr()->get_data_path()) + FEATURES2D_DIR + "/" + IMAGE_FILENAME, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(image.empty());
+
+    int numThreads = getNumThreads();
+
+    vector<Elliptic_KeyPoint> regionsSeq;
+    Mat descriptorsSeq;
+    setNumThreads(1);
+    detectAffineRegions(image, regionsSeq, descriptorsSeq);
+    ASSERT_FALSE(regionsSeq.empty());
+
+    setNumThreads(getNumberOfCPUs());
+    vector<Elliptic_KeyPoint> regions;
+    Mat descriptors;
+    detectAffineRegions(image, regions, descriptors);
+    setNumThreads(numThreads);
+
+    ASSERT_EQ(regionsSeq.size(), regions.size());
+    for (size_t i = 0; i < regions.size(); i++)
+    {
+        EXPECT_EQ(regionsSeq[i].pt, regions[i].pt) << "region " << i;
+        EXPECT_EQ(regionsSeq[i].size, regions[i].size) << "region " << i;
+        EXPECT_EQ(regionsSeq[i].angle, regions[i].angle) << "region " << i;
+        EXPECT_EQ(regionsSeq[i].axes, regions[i].axes) << "region " << i;
+        EXPECT_EQ(regionsSeq[i].si, regions[i].si) << "region " << i;
+        EXPECT_EQ(0, norm(Mat(regionsSeq[i].transf), Mat(regions[i].transf), NORM_INF)) << "region " << i;
+    }
+    EXPECT_EQ(0, cvtest::norm(descriptorsSeq, descriptors, NORM_INF));
+
+    // No region is a duplicate of a region kept before it
+    const float maxDiff = 4;
+    for (size_t j = 0; j < regions.size(); j++)
+    {
+        for (size_t i = 0; i < j; i++)
+        {
+            const Elliptic_KeyPoint& kp1 = regions[i];
+            const Elliptic_KeyPoint& kp2 = regions[j];
+            Size axes1 = kp1.axes, axes2 = kp2.axes;
+            bool similar = norm(kp1.pt - kp2.pt) <= maxDiff && std::abs(kp1.angle - kp2.angle) < 15 &&
+                    std::max(kp1.si, kp2.si) / std::min(kp1.si, kp2.si) < 1.4f &&
+                    axes1.width - axes2.width < 5 && axes1.height - axes2.height < 5;
+            ASSERT_FALSE(similar) << "regions " << i << " and " << j;
+        }
+    }
+}
+
 /*
  * Descriptors
  */
@@ -1355,6 +1409,139 @@ TEST(Features2d_SIFT_using_mask, regression)
     test.safe_run();
 }
 
+TEST(Features2d_SIFT_threads, regression)
+{
+    string path = string(cvtest::TS::ptr()->get_data_path() + "detectors_descriptors_evaluation/images_datasets/graf/img1.png");
+    Mat img = imread(path, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(img.empty());
+
+    Ptr<SIFT> sift = SIFT::create();
+    int nThreads = getNumThreads();
+
+    vector<KeyPoint> keypoints, keypointsSerial;
+    Mat descriptors, descriptorsSerial;
+    sift->detectAndCompute(img, noArray(), keypoints, descriptors);
+    setNumThreads(1);
+    sift->detectAndCompute(img, noArray(), keypointsSerial, descriptorsSerial);
+    setNumThreads(nThreads);
+
+    ASSERT_EQ(keypointsSerial.size(), keypoints.size());
+    for( size_t i = 0; i < keypoints.size(); i++ )
+    {
+        EXPECT_EQ(keypointsSerial[i].pt, keypoints[i].pt);
+        EXPECT_EQ(keypointsSerial[i].octave, keypoints[i].octave);
+        EXPECT_EQ(keypointsSerial[i].angle, keypoints[i].angle);
+    }
+    EXPECT_EQ(0, cvtest::norm(descriptors, descriptorsSerial, NORM_INF));
+}
+
+TEST(Features2d_BinaryDescriptors_threads, regression)
+{
+    string path = string(cvtest::TS::ptr()->get_data_path() + "detectors_descriptors_evaluation/images_datasets/graf/img1.png");
+    Mat color = imread(path, IMREAD_COLOR), img;
+    ASSERT_FALSE(color.empty());
+    cvtColor(color, img, COLOR_BGR2GRAY);
+
+    vector<KeyPoint> points;
+    ORB::create(2000)->detect(img, points);
+
+    Ptr<Feature2D> extractors[] = { LATCH::create(32, true), LATCH::create(64, false, 2), LUCID::create(), FREAK::create() };
+    int nThreads = getNumThreads();
+
+    for( size_t e = 0; e < sizeof(extractors)/sizeof(extractors[0]); e++ )
+    {
+        Mat input = e == 2 ? color : img;
+        vector<KeyPoint> keypoints = points, keypointsSerial = points;
+        Mat descriptors, descriptorsSerial;
+        extractors[e]->compute(input, keypoints, descriptors);
+        setNumThreads(1);
+        extractors[e]->compute(input, keypointsSerial, descriptorsSerial);
+        setNumThreads(nThreads);
+
+        ASSERT_EQ(keypointsSerial.size(), keypoints.size());
+        ASSERT_FALSE(descriptors.empty());
+        for( size_t i = 0; i < keypoints.size(); i++ )
+            EXPECT_EQ(keypointsSerial[i].angle, keypoints[i].angle);
+        EXPECT_EQ(0, cvtest::norm(descriptors, descriptorsSerial, NORM_INF)) << "extractor " << e;
+    }
+}
+
+TEST(Features2d_StarDetector_threads, regression)
+{
+    string path = string(cvtest::TS::ptr()->get_data_path() + "detectors_descriptors_evaluation/images_datasets/graf/img1.png");
+    Mat img = imread(path, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(img.empty());
+
+    Ptr<StarDetector> star = StarDetector::create();
+    int nThreads = getNumThreads();
+
+    vector<KeyPoint> keypoints, keypointsSerial;
+    star->detect(img, keypoints);
+    setNumThreads(1);
+    star->detect(img, keypointsSerial);
+    setNumThreads(nThreads);
+
+    ASSERT_FALSE(keypoints.empty());
+    ASSERT_EQ(keypointsSerial.size(), keypoints.size());
+    for( size_t i = 0; i < keypoints.size(); i++ )
+    {
+        EXPECT_EQ(keypointsSerial[i].pt, keypoints[i].pt);
+        EXPECT_EQ(keypointsSerial[i].size, keypoints[i].size);
+        EXPECT_EQ(keypointsSerial[i].response, keypoints[i].response);
+    }
+}
+
+class DAISYTilesCollector : public DAISY::TileCallback
+{
+public:
+    DAISYTilesCollector(Size _size, int descriptorSize) : size(_size)
+    {
+        descriptors = Mat::zeros(size.area(), descriptorSize, CV_32F);
+        covered = Mat::zeros(size, CV_8U);
+    }
+
+    void process(const Rect& tile, const Mat& tileDescriptors)
+    {
+        ASSERT_EQ(tile.area(), tileDescriptors.rows);
+        for( int y = 0; y < tile.height; y++ )
+        {
+            Mat rows = descriptors.rowRange((tile.y + y)*size.width + tile.x, (tile.y + y)*size.width + tile.x + tile.width);
+            tileDescriptors.rowRange(y*tile.width, (y + 1)*tile.width).copyTo(rows);
+        }
+        covered(tile) += 1;
+    }
+
+    Size size;
+    Mat descriptors, covered;
+};
+
+TEST(Features2d_DAISY_tiles, regression)
+{
+    string path = string(cvtest::TS::ptr()->get_data_path() + "detectors_descriptors_evaluation/images_datasets/graf/img1.png");
+    Mat img = imread(path, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(img.empty());
+    img = img(Rect(200, 150, 240, 180)).clone();
+
+    int norms[] = { DAISY::NRM_NONE, DAISY::NRM_PARTIAL };
+    for( int n = 0; n < 2; n++ )
+    {
+        Ptr<DAISY> daisy = DAISY::create(15, 3, 8, 8, norms[n]);
+
+        Mat descriptors;
+        daisy->compute(img, descriptors);
+
+        // small tiles, the second frame reuses the buffers of the first one
+        for( int frame = 0; frame < 2; frame++ )
+        {
+            DAISYTilesCollector collector(img.size(), daisy->descriptorSize());
+            daisy->compute(img, Size(64, 48), collector);
+
+            EXPECT_EQ(img.size().area(), countNonZero(collector.covered == 1));
+            EXPECT_LE(cvtest::norm(descriptors, collector.descriptors, NORM_INF), 1e-4) << "norm " << norms[n];
+        }
+    }
+}
+
 TEST(DISABLED_Features2d_SURF_using_mask, regression)
 {
     FeatureDetectorUsingMaskTest test(SURF::create());
@@ -0,0 +1,135 @@
+#include "test_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::xfeatures2d;
+
+namespace
+{
+
+// Scalar reference, as the distances and similarities were computed before they were vectorized
+float referenceDistance(int distanceFunction, const float* p1, const float* p2)
+{
+    float result = 0;
+    for (int d = 1; d < 8; d++)
+    {
+        float difference = p1[d] - p2[d];
+        switch (distanceFunction)
+        {
+        case PCTSignatures::L0_25: result += std::sqrt(std::sqrt(std::abs(difference))); break;
+        case PCTSignatures::L0_5: result += std::sqrt(std::abs(difference)); break;
+        case PCTSignatures::L1: result += std::abs(difference); break;
+        case PCTSignatures::L2:
+        case PCTSignatures::L2SQUARED: result += difference * difference; break;
+        case PCTSignatures::L5: result += std::abs(difference) * difference * difference * difference * difference; break;
+        case PCTSignatures::L_INFINITY: if (difference > result) result = difference; break;
+        }
+    }
+    switch (distanceFunction)
+    {
+    case PCTSignatures::L0_25: result *= result; return result * result;
+    case PCTSignatures::L0_5: return result * result;
+    case PCTSignatures::L2: return std::sqrt(result);
+    case PCTSignatures::L5: return std::pow(result, 0.2f);
+    default: return result;
+    }
+}
+
+float referencePartialSQFD(int distanceFunction, int similarityFunction, float alpha, const Mat& s0, const Mat& s1)
+{
+    float result = 0;
+    for (int i = 0; i < s0.rows; i++)
+    {
+        for (int j = 0; j < s1.rows; j++)
+        {
+            float distance = referenceDistance(distanceFunction, s0.ptr<float>(i), s1.ptr<float>(j));
+            float similarity = similarityFunction == PCTSignatures::MINUS ? -distance :
+                    similarityFunction == PCTSignatures::GAUSSIAN ? std::exp(-alpha + distance * distance) :
+                    1 / (alpha + distance);
+            result += s0.at<float>(i, 0) * s1.at<float>(j, 0) * similarity;
+        }
+    }
+    return result;
+}
+
+Mat randomSignature(RNG& rng, int rows)
+{
+    Mat signature(rows, 8, CV_32F);
+    rng.fill(signature, RNG::UNIFORM, Scalar::all(0), Scalar::all(1));
+    return signature;
+}
+
+}
+
+TEST(Features2d_PCTSignaturesSQFD, scalar_reference)
+{
+    RNG rng(0x50c7);
+
+    // centroid counts which are not multiples of 4, the distances are computed by 4 centroids at once
+    Mat source = randomSignature(rng, 13);
+    vector<Mat> images;
+    for (int rows = 1; rows <= 9; rows++)
+        images.push_back(randomSignature(rng, rows));
+
+    for (int distanceFunction = PCTSignatures::L0_25; distanceFunction <= PCTSignatures::L_INFINITY; distanceFunction++)
+    {
+        for (int similarityFunction = PCTSignatures::MINUS; similarityFunction <= PCTSignatures::HEURISTIC; similarityFunction++)
+        {
+            const float alpha = 1.f;
+            Ptr<PCTSignaturesSQFD> sqfd = PCTSignaturesSQFD::create(distanceFunction, similarityFunction, alpha);
+
+            vector<float> distances;
+            sqfd->computeQuadraticFormDistances(source, images, distances);
+            ASSERT_EQ(images.size(), distances.size());
+
+            float p00 = referencePartialSQFD(distanceFunction, similarityFunction, alpha, source, source);
+            for (size_t i = 0; i < images.size(); i++)
+            {
+                float p11 = referencePartialSQFD(distanceFunction, similarityFunction, alpha, images[i], images[i]);
+                float p01 = referencePartialSQFD(distanceFunction, similarityFunction, alpha, source, images[i]);
+                float squared = p00 + p11 - 2 * p01;
+
+                float distance = sqfd->computeQuadraticFormDistance(source, images[i]);
+
+                // the batch only shares the partial SQFD of the source signature
+                if (cvIsNaN(distance))
+                    EXPECT_TRUE(cvIsNaN(distances[i]));
+                else
+                    EXPECT_EQ(distance, distances[i]);
+
+                // the squared distance is compared, it cancels out for close signatures
+                if (squared < 0)
+                {
+                    EXPECT_TRUE(cvIsNaN(distance) || distance == 0) << "distance=" << distanceFunction << " similarity=" << similarityFunction;
+                    continue;
+                }
+                float eps = 1e-5f * (std::abs(p00) + std::abs(p11) + 2 * std::abs(p01));
+                EXPECT_NEAR(squared, distance * distance, eps)
+                        << "distance=" << distanceFunction << " similarity=" << similarityFunction << " rows=" << images[i].rows;
+            }
+        }
+    }
+}
+
+TEST(Features2d_PCTSignatures, threads_match_sequential)
+{
+    Mat image = imread(string(cvtest::TS::ptr()->get_data_path()) + "features2d/tsukuba.png");
+    ASSERT_FALSE(image.empty());
+
+    Ptr<PCTSignatures> pct = PCTSignatures::create(2000, 400);
+
+    int numThreads = getNumThreads();
+
+    Mat signatureSeq;
+    setNumThreads(1);
+    pct->computeSignature(image, signatureSeq);
+
+    Mat signature;
+    setNumThreads(getNumberOfCPUs());
+    pct->computeSignature(image, signature);
+    setNumThreads(numThreads);
+
+    ASSERT_FALSE(signatureSeq.empty());
+    ASSERT_EQ(signatureSeq.size(), signature.size());
+    EXPECT_EQ(0, cvtest::norm(signatureSeq, signature, NORM_INF));
+}
@@ -447,6 +447,105 @@ CV_EXPORTS_W void fastGlobalSmootherFilter(InputArray guide, InputArray src, Out
 For more details about L0 Smoother, see the original paper @cite xu2011image.
 */
 CV_EXPORTS_W void l0Smooth(InputArray src, OutputArray dst, double lambda = 0.02, double kappa = 2.0);
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+
+/** @brief Interface of the images read by TiledEdgeAwareFilter, region by region.
+
+Implement it to pull regions of an image that doesn't fit in memory, e.g. from a file reader.
+ */
+class CV_EXPORTS TileSource
+{
+public:
+    virtual ~TileSource() {}
+
+    /** @brief Size of the whole image. */
+    virtual Size size() const = 0;
+
+    /** @brief Provides a region of the image.
+
+    @param roi region of the image, always inside the image.
+
+    @param dst output region, of size roi.size(). It can be a header over data owned by the source.
+     */
+    virtual void getRegion(const Rect& roi, Mat& dst) = 0;
+};
+
+/** @brief Interface of the images written by TiledEdgeAwareFilter, region by region.
+ */
+class CV_EXPORTS TileSink
+{
+public:
+    virtual ~TileSink() {}
+
+    /** @brief Receives a region of the filtered image. Regions don't overlap and cover the whole image.
+
+    @param roi region of the image.
+
+    @param src filtered region, only valid during the call.
+     */
+    virtual void putRegion(const Rect& roi, const Mat& src) = 0;
+};
+
+/** @brief Interface for tiled execution of edge-aware filters on very large images.
+
+The image is filtered tile by tile. Each tile is filtered with a halo of surrounding pixels, and only
+its inner part is written to the output, so that memory usage only depends on the tile and halo sizes.
+The output of the guided filter is the same as for the whole image when the halo is at least
+2*radius + 1 (the default). The other filters have an unbounded support: their output matches the whole
+image one within a tolerance which decreases as the halo grows.
+ */
+class CV_EXPORTS_W TiledEdgeAwareFilter : public Algorithm
+{
+public:
+    /** @brief Filter an image read and written region by region.
+
+    @param guide source of the guide image.
+
+    @param src source of the image to filter, with the same size as the guide.
+
+    @param dst sink of the filtered image.
+     */
+    virtual void filter(const Ptr<TileSource>& guide, const Ptr<TileSource>& src, const Ptr<TileSink>& dst) = 0;
+
+    /** @brief Filter an image held in memory, e.g. a Mat header over a memory-mapped file.
+
+    @param guide guide image.
+
+    @param src image to filter, with the same size as the guide.
+
+    @param dst destination image. If it already has the size and the type of the output, it is written in place.
+     */
+    CV_WRAP virtual void filter(InputArray guide, InputArray src, OutputArray dst) = 0;
+
+    /** @see setTileSize */
+    CV_WRAP virtual int getTileSize() const = 0;
+    /** @brief Side of the square tiles written to the output. */
+    CV_WRAP virtual void setTileSize(int tileSize) = 0;
+    /** @see setHaloSize */
+    CV_WRAP virtual int getHaloSize() const = 0;
+    /** @brief Number of pixels filtered around each tile, on each side. */
+    CV_WRAP virtual void setHaloSize(int haloSize) = 0;
+};
+
+/** @brief Factory method, create a tiled guided filter. See guidedFilter for the parameters.
+ */
+CV_EXPORTS_W Ptr<TiledEdgeAwareFilter> createTiledGuidedFilter(int radius, double eps, int tileSize = 1024);
+
+/** @brief Factory method, create a tiled Domain Transform filter. See dtFilter for the parameters.
+ */
+CV_EXPORTS_W Ptr<TiledEdgeAwareFilter> createTiledDTFilter(double sigmaSpatial, double sigmaColor, int mode = DTF_NC, int numIters = 3, int tileSize = 1024);
+
+/** @brief Factory method, create a tiled Fast Global Smoother filter. See fastGlobalSmootherFilter for the parameters.
+ */
+CV_EXPORTS_W Ptr<TiledEdgeAwareFilter> createTiledFastGlobalSmootherFilter(double lambda, double sigma_color, double lambda_attenuation = 0.25, int num_iter = 3, int tileSize = 1024);
+
+/** @brief Factory method, create a tiled Adaptive Manifold filter. See amFilter for the parameters.
+
+The random number generator of the filter is disabled, so that all tiles use the same manifolds.
+ */
+CV_EXPORTS_W Ptr<TiledEdgeAwareFilter> createTiledAMFilter(double sigma_s, double sigma_r, bool adjust_outliers = false, int tileSize = 1024);
 //! @}
 }
 }
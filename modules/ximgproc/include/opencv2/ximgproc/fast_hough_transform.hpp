@@ -158,6 +158,24 @@ CV_EXPORTS Vec4i HoughPoint2Line(const Point &houghPoint,
                                  int         makeSkew = HDO_DESKEW,
                                  int         rules = RO_IGNORE_BORDERS );
 
+/**
+* @brief   Calculates coordinates of line segments corresponded by points in Hough space.
+* @param   houghPoints Points in Hough space, vector of cv::Point or CV_32SC2 matrix.
+* @param   srcImgInfo  The source (input) image of Hough transform.
+* @param   lines       The destination line segments, one Vec4i per point.
+* @param   angleRange  The part of Hough space where points are situated, see cv::AngleRangeOption
+* @param   makeSkew    Specifies to do or not to do image skewing, see cv::HoughDeskewOption
+* @param   rules       Specifies strictness of line segment calculating, see cv::RulesOption
+*
+* Batched form of HoughPoint2Line for all the maxima found in a Hough image.
+*/
+CV_EXPORTS void HoughPoint2Line(InputArray  houghPoints,
+                                InputArray  srcImgInfo,
+                                OutputArray lines,
+                                int         angleRange = ARO_315_135,
+                                int         makeSkew = HDO_DESKEW,
+                                int         rules = RO_IGNORE_BORDERS );
+
 } }// namespace cv::ximgproc
 
 #endif //__cplusplus
@@ -95,6 +95,11 @@ public:
     can be seen below.
 
     ![image](pics/superpixels_blocks2.png)
+
+    The block and pixel updates are run in parallel on horizontal bands of the image: every other
+    band is processed at the same time, then the remaining ones. The bands only depend on the image
+    size and on the number of superpixels, so the result is deterministic and doesn't depend on the
+    number of threads.
      */
     CV_WRAP virtual void iterate(InputArray img, int num_iterations=4) = 0;
 
@@ -59,6 +59,17 @@ namespace cv {
 
                             CV_WRAP virtual void setMinSize(int min_size) = 0;
                             CV_WRAP virtual int getMinSize() = 0;
+
+                            /** @brief Set the size of the tiles used to segment large images
+                                @param tile_size Side of the square tiles, in pixels. 0 (the default) segments the whole image at once.
+
+                                Tiles are segmented in parallel and their borders are stitched afterwards. Tiling only limits the number of
+                                edges built and sorted at once; the per-pixel segmentation state is still allocated for the whole image, and
+                                the edges left unmerged by the tiles are kept until the stitching. The result is close to, but not exactly the
+                                same as, a segmentation of the whole image. Implementations without tiling ignore this setting.
+                            */
+                            CV_WRAP virtual void setTileSize(int tile_size) { (void)tile_size; }
+                            CV_WRAP virtual int getTileSize() { return 0; }
                     };
 
                     /** @brief Creates a graph based segmentor
@@ -235,6 +246,9 @@ namespace cv {
 
                             /** @brief Based on all images, graph segmentations and stragies, computes all possible rects and return them
                                 @param rects The list of rects. The first ones are more relevents than the lasts ones.
+
+                                The (image, graph segmentation) combinations are processed in parallel when all the strategies are
+                                built-in ones. Custom strategies are stateful objects that cannot be copied, so they are run sequentially.
                             */
                             CV_WRAP virtual void process(CV_OUT std::vector<Rect>& rects) = 0;
                     };
@@ -127,12 +127,23 @@ public:
     @param isParallel enables/disables parallel computing.
      */
     CV_WRAP virtual void edgesNms(cv::InputArray edge_image, cv::InputArray orientation_image, cv::OutputArray _dst, int r = 2, int s = 0, float m = 1, bool isParallel = true) const = 0;
+
+    /** @brief The function saves the model in a binary format.
+
+    Binary models are recognized by createStructuredEdgeDetection and load much faster than YAML ones,
+    so this can be used to convert a model once, e.g. model.yml.gz to model.bin. The format stores
+    the arrays of the forest as they are in memory, hence it depends on the endianness of the machine.
+    @param filename name of the file where the model is saved
+     */
+    CV_WRAP virtual void saveBinaryModel(const String &filename) const = 0;
 };
 
 /*!
 * The only constructor
 *
-* \param model : name of the file where the model is stored
+* \param model : name of the file where the model is stored, either in
+*                YAML/XML (possibly gzipped) or in the binary format written by
+*                StructuredEdgeDetection::saveBinaryModel
 * \param howToGetFeatures : optional object inheriting from RFFeatureGetter.
 *                           You need it only if you would like to train your
 *                           own forest, pass NULL otherwise
@@ -87,4 +87,32 @@ PERF_TEST_P(srcSize_srcType_dstDepth, FastHoughTransform,
 
 #undef ALL_MAT_DEPHTS
 
+CV_ENUM(FhtOperation, FHT_MIN, FHT_MAX, FHT_ADD, FHT_AVE)
+CV_ENUM(FhtAngleRange, ARO_315_0, ARO_315_45, ARO_315_135)
+typedef std::tr1::tuple<FhtOperation, FhtAngleRange> op_angleRange_t;
+typedef perf::TestBaseWithParam<op_angleRange_t> op_angleRange;
+
+PERF_TEST_P(op_angleRange, FastHoughTransform_1080p,
+            testing::Combine(
+                FhtOperation::all(),
+                FhtAngleRange::all()
+                )
+            )
+{
+    int operation  = get<0>(GetParam());
+    int angleRange = get<1>(GetParam());
+
+    Mat src(sz1080p, CV_8UC1);
+    Mat fht;
+
+    declare.in(src, WARMUP_RNG);
+
+    TEST_CYCLE_N(3)
+    {
+        FastHoughTransform(src, fht, CV_32S, angleRange, operation);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 } // namespace cvtest
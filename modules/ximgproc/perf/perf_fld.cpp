@@ -0,0 +1,68 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "perf_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace perf;
+using namespace cv;
+using namespace cv::ximgproc;
+
+typedef TestBaseWithParam<Size> LineDetectorTest;
+
+// Random lines over a smooth background, resized to the tested resolution
+static void createLinesImage(Size sz, Mat& img)
+{
+    RNG rng(0);
+    img.create(sz, CV_8UC1);
+    rng.fill(img, RNG::UNIFORM, 0, 64);
+    GaussianBlur(img, img, Size(0, 0), 3);
+
+    for (int i = 0; i < 100; i++)
+    {
+        Point p1(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Point p2(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        line(img, p1, p2, Scalar::all(rng.uniform(128, 256)), rng.uniform(1, 4));
+    }
+}
+
+PERF_TEST_P(LineDetectorTest, FastLineDetector, Values(szVGA, sz720p, sz1080p))
+{
+    Mat img;
+    createLinesImage(GetParam(), img);
+
+    Ptr<FastLineDetector> fld = createFastLineDetector();
+    std::vector<Vec4f> lines;
+
+    declare.in(img);
+
+    TEST_CYCLE()
+    {
+        fld->detect(img, lines);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(LineDetectorTest, LineSegmentDetector, Values(szVGA, sz720p, sz1080p))
+{
+    Mat img;
+    createLinesImage(GetParam(), img);
+
+    Ptr<LineSegmentDetector> lsd = createLineSegmentDetector();
+    std::vector<Vec4f> lines;
+
+    declare.in(img);
+
+    TEST_CYCLE()
+    {
+        lsd->detect(img, lines);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}
@@ -0,0 +1,119 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#ifndef __OPENCV_PERF_MAT_ALLOCATOR_HPP__
+#define __OPENCV_PERF_MAT_ALLOCATOR_HPP__
+
+#include "opencv2/core.hpp"
+#include "opencv2/core/utility.hpp"
+#include <algorithm>
+#include <set>
+
+namespace perf
+{
+
+/*
+ * Counts the Mat buffers allocated and tracks the memory they hold while installed as the default
+ * allocator, see MatAllocationScope. The buffers it allocates are released through it, possibly after
+ * the test is over, so there is a single instance which is never destroyed.
+ */
+class MatAllocationCounter : public cv::MatAllocator
+{
+ public:
+  static MatAllocationCounter& instance()
+  {
+    static MatAllocationCounter* counter = new MatAllocationCounter();
+    return *counter;
+  }
+
+  void reset()
+  {
+    cv::AutoLock lock( mutex );
+    count = 0;
+    current = peak = 0;
+    live.clear();
+  }
+
+  cv::UMatData* allocate( int dims, const int* sizes, int type, void* data, size_t* step, int flags, cv::UMatUsageFlags usageFlags ) const
+  {
+    cv::UMatData* u = stdAllocator->allocate( dims, sizes, type, data, step, flags, usageFlags );
+    if( u && !data )
+    {
+      u->currAllocator = this;
+      cv::AutoLock lock( mutex );
+      live.insert( u );
+      count++;
+      current += (int64) u->size;
+      peak = std::max( peak, current );
+    }
+    return u;
+  }
+
+  bool allocate( cv::UMatData* data, int accessflags, cv::UMatUsageFlags usageFlags ) const
+  {
+    return stdAllocator->allocate( data, accessflags, usageFlags );
+  }
+
+  void deallocate( cv::UMatData* u ) const
+  {
+    if( u && !( u->flags & cv::UMatData::USER_ALLOCATED ) )
+    {
+      // buffers allocated before the last reset are not accounted in current
+      cv::AutoLock lock( mutex );
+      if( live.erase( u ) )
+        current -= (int64) u->size;
+    }
+    stdAllocator->deallocate( u );
+  }
+
+  mutable int count;      // buffers allocated since reset
+  mutable int64 current;  // bytes held by the buffers allocated since reset
+  mutable int64 peak;
+
+ private:
+  MatAllocationCounter() :
+      count( 0 ),
+      current( 0 ),
+      peak( 0 ),
+      stdAllocator( cv::Mat::getStdAllocator() )
+  {
+  }
+
+  cv::MatAllocator* stdAllocator;
+  mutable std::set<const cv::UMatData*> live;  // buffers allocated since reset, not released yet
+  mutable cv::Mutex mutex;
+};
+
+/*
+ * Resets the counter and installs it as the default Mat allocator for the lifetime of the scope. The
+ * previous allocator is restored on every exit path, including exceptions and ASSERT failures.
+ */
+class MatAllocationScope
+{
+ public:
+  MatAllocationScope() :
+      counter( MatAllocationCounter::instance() ),
+      prevAllocator( cv::Mat::getDefaultAllocator() )
+  {
+    counter.reset();
+    cv::Mat::setDefaultAllocator( &counter );
+  }
+
+  ~MatAllocationScope()
+  {
+    cv::Mat::setDefaultAllocator( prevAllocator );
+  }
+
+  MatAllocationCounter& counter;
+
+ private:
+  cv::MatAllocator* prevAllocator;
+
+  MatAllocationScope( const MatAllocationScope& );
+  MatAllocationScope& operator=( const MatAllocationScope& );
+};
+
+}
+
+#endif
@@ -0,0 +1,61 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "perf_precomp.hpp"
+
+namespace cvtest
+{
+
+using std::tr1::tuple;
+using std::tr1::get;
+using namespace perf;
+using namespace testing;
+using namespace cv;
+using namespace cv::ximgproc;
+
+typedef tuple<Size, int, bool> EdgeAwareInterpolatorParams;
+typedef TestBaseWithParam<EdgeAwareInterpolatorParams> EdgeAwareInterpolatorPerfTest;
+
+/* 1024x436 is the resolution of the MPI-Sintel sequences */
+PERF_TEST_P(EdgeAwareInterpolatorPerfTest, perf,
+            Combine(Values(Size(1024, 436), szVGA), Values(32, 128), Bool()))
+{
+    Size sz            = get<0>(GetParam());
+    int k              = get<1>(GetParam());
+    bool use_post_proc = get<2>(GetParam());
+
+    // textured image with a smooth flow sampled on a grid, as sparse matchers typically produce
+    RNG rng(0);
+    Mat from(sz, CV_8UC3);
+    rng.fill(from, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+    GaussianBlur(from, from, Size(5, 5), 0);
+
+    const int grid_step = 8;
+    std::vector<Point2f> from_points, to_points;
+    for (int y = grid_step / 2; y < sz.height; y += grid_step)
+        for (int x = grid_step / 2; x < sz.width; x += grid_step)
+        {
+            Point2f p((float)x, (float)y);
+            Point2f flow(5.0f * (float)std::sin(y * 0.01), 3.0f * (float)std::cos(x * 0.01));
+            from_points.push_back(p);
+            to_points.push_back(p + flow + Point2f(rng.uniform(-0.5f, 0.5f), rng.uniform(-0.5f, 0.5f)));
+        }
+
+    Ptr<EdgeAwareInterpolator> interpolator = createEdgeAwareInterpolator();
+    interpolator->setK(k);
+    interpolator->setUsePostProcessing(use_post_proc);
+
+    Mat dense_flow;
+    declare.in(from).out(dense_flow);
+
+    // the same interpolator is reused, as for the frames of a video
+    TEST_CYCLE_N(5)
+    {
+        interpolator->interpolate(from, from_points, Mat(), to_points, dense_flow);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}
@@ -0,0 +1,40 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "perf_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace perf;
+using namespace cv;
+using namespace cv::ximgproc;
+
+typedef TestBaseWithParam<Size> StructuredEdgeDetectionTest;
+
+PERF_TEST_P(StructuredEdgeDetectionTest, detectEdges, Values(sz1080p))
+{
+    Size sz = GetParam();
+
+    Ptr<StructuredEdgeDetection> pDollar =
+        createStructuredEdgeDetection(getDataPath("cv/ximgproc/model.yml.gz"));
+
+    Mat img = imread(getDataPath("cv/ximgproc/sources/01.png"), 1);
+    ASSERT_FALSE(img.empty());
+
+    Mat src, dst;
+    resize(img, src, sz);
+    src.convertTo(src, DataType<float>::type, 1/255.0);
+
+    declare.in(src).out(dst);
+
+    TEST_CYCLE_N(3)
+    {
+        pDollar->detectEdges(src, dst);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}
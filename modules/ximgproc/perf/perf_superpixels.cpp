@@ -0,0 +1,127 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "perf_precomp.hpp"
+
+namespace cvtest
+{
+
+using std::tr1::tuple;
+using std::tr1::get;
+using namespace perf;
+using namespace testing;
+using namespace cv;
+using namespace cv::ximgproc;
+
+enum { SP_SLIC, SP_SLICO, SP_MSLIC, SP_SEEDS, SP_LSC };
+CV_ENUM(SuperpixelAlgorithm, SP_SLIC, SP_SLICO, SP_MSLIC, SP_SEEDS, SP_LSC);
+typedef tuple<SuperpixelAlgorithm, Size> SuperpixelParams;
+typedef TestBaseWithParam<SuperpixelParams> SuperpixelPerfTest;
+
+/* Overlapping rectangles and ellipses of random colors, with the map of the regions they form */
+static void generateRegions(Size sz, Mat& img, Mat& regions)
+{
+    RNG rng(0);
+    img.create(sz, CV_8UC3);
+    img.setTo(Scalar(128, 128, 128));
+    regions = Mat::zeros(sz, CV_32S);
+
+    int nr_shapes = std::max(50, (int)(sz.area() / 20000));
+    for (int i = 1; i <= nr_shapes; i++)
+    {
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        Point center(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Size axes(rng.uniform(sz.width / 64, sz.width / 8), rng.uniform(sz.height / 64, sz.height / 8));
+        if (i % 2)
+        {
+            rectangle(img, center - Point(axes), center + Point(axes), color, -1);
+            rectangle(regions, center - Point(axes), center + Point(axes), Scalar(i), -1);
+        }
+        else
+        {
+            double angle = rng.uniform(0, 180);
+            ellipse(img, center, axes, angle, 0, 360, color, -1);
+            ellipse(regions, center, axes, angle, 0, 360, Scalar(i), -1);
+        }
+    }
+
+    // texture so that the boundaries are not trivial to find
+    Mat noise(sz, CV_16SC3);
+    rng.fill(noise, RNG::NORMAL, Scalar::all(0), Scalar::all(8));
+    add(img, noise, img, noArray(), CV_8U);
+    GaussianBlur(img, img, Size(3, 3), 0);
+}
+
+/* Fraction of the boundary pixels of the regions which lie within 2 pixels of a superpixel boundary */
+static double boundaryRecall(const Mat& contours, const Mat& regions)
+{
+    Mat gt = Mat::zeros(regions.size(), CV_8U);
+    for (int y = 0; y < regions.rows; y++)
+    {
+        const int* r = regions.ptr<int>(y);
+        const int* rnext = regions.ptr<int>(std::min(y + 1, regions.rows - 1));
+        uchar* g = gt.ptr<uchar>(y);
+        for (int x = 0; x < regions.cols; x++)
+            g[x] = (r[x] != r[std::min(x + 1, regions.cols - 1)] || r[x] != rnext[x]) ? 255 : 0;
+    }
+
+    Mat near;
+    dilate(contours, near, getStructuringElement(MORPH_RECT, Size(5, 5)));
+    int total = countNonZero(gt);
+    return total ? (double)countNonZero(gt & near) / total : 1.0;
+}
+
+PERF_TEST_P(SuperpixelPerfTest, perf,
+            Combine(SuperpixelAlgorithm::all(), Values(szVGA, sz1080p, Size(3840, 2160))))
+{
+    int algorithm = get<0>(GetParam());
+    Size sz       = get<1>(GetParam());
+
+    const int region_size = 20;
+    Mat img, regions, lab;
+    generateRegions(sz, img, regions);
+    cvtColor(img, lab, COLOR_BGR2Lab);
+
+    Mat contours;
+    declare.in(lab).time(300);
+
+    TEST_CYCLE_N(1)
+    {
+        switch (algorithm)
+        {
+        case SP_SLIC:
+        case SP_SLICO:
+        case SP_MSLIC:
+        {
+            int slicAlgorithm = algorithm == SP_SLIC ? SLIC : (algorithm == SP_SLICO ? SLICO : MSLIC);
+            Ptr<SuperpixelSLIC> slic = createSuperpixelSLIC(lab, slicAlgorithm, region_size);
+            slic->iterate(10);
+            slic->enforceLabelConnectivity();
+            slic->getLabelContourMask(contours, false);
+            break;
+        }
+        case SP_SEEDS:
+        {
+            Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(sz.width, sz.height, lab.channels(),
+                    (int)(sz.area() / (region_size * region_size)), 4);
+            seeds->iterate(lab, 4);
+            seeds->getLabelContourMask(contours, false);
+            break;
+        }
+        case SP_LSC:
+        {
+            Ptr<SuperpixelLSC> lsc = createSuperpixelLSC(lab, region_size);
+            lsc->iterate(10);
+            lsc->enforceLabelConnectivity();
+            lsc->getLabelContourMask(contours, false);
+            break;
+        }
+        }
+    }
+
+    RecordProperty("boundary_recall", cv::format("%.4f", boundaryRecall(contours, regions)));
+    SANITY_CHECK_NOTHING();
+}
+
+}
@@ -0,0 +1,55 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "perf_precomp.hpp"
+#include "perf_mat_allocator.hpp"
+
+namespace cvtest
+{
+
+using std::tr1::tuple;
+using std::tr1::get;
+using namespace perf;
+using namespace testing;
+using namespace cv;
+using namespace cv::ximgproc;
+
+enum { FILTER_GUIDED, FILTER_DT, FILTER_FGS, FILTER_AMF };
+CV_ENUM(TiledFilterType, FILTER_GUIDED, FILTER_DT, FILTER_FGS, FILTER_AMF);
+typedef tuple<TiledFilterType, bool, Size> TiledFilterParams;
+typedef TestBaseWithParam<TiledFilterParams> TiledEdgeAwareFilterPerfTest;
+
+PERF_TEST_P(TiledEdgeAwareFilterPerfTest, perf,
+            Combine(TiledFilterType::all(), Bool(), Values(sz1080p, Size(4096, 4096))))
+{
+    int filterType = get<0>(GetParam());
+    bool tiled     = get<1>(GetParam());
+    Size sz        = get<2>(GetParam());
+
+    Mat guide(sz, CV_8UC3), src(sz, CV_8UC3), dst(sz, CV_8UC3);
+    declare.in(guide, src, WARMUP_RNG).out(dst);
+
+    Ptr<TiledEdgeAwareFilter> tf;
+    if (filterType == FILTER_GUIDED)
+        tf = createTiledGuidedFilter(8, 100.0);
+    else if (filterType == FILTER_DT)
+        tf = createTiledDTFilter(10.0, 30.0);
+    else if (filterType == FILTER_FGS)
+        tf = createTiledFastGlobalSmootherFilter(100.0, 10.0);
+    else
+        tf = createTiledAMFilter(16.0, 0.2);
+    if (!tiled)
+        tf->setTileSize(std::max(sz.width, sz.height));
+
+    MatAllocationScope allocationScope;
+    TEST_CYCLE_N(3)
+    {
+        tf->filter(guide, src, dst);
+    }
+
+    RecordProperty("peak_memory_mb", cv::format("%.1f", allocationScope.counter.peak / (1024.0 * 1024.0)));
+    SANITY_CHECK_NOTHING();
+}
+
+}
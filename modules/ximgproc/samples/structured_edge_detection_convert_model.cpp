@@ -0,0 +1,46 @@
+/**************************************************************************************
+Converts a structured edge detection model to the binary format, which loads much
+faster than the YAML one, e.g.:
+    structured_edge_detection_convert_model -m=model.yml.gz -o=model.bin
+The resulting file can be passed to createStructuredEdgeDetection like the original model.
+***************************************************************************************/
+
+#include <opencv2/ximgproc.hpp>
+#include "opencv2/core/utility.hpp"
+#include <iostream>
+
+using namespace cv;
+using namespace cv::ximgproc;
+
+const char* keys =
+{
+    "{m || model name}"
+    "{o || output binary model name}"
+};
+
+int main( int argc, const char** argv )
+{
+    CommandLineParser parser(argc, argv, keys);
+    if ( !parser.check() )
+    {
+        parser.printErrors();
+        return -1;
+    }
+
+    String modelFilename = parser.get<String>("m");
+    String outFilename = parser.get<String>("o");
+
+    if ( modelFilename.empty() || outFilename.empty() )
+    {
+        std::cout << "\nThis sample converts a structured edge detection model to the binary format\n"
+               "Call:\n"
+               "    structured_edge_detection_convert_model -m=model_name -o=out_model_name\n\n";
+        return 0;
+    }
+
+    Ptr<StructuredEdgeDetection> pDollar =
+        createStructuredEdgeDetection(modelFilename);
+    pDollar->saveBinaryModel(outFilename);
+
+    return 0;
+}
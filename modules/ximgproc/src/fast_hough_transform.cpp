@@ -42,6 +42,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv { namespace ximgproc {
 
@@ -49,67 +50,97 @@ namespace cv { namespace ximgproc {
     typedef __int32 int32_t;
 #endif
 
-template<typename T, int D, HoughOp Op>
-struct HoughOperator { };
-#define SPECIALIZE_HOUGHOP(TOp, body)                                         \
-    template<typename T, int D>                                               \
-    struct HoughOperator<T, D, TOp> {                                         \
-        static void operate(T *pDst, T *pSrc0, T* pSrc1, int len) {           \
-            Mat dst (Size(1, len), D, pDst);                                  \
-            Mat src0(Size(1, len), D, pSrc0);                                 \
-            Mat src1(Size(1, len), D, pSrc1);                                 \
-            body;                                                             \
+//----------------------hough operators----------------------------------------
+
+template<typename T, HoughOp Op>
+struct HoughScalarOperator { };
+template<typename T>
+struct HoughScalarOperator<T, FHT_ADD> {
+    static inline T apply(T a, T b) { return saturate_cast<T>(a + b); }
+};
+template<typename T>
+struct HoughScalarOperator<T, FHT_MIN> {
+    static inline T apply(T a, T b) { return std::min(a, b); }
+};
+template<typename T>
+struct HoughScalarOperator<T, FHT_MAX> {
+    static inline T apply(T a, T b) { return std::max(a, b); }
+};
+template<typename T>
+struct HoughScalarOperator<T, FHT_AVE> {
+    // same rounding as addWeighted(src0, 0.5, src1, 0.5, 0.0, dst)
+    static inline T apply(T a, T b) { return saturate_cast<T>(a * 0.5 + b * 0.5); }
+};
+
+#if CV_SIMD128
+// Returns the number of elements processed, the tail is left to the scalar operator.
+// Integer averages are not vectorized as v_avg rounds halves up, unlike cvRound.
+template<typename T, HoughOp Op>
+struct HoughVecOperator {
+    static inline int operate(T *, const T *, const T *, int) { return 0; }
+};
+#define SPECIALIZE_HOUGHVECOP(T, VT, TOp, body)                               \
+    template<>                                                                \
+    struct HoughVecOperator<T, TOp> {                                         \
+        static inline int operate(T *pDst, const T *pSrc0, const T *pSrc1,    \
+                                  int len) {                                  \
+            int i = 0;                                                        \
+            for (; i <= len - VT::nlanes; i += VT::nlanes) {                  \
+                VT a = v_load(pSrc0 + i), b = v_load(pSrc1 + i);              \
+                v_store(pDst + i, body);                                      \
+            }                                                                 \
+            return i;                                                         \
         }                                                                     \
     };
-SPECIALIZE_HOUGHOP(FHT_ADD, add(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_MIN, min(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_MAX, max(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_AVE, addWeighted(src0, 0.5, src1, 0.5, 0.0, dst));
-#undef SPECIALIZE_HOUGHOP
+#define SPECIALIZE_HOUGHVECOPS(T, VT)                                         \
+    SPECIALIZE_HOUGHVECOP(T, VT, FHT_ADD, a + b)                              \
+    SPECIALIZE_HOUGHVECOP(T, VT, FHT_MIN, v_min(a, b))                        \
+    SPECIALIZE_HOUGHVECOP(T, VT, FHT_MAX, v_max(a, b))
+SPECIALIZE_HOUGHVECOPS(uchar,  v_uint8x16)
+SPECIALIZE_HOUGHVECOPS(schar,  v_int8x16)
+SPECIALIZE_HOUGHVECOPS(ushort, v_uint16x8)
+SPECIALIZE_HOUGHVECOPS(short,  v_int16x8)
+SPECIALIZE_HOUGHVECOPS(int,    v_int32x4)
+SPECIALIZE_HOUGHVECOPS(float,  v_float32x4)
+SPECIALIZE_HOUGHVECOP(float, v_float32x4, FHT_AVE,
+                      a * v_setall_f32(0.5f) + b * v_setall_f32(0.5f))
+#if CV_SIMD128_64F
+SPECIALIZE_HOUGHVECOPS(double, v_float64x2)
+SPECIALIZE_HOUGHVECOP(double, v_float64x2, FHT_AVE,
+                      a * v_setall_f64(0.5) + b * v_setall_f64(0.5))
+#endif
+#undef SPECIALIZE_HOUGHVECOPS
+#undef SPECIALIZE_HOUGHVECOP
+#endif
+
+template<typename T, HoughOp Op>
+struct HoughOperator {
+    static void operate(T *pDst, const T *pSrc0, const T *pSrc1, int len) {
+        int i = 0;
+#if CV_SIMD128
+        i = HoughVecOperator<T, Op>::operate(pDst, pSrc0, pSrc1, len);
+#endif
+        for (; i < len; i++)
+            pDst[i] = HoughScalarOperator<T, Op>::apply(pSrc0[i], pSrc1[i]);
+    }
+};
 
 //----------------------fht----------------------------------------------------
 
-template <typename T, int D, HoughOp OP>
-void fhtCore(Mat     &img0,
-             Mat     &img1,
-             int32_t  y0,
-             int32_t  h,
-             bool     isPositiveShift,
-             int      level,
-             double   aspl)
+// Merges the rows [y0 + sBegin, y0 + sEnd) of the butterfly node (y0, h):
+// the two halves of the node are in img1, the result is written to img0.
+template <typename T, HoughOp OP>
+void fhtMergeRows(Mat     &img0,
+                  Mat     &img1,
+                  int32_t  y0,
+                  int32_t  h,
+                  bool     isPositiveShift,
+                  int      level,
+                  double   aspl,
+                  int32_t  sBegin,
+                  int32_t  sEnd)
 {
-    if (level <= 0)
-        return;
-
-    CV_Assert(h > 0);
-    if (h == 1)
-    {
-        if ((aspl != 0.0) && (level == 1))
-        {
-            int w = img0.cols;
-            uchar* pLine0 = img0.data + img0.step * y0;
-            uchar* pLine1 = img1.data + img1.step * y0;
-            int dLine = cvRound(y0 * aspl);
-            dLine = dLine % w;
-            dLine = dLine * (int)(img1.elemSize());
-            int wLine = img0.cols * (int)(img0.elemSize());
-            memcpy(pLine0, pLine1 + wLine - dLine, dLine);
-            memcpy(pLine0 + dLine, pLine1, wLine - dLine);
-        }
-        else
-        {
-            memcpy(img0.data + img0.step * y0,
-                   img1.data + img1.step * y0,
-                   img0.cols * (int)(img0.elemSize()));
-        }
-        return;
-    }
     const int32_t k = h >> 1;
-    fhtCore<T, D, OP>(img1, img0, y0, k,
-                      isPositiveShift, level - 1, aspl);
-    fhtCore<T, D, OP>(img1, img0, y0 + k, h - k,
-                      isPositiveShift, level - 1, aspl);
-
     int au = 2 * k - 2;
     int ad = 2 * h - 2 * k - 2;
     int b = h - 1;
@@ -117,7 +148,7 @@ void fhtCore(Mat     &img0,
     int w = img0.cols;
     int wm = (h / w + 1) * w;
 
-    for (int32_t s = 0; s < h; s++)
+    for (int32_t s = sBegin; s < sEnd; s++)
     {
         int su = (s * au + b) / d;
         int sd = (s * ad + b) / d;
@@ -144,66 +175,191 @@ void fhtCore(Mat     &img0,
             {
                 if (w0 >= dD)
                 {
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                               (T *)pLineU,
-                                               (T *)pLineD + (w0 - dX),
-                                               w1 + dX);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + (w1 + dD),
-                                               (T *)pLineU + (w1 + dX),
-                                               (T *)pLineD,
-                                               w0 - dD);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                               (T *)pLineU + (wB - dU),
-                                               (T *)pLineD + (w0 - dD),
-                                               dU);
+                    HoughOperator<T, OP>::operate((T *)pLine0 + dU,
+                                                  (T *)pLineU,
+                                                  (T *)pLineD + (w0 - dX),
+                                                  w1 + dX);
+                    HoughOperator<T, OP>::operate((T *)pLine0 + (w1 + dD),
+                                                  (T *)pLineU + (w1 + dX),
+                                                  (T *)pLineD,
+                                                  w0 - dD);
+                    HoughOperator<T, OP>::operate((T *)pLine0,
+                                                  (T *)pLineU + (wB - dU),
+                                                  (T *)pLineD + (w0 - dD),
+                                                  dU);
                 }
                 else
                 {
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                               (T *)pLineU,
-                                               (T *)pLineD + (w0 - dX),
-                                               wB - dU);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                               (T *)pLineU + (wB - dU),
-                                               (T *)pLineD + (w0 + wB - dD),
-                                               dD - w0);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + (dD - w0),
-                                               (T *)pLineU + (w1 + dX),
-                                               (T *)pLineD,
-                                               w0 - dX);
+                    HoughOperator<T, OP>::operate((T *)pLine0 + dU,
+                                                  (T *)pLineU,
+                                                  (T *)pLineD + (w0 - dX),
+                                                  wB - dU);
+                    HoughOperator<T, OP>::operate((T *)pLine0,
+                                                  (T *)pLineU + (wB - dU),
+                                                  (T *)pLineD + (w0 + wB - dD),
+                                                  dD - w0);
+                    HoughOperator<T, OP>::operate((T *)pLine0 + (dD - w0),
+                                                  (T *)pLineU + (w1 + dX),
+                                                  (T *)pLineD,
+                                                  w0 - dX);
                 }
             }
             else
             {
-                HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                           (T *)pLineU,
-                                           (T *)pLineD + (wB - (dX - w0)),
-                                           dX - w0);
-                HoughOperator<T, D, OP>::operate((T *)pLine0 + (dD - w0),
-                                           (T *)pLineU + (dX - w0),
-                                           (T *)pLineD,
-                                           wB - (dX - w0) - dU);
-                HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                           (T *)pLineU + (wB - dU),
-                                           (T *)pLineD + (wB - (dX - w0) - dU),
-                                           dU);
+                HoughOperator<T, OP>::operate((T *)pLine0 + dU,
+                                              (T *)pLineU,
+                                              (T *)pLineD + (wB - (dX - w0)),
+                                              dX - w0);
+                HoughOperator<T, OP>::operate((T *)pLine0 + (dD - w0),
+                                              (T *)pLineU + (dX - w0),
+                                              (T *)pLineD,
+                                              wB - (dX - w0) - dU);
+                HoughOperator<T, OP>::operate((T *)pLine0,
+                                              (T *)pLineU + (wB - dU),
+                                              (T *)pLineD + (wB - (dX - w0) - dU),
+                                              dU);
             }
         }
         else
         {
-            HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                        (T *)pLineU,
-                                        (T *)pLineD + w0,
-                                        w1);
-            HoughOperator<T, D, OP>::operate((T *)pLine0 + w1,
-                                        (T *)pLineU + w1,
-                                        (T *)pLineD,
-                                        w0);
+            HoughOperator<T, OP>::operate((T *)pLine0,
+                                          (T *)pLineU,
+                                          (T *)pLineD + w0,
+                                          w1);
+            HoughOperator<T, OP>::operate((T *)pLine0 + w1,
+                                          (T *)pLineU + w1,
+                                          (T *)pLineD,
+                                          w0);
+        }
+    }
+}
+
+template <typename T, HoughOp OP>
+void fhtCore(Mat     &img0,
+             Mat     &img1,
+             int32_t  y0,
+             int32_t  h,
+             bool     isPositiveShift,
+             int      level,
+             double   aspl)
+{
+    if (level <= 0)
+        return;
+
+    CV_Assert(h > 0);
+    if (h == 1)
+    {
+        if ((aspl != 0.0) && (level == 1))
+        {
+            int w = img0.cols;
+            uchar* pLine0 = img0.data + img0.step * y0;
+            uchar* pLine1 = img1.data + img1.step * y0;
+            int dLine = cvRound(y0 * aspl);
+            dLine = dLine % w;
+            dLine = dLine * (int)(img1.elemSize());
+            int wLine = img0.cols * (int)(img0.elemSize());
+            memcpy(pLine0, pLine1 + wLine - dLine, dLine);
+            memcpy(pLine0 + dLine, pLine1, wLine - dLine);
+        }
+        else
+        {
+            memcpy(img0.data + img0.step * y0,
+                   img1.data + img1.step * y0,
+                   img0.cols * (int)(img0.elemSize()));
         }
+        return;
     }
+    const int32_t k = h >> 1;
+    fhtCore<T, OP>(img1, img0, y0, k,
+                   isPositiveShift, level - 1, aspl);
+    fhtCore<T, OP>(img1, img0, y0 + k, h - k,
+                   isPositiveShift, level - 1, aspl);
+
+    fhtMergeRows<T, OP>(img0, img1, y0, h, isPositiveShift, level, aspl, 0, h);
+}
+
+// Node of the butterfly recursion of fhtCore, covering rows [y0, y0 + h)
+struct FhtNode
+{
+    int32_t y0, h;
+    FhtNode(int32_t _y0, int32_t _h) : y0(_y0), h(_h) { }
+};
+
+// Lists the nodes of the recursion by depth, down to maxDepth
+static void collectFhtNodes(std::vector<std::vector<FhtNode> > &nodes,
+                            int32_t y0,
+                            int32_t h,
+                            int     depth,
+                            int     maxDepth)
+{
+    nodes[depth].push_back(FhtNode(y0, h));
+    if (depth == maxDepth)
+        return;
+    const int32_t k = h >> 1;
+    collectFhtNodes(nodes, y0, k, depth + 1, maxDepth);
+    collectFhtNodes(nodes, y0 + k, h - k, depth + 1, maxDepth);
 }
 
-template <typename T, int D, HoughOp Op>
+template <typename T, HoughOp OP>
+class FhtTilesInvoker : public ParallelLoopBody
+{
+public:
+    FhtTilesInvoker(Mat &img0_, Mat &img1_, const std::vector<FhtNode> &tiles_,
+                    bool isPositiveShift_, int level_, double aspl_)
+        : img0(img0_), img1(img1_), tiles(tiles_),
+          isPositiveShift(isPositiveShift_), level(level_), aspl(aspl_) { }
+
+    void operator()(const Range &range) const
+    {
+        for (int i = range.start; i < range.end; i++)
+            fhtCore<T, OP>(img0, img1, tiles[i].y0, tiles[i].h,
+                           isPositiveShift, level, aspl);
+    }
+
+private:
+    Mat &img0, &img1;
+    const std::vector<FhtNode> &tiles;
+    bool isPositiveShift;
+    int level;
+    double aspl;
+};
+
+template <typename T, HoughOp OP>
+class FhtMergeInvoker : public ParallelLoopBody
+{
+public:
+    FhtMergeInvoker(Mat &img0_, Mat &img1_, const std::vector<FhtNode> &nodes_,
+                    bool isPositiveShift_, int level_, double aspl_)
+        : img0(img0_), img1(img1_), nodes(nodes_),
+          isPositiveShift(isPositiveShift_), level(level_), aspl(aspl_) { }
+
+    void operator()(const Range &range) const
+    {
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            const int32_t y0 = nodes[i].y0, h = nodes[i].h;
+            const int32_t yBegin = std::max(range.start, y0);
+            const int32_t yEnd = std::min(range.end, y0 + h);
+            if (yBegin < yEnd)
+                fhtMergeRows<T, OP>(img0, img1, y0, h, isPositiveShift, level,
+                                    aspl, yBegin - y0, yEnd - y0);
+        }
+    }
+
+private:
+    Mat &img0, &img1;
+    const std::vector<FhtNode> &nodes;
+    bool isPositiveShift;
+    int level;
+    double aspl;
+};
+
+// Subtrees of the recursion which fit the cache (and at least one per thread)
+// are computed as independent tiles, then the levels above them are merged
+// in parallel over the rows. The result does not depend on the tiling.
+static const size_t FHT_TILE_BYTES = 1 << 18;
+
+template <typename T, HoughOp Op>
 void fhtVoT(Mat    &img0,
             Mat    &img1,
             bool    isPositiveShift,
@@ -213,10 +369,41 @@ void fhtVoT(Mat    &img0,
     for (int thres = 1; img0.rows > thres; thres <<= 1)
         level++;
 
-    fhtCore<T, D, Op>(img0, img1, 0, img0.rows, isPositiveShift, level, aspl);
+    const size_t rowBytes = img0.cols * img0.elemSize();
+    const int nThreads = getNumThreads();
+    int tileDepth = 0;
+    while (tileDepth + 1 < level && (img0.rows >> (tileDepth + 1)) >= 8 &&
+           ((img0.rows >> tileDepth) * rowBytes * 2 > FHT_TILE_BYTES ||
+            (1 << tileDepth) < nThreads))
+        tileDepth++;
+
+    if (tileDepth == 0)
+    {
+        fhtCore<T, Op>(img0, img1, 0, img0.rows, isPositiveShift, level, aspl);
+        return;
+    }
+
+    std::vector<std::vector<FhtNode> > nodes(tileDepth + 1);
+    collectFhtNodes(nodes, 0, img0.rows, 0, tileDepth);
+
+    // the destination and source swap at each level of the recursion
+    const std::vector<FhtNode> &tiles = nodes[tileDepth];
+    parallel_for_(Range(0, (int)tiles.size()),
+                  FhtTilesInvoker<T, Op>((tileDepth & 1) ? img1 : img0,
+                                         (tileDepth & 1) ? img0 : img1,
+                                         tiles, isPositiveShift,
+                                         level - tileDepth, aspl));
+    for (int depth = tileDepth - 1; depth >= 0; depth--)
+    {
+        parallel_for_(Range(0, img0.rows),
+                      FhtMergeInvoker<T, Op>((depth & 1) ? img1 : img0,
+                                             (depth & 1) ? img0 : img1,
+                                             nodes[depth], isPositiveShift,
+                                             level - depth, aspl));
+    }
 }
 
-template <typename T, int D>
+template <typename T>
 void fhtVo(Mat    &img0,
            Mat    &img1,
            bool    isPositiveShift,
@@ -226,16 +413,16 @@ void fhtVo(Mat    &img0,
     switch (operation)
     {
     case FHT_ADD:
-        fhtVoT<T, D, FHT_ADD>(img0, img1, isPositiveShift, aspl);
+        fhtVoT<T, FHT_ADD>(img0, img1, isPositiveShift, aspl);
         break;
     case FHT_AVE:
-        fhtVoT<T, D, FHT_AVE>(img0, img1, isPositiveShift, aspl);
+        fhtVoT<T, FHT_AVE>(img0, img1, isPositiveShift, aspl);
         break;
     case FHT_MAX:
-        fhtVoT<T, D, FHT_MAX>(img0, img1, isPositiveShift, aspl);
+        fhtVoT<T, FHT_MAX>(img0, img1, isPositiveShift, aspl);
         break;
     case FHT_MIN:
-        fhtVoT<T, D, FHT_MIN>(img0, img1, isPositiveShift, aspl);
+        fhtVoT<T, FHT_MIN>(img0, img1, isPositiveShift, aspl);
         break;
     default:
         CV_Error_(CV_StsNotImplemented, ("Unknown operation %d", operation));
@@ -253,25 +440,25 @@ static void fhtVo(Mat    &img0,
     switch (depth)
     {
     case CV_8U:
-        fhtVo<uchar, CV_8UC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<uchar>(img0, img1, isPositiveShift, operation, aspl);
         break;
     case CV_8S:
-        fhtVo<schar, CV_8SC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<schar>(img0, img1, isPositiveShift, operation, aspl);
         break;
     case CV_16U:
-        fhtVo<ushort, CV_16UC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<ushort>(img0, img1, isPositiveShift, operation, aspl);
         break;
     case CV_16S:
-        fhtVo<short, CV_16SC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<short>(img0, img1, isPositiveShift, operation, aspl);
         break;
     case CV_32S:
-        fhtVo<int, CV_32SC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<int>(img0, img1, isPositiveShift, operation, aspl);
         break;
     case CV_32F:
-        fhtVo<float, CV_32FC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<float>(img0, img1, isPositiveShift, operation, aspl);
         break;
     case CV_64F:
-        fhtVo<double, CV_64FC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<double>(img0, img1, isPositiveShift, operation, aspl);
         break;
     default:
         CV_Error_(CV_StsNotImplemented, ("Unknown depth %d", depth));
@@ -496,18 +683,51 @@ static void rotateLineRightCyclic(uchar *pLine,
 {
   shift = shift % len;
   shift = (shift + len) % len;
-  memcpy(pBuf, pLine, len);
-  memcpy(pLine + shift, pBuf, len - shift);
-  if (shift > 0)
-    memcpy(pLine, pBuf + len - shift, shift);
+  // only the shorter side of the rotation goes through the buffer
+  if (shift <= len - shift)
+  {
+    memcpy(pBuf, pLine + len - shift, shift);
+    memmove(pLine + shift, pLine, len - shift);
+    memcpy(pLine, pBuf, shift);
+  }
+  else
+  {
+    memcpy(pBuf, pLine, len - shift);
+    memmove(pLine, pLine + len - shift, shift);
+    memcpy(pLine + shift, pBuf, len - shift);
+  }
 }
 
+class SkewQuadrantInvoker : public ParallelLoopBody
+{
+public:
+    SkewQuadrantInvoker(Mat &quad_, double start_, double step_)
+        : quad(quad_), start(start_), step(step_) { }
+
+    void operator()(const Range &range) const
+    {
+        const int pixlen = static_cast<int>(quad.elemSize());
+        const int len = quad.cols * pixlen;
+        std::vector<uchar> buf_(len);
+        uchar *pBuf = &buf_[0];
+        for (int y = range.start; y < range.end; y++)
+        {
+            uchar *pLine = quad.ptr(y);
+            int shift = static_cast<int>(start + step * y) * pixlen;
+            rotateLineRightCyclic(pLine, pBuf, len, shift);
+        }
+    }
+
+private:
+    Mat &quad;
+    double start, step;
+};
+
 static void skewQuadrant(Mat         &quad,
                          const Mat   &src,
-                         uchar       *pBuf,
                          int          quadrant)
 {
-    CV_Assert(pBuf);
+    CV_Assert(quad.cols > 0);
 
     const int wd = src.cols;
     const int ht = src.rows;
@@ -535,15 +755,60 @@ static void skewQuadrant(Mat         &quad,
         CV_Error_(CV_StsNotImplemented, ("Unknown quadrant %d", quadrant));
     }
 
-    const int pixlen = static_cast<int>(quad.elemSize());
-    const int len = quad.cols * pixlen;
-    for (int y = 0; y < quad.rows; y++)
+    parallel_for_(Range(0, quad.rows), SkewQuadrantInvoker(quad, start, step));
+}
+
+static void processFHTQuadrant(Mat       &dst,
+                               const Mat &src,
+                               int        operation,
+                               int        quadrant,
+                               int        makeSkew)
+{
+    calculateFHTQuadrant(dst, src, operation, quadrant);
+    if (quadrant == ARO_315_0 || quadrant == ARO_45_90 ||
+        quadrant == ARO_CTR_VER)
+        flip(dst, dst, 0);
+    if (HDO_DESKEW == makeSkew)
+        skewQuadrant(dst, src, quadrant);
+}
+
+// Quadrants of a multi-quadrant range are computed in parallel. Neighbouring
+// regions share a row of dst, which the later quadrant overwrites, so all but
+// the last quadrant are computed aside and copied without their last row.
+class FHTQuadrantsInvoker : public ParallelLoopBody
+{
+public:
+    FHTQuadrantsInvoker(const std::vector<Mat> &dsts_,
+                        const std::vector<Mat> &srcs_,
+                        const std::vector<int> &quadrants_,
+                        int operation_,
+                        int makeSkew_)
+        : dsts(dsts_), srcs(srcs_), quadrants(quadrants_),
+          operation(operation_), makeSkew(makeSkew_) { }
+
+    void operator()(const Range &range) const
     {
-        uchar *pLine = quad.ptr(y);
-        int shift = static_cast<int>(start + step * y) * pixlen;
-        rotateLineRightCyclic(pLine, pBuf, len, shift);
+        for (int i = range.start; i < range.end; i++)
+        {
+            Mat region = dsts[i];
+            if (i + 1 == (int)quadrants.size())
+            {
+                processFHTQuadrant(region, srcs[i], operation, quadrants[i], makeSkew);
+                continue;
+            }
+            Mat quad(region.size(), region.type());
+            processFHTQuadrant(quad, srcs[i], operation, quadrants[i], makeSkew);
+            if (region.rows > 1)
+                quad.rowRange(0, quad.rows - 1).copyTo(region.rowRange(0, region.rows - 1));
+        }
     }
-}
+
+private:
+    const std::vector<Mat> &dsts;
+    const std::vector<Mat> &srcs;
+    const std::vector<int> &quadrants;
+    int operation, makeSkew;
+};
 
 void FastHoughTransform(InputArray  src,
                         OutputArray dst,
@@ -560,112 +825,59 @@ void FastHoughTransform(InputArray  src,
     createDstFhtMat(dst, src, dstMatDepth, angleRange);
     Mat dstMat = dst.getMat();
 
-    Mat imgRegDst;
-    const int len = dstMat.cols * static_cast<int>(dstMat.elemSize());
-    CV_Assert(len > 0);
-    std::vector<uchar> buf_(len);
-    uchar *buf(&buf_[0]);
-
-    if (angleRange == ARO_315_135)
-    {
-        {
-            Mat imgSrc;
-            createFHTSrc(imgSrc, srcMat, ARO_315_45);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_315_0, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0);
-            flip(imgRegDst, imgRegDst, 0);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_315_0);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_0_45, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_0_45);
-        }
-        {
-            Mat imgSrc;
-            createFHTSrc(imgSrc, srcMat, ARO_45_135);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_45_90, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90);
-            flip(imgRegDst, imgRegDst, 0);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_45_90);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_90_135, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_90_135);
-        }
-        return;
-    }
-
-    Mat imgSrc;
-    createFHTSrc(imgSrc, srcMat, angleRange);
-
+    std::vector<int> quadrants;
     switch (angleRange)
     {
     case ARO_315_0:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
     case ARO_0_45:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
     case ARO_45_90:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
     case ARO_90_135:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_315_45:
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_315_0, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0);
-        flip(imgRegDst, imgRegDst, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_315_0);
-
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_0_45, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_0_45);
-        return;
-    case ARO_45_135:
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_45_90, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90);
-        flip(imgRegDst, imgRegDst, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_45_90);
-
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_90_135, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_90_135);
-        return;
     case ARO_CTR_VER:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
     case ARO_CTR_HOR:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
+        quadrants.push_back(angleRange);
+        break;
+    case ARO_315_45:
+        quadrants.push_back(ARO_315_0);
+        quadrants.push_back(ARO_0_45);
+        break;
+    case ARO_45_135:
+        quadrants.push_back(ARO_45_90);
+        quadrants.push_back(ARO_90_135);
+        break;
+    case ARO_315_135:
+        quadrants.push_back(ARO_315_0);
+        quadrants.push_back(ARO_0_45);
+        quadrants.push_back(ARO_45_90);
+        quadrants.push_back(ARO_90_135);
+        break;
     default:
         CV_Error_(CV_StsNotImplemented, ("Unknown angleRange %d", angleRange));
     }
+
+    // the vertical and horizontal quadrants share the same tiled source
+    Mat imgSrcVer, imgSrcHor;
+    const int nQuadrants = (int)quadrants.size();
+    std::vector<Mat> srcs(nQuadrants), dsts(nQuadrants);
+    for (int i = 0; i < nQuadrants; i++)
+    {
+        const int quadrant = quadrants[i];
+        const bool isHorizontal = quadrant == ARO_45_90 ||
+                                  quadrant == ARO_90_135 ||
+                                  quadrant == ARO_CTR_HOR;
+        Mat &imgSrc = isHorizontal ? imgSrcHor : imgSrcVer;
+        if (imgSrc.empty())
+            createFHTSrc(imgSrc, srcMat, isHorizontal ? ARO_45_135 : ARO_315_45);
+        srcs[i] = imgSrc;
+
+        if (nQuadrants == 1)
+            dsts[i] = dstMat;
+        else
+            setFHTDstRegion(dsts[i], dstMat, srcMat, quadrant, angleRange);
+    }
+
+    parallel_for_(Range(0, nQuadrants),
+                  FHTQuadrantsInvoker(dsts, srcs, quadrants, operation, makeSkew),
+                  nQuadrants);
 }
 
 //-----------------------------------------------------------------------------
@@ -835,14 +1047,12 @@ static void crossSegments(Point             &point,
     point.y =  cvRound(line1.u.y + mul * (line1.v.y - line1.u.y));
 }
 
-Vec4i HoughPoint2Line(const Point &houghPoint,
-                      InputArray  srcImgInfo,
-                      int         angleRange,
-                      int         makeSkew,
-                      int         rules)
+static Vec4i houghPoint2Line(const Point &houghPoint,
+                             const Mat   &srcImgInfoMat,
+                             int          angleRange,
+                             int          makeSkew,
+                             int          rules)
 {
-    Mat srcImgInfoMat = srcImgInfo.getMat();
-
     int const cols = srcImgInfoMat.cols;
     int const rows = srcImgInfoMat.rows;
 
@@ -1020,6 +1230,43 @@ Vec4i HoughPoint2Line(const Point &houghPoint,
     return Vec4i(dstLine.v.x, dstLine.v.y, dstLine.u.x, dstLine.u.y);
 }
 
+Vec4i HoughPoint2Line(const Point &houghPoint,
+                      InputArray  srcImgInfo,
+                      int         angleRange,
+                      int         makeSkew,
+                      int         rules)
+{
+    Mat srcImgInfoMat = srcImgInfo.getMat();
+    return houghPoint2Line(houghPoint, srcImgInfoMat, angleRange, makeSkew, rules);
+}
+
+void HoughPoint2Line(InputArray  houghPoints,
+                     InputArray  srcImgInfo,
+                     OutputArray lines,
+                     int         angleRange,
+                     int         makeSkew,
+                     int         rules)
+{
+    Mat pointsMat = houghPoints.getMat();
+    int const count = pointsMat.checkVector(2, CV_32S);
+    CV_Assert(count >= 0);
+    if (!pointsMat.isContinuous())
+        pointsMat = pointsMat.clone();
+
+    Mat srcImgInfoMat = srcImgInfo.getMat();
+
+    lines.create(count, 1, CV_32SC4);
+    if (count == 0)
+        return;
+    Mat linesMat = lines.getMat();
+
+    const Point *pPoints = pointsMat.ptr<Point>();
+    Vec4i *pLines = linesMat.ptr<Vec4i>();
+    for (int i = 0; i < count; i++)
+        pLines[i] = houghPoint2Line(pPoints[i], srcImgInfoMat,
+                                    angleRange, makeSkew, rules);
+}
+
 //-----------------------------------------------------------------------------
 
 
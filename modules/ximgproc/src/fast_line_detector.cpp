@@ -70,7 +70,7 @@ class FastLineDetectorImpl : public FastLineDetector
 
         FastLineDetectorImpl& operator= (const FastLineDetectorImpl&); // to quiet MSVC
         template<class T>
-            void incidentPoint(const Mat& l, T& pt);
+            void incidentPoint(const Vec3d& l, T& pt);
 
         void mergeLines(const SEGMENT& seg1, const SEGMENT& seg2, SEGMENT& seg_merged);
 
@@ -78,12 +78,14 @@ class FastLineDetectorImpl : public FastLineDetector
 
         bool getPointChain(const Mat& img, Point pt, Point& chained_pt, float& direction, int step);
 
-        double distPointLine(const Mat& p, Mat& l);
+        double distPointLine(const Vec3d& p, Vec3d& l);
 
         void extractSegments(const std::vector<Point2i>& points, std::vector<SEGMENT>& segments );
 
         void lineDetection(const Mat& src, std::vector<SEGMENT>& segments_all);
 
+        void chainSegments(const Mat& src, const std::vector<Point2i>& points, std::vector<SEGMENT>& segments_chain);
+
         void pointInboardTest(const Mat& src, Point2i& pt);
 
         inline void getAngle(SEGMENT& seg);
@@ -92,8 +94,56 @@ class FastLineDetectorImpl : public FastLineDetector
 
         void drawSegment(Mat& mat, const SEGMENT& seg, Scalar bgr = Scalar(0,255,0),
                 int thickness = 1, bool directed = true);
+
+        friend class ChainSegmentsInvoker;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Extracts the segments of edge chains in parallel. Chains are traced beforehand in
+// raster order over the whole image, so the result doesn't depend on the number of threads.
+class ChainSegmentsInvoker : public ParallelLoopBody
+{
+    public:
+        ChainSegmentsInvoker(FastLineDetectorImpl& _fld, const Mat& _src,
+                const std::vector<Point2i>& _points, const std::vector<int>& _chain_starts,
+                std::vector<std::vector<SEGMENT> >& _segments)
+            : fld(_fld), src(_src), points(_points), chain_starts(_chain_starts), segments(_segments)
+        {
+        }
+
+        void operator()(const Range& range) const
+        {
+            std::vector<Point2i> chain;
+            for(int i = range.start; i < range.end; ++i)
+            {
+                chain.assign(points.begin() + chain_starts[i], points.begin() + chain_starts[i + 1]);
+                fld.chainSegments(src, chain, segments[i]);
+            }
+        }
+
+    private:
+        FastLineDetectorImpl& fld;
+        const Mat& src;
+        const std::vector<Point2i>& points;
+        const std::vector<int>& chain_starts;
+        std::vector<std::vector<SEGMENT> >& segments;
+
+        ChainSegmentsInvoker& operator= (const ChainSegmentsInvoker&); // to quiet MSVC
 };
 
+// Line through two points, in homogeneous coordinates
+static inline Vec3d lineThroughPoints(double x1, double y1, double x2, double y2)
+{
+    return Vec3d(x1, y1, 1.0).cross(Vec3d(x2, y2, 1.0));
+}
+
+// Line given by fitLine, in homogeneous coordinates
+static inline Vec3d lineFromFit(const Vec4f& line)
+{
+    return lineThroughPoints(line[2], line[3], line[2] + line[0], line[3] + line[1]);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////
 
 CV_EXPORTS Ptr<FastLineDetector> createFastLineDetector(
@@ -260,40 +310,23 @@ void FastLineDetectorImpl::mergeLines(const SEGMENT& seg1, const SEGMENT& seg2,
     seg_merged.y2 = (float)delta2y;
 }
 
-double FastLineDetectorImpl::distPointLine(const Mat& p, Mat& l)
+double FastLineDetectorImpl::distPointLine(const Vec3d& p, Vec3d& l)
 {
-    double x = l.at<double>(0,0);
-    double y = l.at<double>(1,0);
+    double x = l[0];
+    double y = l[1];
     double w = sqrt(x*x+y*y);
 
-    l.at<double>(0,0) = x / w;
-    l.at<double>(1,0) = y / w;
-    l.at<double>(2,0) = l.at<double>(2,0) / w;
+    l[0] = x / w;
+    l[1] = y / w;
+    l[2] = l[2] / w;
 
     return l.dot(p);
 }
 
 bool FastLineDetectorImpl::mergeSegments(const SEGMENT& seg1, const SEGMENT& seg2, SEGMENT& seg_merged)
 {
-    double o[] = { 0.0, 0.0, 1.0 };
-    double a[] = { 0.0, 0.0, 1.0 };
-    double b[] = { 0.0, 0.0, 1.0 };
-    double c[3];
-
-    o[0] = ( seg2.x1 + seg2.x2 ) / 2.0;
-    o[1] = ( seg2.y1 + seg2.y2 ) / 2.0;
-
-    a[0] = seg1.x1;
-    a[1] = seg1.y1;
-    b[0] = seg1.x2;
-    b[1] = seg1.y2;
-
-    Mat ori = Mat(3, 1, CV_64FC1, o).clone();
-    Mat p1 = Mat(3, 1, CV_64FC1, a).clone();
-    Mat p2 = Mat(3, 1, CV_64FC1, b).clone();
-    Mat l1 = Mat(3, 1, CV_64FC1, c).clone();
-
-    l1 = p1.cross(p2);
+    Vec3d ori(( seg2.x1 + seg2.x2 ) / 2.0, ( seg2.y1 + seg2.y2 ) / 2.0, 1.0);
+    Vec3d l1 = lineThroughPoints(seg1.x1, seg1.y1, seg1.x2, seg1.y2);
 
     Point2f seg1mid, seg2mid;
     seg1mid.x = (seg1.x1 + seg1.x2) /2.0f;
@@ -321,26 +354,21 @@ bool FastLineDetectorImpl::mergeSegments(const SEGMENT& seg1, const SEGMENT& seg
 }
 
 template<class T>
-    void FastLineDetectorImpl::incidentPoint(const Mat& l, T& pt)
+    void FastLineDetectorImpl::incidentPoint(const Vec3d& l, T& pt)
     {
-        double a[] = { (double)pt.x, (double)pt.y, 1.0 };
-        double b[] = { l.at<double>(0,0), l.at<double>(1,0), 0.0 };
-        double c[3];
+        Vec3d xk((double)pt.x, (double)pt.y, 1.0);
+        Vec3d lh(l[0], l[1], 0.0);
 
-        Mat xk = Mat(3, 1, CV_64FC1, a).clone();
-        Mat lh = Mat(3, 1, CV_64FC1, b).clone();
-        Mat lk = Mat(3, 1, CV_64FC1, c).clone();
-
-        lk = xk.cross(lh);
+        Vec3d lk = xk.cross(lh);
         xk = lk.cross(l);
 
-        xk.convertTo(xk, -1, 1.0 / xk.at<double>(2,0));
+        xk *= 1.0 / xk[2];
 
         Point2f pt_tmp;
-        pt_tmp.x = (float)xk.at<double>(0,0) < 0.0f ? 0.0f : (float)xk.at<double>(0,0)
-            >= (imagewidth - 1.0f) ? (imagewidth - 1.0f) : (float)xk.at<double>(0,0);
-        pt_tmp.y = (float)xk.at<double>(1,0) < 0.0f ? 0.0f : (float)xk.at<double>(1,0)
-            >= (imageheight - 1.0f) ? (imageheight - 1.0f) : (float)xk.at<double>(1,0);
+        pt_tmp.x = (float)xk[0] < 0.0f ? 0.0f : (float)xk[0]
+            >= (imagewidth - 1.0f) ? (imagewidth - 1.0f) : (float)xk[0];
+        pt_tmp.y = (float)xk[1] < 0.0f ? 0.0f : (float)xk[1]
+            >= (imageheight - 1.0f) ? (imageheight - 1.0f) : (float)xk[1];
         pt = T(pt_tmp);
     }
 
@@ -361,15 +389,8 @@ void FastLineDetectorImpl::extractSegments(const std::vector<Point2i>& points, s
         ps = points[i];
         pe = points[i + threshold_length];
 
-        double a[] = { (double)ps.x, (double)ps.y, 1 };
-        double b[] = { (double)pe.x, (double)pe.y, 1 };
-        double c[3], d[3];
-
-        Mat p1 = Mat(3, 1, CV_64FC1, a).clone();
-        Mat p2 = Mat(3, 1, CV_64FC1, b).clone();
-        Mat p = Mat(3, 1, CV_64FC1, c).clone();
-        Mat l = Mat(3, 1, CV_64FC1, d).clone();
-        l = p1.cross(p2);
+        Vec3d l = lineThroughPoints(ps.x, ps.y, pe.x, pe.y);
+        Vec3d p;
 
         is_line = true;
 
@@ -381,9 +402,7 @@ void FastLineDetectorImpl::extractSegments(const std::vector<Point2i>& points, s
             pt.x = points[i+j].x;
             pt.y = points[i+j].y;
 
-            p.at<double>(0,0) = (double)pt.x;
-            p.at<double>(1,0) = (double)pt.y;
-            p.at<double>(2,0) = 1.0;
+            p = Vec3d((double)pt.x, (double)pt.y, 1.0);
 
             double dist = distPointLine(p, l);
 
@@ -403,15 +422,7 @@ void FastLineDetectorImpl::extractSegments(const std::vector<Point2i>& points, s
 
         Vec4f line;
         fitLine( Mat(l_points), line, DIST_L2, 0, 0.01, 0.01);
-        a[0] = line[2];
-        a[1] = line[3];
-        b[0] = line[2] + line[0];
-        b[1] = line[3] + line[1];
-
-        p1 = Mat(3, 1, CV_64FC1, a).clone();
-        p2 = Mat(3, 1, CV_64FC1, b).clone();
-
-        l = p1.cross(p2);
+        l = lineFromFit(line);
 
         incidentPoint(l, ps);
 
@@ -421,23 +432,13 @@ void FastLineDetectorImpl::extractSegments(const std::vector<Point2i>& points, s
             pt.x = points[i+j].x;
             pt.y = points[i+j].y;
 
-            p.at<double>(0,0) = (double)pt.x;
-            p.at<double>(1,0) = (double)pt.y;
-            p.at<double>(2,0) = 1.0;
+            p = Vec3d((double)pt.x, (double)pt.y, 1.0);
 
             double dist = distPointLine(p, l);
             if ( fabs( dist ) > threshold_dist )
             {
                 fitLine( Mat(l_points), line, DIST_L2, 0, 0.01, 0.01);
-                a[0] = line[2];
-                a[1] = line[3];
-                b[0] = line[2] + line[0];
-                b[1] = line[3] + line[1];
-
-                p1 = Mat(3, 1, CV_64FC1, a).clone();
-                p2 = Mat(3, 1, CV_64FC1, b).clone();
-
-                l = p1.cross(p2);
+                l = lineFromFit(line);
                 dist = distPointLine(p, l);
                 if ( fabs( dist ) > threshold_dist ) {
                     j--;
@@ -448,15 +449,7 @@ void FastLineDetectorImpl::extractSegments(const std::vector<Point2i>& points, s
             l_points.push_back(pt);
         }
         fitLine( Mat(l_points), line, DIST_L2, 0, 0.01, 0.01);
-        a[0] = line[2];
-        a[1] = line[3];
-        b[0] = line[2] + line[0];
-        b[1] = line[3] + line[1];
-
-        p1 = Mat(3, 1, CV_64FC1, a).clone();
-        p2 = Mat(3, 1, CV_64FC1, b).clone();
-
-        l = p1.cross(p2);
+        l = lineFromFit(line);
 
         Point2f e1, e2;
         e1.x = (float)ps.x;
@@ -541,15 +534,19 @@ void FastLineDetectorImpl::lineDetection(const Mat& src, std::vector<SEGMENT>& s
     int r, c;
     imageheight=src.rows; imagewidth=src.cols;
 
-    std::vector<Point2i> points;
-    std::vector<SEGMENT> segments, segments_tmp;
+    std::vector<SEGMENT> segments_tmp;
     Mat canny;
     Canny(src, canny, canny_th1, canny_th2, canny_aperture_size);
 
     canny.colRange(0,6).rowRange(0,6) = 0;
     canny.colRange(src.cols-5,src.cols).rowRange(src.rows-5,src.rows) = 0;
 
-    SEGMENT seg, seg1, seg2;
+    SEGMENT seg1, seg2;
+
+    // Edge chains are traced in raster order, each one consuming its pixels, then their
+    // segments are extracted in parallel and gathered in the order of the chains
+    std::vector<Point2i> points;
+    std::vector<int> chain_starts(1, 0);
 
     for ( r = 0; r < imageheight; r++ )
     {
@@ -561,6 +558,7 @@ void FastLineDetectorImpl::lineDetection(const Mat& src, std::vector<SEGMENT>& s
 
             // Found seeds
             Point2i pt = Point2i(c,r);
+            size_t chain_start = points.size();
 
             points.push_back(pt);
             canny.at<unsigned char>(pt.y, pt.x) = 0;
@@ -574,42 +572,27 @@ void FastLineDetectorImpl::lineDetection(const Mat& src, std::vector<SEGMENT>& s
                 canny.at<unsigned char>(pt.y, pt.x) = 0;
             }
 
-            if ( points.size() < (unsigned int)threshold_length + 1 )
-            {
-                points.clear();
-                continue;
-            }
-
-            extractSegments(points, segments);
-
-            if ( segments.size() == 0 )
+            if ( points.size() - chain_start < (unsigned int)threshold_length + 1 )
             {
-                points.clear();
+                points.resize(chain_start);
                 continue;
             }
-            for ( int i = 0; i < (int)segments.size(); i++ )
-            {
-                seg = segments[i];
-                float length = sqrt((seg.x1 - seg.x2)*(seg.x1 - seg.x2) +
-                        (seg.y1 - seg.y2)*(seg.y1 - seg.y2));
-                if(length < threshold_length)
-                    continue;
-                if( (seg.x1 <= 5.0f && seg.x2 <= 5.0f) ||
-                    (seg.y1 <= 5.0f && seg.y2 <= 5.0f) ||
-                    (seg.x1 >= imagewidth - 5.0f && seg.x2 >= imagewidth - 5.0f) ||
-                    (seg.y1 >= imageheight - 5.0f && seg.y2 >= imageheight - 5.0f) )
-                    continue;
-                additionalOperationsOnSegment(src, seg);
-                if(!do_merge)
-                    segments_all.push_back(seg);
-                segments_tmp.push_back(seg);
-            }
-            points.clear();
-            segments.clear();
+            chain_starts.push_back((int)points.size());
         }
     }
+
+    int nchains = (int)chain_starts.size() - 1;
+    std::vector<std::vector<SEGMENT> > segments_chains(nchains);
+    parallel_for_(Range(0, nchains), ChainSegmentsInvoker(*this, src, points, chain_starts, segments_chains));
+
+    for ( int i = 0; i < nchains; i++ )
+        segments_tmp.insert(segments_tmp.end(), segments_chains[i].begin(), segments_chains[i].end());
+
     if(!do_merge)
+    {
+        segments_all.insert(segments_all.end(), segments_tmp.begin(), segments_tmp.end());
         return;
+    }
 
     bool is_merged = false;
     int ith = (int)segments_tmp.size() - 1;
@@ -642,6 +625,31 @@ void FastLineDetectorImpl::lineDetection(const Mat& src, std::vector<SEGMENT>& s
     segments_all = segments_tmp;
 }
 
+void FastLineDetectorImpl::chainSegments(const Mat& src, const std::vector<Point2i>& points,
+        std::vector<SEGMENT>& segments_chain)
+{
+    std::vector<SEGMENT> segments;
+    SEGMENT seg;
+
+    extractSegments(points, segments);
+
+    for ( int i = 0; i < (int)segments.size(); i++ )
+    {
+        seg = segments[i];
+        float length = sqrt((seg.x1 - seg.x2)*(seg.x1 - seg.x2) +
+                (seg.y1 - seg.y2)*(seg.y1 - seg.y2));
+        if(length < threshold_length)
+            continue;
+        if( (seg.x1 <= 5.0f && seg.x2 <= 5.0f) ||
+            (seg.y1 <= 5.0f && seg.y2 <= 5.0f) ||
+            (seg.x1 >= imagewidth - 5.0f && seg.x2 >= imagewidth - 5.0f) ||
+            (seg.y1 >= imageheight - 5.0f && seg.y2 >= imageheight - 5.0f) )
+            continue;
+        additionalOperationsOnSegment(src, seg);
+        segments_chain.push_back(seg);
+    }
+}
+
 inline void FastLineDetectorImpl::getAngle(SEGMENT& seg)
 {
     seg.angle = (float)(fastAtan2(seg.y2 - seg.y1, seg.x2 - seg.x1) / 180.0f * CV_PI);
@@ -662,8 +670,8 @@ void FastLineDetectorImpl::additionalOperationsOnSegment(const Mat& src, SEGMENT
     dx = (double) end.x - (double) start.x;
     dy = (double) end.y - (double) start.y;
 
-    int num_points = 10;
-    Point2f *points = new Point2f[num_points];
+    const int num_points = 10;
+    Point2f points[num_points];
 
     points[0] = start;
     points[num_points - 1] = end;
@@ -675,8 +683,8 @@ void FastLineDetectorImpl::additionalOperationsOnSegment(const Mat& src, SEGMENT
         points[i].y = points[0].y + ((float)dy / float(num_points - 1) * (float) i);
     }
 
-    Point2i *points_right = new Point2i[num_points];
-    Point2i *points_left = new Point2i[num_points];
+    Point2i points_right[num_points];
+    Point2i points_left[num_points];
     double gap = 1.0;
 
     for(int i = 0; i < num_points; i++)
@@ -703,10 +711,6 @@ void FastLineDetectorImpl::additionalOperationsOnSegment(const Mat& src, SEGMENT
         getAngle(seg);
     }
 
-    delete[] points;
-    delete[] points_right;
-    delete[] points_left;
-
     return;
 }
 
@@ -61,27 +61,11 @@ namespace cv {
                     }
             };
 
-            // A point in the sets of points
-            class PointSetElement {
-                public:
-                    int p;
-                    int size;
-
-                    PointSetElement() { }
-
-                    PointSetElement(int p_) {
-                        p = p_;
-                        size = 1;
-                    }
-            };
-
-            // An object to manage set of points, who can be fusionned
+            // An object to manage set of points, who can be fusionned.
+            // Each point uses a single int: the index of its parent, or minus the size of the set for the main point.
             class PointSet {
                 public:
-                    PointSet(int nb_elements_);
-                    ~PointSet();
-
-                    int nb_elements;
+                    PointSet(int nb_elements_) : mapping(nb_elements_, -1) { }
 
                     // Return the main point of the point's set
                     int getBasePoint(int p);
@@ -90,10 +74,10 @@ namespace cv {
                     void joinPoints(int p_a, int p_b);
 
                     // Return the set size of a set (based on the main point)
-                    int size(unsigned int p) { return mapping[p].size; }
+                    int size(int p) const { return -mapping[p]; }
 
                 private:
-                    PointSetElement* mapping;
+                    std::vector<int> mapping;
 
             };
 
@@ -103,6 +87,7 @@ namespace cv {
                         sigma = 0.5;
                         k = 300;
                         min_size = 100;
+                        tile_size = 0;
                         name_ = "GraphSegmentation";
                     }
 
@@ -120,11 +105,15 @@ namespace cv {
                     virtual void setMinSize(int min_size_) { min_size = min_size_; }
                     virtual int getMinSize() { return min_size; }
 
+                    virtual void setTileSize(int tile_size_) { tile_size = std::max(tile_size_, 0); }
+                    virtual int getTileSize() { return tile_size; }
+
                     virtual void write(FileStorage& fs) const {
                         fs << "name" << name_
                         << "sigma" << sigma
                         << "k" << k
-                        << "min_size" << (int)min_size;
+                        << "min_size" << (int)min_size
+                        << "tile_size" << tile_size;
                     }
 
                     virtual void read(const FileNode& fn) {
@@ -133,147 +122,231 @@ namespace cv {
                         sigma = (double)fn["sigma"];
                         k = (float)fn["k"];
                         min_size = (int)(int)fn["min_size"];
+                        tile_size = fn["tile_size"].empty() ? 0 : (int)fn["tile_size"];
                     }
 
                 private:
                     double sigma;
                     float k;
                     int min_size;
+                    int tile_size;
                     String name_;
 
                     // Pre-filter the image
                     void filter(const Mat &img, Mat &img_filtered);
 
-                    // Build the graph between each pixels
-                    void buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered);
-
-                    // Segment the graph
-                    void segmentGraph(Edge * edges, const int &nb_edges, const Mat & img_filtered, PointSet **es);
+                    // Segment the graph. Only the edges that didn't lead to a merge are kept, in order.
+                    void segmentGraph(std::vector<Edge> &edges, PointSet &es, std::vector<float> &thresholds) const;
 
                     // Remove areas too small
-                    void filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es);
+                    void filterSmallAreas(const std::vector<Edge> &edges, PointSet &es) const;
 
                     // Map the segemented graph to a Mat with uniques, sequentials ids
-                    void finalMapping(PointSet *es, Mat &output);
+                    void finalMapping(PointSet &es, Mat &output);
+
+                    friend class SegmentTilesInvoker;
             };
 
-            void GraphSegmentationImpl::filter(const Mat &img, Mat &img_filtered) {
+            // Compute the edges between the pixels of each row of an area
+            class BuildGraphInvoker : public ParallelLoopBody {
+                public:
+                    BuildGraphInvoker(const Mat &img_filtered_, const Rect &area_, std::vector<Edge> &edges_) :
+                        img_filtered(img_filtered_), area(area_), edges(edges_) {
+                    }
 
-                Mat img_converted;
+                    virtual void operator()(const Range& range) const {
 
-                // Switch to float
-                img.convertTo(img_converted, CV_32F);
+                        int nb_channels = img_filtered.channels();
+                        int cols = img_filtered.cols;
 
-                // Apply gaussian filter
-                GaussianBlur(img_converted, img_filtered, Size(0, 0), sigma, sigma);
-            }
+                        for (int i = range.start; i < range.end; i++) {
 
-            void GraphSegmentationImpl::buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered) {
+                            int y = area.y + i;
+                            const float* p = img_filtered.ptr<float>(y);
+                            const float* p_down = i + 1 < area.height ? img_filtered.ptr<float>(y + 1) : NULL;
 
-                *edges = new Edge[img_filtered.rows * img_filtered.cols * 4];
+                            // Each row has its right edges, then its down edges (but for the last row)
+                            Edge* e = &edges[(size_t)i * (2 * area.width - 1)];
 
-                nb_edges = 0;
+                            for (int x = area.x; x < area.x + area.width; x++) {
+                                const float* a = p + x * nb_channels;
 
-                int nb_channels = img_filtered.channels();
+                                if (x + 1 < area.x + area.width) {
+                                    e->weight = diff(a, a + nb_channels, nb_channels);
+                                    e->from = y * cols + x;
+                                    e->to = y * cols + x + 1;
+                                    e++;
+                                }
+                            }
 
-                for (int i = 0; i < (int)img_filtered.rows; i++) {
-                    const float* p = img_filtered.ptr<float>(i);
+                            if (p_down) {
+                                for (int x = area.x; x < area.x + area.width; x++) {
+                                    e->weight = diff(p + x * nb_channels, p_down + x * nb_channels, nb_channels);
+                                    e->from = y * cols + x;
+                                    e->to = (y + 1) * cols + x;
+                                    e++;
+                                }
+                            }
+                        }
+                    }
 
-                    for (int j = 0; j < (int)img_filtered.cols; j++) {
+                    static float diff(const float* a, const float* b, int nb_channels) {
+                        float tmp_total = 0;
 
-                        //Take the right, left, top and down pixel
-                        for (int delta = -1; delta <= 1; delta += 2) {
-                            for (int delta_j = 0, delta_i = 1; delta_j <= 1; delta_j++ || delta_i--) {
+                        for (int channel = 0; channel < nb_channels; channel++) {
+                            float d = a[channel] - b[channel];
+                            tmp_total += d * d;
+                        }
 
-                                int i2 = i + delta * delta_i;
-                                int j2 = j + delta * delta_j;
+                        return std::sqrt(tmp_total);
+                    }
 
-                                if (i2 >= 0 && i2 < img_filtered.rows && j2 >= 0 && j2 < img_filtered.cols) {
-                                    const float* p2 = img_filtered.ptr<float>(i2);
+                private:
+                    const Mat &img_filtered;
+                    Rect area;
+                    std::vector<Edge> &edges;
+            };
 
-                                    float tmp_total = 0;
+            // Build the graph between each pixels of an area (right and down neighbours)
+            static void buildGraph(const Mat &img_filtered, const Rect &area, std::vector<Edge> &edges) {
 
-                                    for ( int channel = 0; channel < nb_channels; channel++) {
-                                        tmp_total += pow(p[j * nb_channels + channel] - p2[j2 * nb_channels + channel], 2);
-                                    }
+                edges.resize((size_t)area.height * (area.width - 1) + (size_t)(area.height - 1) * area.width);
 
-                                    float diff = 0;
-                                    diff = sqrt(tmp_total);
+                if (!edges.empty()) {
+                    parallel_for_(Range(0, area.height), BuildGraphInvoker(img_filtered, area, edges));
+                }
+            }
 
-                                    (*edges)[nb_edges].weight = diff;
-                                    (*edges)[nb_edges].from = i * img_filtered.cols +  j;
-                                    (*edges)[nb_edges].to = i2 * img_filtered.cols + j2;
+            // Sort edges by weight, with a bucket sort on the weights quantized to 16 bits.
+            // Each bucket is then sorted on the exact weights, so the order is the one of a full (stable) sort.
+            // buckets is a scratch array, kept by the caller across calls.
+            static void sortEdges(std::vector<Edge> &edges, std::vector<int> &buckets) {
 
-                                    nb_edges++;
-                                }
-                            }
-                        }
+                const int nb_buckets = 1 << 16;
+
+                float max_weight = 0;
+
+                for (size_t i = 0; i < edges.size(); i++) {
+                    max_weight = std::max(max_weight, edges[i].weight);
+                }
+
+                float scale = max_weight > 0 ? (nb_buckets - 1) / max_weight : 0;
+
+                buckets.assign(nb_buckets + 1, 0);
+
+                for (size_t i = 0; i < edges.size(); i++) {
+                    buckets[std::min((int)(edges[i].weight * scale), nb_buckets - 1) + 1]++;
+                }
+
+                for (int b = 0; b < nb_buckets; b++) {
+                    buckets[b + 1] += buckets[b];
+                }
+
+                std::vector<Edge> sorted(edges.size());
+
+                // buckets[b] moves from the start to the end of bucket b
+                for (size_t i = 0; i < edges.size(); i++) {
+                    sorted[buckets[std::min((int)(edges[i].weight * scale), nb_buckets - 1)]++] = edges[i];
+                }
+
+                for (int b = 0, begin = 0; b < nb_buckets; begin = buckets[b++]) {
+                    if (buckets[b] - begin > 1) {
+                        std::stable_sort(sorted.begin() + begin, sorted.begin() + buckets[b]);
                     }
                 }
+
+                edges.swap(sorted);
             }
 
-            void GraphSegmentationImpl::segmentGraph(Edge *edges, const int &nb_edges, const Mat &img_filtered, PointSet **es) {
+            // Segment tiles of the image independently. Tiles don't share any pixel, so they can
+            // use the same PointSet concurrently.
+            class SegmentTilesInvoker : public ParallelLoopBody {
+                public:
+                    SegmentTilesInvoker(const GraphSegmentationImpl &gs_, const Mat &img_filtered_, const std::vector<Rect> &tiles_,
+                                        PointSet &es_, std::vector<float> &thresholds_, std::vector<std::vector<Edge> > &remaining_,
+                                        TLSData<std::vector<int> > &sortBuckets_) :
+                        gs(gs_), img_filtered(img_filtered_), tiles(tiles_), es(es_), thresholds(thresholds_), remaining(remaining_),
+                        sortBuckets(sortBuckets_) {
+                    }
 
-                int total_points = ( int)(img_filtered.rows * img_filtered.cols);
+                    virtual void operator()(const Range& range) const {
+                        std::vector<int> &buckets = *sortBuckets.get();
 
-                // Sort edges
-                std::sort(edges, edges + nb_edges);
+                        for (int t = range.start; t < range.end; t++) {
+                            std::vector<Edge> edges;
 
-                // Create a set with all point (by default mapped to themselfs)
-                *es = new PointSet(img_filtered.cols * img_filtered.rows);
+                            buildGraph(img_filtered, tiles[t], edges);
+                            sortEdges(edges, buckets);
+                            gs.segmentGraph(edges, es, thresholds);
 
-                // Thresholds
-                float* thresholds = new float[total_points];
+                            remaining[t].swap(edges);
+                        }
+                    }
 
-                for (int i = 0; i < total_points; i++)
-                    thresholds[i] = k;
+                private:
+                    const GraphSegmentationImpl &gs;
+                    const Mat &img_filtered;
+                    const std::vector<Rect> &tiles;
+                    PointSet &es;
+                    std::vector<float> &thresholds;
+                    std::vector<std::vector<Edge> > &remaining;
+                    TLSData<std::vector<int> > &sortBuckets; // one bucket array per thread, reused across tiles
+            };
+
+            void GraphSegmentationImpl::filter(const Mat &img, Mat &img_filtered) {
+
+                Mat img_converted;
+
+                // Switch to float
+                img.convertTo(img_converted, CV_32F);
+
+                // Apply gaussian filter
+                GaussianBlur(img_converted, img_filtered, Size(0, 0), sigma, sigma);
+            }
+
+            void GraphSegmentationImpl::segmentGraph(std::vector<Edge> &edges, PointSet &es, std::vector<float> &thresholds) const {
+
+                size_t kept = 0;
 
-                for ( int i = 0; i < nb_edges; i++) {
+                for (size_t i = 0; i < edges.size(); i++) {
 
-                    int p_a = (*es)->getBasePoint(edges[i].from);
-                    int p_b = (*es)->getBasePoint(edges[i].to);
+                    int p_a = es.getBasePoint(edges[i].from);
+                    int p_b = es.getBasePoint(edges[i].to);
 
                     if (p_a != p_b) {
                         if (edges[i].weight <= thresholds[p_a] && edges[i].weight <= thresholds[p_b]) {
-                            (*es)->joinPoints(p_a, p_b);
-                            p_a = (*es)->getBasePoint(p_a);
-                            thresholds[p_a] = edges[i].weight + k / (*es)->size(p_a);
-
-                            edges[i].weight = 0;
+                            es.joinPoints(p_a, p_b);
+                            p_a = es.getBasePoint(p_a);
+                            thresholds[p_a] = edges[i].weight + k / es.size(p_a);
+                        } else {
+                            edges[kept++] = edges[i];
                         }
                     }
                 }
 
-                delete [] thresholds;
+                edges.resize(kept);
             }
 
-            void GraphSegmentationImpl::filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es) {
-
-                for ( int i = 0; i < nb_edges; i++) {
+            void GraphSegmentationImpl::filterSmallAreas(const std::vector<Edge> &edges, PointSet &es) const {
 
-                    if (edges[i].weight > 0) {
+                for (size_t i = 0; i < edges.size(); i++) {
 
-                        int p_a = es->getBasePoint(edges[i].from);
-                        int p_b = es->getBasePoint(edges[i].to);
+                    int p_a = es.getBasePoint(edges[i].from);
+                    int p_b = es.getBasePoint(edges[i].to);
 
-                        if (p_a != p_b && (es->size(p_a) < min_size || es->size(p_b) < min_size)) {
-                            es->joinPoints(p_a, p_b);
-
-                        }
+                    if (p_a != p_b && (es.size(p_a) < min_size || es.size(p_b) < min_size)) {
+                        es.joinPoints(p_a, p_b);
                     }
                 }
 
             }
 
-            void GraphSegmentationImpl::finalMapping(PointSet *es, Mat &output) {
+            void GraphSegmentationImpl::finalMapping(PointSet &es, Mat &output) {
 
                 int maximum_size = ( int)(output.rows * output.cols);
 
                 int last_id = 0;
-                int * mapped_id = new int[maximum_size];
-
-                for ( int i = 0; i < maximum_size; i++)
-                    mapped_id[i] = -1;
+                std::vector<int> mapped_id(maximum_size, -1);
 
                 int rows = output.rows;
                 int cols = output.cols;
@@ -289,7 +362,7 @@ namespace cv {
 
                     for (int j = 0; j < cols; j++) {
 
-                        int point = es->getBasePoint(i * cols + j);
+                        int point = es.getBasePoint(i * cols + j);
 
                         if (mapped_id[point] == -1) {
                             mapped_id[point] = last_id;
@@ -299,8 +372,6 @@ namespace cv {
                         p[j] = mapped_id[point];
                     }
                 }
-
-                delete [] mapped_id;
             }
 
             void GraphSegmentationImpl::processImage(InputArray src, OutputArray dst) {
@@ -315,26 +386,83 @@ namespace cv {
                 Mat img_filtered;
                 filter(img, img_filtered);
 
-                // Build graph
-                Edge *edges;
-                int nb_edges;
+                // Split in tiles
+                int tile_w = tile_size > 0 ? tile_size : img.cols;
+                int tile_h = tile_size > 0 ? tile_size : img.rows;
+
+                std::vector<Rect> tiles;
+
+                for (int y = 0; y < img.rows; y += tile_h) {
+                    for (int x = 0; x < img.cols; x += tile_w) {
+                        tiles.push_back(Rect(x, y, std::min(tile_w, img.cols - x), std::min(tile_h, img.rows - y)));
+                    }
+                }
+
+                // Create a set with all point (by default mapped to themselfs)
+                PointSet es(img.rows * img.cols);
+
+                // Thresholds
+                std::vector<float> thresholds(img.rows * img.cols, k);
+
+                // Segment each tile
+                std::vector<std::vector<Edge> > remaining(tiles.size());
+
+                TLSData<std::vector<int> > sortBuckets;
+
+                parallel_for_(Range(0, (int)tiles.size()), SegmentTilesInvoker(*this, img_filtered, tiles, es, thresholds, remaining, sortBuckets));
+
+                std::vector<Edge> edges;
+
+                if (tiles.size() == 1) {
+                    edges.swap(remaining[0]);
+                } else {
+                    // Stitch tiles with the edges crossing their borders
+                    int cols = img.cols;
+
+                    for (int x = tile_w; x < img.cols; x += tile_w) {
+                        for (int y = 0; y < img.rows; y++) {
+                            const float* p = img_filtered.ptr<float>(y);
 
-                buildGraph(&edges, nb_edges, img_filtered);
+                            Edge e;
+                            e.weight = BuildGraphInvoker::diff(p + (x - 1) * img.channels(), p + x * img.channels(), img.channels());
+                            e.from = y * cols + x - 1;
+                            e.to = y * cols + x;
+                            edges.push_back(e);
+                        }
+                    }
 
-                // Segment graph
-                PointSet *es;
+                    for (int y = tile_h; y < img.rows; y += tile_h) {
+                        const float* p_up = img_filtered.ptr<float>(y - 1);
+                        const float* p = img_filtered.ptr<float>(y);
 
-                segmentGraph(edges, nb_edges, img_filtered, &es);
+                        for (int x = 0; x < img.cols; x++) {
+                            Edge e;
+                            e.weight = BuildGraphInvoker::diff(p_up + x * img.channels(), p + x * img.channels(), img.channels());
+                            e.from = (y - 1) * cols + x;
+                            e.to = y * cols + x;
+                            edges.push_back(e);
+                        }
+                    }
+
+                    std::vector<int> buckets;
+
+                    sortEdges(edges, buckets);
+                    segmentGraph(edges, es, thresholds);
+
+                    for (size_t t = 0; t < remaining.size(); t++) {
+                        edges.insert(edges.end(), remaining[t].begin(), remaining[t].end());
+                        std::vector<Edge>().swap(remaining[t]);
+                    }
+
+                    sortEdges(edges, buckets);
+                }
 
                 // Remove small areas
-                filterSmallAreas(edges, nb_edges, es);
+                filterSmallAreas(edges, es);
 
                 // Map to final output
                 finalMapping(es, output);
 
-                delete [] edges;
-                delete es;
-
             }
 
             Ptr<GraphSegmentation> createGraphSegmentation(double sigma, float k, int min_size) {
@@ -348,44 +476,31 @@ namespace cv {
                 return graphseg;
             }
 
-            PointSet::PointSet(int nb_elements_) {
-                nb_elements = nb_elements_;
+            int PointSet::getBasePoint(int p) {
 
-                mapping = new PointSetElement[nb_elements];
-
-                for ( int i = 0; i < nb_elements; i++) {
-                    mapping[i] = PointSetElement(i);
-                }
-            }
+                // Path halving: each visited point is linked to its grand-parent
+                while (mapping[p] >= 0) {
+                    int parent = mapping[p];
 
-            PointSet::~PointSet() {
-                delete [] mapping;
-            }
-
-            int PointSet::getBasePoint( int p) {
-
-                 int base_p = p;
+                    if (mapping[parent] < 0) {
+                        return parent;
+                    }
 
-                while (base_p != mapping[base_p].p) {
-                    base_p = mapping[base_p].p;
+                    mapping[p] = mapping[parent];
+                    p = mapping[p];
                 }
 
-                // Save mapping for faster acces later
-                mapping[p].p = base_p;
-
-                return base_p;
+                return p;
             }
 
             void PointSet::joinPoints(int p_a, int p_b) {
 
                 // Always target smaller set, to avoid redirection in getBasePoint
-                if (mapping[p_a].size < mapping[p_b].size)
-                    swap(p_a, p_b);
-
-                mapping[p_b].p = p_a;
-                mapping[p_a].size += mapping[p_b].size;
+                if (mapping[p_a] > mapping[p_b])
+                    std::swap(p_a, p_b);
 
-                nb_elements--;
+                mapping[p_a] += mapping[p_b];
+                mapping[p_b] = p_a;
             }
 
         }
@@ -1329,71 +1329,167 @@ struct FeatureSpaceCenters : ParallelLoopBody
     vector<float> *centerY1, *centerY2;
 };
 
-struct FeatureSpaceKmeans : ParallelLoopBody
+/*
+ *    FeatureSpaceTables
+ *
+ *    cos / sin terms of the feature space
+ *    per column, per row, and per value of
+ *    the 8 bit channels, computed once for
+ *    all the k-means iterations
+ *
+ */
+struct FeatureSpaceTables
 {
-    FeatureSpaceKmeans( Mat* _klabels, Mat* _dist,
-                        const vector< Mat >& _chvec, const Mat& _W,
-                        const vector<float>& _kseedsx, const vector<float>& _kseedsy,
-                        vector<float>& _centerX1, vector<float>& _centerX2,
-                        vector<float>& _centerY1, vector<float>& _centerY2,
-                        vector< vector<float> >& _centerC1, vector< vector<float> >& _centerC2,
-                        const int _nr_channels, const float _chvec_max,
-                        const float _dist_coeff, const float _color_coeff,
-                        const int _stepx, const int _stepy )
+    FeatureSpaceTables( const vector< Mat >& _chvec, const int _nr_channels,
+                        const float _chvec_max, const float _dist_coeff,
+                        const float _color_coeff, const int _stepx, const int _stepy )
     {
-      W = _W;
-      dist = _dist;
       chvec = _chvec;
-      stepx = _stepx;
-      stepy = _stepy;
-      klabels = _klabels;
       chvec_max = _chvec_max;
-      dist_coeff = _dist_coeff;
       nr_channels = _nr_channels;
       color_coeff = _color_coeff;
 
       PI2 = float(CV_PI / 2.0f);
 
-      kseedsx = _kseedsx;
-      kseedsy = _kseedsy;
-      width  = chvec[0].cols;
-      height = chvec[0].rows;
+      int width  = chvec[0].cols;
+      int height = chvec[0].rows;
 
-      centerX1 = _centerX1; centerX2 = _centerX2;
-      centerY1 = _centerY1; centerY2 = _centerY2;
-      centerC1 = _centerC1; centerC2 = _centerC2;
+      x1.resize( width ); x2.resize( width );
+      for( int x = 0; x < width; x++ )
+      {
+        float thetaX = ( (float) x / (float) _stepx ) * PI2;
+        x1[x] = _dist_coeff * cos(thetaX);
+        x2[x] = _dist_coeff * sin(thetaX);
+      }
+
+      y1.resize( height ); y2.resize( height );
+      for( int y = 0; y < height; y++ )
+      {
+        float thetaY = ( (float) y / (float) _stepy ) * PI2;
+        y1[y] = _dist_coeff * cos(thetaY);
+        y2[y] = _dist_coeff * sin(thetaY);
+      }
+
+      C1.resize( nr_channels ); C2.resize( nr_channels );
+      for( int b = 0; b < nr_channels; b++ )
+      {
+        if ( chvec[b].depth() != CV_8U )
+          continue;
+        C1[b].resize( 256 ); C2[b].resize( 256 );
+        for( int v = 0; v < 256; v++ )
+        {
+          float thetaC = ( (float) v / chvec_max ) * PI2;
+          C1[b][v] = color_coeff * cos(thetaC) / nr_channels;
+          C2[b][v] = color_coeff * sin(thetaC) / nr_channels;
+        }
+      }
+    }
+
+    // channel terms of pixel (y,x), not normalized by W
+    inline void channel( int b, int y, int x, float& c1, float& c2 ) const
+    {
+      if ( !C1[b].empty() )
+      {
+        uchar v = chvec[b].at<uchar>(y,x);
+        c1 = C1[b][v]; c2 = C2[b][v];
+        return;
+      }
+
+      float thetaC = 0.0f;
+      switch ( chvec[b].depth() )
+      {
+        case CV_8S:
+          thetaC = ( (float) chvec[b].at<char>(y,x)   / chvec_max ) * PI2;
+          break;
+        case CV_16U:
+          thetaC = ( (float) chvec[b].at<ushort>(y,x) / chvec_max ) * PI2;
+          break;
+        case CV_16S:
+          thetaC = ( (float) chvec[b].at<short>(y,x)  / chvec_max ) * PI2;
+          break;
+        case CV_32S:
+          thetaC = ( (float) chvec[b].at<int>(y,x)    / chvec_max ) * PI2;
+          break;
+        case CV_32F:
+          thetaC = ( (float) chvec[b].at<float>(y,x)  / chvec_max ) * PI2;
+          break;
+        case CV_64F:
+          thetaC = ( (float) chvec[b].at<double>(y,x) / chvec_max ) * PI2;
+          break;
+        default:
+          CV_Error( Error::StsInternal, "Invalid matrix depth" );
+          break;
+      }
+      c1 = color_coeff * cos(thetaC) / nr_channels;
+      c2 = color_coeff * sin(thetaC) / nr_channels;
+    }
+
+    float PI2;
+    int nr_channels;
+    float chvec_max;
+    float color_coeff;
+
+    vector<Mat> chvec;
+    vector<float> x1, x2;
+    vector<float> y1, y2;
+    vector< vector<float> > C1, C2;
+};
+
+/*
+ *    FeatureSpaceKmeans
+ *
+ *    assigns each pixel to the closest center
+ *    among the seeds whose window covers it,
+ *    parallel over rows: seeds are visited in
+ *    the same order for every pixel, so the
+ *    labels don't depend on the split
+ *
+ */
+struct FeatureSpaceKmeans : ParallelLoopBody
+{
+    FeatureSpaceKmeans( Mat& _klabels, Mat& _dist, const Mat& _W,
+                        const FeatureSpaceTables& _tables,
+                        const vector<float>& _kseedsx, const vector<float>& _kseedsy,
+                        const vector<float>& _centerX1, const vector<float>& _centerX2,
+                        const vector<float>& _centerY1, const vector<float>& _centerY2,
+                        const vector< vector<float> >& _centerC1,
+                        const vector< vector<float> >& _centerC2,
+                        const int _nr_channels, const int _stepx, const int _stepy )
+      : klabels(_klabels), dist(_dist), W(_W), tables(_tables),
+        kseedsx(_kseedsx), kseedsy(_kseedsy),
+        centerX1(_centerX1), centerX2(_centerX2),
+        centerY1(_centerY1), centerY2(_centerY2),
+        centerC1(_centerC1), centerC2(_centerC2),
+        nr_channels(_nr_channels), stepx(_stepx), stepy(_stepy)
+    {
+      width  = W.cols;
+      height = W.rows;
     }
 
     void operator()( const Range& range ) const
     {
-      for( int i = range.start; i < range.end; i++ )
+      int numlabels = (int) kseedsx.size();
+      for( int i = 0; i < numlabels; i++ )
       {
         int X = (int)kseedsx[i]; int Y = (int)kseedsy[i];
         int minX = (X-(stepx) <= 0) ? 0 : X-stepx;
-        int minY = (Y-(stepy) <= 0) ? 0 : Y-stepy;
+        int minY = (Y-(stepy) <= range.start) ? range.start : Y-stepy;
         int maxX = (X+(stepx) >= width -1) ? width -1 : X+stepx;
-        int maxY = (Y+(stepy) >= height-1) ? height-1 : Y+stepy;
+        int maxY = (Y+(stepy) >= range.end-1) ? range.end-1 : Y+stepy;
 
-        for( int x = minX; x <= maxX; x++ )
+        for( int y = minY; y <= maxY; y++ )
         {
-          float thetaX = ( (float) x / (float) stepx ) * PI2;
+          const float* Wrow = W.ptr<float>(y);
+          float* distrow = dist.ptr<float>(y);
+          int* labelsrow = klabels.ptr<int>(y);
 
-          float tx1 = dist_coeff * cos(thetaX);
-          float tx2 = dist_coeff * sin(thetaX);
-
-          for( int y = minY; y <= maxY; y++ )
+          for( int x = minX; x <= maxX; x++ )
           {
-            float thetaY = ( (float) y / (float) stepy ) * PI2;
-
-            // we do not store pre-computed x1, x2
-            float x1 = tx1 / W.at<float>(y,x);
-            float x2 = tx2 / W.at<float>(y,x);
-            // we do not store pre-computed y1, y2
-            float y1 = (dist_coeff * cos(thetaY)) / W.at<float>(y,x);
-            float y2 = (dist_coeff * sin(thetaY)) / W.at<float>(y,x);
-
-            float diffx1 = x1 - centerX1[i]; float diffx2 = x2 - centerX2[i];
-            float diffy1 = y1 - centerY1[i]; float diffy2 = y2 - centerY2[i];
+            float w = Wrow[x];
+            float diffx1 = tables.x1[x] / w - centerX1[i];
+            float diffx2 = tables.x2[x] / w - centerX2[i];
+            float diffy1 = tables.y1[y] / w - centerY1[i];
+            float diffy2 = tables.y2[y] / w - centerY2[i];
 
             // compute distance given distance terms
             double D = (diffx1 * diffx1) + (diffx2 * diffx2)
@@ -1402,290 +1498,131 @@ struct FeatureSpaceKmeans : ParallelLoopBody
             // compute distance given channels terms
             for( int b = 0; b < nr_channels; b++ )
             {
-              float thetaC = 0.0f;
-              switch ( chvec[b].depth() )
-              {
-                case CV_8U:
-                  thetaC = ( (float) chvec[b].at<uchar>(y,x)  / chvec_max ) * PI2;
-                  break;
-                case CV_8S:
-                  thetaC = ( (float) chvec[b].at<char>(y,x)   / chvec_max ) * PI2;
-                  break;
-                case CV_16U:
-                  thetaC = ( (float) chvec[b].at<ushort>(y,x) / chvec_max ) * PI2;
-                  break;
-                case CV_16S:
-                  thetaC = ( (float) chvec[b].at<short>(y,x)  / chvec_max ) * PI2;
-                  break;
-                case CV_32S:
-                  thetaC = ( (float) chvec[b].at<int>(y,x)    / chvec_max ) * PI2;
-                  break;
-                case CV_32F:
-                  thetaC = ( (float) chvec[b].at<float>(y,x)  / chvec_max ) * PI2;
-                  break;
-                case CV_64F:
-                  thetaC = ( (float) chvec[b].at<double>(y,x) / chvec_max ) * PI2;
-                  break;
-                default:
-                  CV_Error( Error::StsInternal, "Invalid matrix depth" );
-                  break;
-              }
-              // we do not store pre-computed C1[b], C2[b]
-              float C1 = (color_coeff * cos(thetaC) / nr_channels) / W.at<float>(y,x);
-              float C2 = (color_coeff * sin(thetaC) / nr_channels) / W.at<float>(y,x);
+              float C1, C2;
+              tables.channel( b, y, x, C1, C2 );
 
-              float diffC1 = C1 - centerC1[b][i]; float diffC2 = C2 - centerC2[b][i];
+              float diffC1 = C1 / w - centerC1[b][i];
+              float diffC2 = C2 / w - centerC2[b][i];
 
               D += (diffC1 * diffC1) + (diffC2 * diffC2);
             }
 
             // assign label if within D
-            if ( D < dist->at<float>(y,x) )
+            if ( D < distrow[x] )
             {
-              dist->at<float>(y,x) = (float)D;
-              klabels->at<int>(y,x) = i;
+              distrow[x] = (float)D;
+              labelsrow[x] = i;
             }
           }
         }
-
       }
     }
 
-    Mat W;
-    float PI2;
+    Mat& klabels;
+    Mat& dist;
+    const Mat& W;
+    const FeatureSpaceTables& tables;
+    const vector<float>& kseedsx;
+    const vector<float>& kseedsy;
+    const vector<float>& centerX1;
+    const vector<float>& centerX2;
+    const vector<float>& centerY1;
+    const vector<float>& centerY2;
+    const vector< vector<float> >& centerC1;
+    const vector< vector<float> >& centerC2;
     int nr_channels;
     int stepx, stepy;
     int width, height;
-
-    float chvec_max;
-    float dist_coeff;
-    float color_coeff;
-
-    Mat* dist;
-    Mat* klabels;
-    vector<Mat> chvec;
-    vector<float> kseedsx, kseedsy;
-    vector<float> centerX1, centerX2;
-    vector<float> centerY1, centerY2;
-    vector< vector<float> > centerC1;
-    vector< vector<float> > centerC2;
 };
 
-struct FeatureCenterDists
+/*
+ *    FeatureCenterDists
+ *
+ *    accumulates the centers of each stripe of
+ *    rows in its own row of the accumulators,
+ *    summed afterwards by FeatureNormals
+ *
+ */
+struct FeatureCenterDists : ParallelLoopBody
 {
-    FeatureCenterDists( const vector< Mat >& _chvec, const Mat& _W, const Mat& _klabels,
-                        const int _nr_channels, const float _chvec_max, const float _dist_coeff,
-                        const float _color_coeff, const int _stepx, const int _stepy, const int _numlabels )
+    // per label layout of the accumulators
+    enum { WSUM = 0, SEEDX, SEEDY, X1, X2, Y1, Y2, C0 };
+
+    FeatureCenterDists( Mat& _sums, Mat& _counts, const Mat& _klabels, const Mat& _W,
+                        const FeatureSpaceTables& _tables, const int _nr_channels,
+                        const int _nstripes )
+      : sums(_sums), counts(_counts), klabels(_klabels), W(_W), tables(_tables),
+        nr_channels(_nr_channels), nstripes(_nstripes)
     {
-      W = _W;
-      chvec = _chvec;
-      stepx = _stepx;
-      stepy = _stepy;
-      klabels = _klabels;
-      numlabels = _numlabels;
-      chvec_max = _chvec_max;
-      dist_coeff = _dist_coeff;
-      nr_channels = _nr_channels;
-      color_coeff = _color_coeff;
-
-      PI2 = float(CV_PI / 2.0f);
-
-      Wsum.resize(numlabels);
-      kseedsx.resize(numlabels);
-      kseedsy.resize(numlabels);
-      centerX1.resize(numlabels);
-      centerX2.resize(numlabels);
-      centerY1.resize(numlabels);
-      centerY2.resize(numlabels);
-      centerC1.resize(nr_channels);
-      centerC2.resize(nr_channels);
-      clusterSize.resize(numlabels);
-      for( int b = 0; b < nr_channels; b++ )
-      {
-        centerC1[b].resize(numlabels);
-        centerC2[b].resize(numlabels);
-      }
-      // refill with zero all arrays
-      fill(centerX1.begin(), centerX1.end(), 0.0f);
-      fill(centerX2.begin(), centerX2.end(), 0.0f);
-      fill(centerY1.begin(), centerY1.end(), 0.0f);
-      fill(centerY2.begin(), centerY2.end(), 0.0f);
-      for( int b = 0; b < nr_channels; b++ )
-      {
-        fill(centerC1[b].begin(), centerC1[b].end(), 0.0f);
-        fill(centerC2[b].begin(), centerC2[b].end(), 0.0f);
-      }
-      fill(Wsum.begin(), Wsum.end(), 0.0f);
-      fill(kseedsx.begin(), kseedsx.end(), 0.0f);
-      fill(kseedsy.begin(), kseedsy.end(), 0.0f);
-      fill(clusterSize.begin(), clusterSize.end(), 0);
+      nfeatures = C0 + 2 * nr_channels;
     }
 
-    FeatureCenterDists( const FeatureCenterDists& counter, Split )
+    void operator()( const Range& range ) const
     {
-      *this = counter;
-      // refill with zero all arrays
-      fill(centerX1.begin(), centerX1.end(), 0.0f);
-      fill(centerX2.begin(), centerX2.end(), 0.0f);
-      fill(centerY1.begin(), centerY1.end(), 0.0f);
-      fill(centerY2.begin(), centerY2.end(), 0.0f);
-      for( int b = 0; b < nr_channels; b++ )
+      for( int s = range.start; s < range.end; s++ )
       {
-        fill(centerC1[b].begin(), centerC1[b].end(), 0.0f);
-        fill(centerC2[b].begin(), centerC2[b].end(), 0.0f);
-      }
-      fill(Wsum.begin(), Wsum.end(), 0.0f);
-      fill(kseedsx.begin(), kseedsx.end(), 0.0f);
-      fill(kseedsy.begin(), kseedsy.end(), 0.0f);
-      fill(clusterSize.begin(), clusterSize.end(), 0);
-
-    }
-
-    void operator()( const BlockedRange& range )
-    {
-      // previous block state
-      vector<float> tmp_Wsum = Wsum;
-      vector<float> tmp_kseedsx = kseedsx;
-      vector<float> tmp_kseedsy = kseedsy;
-      vector<float> tmp_centerX1 = centerX1;
-      vector<float> tmp_centerX2 = centerX2;
-      vector<float> tmp_centerY1 = centerY1;
-      vector<float> tmp_centerY2 = centerY2;
-      vector< vector<float> > tmp_centerC1 = centerC1;
-      vector< vector<float> > tmp_centerC2 = centerC2;
-      vector<int> tmp_clusterSize = clusterSize;
-
-      for ( int x = range.begin(); x != range.end(); x++ )
-      {
-
-        float thetaX = ( (float) x / (float) stepx ) * PI2;
-
-        // we do not store pre-computed x1, x2
-        float x1 = (dist_coeff * cos(thetaX));
-        float x2 = (dist_coeff * sin(thetaX));
-
-        for( int y = 0; y < chvec[0].rows; y++ )
+        float* acc = sums.ptr<float>(s);
+        int* clusterSize = counts.ptr<int>(s);
+        memset( acc, 0, sums.cols * sizeof(float) );
+        memset( clusterSize, 0, counts.cols * sizeof(int) );
+
+        int y0 = s * W.rows / nstripes;
+        int y1 = (s + 1) * W.rows / nstripes;
+        for( int y = y0; y < y1; y++ )
         {
-          float thetaY = ( (float) y / (float) stepy ) * PI2;
+          const float* Wrow = W.ptr<float>(y);
+          const int* labelsrow = klabels.ptr<int>(y);
 
-          // we do not store pre-computed y1, y2
-          float y1 = (dist_coeff * cos(thetaY));
-          float y2 = (dist_coeff * sin(thetaY));
-
-          int L = klabels.at<int>(y,x);
+          for( int x = 0; x < W.cols; x++ )
+          {
+            int L = labelsrow[x];
+            float* c = acc + L * nfeatures;
 
-          tmp_centerX1[L] += x1; tmp_centerX2[L] += x2;
-          tmp_centerY1[L] += y1; tmp_centerY2[L] += y2;
+            c[X1] += tables.x1[x]; c[X2] += tables.x2[x];
+            c[Y1] += tables.y1[y]; c[Y2] += tables.y2[y];
 
-          // compute distance given channels terms
-          for( int b = 0; b < nr_channels; b++ )
-          {
-            float thetaC = 0.0f;
-            switch ( chvec[b].depth() )
+            for( int b = 0; b < nr_channels; b++ )
             {
-              case CV_8U:
-                thetaC = ( (float) chvec[b].at<uchar>(y,x)  / chvec_max ) * PI2;
-                break;
-              case CV_8S:
-                thetaC = ( (float) chvec[b].at<char>(y,x)   / chvec_max ) * PI2;
-                break;
-              case CV_16U:
-                thetaC = ( (float) chvec[b].at<ushort>(y,x) / chvec_max ) * PI2;
-                break;
-              case CV_16S:
-                thetaC = ( (float) chvec[b].at<short>(y,x)  / chvec_max ) * PI2;
-                break;
-              case CV_32S:
-                thetaC = ( (float) chvec[b].at<int>(y,x)    / chvec_max ) * PI2;
-                break;
-              case CV_32F:
-                thetaC = ( (float) chvec[b].at<float>(y,x)  / chvec_max ) * PI2;
-                break;
-              case CV_64F:
-                thetaC = ( (float) chvec[b].at<double>(y,x) / chvec_max ) * PI2;
-                break;
-              default:
-                CV_Error( Error::StsInternal, "Invalid matrix depth" );
-                break;
+              float C1, C2;
+              tables.channel( b, y, x, C1, C2 );
+              c[C0 + 2*b] += C1; c[C0 + 2*b + 1] += C2;
             }
-
-            // we do not store pre-computed C1[b], C2[b]
-            float C1 = (color_coeff * cos(thetaC) / nr_channels);
-            float C2 = (color_coeff * sin(thetaC) / nr_channels);
-
-            tmp_centerC1[b][L] += C1; tmp_centerC2[b][L] += C2;
-
+            clusterSize[L]++;
+            c[WSUM] += Wrow[x];
+            c[SEEDX] += x; c[SEEDY] += y;
           }
-          tmp_clusterSize[L]++;
-          tmp_Wsum[L] += W.at<float>(y,x);
-          tmp_kseedsx[L] += x; tmp_kseedsy[L] += y;
         }
       }
-
-      Wsum = tmp_Wsum;
-      kseedsx = tmp_kseedsx;
-      kseedsy = tmp_kseedsy;
-      clusterSize = tmp_clusterSize;
-      centerX1 = tmp_centerX1; centerX2 = tmp_centerX2;
-      centerY1 = tmp_centerY1; centerY2 = tmp_centerY2;
-      centerC1 = tmp_centerC1; centerC2 = tmp_centerC2;
     }
 
-    void join( FeatureCenterDists& fcd )
-    {
-      for (int l = 0; l < numlabels; l++)
-      {
-        Wsum[l] += fcd.Wsum[l];
-        kseedsx[l] += fcd.kseedsx[l];
-        kseedsy[l] += fcd.kseedsy[l];
-        centerX1[l] += fcd.centerX1[l];
-        centerX2[l] += fcd.centerX2[l];
-        centerY1[l] += fcd.centerY1[l];
-        centerY2[l] += fcd.centerY2[l];
-        clusterSize[l] += fcd.clusterSize[l];
-        for( int b = 0; b < nr_channels; b++ )
-        {
-            centerC1[b][l] += fcd.centerC1[b][l];
-            centerC2[b][l] += fcd.centerC2[b][l];
-        }
-      }
-    }
-
-    Mat W;
-    float PI2;
-    int numlabels;
+    Mat& sums;
+    Mat& counts;
+    const Mat& klabels;
+    const Mat& W;
+    const FeatureSpaceTables& tables;
     int nr_channels;
-    int stepx, stepy;
-
-    float chvec_max;
-    float dist_coeff;
-    float color_coeff;
-
-    Mat klabels;
-    vector<Mat> chvec;
-
-    vector<float> Wsum;
-    vector<int> clusterSize;
-    vector<float> kseedsx, kseedsy;
-    vector<float> centerX1, centerX2;
-    vector<float> centerY1, centerY2;
-    vector< vector<float> > centerC1, centerC2;
-
+    int nstripes;
+    int nfeatures;
 };
 
+/*
+ *    FeatureNormals
+ *
+ *    sums the accumulators of the stripes in
+ *    a fixed order and normalizes the centers
+ *
+ */
 struct FeatureNormals : ParallelLoopBody
 {
-    FeatureNormals( const vector<float>& _Wsum, const vector<int>& _clusterSize,
+    FeatureNormals( const Mat& _sums, const Mat& _counts,
                     vector<float>* _kseedsx, vector<float>* _kseedsy,
                     vector<float>* _centerX1, vector<float>* _centerX2,
                     vector<float>* _centerY1, vector<float>* _centerY2,
                     vector< vector<float> >* _centerC1, vector< vector<float> >* _centerC2,
-                    const int _numlabels, const int _nr_channels )
+                    const int _nr_channels )
+      : sums(_sums), counts(_counts), nr_channels(_nr_channels)
     {
-      Wsum = _Wsum;
-      numlabels = _numlabels;
-      clusterSize = _clusterSize;
-      nr_channels = _nr_channels;
+      nfeatures = FeatureCenterDists::C0 + 2 * nr_channels;
 
       kseedsx = _kseedsx; kseedsy = _kseedsy;
       centerX1 = _centerX1; centerX2 = _centerX2;
@@ -1695,29 +1632,50 @@ struct FeatureNormals : ParallelLoopBody
 
     void operator()( const Range& range ) const
     {
+      AutoBuffer<float> _c( nfeatures );
+      float* c = _c;
+
       for( int i = range.start; i < range.end; i++ )
       {
-        if ( Wsum[i] != 0 )
+        int clusterSize = 0;
+        for( int k = 0; k < nfeatures; k++ )
+          c[k] = 0.0f;
+        for( int s = 0; s < sums.rows; s++ )
         {
-          centerX1->at(i) /= Wsum[i]; centerX2->at(i) /= Wsum[i];
-          centerY1->at(i) /= Wsum[i]; centerY2->at(i) /= Wsum[i];
-          for( int b = 0; b < nr_channels; b++ )
-          {
-            centerC1->at(b)[i] /= Wsum[i]; centerC2->at(b)[i] /= Wsum[i];
-          }
+          const float* acc = sums.ptr<float>(s) + i * nfeatures;
+          for( int k = 0; k < nfeatures; k++ )
+            c[k] += acc[k];
+          clusterSize += counts.ptr<int>(s)[i];
+        }
+
+        float Wsum = c[FeatureCenterDists::WSUM];
+        if ( Wsum != 0 )
+        {
+          for( int k = FeatureCenterDists::X1; k < nfeatures; k++ )
+            c[k] /= Wsum;
+        }
+        centerX1->at(i) = c[FeatureCenterDists::X1]; centerX2->at(i) = c[FeatureCenterDists::X2];
+        centerY1->at(i) = c[FeatureCenterDists::Y1]; centerY2->at(i) = c[FeatureCenterDists::Y2];
+        for( int b = 0; b < nr_channels; b++ )
+        {
+          centerC1->at(b)[i] = c[FeatureCenterDists::C0 + 2*b];
+          centerC2->at(b)[i] = c[FeatureCenterDists::C0 + 2*b + 1];
         }
-        if ( clusterSize[i] != 0 )
+
+        kseedsx->at(i) = c[FeatureCenterDists::SEEDX];
+        kseedsy->at(i) = c[FeatureCenterDists::SEEDY];
+        if ( clusterSize != 0 )
         {
-          kseedsx->at(i) /= clusterSize[i];
-          kseedsy->at(i) /= clusterSize[i];
+          kseedsx->at(i) /= clusterSize;
+          kseedsy->at(i) /= clusterSize;
         }
       }
     }
 
-    int numlabels;
-    vector<float> Wsum;
-    vector<int> clusterSize;
+    const Mat& sums;
+    const Mat& counts;
     int nr_channels;
+    int nfeatures;
 
     vector<float> *kseedsx, *kseedsy;
     vector<float> *centerX1, *centerX2;
@@ -1736,7 +1694,7 @@ struct FeatureNormals : ParallelLoopBody
  */
 inline void SuperpixelLSCImpl::PerformLSC( const int&  itrnum )
 {
-    // allocate initial workspaces
+    // allocate workspaces, reused by all the iterations
     cv::Mat dist( m_height, m_width, CV_32F );
 
     vector<float> centerX1( m_numlabels );
@@ -1750,8 +1708,15 @@ inline void SuperpixelLSCImpl::PerformLSC( const int&  itrnum )
       centerC1[b].resize( m_numlabels );
       centerC2[b].resize( m_numlabels );
     }
-    vector<float> Wsum( m_numlabels );
-    vector<int> clusterSize( m_numlabels );
+
+    // stripes of the center accumulation, their number doesn't
+    // depend on the threads so that the sums are deterministic
+    const int nstripes = std::max( 1, std::min( 16, m_height / 32 ) );
+    Mat sums( nstripes, m_numlabels * (FeatureCenterDists::C0 + 2 * m_nr_channels), CV_32F );
+    Mat counts( nstripes, m_numlabels, CV_32S );
+
+    FeatureSpaceTables tables( m_chvec, m_nr_channels, m_chvec_max,
+                               m_dist_coeff, m_color_coeff, m_stepx, m_stepy );
 
     // compute weighted distance centers
     parallel_for_( Range(0, m_numlabels), FeatureSpaceCenters(
@@ -1767,32 +1732,20 @@ inline void SuperpixelLSCImpl::PerformLSC( const int&  itrnum )
       dist.setTo( FLT_MAX );
 
       // k-mean
-      parallel_for_( Range(0, m_numlabels), FeatureSpaceKmeans(
-                     &m_klabels, &dist, m_chvec, m_W, m_kseedsx, m_kseedsy,
+      parallel_for_( Range(0, m_height), FeatureSpaceKmeans(
+                     m_klabels, dist, m_W, tables, m_kseedsx, m_kseedsy,
                      centerX1, centerX2, centerY1, centerY2, centerC1, centerC2,
-                     m_nr_channels, m_chvec_max, m_dist_coeff, m_color_coeff,
-                     m_stepx, m_stepy ) );
-
-      // parallel reduce structure
-      FeatureCenterDists fcd( m_chvec, m_W, m_klabels, m_nr_channels, m_chvec_max,
-                              m_dist_coeff, m_color_coeff, m_stepx, m_stepy, m_numlabels );
+                     m_nr_channels, m_stepx, m_stepy ), m_height / m_stepy + 1 );
 
       // accumulate center distances
-      parallel_reduce( BlockedRange(0, m_width), fcd );
-
-      // featch out the results
-      Wsum = fcd.Wsum; clusterSize = fcd.clusterSize;
-      m_kseedsx = fcd.kseedsx; m_kseedsy = fcd.kseedsy;
-      centerX1 = fcd.centerX1; centerX2 = fcd.centerX2;
-      centerY1 = fcd.centerY1; centerY2 = fcd.centerY2;
-      centerC1 = fcd.centerC1; centerC2 = fcd.centerC2;
-
+      parallel_for_( Range(0, nstripes), FeatureCenterDists(
+                     sums, counts, m_klabels, m_W, tables, m_nr_channels, nstripes ) );
 
-      // normalize accumulated distances
+      // reduce and normalize accumulated distances
       parallel_for_( Range(0, m_numlabels), FeatureNormals(
-                     Wsum, clusterSize, &m_kseedsx, &m_kseedsy,
+                     sums, counts, &m_kseedsx, &m_kseedsy,
                      &centerX1, &centerX2, &centerY1, &centerY2,
-                     &centerC1, &centerC2, m_numlabels, m_nr_channels ) );
+                     &centerC1, &centerC2, m_nr_channels ) );
     }
 }
 
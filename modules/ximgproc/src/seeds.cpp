@@ -40,6 +40,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 /******************************************************************************\
 *                            SEEDS Superpixels                                *
@@ -52,6 +53,7 @@
 #include <algorithm>
 #include <vector>
 #include <cstdlib>
+#include <climits>
 using namespace std;
 
 
@@ -109,6 +111,8 @@ private:
     inline void updateLabels();
     // main loop for pixel updating
     void updatePixels();
+    void updatePixelsHorizontal(int y_begin, int y_end);
+    void updatePixelsVertical(int y_begin, int y_end);
 
 
     /* block operations */
@@ -122,6 +126,24 @@ private:
 
     //main loop for block updates
     void updateBlocks(int level, float req_confidence = 0.0f);
+    void updateBlocksHorizontal(int level, float req_confidence, int y_begin, int y_end);
+    void updateBlocksVertical(int level, float req_confidence, int y_begin, int y_end);
+
+    /* parallel processing */
+    enum { PIXELS_HORIZONTAL, PIXELS_VERTICAL, BLOCKS_HORIZONTAL, BLOCKS_VERTICAL };
+    // runs an update pass on bands of band_height rows: the even bands in parallel, then the odd ones
+    void runBands(int pass, int level, float req_confidence, int rows, int band_height);
+    void runBand(int pass, int level, float req_confidence, int y_begin, int y_end);
+    // true if a superpixel spans 3 bands, so that 2 bands processed at the same time could update it
+    bool bandsOverlap(int band_height) const;
+    // rows covered by each superpixel on the pixel grid (level == -1) or on a block level
+    void computeLabelRows(int level);
+    inline void extendLabelRows(int label, int row);
+    // row ranges for parallel_for_
+    void computeHistogramsLevel0(int row_begin, int row_end);
+    void updateLabelsRows(int y_begin, int y_end);
+    friend class SeedsRowsInvoker;
+    friend class SeedsBandInvoker;
 
     /* go to next block level */
     int goDownOneLevel();
@@ -172,6 +194,11 @@ private:
     vector<HISTN*> histogram; //[level][label * histogram_size_aligned + j]
     vector<HISTN*> T; //[level][label] how many pixels with this label
 
+    // [label] first and last row of each superpixel, on the grid being updated. These are only
+    // extended during an update pass, so that they are a conservative bound of the superpixel
+    vector<int> label_min_row;
+    vector<int> label_max_row;
+
     /* OpenCV containers for our memory arrays. This makes sure memory is
      * allocated & released properly */
     Mat labels_mat;
@@ -184,6 +211,93 @@ private:
     vector<Mat> parent_pre_init_mat;
 };
 
+class SeedsRowsInvoker : public ParallelLoopBody
+{
+public:
+    typedef void (SuperpixelSEEDSImpl::*RowsFunction)(int row_begin, int row_end);
+
+    SeedsRowsInvoker(SuperpixelSEEDSImpl& seeds_, RowsFunction function_)
+        : seeds(seeds_), function(function_) {}
+
+    void operator()(const Range& range) const
+    {
+        (seeds.*function)(range.start, range.end);
+    }
+
+private:
+    SuperpixelSEEDSImpl& seeds;
+    RowsFunction function;
+};
+
+class SeedsBandInvoker : public ParallelLoopBody
+{
+public:
+    SeedsBandInvoker(SuperpixelSEEDSImpl& seeds_, int pass_, int level_, float req_confidence_,
+            int rows_, int band_height_, int parity_)
+        : seeds(seeds_), pass(pass_), level(level_), req_confidence(req_confidence_),
+          rows(rows_), band_height(band_height_), parity(parity_) {}
+
+    void operator()(const Range& range) const
+    {
+        for (int i = range.start; i < range.end; i++)
+        {
+            int y_begin = (2 * i + parity) * band_height;
+            int y_end = std::min(y_begin + band_height, rows);
+            seeds.runBand(pass, level, req_confidence, y_begin, y_end);
+        }
+    }
+
+private:
+    SuperpixelSEEDSImpl& seeds;
+    int pass, level;
+    float req_confidence;
+    int rows, band_height, parity;
+};
+
+template<typename _Tp>
+static inline int imageBin(_Tp value, int nr_bins, int max_value)
+{
+    return (int) value * nr_bins / max_value;
+}
+
+/* for float: max_value is assumed to be 1.0f */
+static inline int imageBin(float value, int nr_bins, int)
+{
+    return std::min((int)(value * (float)nr_bins), nr_bins-1);
+}
+
+template<typename _Tp>
+class SeedsImageBinsInvoker : public ParallelLoopBody
+{
+public:
+    SeedsImageBinsInvoker(const Mat& img_, unsigned int* image_bins_, int nr_bins_, int max_value_)
+        : img(img_), image_bins(image_bins_), nr_bins(nr_bins_), max_value(max_value_) {}
+
+    void operator()(const Range& range) const
+    {
+        int img_width = img.size().width;
+        int channels = img.channels();
+
+        for (int y = range.start; y < range.end; ++y)
+        {
+            const _Tp* ptr = img.ptr<_Tp>(y);
+            unsigned int* bins = image_bins + y * img_width;
+            for (int x = 0; x < img_width; ++x, ptr += channels)
+            {
+                int bin = 0;
+                for (int i = 0; i < channels; ++i)
+                    bin = bin * nr_bins + imageBin(ptr[i], nr_bins, max_value);
+                bins[x] = bin;
+            }
+        }
+    }
+
+private:
+    const Mat& img;
+    unsigned int* image_bins;
+    int nr_bins, max_value;
+};
+
 CV_EXPORTS Ptr<SuperpixelSEEDS> createSuperpixelSEEDS(int image_width, int image_height,
         int image_channels, int num_superpixels, int num_levels, int prior, int histogram_bins,
         bool double_step)
@@ -335,42 +449,8 @@ void SuperpixelSEEDSImpl::initialize(int num_superpixels, int num_levels)
 template<typename _Tp>
 void SuperpixelSEEDSImpl::initImageBins(const Mat& img, int max_value)
 {
-    int img_width = img.size().width;
-    int img_height = img.size().height;
-    int channels = img.channels();
-
-    for (int y = 0; y < img_height; ++y)
-    {
-        for (int x = 0; x < img_width; ++x)
-        {
-            const _Tp* ptr = img.ptr<_Tp>(y, x);
-            int bin = 0;
-            for (int i = 0; i < channels; ++i)
-                bin = bin * nr_bins + (int) ptr[i] * nr_bins / max_value;
-            image_bins[y * img_width + x] = bin;
-        }
-    }
-}
-
-/* specialization for float: max_value is assumed to be 1.0f */
-template<>
-void SuperpixelSEEDSImpl::initImageBins<float>(const Mat& img, int)
-{
-    int img_width = img.size().width;
-    int img_height = img.size().height;
-    int channels = img.channels();
-
-    for (int y = 0; y < img_height; ++y)
-    {
-        for (int x = 0; x < img_width; ++x)
-        {
-            const float* ptr = img.ptr<float>(y, x);
-            int bin = 0;
-            for(int i=0; i<channels; ++i)
-                bin = bin * nr_bins + std::min((int)(ptr[i] * (float)nr_bins), nr_bins-1);
-            image_bins[y*img_width + x] = bin;
-        }
-    }
+    parallel_for_(Range(0, img.rows),
+            SeedsImageBinsInvoker<_Tp>(img, image_bins, nr_bins, max_value));
 }
 
 void SuperpixelSEEDSImpl::initImage(InputArray img)
@@ -457,9 +537,10 @@ void SuperpixelSEEDSImpl::computeHistograms(int until_level)
         memset(T[level], 0, sizeof(HISTN) * nr_labels);
     }
 
-    // build histograms on the first level by adding the pixels to the blocks
-    for (int i = 0; i < width * height; ++i)
-        addPixel(0, labels_bottom[i], i);
+    // build histograms on the first level by adding the pixels to the blocks,
+    // each row of blocks is built independently
+    parallel_for_(Range(0, nr_wh[1]),
+            SeedsRowsInvoker(*this, &SuperpixelSEEDSImpl::computeHistogramsLevel0));
 
     // build histograms on the upper levels by adding the histogram from the level below
     for (int level = 1; level < until_level; level++)
@@ -471,7 +552,104 @@ void SuperpixelSEEDSImpl::computeHistograms(int until_level)
     }
 }
 
+void SuperpixelSEEDSImpl::computeHistogramsLevel0(int row_begin, int row_end)
+{
+    // pixel rows of the rows of blocks, see computeLabel()
+    int block_height = height / nr_wh[1];
+    int y_begin = row_begin * block_height;
+    int y_end = row_end == nr_wh[1] ? height : row_end * block_height;
+
+    for (int i = y_begin * width; i < y_end * width; ++i)
+        addPixel(0, labels_bottom[i], i);
+}
+
+void SuperpixelSEEDSImpl::computeLabelRows(int level)
+{
+    int nr_labels = nrLabels(seeds_top_level);
+    label_min_row.assign(nr_labels, INT_MAX);
+    label_max_row.assign(nr_labels, -1);
+
+    const int* grid = level < 0 ? labels : parent[level];
+    int rows = level < 0 ? height : nr_wh[2 * level + 1];
+    int cols = level < 0 ? width : nr_wh[2 * level];
+    for (int y = 0; y < rows; y++)
+    {
+        for (int x = 0; x < cols; x++)
+            extendLabelRows(grid[y * cols + x], y);
+    }
+}
+
+void SuperpixelSEEDSImpl::extendLabelRows(int label, int row)
+{
+    label_min_row[label] = std::min(label_min_row[label], row);
+    label_max_row[label] = std::max(label_max_row[label], row);
+}
+
+bool SuperpixelSEEDSImpl::bandsOverlap(int band_height) const
+{
+    // a band reads the labels up to 2 rows around it. Two bands processed at the same time are
+    // separated by a whole band, they can only access the same superpixel if it spans 3 bands.
+    int nr_labels = nrLabels(seeds_top_level);
+    for (int label = 0; label < nr_labels; label++)
+    {
+        if( label_min_row[label] > label_max_row[label] )
+            continue;
+        int first = std::max(label_min_row[label] - 2, 0) / band_height;
+        int last = (label_max_row[label] + 2) / band_height;
+        if( last - first >= 2 )
+            return true;
+    }
+    return false;
+}
+
+void SuperpixelSEEDSImpl::runBand(int pass, int level, float req_confidence, int y_begin, int y_end)
+{
+    switch (pass)
+    {
+    case PIXELS_HORIZONTAL:
+        updatePixelsHorizontal(y_begin, y_end);
+        break;
+    case PIXELS_VERTICAL:
+        updatePixelsVertical(y_begin, y_end);
+        break;
+    case BLOCKS_HORIZONTAL:
+        updateBlocksHorizontal(level, req_confidence, y_begin, y_end);
+        break;
+    case BLOCKS_VERTICAL:
+        updateBlocksVertical(level, req_confidence, y_begin, y_end);
+        break;
+    }
+}
+
+void SuperpixelSEEDSImpl::runBands(int pass, int level, float req_confidence, int rows, int band_height)
+{
+    int nr_bands = (rows + band_height - 1) / band_height;
+
+    // The bands are always processed in the same order (even bands, then odd bands), whether
+    // they run in parallel or not, so that the result doesn't depend on the number of threads.
+    for (int parity = 0; parity < 2; parity++)
+    {
+        int nr_tasks = (nr_bands - parity + 1) / 2;
+        SeedsBandInvoker invoker(*this, pass, level, req_confidence, rows, band_height, parity);
+        if( nr_tasks > 1 && !bandsOverlap(band_height) )
+            parallel_for_(Range(0, nr_tasks), invoker, nr_tasks);
+        else
+            invoker(Range(0, nr_tasks));
+    }
+}
+
 void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
+{
+    // bands twice as high as the superpixels, so that they rarely span 3 bands
+    int rows = nr_wh[2 * level + 1];
+    int band_height = 2 * (rows / nr_wh[2 * seeds_top_level + 1]) + 4;
+
+    computeLabelRows(level);
+    runBands(BLOCKS_HORIZONTAL, level, req_confidence, rows, band_height);
+    runBands(BLOCKS_VERTICAL, level, req_confidence, rows, band_height);
+}
+
+void SuperpixelSEEDSImpl::updateBlocksHorizontal(int level, float req_confidence, int y_begin, int y_end)
 {
     int labelA;
     int labelB;
@@ -480,7 +658,7 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
     int step = nr_wh[2 * level];
 
     // horizontal bidirectional block updating
-    for (int y = 1; y < nr_wh[2 * level + 1] - 1; y++)
+    for (int y = std::max(y_begin, 1); y < std::min(y_end, nr_wh[2 * level + 1] - 1); y++)
     {
         for (int x = 1; x < nr_wh[2 * level] - 2; x++)
         {
@@ -541,11 +719,20 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
             }
         }
     }
+}
+
+void SuperpixelSEEDSImpl::updateBlocksVertical(int level, float req_confidence, int y_begin, int y_end)
+{
+    int labelA;
+    int labelB;
+    int sublabel;
+    bool done;
+    int step = nr_wh[2 * level];
 
     // vertical bidirectional
     for (int x = 1; x < nr_wh[2 * level] - 1; x++)
     {
-        for (int y = 1; y < nr_wh[2 * level + 1] - 2; y++)
+        for (int y = std::max(y_begin, 1); y < std::min(y_end, nr_wh[2 * level + 1] - 2); y++)
         {
             // choose a label at the current level
             sublabel = y * step + x;
@@ -636,13 +823,51 @@ int SuperpixelSEEDSImpl::goDownOneLevel()
 }
 
 void SuperpixelSEEDSImpl::updatePixels()
+{
+    // bands twice as high as the superpixels, so that they rarely span 3 bands
+    int band_height = 2 * (height / nr_wh[2 * seeds_top_level + 1]) + 4;
+
+    computeLabelRows(-1);
+    runBands(PIXELS_HORIZONTAL, 0, 0.0f, height, band_height);
+    runBands(PIXELS_VERTICAL, 0, 0.0f, height, band_height);
+    forwardbackward = !forwardbackward;
+
+    int labelA;
+    int labelB;
+
+    // update border pixels
+    for (int x = 0; x < width; x++)
+    {
+        labelA = labels[x];
+        labelB = labels[width + x];
+        if( labelA != labelB )
+            update(labelB, x, labelA);
+        labelA = labels[(height - 1) * width + x];
+        labelB = labels[(height - 2) * width + x];
+        if( labelA != labelB )
+            update(labelB, (height - 1) * width + x, labelA);
+    }
+    for (int y = 0; y < height; y++)
+    {
+        labelA = labels[y * width];
+        labelB = labels[y * width + 1];
+        if( labelA != labelB )
+            update(labelB, y * width, labelA);
+        labelA = labels[y * width + width - 1];
+        labelB = labels[y * width + width - 2];
+        if( labelA != labelB )
+            update(labelB, y * width + width - 1, labelA);
+    }
+}
+
+void SuperpixelSEEDSImpl::updatePixelsHorizontal(int y_begin, int y_end)
 {
     int labelA;
     int labelB;
     int priorA = 0;
     int priorB = 0;
 
-    for (int y = 1; y < height - 1; y++)
+    for (int y = std::max(y_begin, 1); y < std::min(y_end, height - 1); y++)
     {
         for (int x = 1; x < width - 2; x++)
         {
@@ -733,10 +958,18 @@ void SuperpixelSEEDSImpl::updatePixels()
             } // labelA != labelB
         } // for x
     } // for y
+}
+
+void SuperpixelSEEDSImpl::updatePixelsVertical(int y_begin, int y_end)
+{
+    int labelA;
+    int labelB;
+    int priorA = 0;
+    int priorB = 0;
 
     for (int x = 1; x < width - 1; x++)
     {
-        for (int y = 1; y < height - 2; y++)
+        for (int y = std::max(y_begin, 1); y < std::min(y_end, height - 2); y++)
         {
 
             labelA = labels[(y) * width + (x)];
@@ -825,31 +1058,6 @@ void SuperpixelSEEDSImpl::updatePixels()
             } // labelA != labelB
         } // for y
     } // for x
-    forwardbackward = !forwardbackward;
-
-    // update border pixels
-    for (int x = 0; x < width; x++)
-    {
-        labelA = labels[x];
-        labelB = labels[width + x];
-        if( labelA != labelB )
-            update(labelB, x, labelA);
-        labelA = labels[(height - 1) * width + x];
-        labelB = labels[(height - 2) * width + x];
-        if( labelA != labelB )
-            update(labelB, (height - 1) * width + x, labelA);
-    }
-    for (int y = 0; y < height; y++)
-    {
-        labelA = labels[y * width];
-        labelB = labels[y * width + 1];
-        if( labelA != labelB )
-            update(labelB, y * width, labelA);
-        labelA = labels[y * width + width - 1];
-        labelB = labels[y * width + width - 2];
-        if( labelA != labelB )
-            update(labelB, y * width + width - 1, labelA);
-    }
 }
 
 void SuperpixelSEEDSImpl::update(int label_new, int image_idx, int label_old)
@@ -858,6 +1066,7 @@ void SuperpixelSEEDSImpl::update(int label_new, int image_idx, int label_old)
     deletePixel(seeds_top_level, label_old, image_idx);
     addPixel(seeds_top_level, label_new, image_idx);
     labels[image_idx] = label_new;
+    extendLabelRows(label_new, image_idx / width);
 }
 
 void SuperpixelSEEDSImpl::addPixel(int level, int label, int image_idx)
@@ -882,15 +1091,12 @@ void SuperpixelSEEDSImpl::addBlock(int level, int label, int sublevel,
 
     //add the (sublevel, sublabel) block to the block (level, label)
     int n = 0;
-#if CV_SSSE3
+#if CV_SIMD128
     const int loop_end = histogram_size - 3;
     for (; n < loop_end; n += 4)
     {
         //this does exactly the same as the loop peeling below, but 4 elements at a time
-        __m128 h_labelp = _mm_load_ps(h_label + n);
-        __m128 h_sublabelp = _mm_load_ps(h_sublabel + n);
-        h_labelp = _mm_add_ps(h_labelp, h_sublabelp);
-        _mm_store_ps(h_label + n, h_labelp);
+        v_store_aligned(h_label + n, v_load_aligned(h_label + n) + v_load_aligned(h_sublabel + n));
     }
 #endif
 
@@ -905,6 +1111,7 @@ void SuperpixelSEEDSImpl::addBlockToplevel(int label, int sublevel, int sublabel
 {
     addBlock(seeds_top_level, label, sublevel, sublabel);
     nr_partitions[label]++;
+    extendLabelRows(label, sublabel / nr_wh[2 * sublevel]);
 }
 
 void SuperpixelSEEDSImpl::deleteBlockToplevel(int label, int sublevel, int sublabel)
@@ -914,15 +1121,12 @@ void SuperpixelSEEDSImpl::deleteBlockToplevel(int label, int sublevel, int subla
 
     //do the reverse operation of add_block_toplevel
     int n = 0;
-#if CV_SSSE3
+#if CV_SIMD128
     const int loop_end = histogram_size - 3;
     for (; n < loop_end; n += 4)
     {
         //this does exactly the same as the loop peeling below, but 4 elements at a time
-        __m128 h_labelp = _mm_load_ps(h_label + n);
-        __m128 h_sublabelp = _mm_load_ps(h_sublabel + n);
-        h_labelp = _mm_sub_ps(h_labelp, h_sublabelp);
-        _mm_store_ps(h_label + n, h_labelp);
+        v_store_aligned(h_label + n, v_load_aligned(h_label + n) - v_load_aligned(h_sublabel + n));
     }
 #endif
 
@@ -937,7 +1141,12 @@ void SuperpixelSEEDSImpl::deleteBlockToplevel(int label, int sublevel, int subla
 
 void SuperpixelSEEDSImpl::updateLabels()
 {
-    for (int i = 0; i < width * height; ++i)
+    parallel_for_(Range(0, height), SeedsRowsInvoker(*this, &SuperpixelSEEDSImpl::updateLabelsRows));
+}
+
+void SuperpixelSEEDSImpl::updateLabelsRows(int y_begin, int y_end)
+{
+    for (int i = y_begin * width; i < y_end * width; ++i)
         labels[i] = parent[0][labels_bottom[i]];
 }
 
@@ -988,28 +1197,18 @@ int SuperpixelSEEDSImpl::threebyfour(int x, int y, int label)
      * x x x x
      */
 
-#if CV_SSSE3
-    __m128i addp = _mm_set1_epi32(1);
-    __m128i addp_middle = _mm_set_epi32(1, 0, 0, 1);
-    __m128i labelp = _mm_set1_epi32(label);
+#if CV_SIMD128
+    v_int32x4 addp = v_setall_s32(1);
+    v_int32x4 addp_middle = v_int32x4(1, 0, 0, 1);
+    v_int32x4 labelp = v_setall_s32(label);
     /* 1. row */
-    __m128i data1 = _mm_loadu_si128((__m128i*) (labels + (y-1)*width + x -1));
-    __m128i mask1 = _mm_cmpeq_epi32(data1, labelp);
-    __m128i countp = _mm_and_si128(mask1, addp);
+    v_int32x4 countp = (v_load(labels + (y-1)*width + x - 1) == labelp) & addp;
     /* 2. row */
-    __m128i data2 = _mm_loadu_si128((__m128i*) (labels + y*width + x -1));
-    __m128i mask2 = _mm_cmpeq_epi32(data2, labelp);
-    __m128i count1 = _mm_and_si128(mask2, addp_middle);
-    countp = _mm_add_epi32(countp, count1);
+    countp += (v_load(labels + y*width + x - 1) == labelp) & addp_middle;
     /* 3. row */
-    __m128i data3 = _mm_loadu_si128((__m128i*) (labels + (y+1)*width + x -1));
-    __m128i mask3 = _mm_cmpeq_epi32(data3, labelp);
-    __m128i count3 = _mm_and_si128(mask3, addp);
-    countp = _mm_add_epi32(count3, countp);
-
-    countp = _mm_hadd_epi32(countp, countp);
-    countp = _mm_hadd_epi32(countp, countp);
-    return _mm_cvtsi128_si32(countp);
+    countp += (v_load(labels + (y+1)*width + x - 1) == labelp) & addp;
+
+    return v_reduce_sum(countp);
 #else
     int count = 0;
     count += (labels[(y - 1) * width + x - 1] == label);
@@ -1039,33 +1238,20 @@ int SuperpixelSEEDSImpl::fourbythree(int x, int y, int label)
      * x x x o
      */
 
-#if CV_SSSE3
-    __m128i addp_border = _mm_set_epi32(0, 1, 1, 1);
-    __m128i addp_middle = _mm_set_epi32(1, 0, 0, 1);
-    __m128i labelp = _mm_set1_epi32(label);
+#if CV_SIMD128
+    v_int32x4 addp_border = v_int32x4(1, 1, 1, 0);
+    v_int32x4 addp_middle = v_int32x4(1, 0, 0, 1);
+    v_int32x4 labelp = v_setall_s32(label);
     /* 1. row */
-    __m128i data1 = _mm_loadu_si128((__m128i*) (labels + (y-1)*width + x -1));
-    __m128i mask1 = _mm_cmpeq_epi32(data1, labelp);
-    __m128i countp = _mm_and_si128(mask1, addp_border);
+    v_int32x4 countp = (v_load(labels + (y-1)*width + x - 1) == labelp) & addp_border;
     /* 2. row */
-    __m128i data2 = _mm_loadu_si128((__m128i*) (labels + y*width + x -1));
-    __m128i mask2 = _mm_cmpeq_epi32(data2, labelp);
-    __m128i count1 = _mm_and_si128(mask2, addp_middle);
-    countp = _mm_add_epi32(countp, count1);
+    countp += (v_load(labels + y*width + x - 1) == labelp) & addp_middle;
     /* 3. row */
-    __m128i data3 = _mm_loadu_si128((__m128i*) (labels + (y+1)*width + x -1));
-    __m128i mask3 = _mm_cmpeq_epi32(data3, labelp);
-    __m128i count3 = _mm_and_si128(mask3, addp_middle);
-    countp = _mm_add_epi32(count3, countp);
+    countp += (v_load(labels + (y+1)*width + x - 1) == labelp) & addp_middle;
     /* 4. row */
-    __m128i data4 = _mm_loadu_si128((__m128i*) (labels + (y+2)*width + x -1));
-    __m128i mask4 = _mm_cmpeq_epi32(data4, labelp);
-    __m128i count4 = _mm_and_si128(mask4, addp_border);
-    countp = _mm_add_epi32(countp, count4);
-
-    countp = _mm_hadd_epi32(countp, countp);
-    countp = _mm_hadd_epi32(countp, countp);
-    return _mm_cvtsi128_si32(countp);
+    countp += (v_load(labels + (y+2)*width + x - 1) == labelp) & addp_border;
+
+    return v_reduce_sum(countp);
 #else
     int count = 0;
     count += (labels[(y - 1) * width + x - 1] == label);
@@ -1109,54 +1295,29 @@ float SuperpixelSEEDSImpl::intersectConf(int level1, int label1A, int label1B,
      */
 
     int n = 0;
-#if CV_SSSE3
-    __m128 count1Ap = _mm_set1_ps(count1A);
-    __m128 count2p = _mm_set1_ps(count2);
-    __m128 count1Bp = _mm_set1_ps(count1B);
-    __m128 sumAp = _mm_set1_ps(0.0f);
-    __m128 sumBp = _mm_set1_ps(0.0f);
+#if CV_SIMD128
+    v_float32x4 count1Ap = v_setall_f32(count1A);
+    v_float32x4 count2p = v_setall_f32(count2);
+    v_float32x4 count1Bp = v_setall_f32(count1B);
+    v_float32x4 sumAp = v_setzero_f32();
+    v_float32x4 sumBp = v_setzero_f32();
 
     const int loop_end = histogram_size - 3;
     for(; n < loop_end; n += 4)
     {
         //this does exactly the same as the loop peeling below, but 4 elements at a time
+        v_float32x4 h1Ap = v_load_aligned(h1A + n);
+        v_float32x4 h1Bp = v_load_aligned(h1B + n);
+        v_float32x4 h2p = v_load_aligned(h2 + n);
 
         // normal
-        __m128 h1Ap = _mm_load_ps(h1A + n);
-        __m128 h1Bp = _mm_load_ps(h1B + n);
-        __m128 h2p = _mm_load_ps(h2 + n);
-
-        __m128 h1ApC2 = _mm_mul_ps(h1Ap, count2p);
-        __m128 h2pC1A = _mm_mul_ps(h2p, count1Ap);
-        __m128 maskA = _mm_cmple_ps(h1ApC2, h2pC1A);
-        __m128 sum1AddA = _mm_and_ps(maskA, h1ApC2);
-        __m128 sum2AddA = _mm_andnot_ps(maskA, h2pC1A);
-        sumAp = _mm_add_ps(sumAp, sum1AddA);
-        sumAp = _mm_add_ps(sumAp, sum2AddA);
+        sumAp += v_min(h1Ap * count2p, h2p * count1Ap);
 
         // del
-        __m128 diffp = _mm_sub_ps(h1Bp, h2p);
-        __m128 h1BpC2 = _mm_mul_ps(diffp, count2p);
-        __m128 h2pC1B = _mm_mul_ps(h2p, count1Bp);
-        __m128 maskB = _mm_cmple_ps(h1BpC2, h2pC1B);
-        __m128 sum1AddB = _mm_and_ps(maskB, h1BpC2);
-        __m128 sum2AddB = _mm_andnot_ps(maskB, h2pC1B);
-        sumBp = _mm_add_ps(sumBp, sum1AddB);
-        sumBp = _mm_add_ps(sumBp, sum2AddB);
+        sumBp += v_min((h1Bp - h2p) * count2p, h2p * count1Bp);
     }
-    // merge results (quite expensive)
-    float sum1Asse;
-    sumAp = _mm_hadd_ps(sumAp, sumAp);
-    sumAp = _mm_hadd_ps(sumAp, sumAp);
-    _mm_store_ss(&sum1Asse, sumAp);
-
-    float sum1Bsse;
-    sumBp = _mm_hadd_ps(sumBp, sumBp);
-    sumBp = _mm_hadd_ps(sumBp, sumBp);
-    _mm_store_ss(&sum1Bsse, sumBp);
-
-    sumA += sum1Asse;
-    sumB += sum1Bsse;
+    sumA += v_reduce_sum(sumAp);
+    sumB += v_reduce_sum(sumBp);
 #endif
 
     //loop peeling
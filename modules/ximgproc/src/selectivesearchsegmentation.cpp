@@ -42,6 +42,7 @@ the use of this software, even if advised of the possibility of such damage.
 #include "opencv2/ximgproc/segmentation.hpp"
 
 #include <iostream>
+#include <queue>
 
 namespace cv {
     namespace ximgproc {
@@ -263,6 +264,9 @@ namespace cv {
                     virtual void addStrategy(Ptr<SelectiveSearchSegmentationStrategy> g, float weight);
                     virtual void clearStrategies();
 
+                    const std::vector<Ptr<SelectiveSearchSegmentationStrategy> >& getStrategies() const { return strategies; }
+                    const std::vector<float>& getWeights() const { return weights; }
+
                 private:
                     String name_;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
@@ -683,6 +687,63 @@ namespace cv {
                 return s;
             }
 
+            // Create a fresh instance of a built-in strategy (and of its sub-strategies), so it can be used
+            // concurrently with the original. Sub-strategies shared between strategies stay shared in the copies,
+            // to keep the per image_id histogram caches effective. Returns an empty Ptr for unknown strategies.
+            static Ptr<SelectiveSearchSegmentationStrategy> cloneStrategy(const Ptr<SelectiveSearchSegmentationStrategy>& s, std::map<SelectiveSearchSegmentationStrategy*, Ptr<SelectiveSearchSegmentationStrategy> >& cloned) {
+
+                std::map<SelectiveSearchSegmentationStrategy*, Ptr<SelectiveSearchSegmentationStrategy> >::iterator it = cloned.find(s.get());
+
+                if (it != cloned.end()) {
+                    return it->second;
+                }
+
+                Ptr<SelectiveSearchSegmentationStrategy> c;
+
+                if (dynamic_cast<SelectiveSearchSegmentationStrategyColorImpl*>(s.get())) {
+                    c = makePtr<SelectiveSearchSegmentationStrategyColorImpl>();
+                } else if (dynamic_cast<SelectiveSearchSegmentationStrategySizeImpl*>(s.get())) {
+                    c = makePtr<SelectiveSearchSegmentationStrategySizeImpl>();
+                } else if (dynamic_cast<SelectiveSearchSegmentationStrategyFillImpl*>(s.get())) {
+                    c = makePtr<SelectiveSearchSegmentationStrategyFillImpl>();
+                } else if (dynamic_cast<SelectiveSearchSegmentationStrategyTextureImpl*>(s.get())) {
+                    c = makePtr<SelectiveSearchSegmentationStrategyTextureImpl>();
+                } else if (SelectiveSearchSegmentationStrategyMultipleImpl* m = dynamic_cast<SelectiveSearchSegmentationStrategyMultipleImpl*>(s.get())) {
+                    Ptr<SelectiveSearchSegmentationStrategyMultipleImpl> cm = makePtr<SelectiveSearchSegmentationStrategyMultipleImpl>();
+
+                    for (size_t i = 0; i < m->getStrategies().size(); i++) {
+                        Ptr<SelectiveSearchSegmentationStrategy> sub = cloneStrategy(m->getStrategies()[i], cloned);
+
+                        if (sub.empty()) {
+                            return Ptr<SelectiveSearchSegmentationStrategy>();
+                        }
+
+                        cm->addStrategy(sub, m->getWeights()[i]);
+                    }
+
+                    c = cm;
+                }
+
+                if (!c.empty()) {
+                    cloned[s.get()] = c;
+                }
+
+                return c;
+            }
+
+            // Initial segmentation of one image with one graph segmentation
+            struct InitialSegmentation {
+                Mat img_regions;
+                Mat_<int> sizes;
+                int nb_segs;
+                std::vector<Rect> bounding_rects;
+
+                // Region adjacency in CSR form: the neighbours of region i, sorted, are
+                // neighbours[neighbours_start[i]] ... neighbours[neighbours_start[i + 1] - 1]
+                std::vector<int> neighbours_start;
+                std::vector<int> neighbours;
+            };
+
             // Core
 
             class SelectiveSearchSegmentationImpl : public SelectiveSearchSegmentation {
@@ -728,7 +789,36 @@ namespace cv {
                     std::vector<Ptr<GraphSegmentation> > segmentations;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
 
-                    void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int region_id);
+                    void computeInitialSegmentation(const Mat& img, Ptr<GraphSegmentation>& gs, InitialSegmentation& seg);
+                    void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const InitialSegmentation& seg, std::vector<Region>& regions, int image_id);
+                    void processCombination(int image_id, std::vector<Ptr<SelectiveSearchSegmentationStrategy> >& strategies_, std::vector<std::vector<Region> >& regions);
+
+                    friend class SelectiveSearchSegmentationInvoker;
+            };
+
+            // Process (image, graph segmentation) combinations in parallel, each one with its own copies of the strategies
+            class SelectiveSearchSegmentationInvoker : public ParallelLoopBody {
+                public:
+                    SelectiveSearchSegmentationInvoker(SelectiveSearchSegmentationImpl* ss_, std::vector<std::vector<Region> >& regions_) :
+                        ss(ss_), regions(regions_) {
+                    }
+
+                    virtual void operator()(const Range& range) const {
+                        for (int image_id = range.start; image_id < range.end; image_id++) {
+                            std::map<SelectiveSearchSegmentationStrategy*, Ptr<SelectiveSearchSegmentationStrategy> > cloned;
+                            std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies(ss->strategies.size());
+
+                            for (size_t i = 0; i < strategies.size(); i++) {
+                                strategies[i] = cloneStrategy(ss->strategies[i], cloned);
+                            }
+
+                            ss->processCombination(image_id, strategies, regions);
+                        }
+                    }
+
+                private:
+                    SelectiveSearchSegmentationImpl* ss;
+                    std::vector<std::vector<Region> >& regions;
             };
 
             void SelectiveSearchSegmentationImpl::setBaseImage(InputArray img) {
@@ -886,103 +976,184 @@ namespace cv {
 
             void SelectiveSearchSegmentationImpl::process(std::vector<Rect>& rects) {
 
+                int nb_combinations = (int)(images.size() * segmentations.size());
+
+                std::vector<std::vector<Region> > combination_regions(nb_combinations * strategies.size());
+
+                // Strategies are stateful, so combinations can only run concurrently on copies of them
+                bool parallel = true;
+                std::map<SelectiveSearchSegmentationStrategy*, Ptr<SelectiveSearchSegmentationStrategy> > cloned;
+
+                for(std::vector<Ptr<SelectiveSearchSegmentationStrategy> >::iterator strategy = strategies.begin(); strategy != strategies.end(); ++strategy) {
+                    if (cloneStrategy(*strategy, cloned).empty()) {
+                        parallel = false;
+                    }
+                }
+
+                if (parallel) {
+                    parallel_for_(Range(0, nb_combinations), SelectiveSearchSegmentationInvoker(this, combination_regions));
+                } else {
+                    for (int image_id = 0; image_id < nb_combinations; image_id++) {
+                        processCombination(image_id, strategies, combination_regions);
+                    }
+                }
+
                 std::vector<Region> all_regions;
 
-                int image_id = 0;
+                for(std::vector<std::vector<Region> >::iterator regions = combination_regions.begin(); regions != combination_regions.end(); ++regions) {
+
+                    // Compute regions' rank, in the same order as a sequential run so the rand() sequence is the same
+                    for(std::vector<Region>::iterator region = (*regions).begin(); region != (*regions).end(); ++region) {
+                        // Note: this is inverted from the paper, but we keep the lover region first so it's works
+                        (*region).rank = ((double) rand() / (RAND_MAX)) * ((*region).level);
+                    }
+
+                    all_regions.insert(all_regions.end(), (*regions).begin(), (*regions).end());
+                }
+
+                std::sort(all_regions.begin(), all_regions.end());
+
+                std::map<Rect, char, rectComparator> processed_rect;
+
+                rects.clear();
+
+                // Remove duplicate in rect list
+                for(std::vector<Region>::iterator region = all_regions.begin(); region != all_regions.end(); ++region) {
+                    if (processed_rect.find((*region).bounding_box) == processed_rect.end()) {
+                        processed_rect[(*region).bounding_box] = true;
+                        rects.push_back((*region).bounding_box);
+                    }
+                }
+
+            }
 
-                for(std::vector<Mat>::iterator image = images.begin(); image != images.end(); ++image) {
-                    for(std::vector<Ptr<GraphSegmentation> >::iterator gs = segmentations.begin(); gs != segmentations.end(); ++gs) {
+            void SelectiveSearchSegmentationImpl::processCombination(int image_id, std::vector<Ptr<SelectiveSearchSegmentationStrategy> >& strategies_, std::vector<std::vector<Region> >& regions) {
 
-                        Mat img_regions;
-                        Mat_<char> is_neighbour;
-                        Mat_<int> sizes;
+                Mat& image = images[image_id / segmentations.size()];
 
-                        // Compute initial segmentation
-                        (*gs)->processImage(*image, img_regions);
+                InitialSegmentation seg;
+                computeInitialSegmentation(image, segmentations[image_id % segmentations.size()], seg);
 
-                        // Get number of regions
-                        double min, max;
-                        minMaxLoc(img_regions, &min, &max);
-                        int nb_segs = (int)max + 1;
+                for (size_t i = 0; i < strategies_.size(); i++) {
+                    hierarchicalGrouping(image, strategies_[i], seg, regions[image_id * strategies_.size() + i], image_id);
+                }
+            }
 
-                        // Compute bouding rects and neighbours
-                        std::vector<Rect> bounding_rects;
-                        bounding_rects.resize(nb_segs);
+            void SelectiveSearchSegmentationImpl::computeInitialSegmentation(const Mat& img, Ptr<GraphSegmentation>& gs, InitialSegmentation& seg) {
 
-                        std::vector<std::vector<cv::Point> > points;
+                // Compute initial segmentation
+                gs->processImage(img, seg.img_regions);
 
-                        points.resize(nb_segs);
+                const Mat& img_regions = seg.img_regions;
 
-                        is_neighbour = Mat::zeros(nb_segs, nb_segs, CV_8UC1);
-                        sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
+                // Get number of regions
+                double min, max;
+                minMaxLoc(img_regions, &min, &max);
+                int nb_segs = (int)max + 1;
+                seg.nb_segs = nb_segs;
 
-                        const int* previous_p = NULL;
+                // Compute sizes, bouding rects and neighbours
+                seg.sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
+                int* sizes = seg.sizes.ptr<int>(0);
 
-                        for (int i = 0; i < (int)img_regions.rows; i++) {
-                            const int* p = img_regions.ptr<int>(i);
+                std::vector<Point> tl(nb_segs, Point(INT_MAX, INT_MAX));
+                std::vector<Point> br(nb_segs, Point(INT_MIN, INT_MIN));
 
-                            for (int j = 0; j < (int)img_regions.cols; j++) {
+                // Pairs of neighbour regions, as (smallest * nb_segs + largest). Only the
+                // boundaries between regions contribute, so this stays far from nb_segs x nb_segs.
+                std::vector<int64> pairs;
 
-                                points[p[j]].push_back(cv::Point(j, i));
-                                sizes.at<int>(p[j], 0) = sizes.at<int>(p[j], 0) + 1;
+                const int* previous_p = NULL;
 
-                                if (i > 0 && j > 0) {
+                for (int i = 0; i < (int)img_regions.rows; i++) {
+                    const int* p = img_regions.ptr<int>(i);
 
-                                    is_neighbour.at<char>(p[j], p[j - 1]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j - 1]) = 1;
+                    for (int j = 0; j < (int)img_regions.cols; j++) {
 
-                                    is_neighbour.at<char>(p[j - 1], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j - 1], p[j]) = 1;
-                                }
-                            }
-                            previous_p = p;
-                        }
+                        int r = p[j];
 
-                        for(int seg = 0; seg < nb_segs; seg++) {
-                            bounding_rects[seg] = cv::boundingRect(points[seg]);
-                        }
+                        sizes[r]++;
+                        tl[r].x = std::min(tl[r].x, j);
+                        tl[r].y = std::min(tl[r].y, i);
+                        br[r].x = std::max(br[r].x, j);
+                        br[r].y = std::max(br[r].y, i);
 
-                        for(std::vector<Ptr<SelectiveSearchSegmentationStrategy> >::iterator strategy = strategies.begin(); strategy != strategies.end(); ++strategy) {
-                            std::vector<Region> regions;
-                            hierarchicalGrouping(*image, *strategy, img_regions, is_neighbour, sizes, nb_segs, bounding_rects, regions, image_id);
+                        if (i > 0 && j > 0) {
+                            int others[3] = { p[j - 1], previous_p[j], previous_p[j - 1] };
 
-                            for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                                all_regions.push_back(*region);
+                            for (int k = 0; k < 3; k++) {
+                                int o = others[k];
+
+                                if (o != r) {
+                                    pairs.push_back(r < o ? (int64)r * nb_segs + o : (int64)o * nb_segs + r);
+                                }
                             }
                         }
+                    }
+                    previous_p = p;
+                }
+
+                seg.bounding_rects.resize(nb_segs);
 
-                        image_id++;
+                for(int r = 0; r < nb_segs; r++) {
+                    if (sizes[r] > 0) {
+                        seg.bounding_rects[r] = Rect(tl[r], br[r] + Point(1, 1));
                     }
                 }
 
-                std::sort(all_regions.begin(), all_regions.end());
+                std::sort(pairs.begin(), pairs.end());
+                pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
 
-                std::map<Rect, char, rectComparator> processed_rect;
+                // Build the symmetric CSR adjacency
+                std::vector<int>& start = seg.neighbours_start;
+                start.assign(nb_segs + 1, 0);
 
-                rects.clear();
+                for (size_t k = 0; k < pairs.size(); k++) {
+                    start[pairs[k] / nb_segs + 1]++;
+                    start[pairs[k] % nb_segs + 1]++;
+                }
 
-                // Remove duplicate in rect list
-                for(std::vector<Region>::iterator region = all_regions.begin(); region != all_regions.end(); ++region) {
-                    if (processed_rect.find((*region).bounding_box) == processed_rect.end()) {
-                        processed_rect[(*region).bounding_box] = true;
-                        rects.push_back((*region).bounding_box);
-                    }
+                for (int r = 0; r < nb_segs; r++) {
+                    start[r + 1] += start[r];
+                }
+
+                seg.neighbours.resize(pairs.size() * 2);
+                std::vector<int> pos(start.begin(), start.end() - 1);
+
+                // Pairs are sorted, so each row of the CSR comes out sorted as well
+                for (size_t k = 0; k < pairs.size(); k++) {
+                    int a = (int)(pairs[k] / nb_segs);
+                    int b = (int)(pairs[k] % nb_segs);
+
+                    seg.neighbours[pos[b]++] = a;
                 }
 
+                for (size_t k = 0; k < pairs.size(); k++) {
+                    int a = (int)(pairs[k] / nb_segs);
+                    int b = (int)(pairs[k] % nb_segs);
+
+                    seg.neighbours[pos[a]++] = b;
+                }
             }
 
-            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes_, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id) {
+            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const InitialSegmentation& seg, std::vector<Region>& regions, int image_id) {
+
+                Mat sizes = seg.sizes.clone();
+                int nb_segs = seg.nb_segs;
 
-                Mat sizes = sizes_.clone();
+                // Max-heap of similarities. Entries refering to an already merged region are stale and skipped.
+                std::priority_queue<Neighbour> similarities;
+
+                // Neighbours of each region. Lists may still contain merged regions, they are filtered when used.
+                std::vector<std::vector<int> > neighbours;
 
-                std::vector<Neighbour> similarities;
                 regions.clear();
+                regions.reserve(nb_segs * 2);
+                neighbours.reserve(nb_segs * 2);
 
                 /////////////////////////////////////////
 
-                s->setImage(img, img_regions, sizes, image_id);
+                s->setImage(img, seg.img_regions, sizes, image_id);
 
                 // Compute initial similarities
                 for (int i = 0; i < nb_segs; i++) {
@@ -991,32 +1162,37 @@ namespace cv {
                     r.id = i;
                     r.level = 1;
                     r.merged_to = -1;
-                    r.bounding_box = bounding_rects[i];
+                    r.bounding_box = seg.bounding_rects[i];
 
                     regions.push_back(r);
 
-                    for (int j = i + 1; j < nb_segs; j++) {
-                        if (is_neighbour.at<char>(i, j)) {
+                    std::vector<int>::const_iterator first = seg.neighbours.begin() + seg.neighbours_start[i];
+                    std::vector<int>::const_iterator last = seg.neighbours.begin() + seg.neighbours_start[i + 1];
+
+                    neighbours.push_back(std::vector<int>(first, last));
+
+                    for (std::vector<int>::const_iterator j = first; j != last; j++) {
+                        if (*j > i) {
                             Neighbour n;
                             n.from = i;
-                            n.to = j;
-                            n.similarity = s->get(i, j);
+                            n.to = *j;
+                            n.similarity = s->get(i, *j);
 
-                            similarities.push_back(n);
+                            similarities.push(n);
                         }
                     }
                 }
 
-                while(similarities.size() > 0) {
+                std::vector<int> local_neighbours;
 
-                    std::sort(similarities.begin(), similarities.end());
+                while(!similarities.empty()) {
 
-                    // for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end(); ++similarity) {
-                    //     std::cout << *similarity << std::endl;
-                    // }
+                    Neighbour p = similarities.top();
+                    similarities.pop();
 
-                    Neighbour p = similarities.back();
-                    similarities.pop_back();
+                    if (regions[p.from].merged_to != -1 || regions[p.to].merged_to != -1) {
+                        continue;
+                    }
 
                     Region region_from = regions[p.from];
                     Region region_to = regions[p.to];
@@ -1029,8 +1205,10 @@ namespace cv {
 
                     regions.push_back(new_r);
 
-                    regions[p.from].merged_to = (int)regions.size() - 1;
-                    regions[p.to].merged_to = (int)regions.size() - 1;
+                    int new_id = (int)regions.size() - 1;
+
+                    regions[p.from].merged_to = new_id;
+                    regions[p.to].merged_to = new_id;
 
                     // Merge
                     s->merge(region_from.id, region_to.id);
@@ -1039,51 +1217,48 @@ namespace cv {
                     sizes.at<int>(region_from.id, 0) += sizes.at<int>(region_to.id, 0);
                     sizes.at<int>(region_to.id, 0) = sizes.at<int>(region_from.id, 0);
 
-                    std::vector<int> local_neighbours;
+                    // Neighbours of the new region are the ones of both merged regions that are still alive
+                    local_neighbours.clear();
 
-                    for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end();) {
-                        if ((*similarity).from == p.from || (*similarity).to == p.from || (*similarity).from == p.to || (*similarity).to == p.to) {
-                            int from = 0;
+                    for (int k = 0; k < 2; k++) {
+                        std::vector<int>& merged = neighbours[k == 0 ? p.from : p.to];
 
-                            if ((*similarity).from == p.from || (*similarity).from == p.to) {
-                                from = (*similarity).to;
-                            } else {
-                                from = (*similarity).from;
+                        for (size_t l = 0; l < merged.size(); l++) {
+                            if (regions[merged[l]].merged_to == -1) {
+                                local_neighbours.push_back(merged[l]);
                             }
+                        }
 
-                            bool already_neighboor = false;
+                        std::vector<int>().swap(merged);
+                    }
 
-                            for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
-                                if (*local_neighbour == from) {
-                                    already_neighboor = true;
-                                }
-                            }
+                    std::sort(local_neighbours.begin(), local_neighbours.end());
+                    local_neighbours.erase(std::unique(local_neighbours.begin(), local_neighbours.end()), local_neighbours.end());
 
-                            if (!already_neighboor) {
-                                local_neighbours.push_back(from);
-                            }
+                    for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
+
+                        // Drop the merged regions from the neighbour list and replace them by the new one
+                        std::vector<int>& other = neighbours[*local_neighbour];
+                        size_t kept = 0;
 
-                            similarity = similarities.erase(similarity);
-                        } else {
-                            similarity++;
+                        for (size_t l = 0; l < other.size(); l++) {
+                            if (regions[other[l]].merged_to == -1) {
+                                other[kept++] = other[l];
+                            }
                         }
-                    }
 
-                    for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
+                        other.resize(kept);
+                        other.push_back(new_id);
 
                         Neighbour n;
-                        n.from = (int)regions.size() - 1;
+                        n.from = new_id;
                         n.to = *local_neighbour;
                         n.similarity = s->get(regions[n.from].id, regions[n.to].id);
 
-                        similarities.push_back(n);
+                        similarities.push(n);
                     }
-                }
 
-                // Compute regions' rank
-                for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                    // Note: this is inverted from the paper, but we keep the lover region first so it's works
-                    (*region).rank = ((double) rand() / (RAND_MAX)) * ((*region).level);
+                    neighbours.push_back(local_neighbours);
                 }
 
             }
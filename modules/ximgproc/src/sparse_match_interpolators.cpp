@@ -79,11 +79,14 @@ protected:
     int w,h;
     int match_num;
 
-    //internal buffers:
-    vector<node>* g;
+    //internal buffers, kept between calls to reuse their memory for the next frame:
+    vector< vector<node> > g;
     Mat labels;
     Mat NNlabels;
     Mat NNdistances;
+    Mat distances_buf;
+    Mat cost_map_buf;
+    vector< vector< vector<node> > > stripe_graphs; //edges found in each stripe of rows by buildGraph
 
     //tunable parameters:
     float lambda;
@@ -98,12 +101,15 @@ protected:
     static const int ransac_interpolation_num_iter = 1;
     float regularization_coef;
     static const int ransac_num_stripes = 4;
+    static const int distance_transform_tile_h = 32;
+    static const int distance_transform_tile_w = 128;
     RNG rngs[ransac_num_stripes];
 
     void init();
     void preprocessData(Mat& src, vector<SparseMatch>& matches);
     void computeGradientMagnitude(Mat& src, Mat& dst);
     void geodesicDistanceTransform(Mat& distances, Mat& cost_map);
+    void geodesicDistanceTile(Mat& distances, Mat& cost_map, int tile_row, int tile_col, int dir);
     void buildGraph(Mat& distances, Mat& cost_map);
     void ransacInterpolation(vector<SparseMatch>& matches, Mat& dst_dense_flow);
 
@@ -118,6 +124,38 @@ protected:
         void operator () (const Range& range) const;
     };
 
+    struct GeodesicWave_ParBody : public ParallelLoopBody
+    {
+        EdgeAwareInterpolatorImpl* inst;
+        Mat* distances;
+        Mat* cost_map;
+        int wave;
+        int dir;
+
+        GeodesicWave_ParBody(EdgeAwareInterpolatorImpl& _inst, Mat& _distances, Mat& _cost_map, int _wave, int _dir);
+        void operator () (const Range& range) const;
+    };
+
+    struct BuildGraph_ParBody : public ParallelLoopBody
+    {
+        EdgeAwareInterpolatorImpl* inst;
+        Mat* distances;
+        Mat* cost_map;
+        int num_stripes;
+        int stripe_sz;
+
+        BuildGraph_ParBody(EdgeAwareInterpolatorImpl& _inst, Mat& _distances, Mat& _cost_map, int _num_stripes);
+        void operator () (const Range& range) const;
+    };
+
+    struct MergeGraph_ParBody : public ParallelLoopBody
+    {
+        EdgeAwareInterpolatorImpl* inst;
+
+        MergeGraph_ParBody(EdgeAwareInterpolatorImpl& _inst);
+        void operator () (const Range& range) const;
+    };
+
     struct RansacInterpolation_ParBody : public ParallelLoopBody
     {
         EdgeAwareInterpolatorImpl* inst;
@@ -186,13 +224,15 @@ void EdgeAwareInterpolatorImpl::interpolate(InputArray from_image, InputArray fr
     CV_Assert(match_num<SHRT_MAX);
 
     Mat src = from_image.getMat();
-    labels = Mat(h,w,CV_16S);
+    labels.create(h,w,CV_16S);
     labels = Scalar(-1);
-    NNlabels = Mat(match_num,k,CV_16S);
+    NNlabels.create(match_num,k,CV_16S);
     NNlabels = Scalar(-1);
-    NNdistances = Mat(match_num,k,CV_32F);
+    NNdistances.create(match_num,k,CV_32F);
     NNdistances = Scalar(0.0f);
-    g = new vector<node>[match_num];
+    g.resize(match_num);
+    for(int i=0;i<match_num;i++)
+        g[i].clear();
 
     preprocessData(src,matches_vector);
 
@@ -201,14 +241,14 @@ void EdgeAwareInterpolatorImpl::interpolate(InputArray from_image, InputArray fr
     ransacInterpolation(matches_vector,dst);
     if(use_post_proc)
         fastGlobalSmootherFilter(src,dst,dst,fgs_lambda,fgs_sigma);
-
-    delete[] g;
 }
 
 void EdgeAwareInterpolatorImpl::preprocessData(Mat& src, vector<SparseMatch>& matches)
 {
-    Mat distances(h,w,CV_32F);
-    Mat cost_map (h,w,CV_32F);
+    distances_buf.create(h,w,CV_32F);
+    cost_map_buf .create(h,w,CV_32F);
+    Mat& distances = distances_buf;
+    Mat& cost_map  = cost_map_buf;
     distances = Scalar(INF);
 
     int x,y;
@@ -264,16 +304,16 @@ void EdgeAwareInterpolatorImpl::computeGradientMagnitude(Mat& src, Mat& dst)
     }
 }
 
-void EdgeAwareInterpolatorImpl::geodesicDistanceTransform(Mat& distances, Mat& cost_map)
+// Relaxes the pixels of a row from their neighbours in the scan order of a pass of the
+// geodesic distance transform: dir=1 is the forward pass (left-to-right, top-to-bottom),
+// dir=-1 the backward one, c is the column index in the order of the scan
+static void geodesicDistanceRow(float* dist_row, short* label_row, const float* cost_row,
+                                const float* dist_row_prev, const short* label_row_prev, const float* cost_row_prev,
+                                int w, int c_start, int c_end, int dir)
 {
-    float c1 = 1.0f/2.0f;
-    float c2 = sqrt(2.0f)/2.0f;
-    float d = 0.0f;
-    int i,j;
-    float *dist_row,      *cost_row;
-    float *dist_row_prev, *cost_row_prev;
-    short *label_row;
-    short *label_row_prev;
+    const float c1 = 1.0f/2.0f;
+    const float c2 = sqrt(2.0f)/2.0f;
+    float d;
 
 #define CHECK(cur_dist,cur_label,cur_cost,prev_dist,prev_label,prev_cost,coef)\
 {\
@@ -283,145 +323,187 @@ void EdgeAwareInterpolatorImpl::geodesicDistanceTransform(Mat& distances, Mat& c
         cur_label = prev_label;}\
 }
 
-    for(int it=0;it<distance_transform_num_iter;it++)
+    for(int c=c_start;c<c_end;c++)
     {
-        //first pass (left-to-right, top-to-bottom):
-        dist_row  = distances.ptr<float>(0);
-        label_row = labels.ptr<short>(0);
-        cost_row  = cost_map.ptr<float>(0);
-        for(j=1;j<w;j++)
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j-1],label_row[j-1],cost_row[j-1],c1);
-
-        for(i=1;i<h;i++)
-        {
-            dist_row       = distances.ptr<float>(i);
-            dist_row_prev  = distances.ptr<float>(i-1);
+        int j = (dir>0) ? c : w-1-c;
+        if(c>0)
+            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j-dir],label_row[j-dir],cost_row[j-dir],c1);
+        if(!dist_row_prev)
+            continue;
+        if(c>0)
+            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j-dir],label_row_prev[j-dir],cost_row_prev[j-dir],c2);
+        CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j],label_row_prev[j],cost_row_prev[j],c1);
+        if(c<w-1)
+            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j+dir],label_row_prev[j+dir],cost_row_prev[j+dir],c2);
+    }
+#undef CHECK
+}
 
-            label_row      = labels.ptr<short>(i);
-            label_row_prev = labels.ptr<short>(i-1);
+// A pixel depends on the previous pixel of its row and on three pixels of the previous row,
+// the rightmost of which is one column ahead in the scan order. In the skewed coordinates
+// (r, u=c+r) all these dependencies are up and to the left, so the passes are computed as
+// waves of independent rectangular tiles, with the same result as a raster scan.
+void EdgeAwareInterpolatorImpl::geodesicDistanceTile(Mat& distances, Mat& cost_map, int tile_row, int tile_col, int dir)
+{
+    int r_start = tile_row*distance_transform_tile_h;
+    int r_end   = min(r_start+distance_transform_tile_h,h);
+    int u_start = tile_col*distance_transform_tile_w;
+    int u_end   = u_start+distance_transform_tile_w;
 
-            cost_row      = cost_map.ptr<float>(i);
-            cost_row_prev = cost_map.ptr<float>(i-1);
+    for(int r=r_start;r<r_end;r++)
+    {
+        int c_start = max(u_start-r,0);
+        int c_end   = min(u_end-r,w);
+        if(c_start>=c_end)
+            continue;
 
-            j=0;
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j+1],label_row_prev[j+1],cost_row_prev[j+1],c2);
-            j++;
-            for(;j<w-1;j++)
-            {
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j-1]     ,label_row[j-1]     ,cost_row[j-1]     ,c1);
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j-1],label_row_prev[j-1],cost_row_prev[j-1],c2);
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j+1],label_row_prev[j+1],cost_row_prev[j+1],c2);
-            }
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j-1]     ,label_row[j-1]     ,cost_row[j-1]     ,c1);
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j-1],label_row_prev[j-1],cost_row_prev[j-1],c2);
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
+        int i = (dir>0) ? r : h-1-r;
+        const float *dist_row_prev = 0, *cost_row_prev = 0;
+        const short *label_row_prev = 0;
+        if(r>0)
+        {
+            dist_row_prev  = distances.ptr<float>(i-dir);
+            label_row_prev = labels.ptr<short>(i-dir);
+            cost_row_prev  = cost_map.ptr<float>(i-dir);
         }
+        geodesicDistanceRow(distances.ptr<float>(i),labels.ptr<short>(i),cost_map.ptr<float>(i),
+                            dist_row_prev,label_row_prev,cost_row_prev,w,c_start,c_end,dir);
+    }
+}
 
-        //second pass (right-to-left, bottom-to-top):
-        dist_row  = distances.ptr<float>(h-1);
-        label_row = labels.ptr<short>(h-1);
-        cost_row  = cost_map.ptr<float>(h-1);
-        for(j=w-2;j>=0;j--)
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j+1],label_row[j+1],cost_row[j+1],c1);
-
-        for(i=h-2;i>=0;i--)
-        {
-            dist_row       = distances.ptr<float>(i);
-            dist_row_prev  = distances.ptr<float>(i+1);
+EdgeAwareInterpolatorImpl::GeodesicWave_ParBody::GeodesicWave_ParBody(EdgeAwareInterpolatorImpl& _inst, Mat& _distances, Mat& _cost_map, int _wave, int _dir):
+inst(&_inst), distances(&_distances), cost_map(&_cost_map), wave(_wave), dir(_dir)
+{}
 
-            label_row      = labels.ptr<short>(i);
-            label_row_prev = labels.ptr<short>(i+1);
+void EdgeAwareInterpolatorImpl::GeodesicWave_ParBody::operator() (const Range& range) const
+{
+    for(int tile_row=range.start;tile_row<range.end;tile_row++)
+        inst->geodesicDistanceTile(*distances,*cost_map,tile_row,wave-tile_row,dir);
+}
 
-            cost_row      = cost_map.ptr<float>(i);
-            cost_row_prev = cost_map.ptr<float>(i+1);
+void EdgeAwareInterpolatorImpl::geodesicDistanceTransform(Mat& distances, Mat& cost_map)
+{
+    int num_tile_rows = (h+distance_transform_tile_h-1)/distance_transform_tile_h;
+    int num_tile_cols = (w+h-1+distance_transform_tile_w-1)/distance_transform_tile_w;
 
-            j=w-1;
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j-1],label_row_prev[j-1],cost_row_prev[j-1],c2);
-            j--;
-            for(;j>0;j--)
+    for(int it=0;it<distance_transform_num_iter;it++)
+    {
+        //first pass (left-to-right, top-to-bottom), then second pass (right-to-left, bottom-to-top):
+        for(int dir=1;dir>=-1;dir-=2)
+        {
+            for(int wave=0;wave<num_tile_rows+num_tile_cols-1;wave++)
             {
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j+1]     ,label_row[j+1]     ,cost_row[j+1]     ,c1);
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j+1],label_row_prev[j+1],cost_row_prev[j+1],c2);
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j-1],label_row_prev[j-1],cost_row_prev[j-1],c2);
+                Range tile_rows(max(0,wave-num_tile_cols+1),min(num_tile_rows,wave+1));
+                parallel_for_(tile_rows,GeodesicWave_ParBody(*this,distances,cost_map,wave,dir));
             }
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j+1]     ,label_row[j+1]     ,cost_row[j+1]     ,c1);
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j+1],label_row_prev[j+1],cost_row_prev[j+1],c2);
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
         }
     }
-#undef CHECK
 }
 
-void EdgeAwareInterpolatorImpl::buildGraph(Mat& distances, Mat& cost_map)
+static inline void addGraphEdge(vector<node>& neighbors, short label, float d)
+{
+    for(unsigned int n=0;n<neighbors.size();n++)
+    {
+        if(neighbors[n].label==label)
+        {
+            neighbors[n].dist = min(neighbors[n].dist,d);
+            return;
+        }
+    }
+    neighbors.push_back(node(label,d));
+}
+
+EdgeAwareInterpolatorImpl::BuildGraph_ParBody::BuildGraph_ParBody(EdgeAwareInterpolatorImpl& _inst, Mat& _distances, Mat& _cost_map, int _num_stripes):
+inst(&_inst), distances(&_distances), cost_map(&_cost_map), num_stripes(_num_stripes)
+{
+    stripe_sz = (int)ceil(inst->h/(double)num_stripes);
+}
+
+void EdgeAwareInterpolatorImpl::BuildGraph_ParBody::operator() (const Range& range) const
 {
-    float *dist_row,      *cost_row;
-    float *dist_row_prev, *cost_row_prev;
-    short *label_row;
-    short *label_row_prev;
-    int i,j;
     const float c1 = 1.0f/2.0f;
     const float c2 = sqrt(2.0f)/2.0f;
-    float d;
-    bool found;
+    int w = inst->w;
 
 #define CHECK(cur_dist,cur_label,cur_cost,prev_dist,prev_label,prev_cost,coef)\
     if(cur_label!=prev_label)\
-    {\
-        d = prev_dist + cur_dist + coef*(cur_cost+prev_cost);\
-        found = false;\
-        for(unsigned int n=0;n<g[prev_label].size();n++)\
-        {\
-            if(g[prev_label][n].label==cur_label)\
-            {\
-                g[prev_label][n].dist = min(g[prev_label][n].dist,d);\
-                found=true;\
-                break;\
-            }\
-        }\
-        if(!found)\
-            g[prev_label].push_back(node(cur_label ,d));\
-    }
-
-    dist_row  = distances.ptr<float>(0);
-    label_row = labels.ptr<short>(0);
-    cost_row  = cost_map.ptr<float>(0);
-    for(j=1;j<w;j++)
-        CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j-1],label_row[j-1],cost_row[j-1],c1);
+        addGraphEdge(graph[prev_label],cur_label,prev_dist + cur_dist + coef*(cur_cost+prev_cost));
 
-    for(i=1;i<h;i++)
+    for(int stripe=range.start;stripe<range.end;stripe++)
     {
-        dist_row       = distances.ptr<float>(i);
-        dist_row_prev  = distances.ptr<float>(i-1);
+        vector< vector<node> >& graph = inst->stripe_graphs[stripe];
+        int start = std::min(stripe     * stripe_sz, inst->h);
+        int end   = std::min((stripe+1) * stripe_sz, inst->h);
+        int i,j;
 
-        label_row      = labels.ptr<short>(i);
-        label_row_prev = labels.ptr<short>(i-1);
+        for(i=start;i<end;i++)
+        {
+            float* dist_row  = distances->ptr<float>(i);
+            short* label_row = inst->labels.ptr<short>(i);
+            float* cost_row  = cost_map->ptr<float>(i);
+            if(i==0)
+            {
+                for(j=1;j<w;j++)
+                    CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j-1],label_row[j-1],cost_row[j-1],c1);
+                continue;
+            }
 
-        cost_row      = cost_map.ptr<float>(i);
-        cost_row_prev = cost_map.ptr<float>(i-1);
+            float* dist_row_prev  = distances->ptr<float>(i-1);
+            short* label_row_prev = inst->labels.ptr<short>(i-1);
+            float* cost_row_prev  = cost_map->ptr<float>(i-1);
 
-        j=0;
-        CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
-        CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j+1],label_row_prev[j+1],cost_row_prev[j+1],c2);
-        j++;
-        for(;j<w-1;j++)
-        {
+            j=0;
+            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
+            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j+1],label_row_prev[j+1],cost_row_prev[j+1],c2);
+            j++;
+            for(;j<w-1;j++)
+            {
+                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j-1]     ,label_row[j-1]     ,cost_row[j-1]     ,c1);
+                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j-1],label_row_prev[j-1],cost_row_prev[j-1],c2);
+                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
+                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j+1],label_row_prev[j+1],cost_row_prev[j+1],c2);
+            }
             CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j-1]     ,label_row[j-1]     ,cost_row[j-1]     ,c1);
             CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j-1],label_row_prev[j-1],cost_row_prev[j-1],c2);
             CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j+1],label_row_prev[j+1],cost_row_prev[j+1],c2);
         }
-        CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j-1]     ,label_row[j-1]     ,cost_row[j-1]     ,c1);
-        CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j-1],label_row_prev[j-1],cost_row_prev[j-1],c2);
-        CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
     }
 #undef CHECK
+}
+
+EdgeAwareInterpolatorImpl::MergeGraph_ParBody::MergeGraph_ParBody(EdgeAwareInterpolatorImpl& _inst):
+inst(&_inst)
+{}
+
+void EdgeAwareInterpolatorImpl::MergeGraph_ParBody::operator() (const Range& range) const
+{
+    for(int i=range.start;i<range.end;i++)
+    {
+        for(unsigned int stripe=0;stripe<inst->stripe_graphs.size();stripe++)
+        {
+            vector<node>& neighbors = inst->stripe_graphs[stripe][i];
+            for(unsigned int n=0;n<neighbors.size();n++)
+                addGraphEdge(inst->g[i],neighbors[n].label,neighbors[n].dist);
+            neighbors.clear();
+        }
+    }
+}
+
+void EdgeAwareInterpolatorImpl::buildGraph(Mat& distances, Mat& cost_map)
+{
+    // the edges of each stripe of rows are collected separately, then merged in the order of the stripes,
+    // so that the lists of neighbors are exactly the ones of a single raster scan:
+    int num_stripes = max(1,min(getNumThreads(),h/32));
+    stripe_graphs.resize(num_stripes);
+    for(int i=0;i<num_stripes;i++)
+        stripe_graphs[i].resize(match_num);
+    parallel_for_(Range(0,num_stripes),BuildGraph_ParBody(*this,distances,cost_map,num_stripes));
+    parallel_for_(Range(0,match_num),MergeGraph_ParBody(*this));
 
     // force equal distances in both directions:
     node* neighbors;
+    bool found;
+    int i,j;
     for(i=0;i<match_num;i++)
     {
         if(g[i].empty())
@@ -474,10 +556,13 @@ struct nodeHeap
         delete[] heap_pos;
     }
 
+    // only the nodes still in the heap have a position to reset, the ones already
+    // taken out by getMin have it reset there
     void clear()
     {
+        for(short i=1;i<=size;i++)
+            heap_pos[heap[i].label] = 0;
         size=0;
-        memset(heap_pos,0,sizeof(short)*num_labels);
     }
 
     inline bool empty()
@@ -590,6 +675,7 @@ void EdgeAwareInterpolatorImpl::GetKNNMatches_ParBody::operator() (const Range&
     nodeHeap q((short)inst->match_num);
     int num_expanded_vertices;
     unsigned char* expanded_flag = new unsigned char[inst->match_num];
+    memset(expanded_flag,0,inst->match_num);
     node* neighbors;
 
     for(int i=start;i<end;i++)
@@ -598,7 +684,6 @@ void EdgeAwareInterpolatorImpl::GetKNNMatches_ParBody::operator() (const Range&
             continue;
 
         num_expanded_vertices = 0;
-        memset(expanded_flag,0,inst->match_num);
         q.clear();
         q.add(node((short)i,0.0f));
         short* NNlabels_row    = inst->NNlabels.ptr<short>(i);
@@ -621,6 +706,10 @@ void EdgeAwareInterpolatorImpl::GetKNNMatches_ParBody::operator() (const Range&
                     q.updateNode(node(neighbors[j].label,vert_for_expansion.dist+neighbors[j].dist));
             }
         }
+
+        //reset only the flags set by this search:
+        for(int j=0;j<num_expanded_vertices;j++)
+            expanded_flag[NNlabels_row[j]] = 0;
     }
     delete[] expanded_flag;
 }
@@ -41,6 +41,8 @@
 #include <algorithm>
 #include <iterator>
 #include <iostream>
+#include <fstream>
+#include <cstring>
 #include <cmath>
 
 #include "precomp.hpp"
@@ -330,6 +332,156 @@ public:
   }
 };
 
+/*!
+ * Node of a tree of the random forest. Trees are stored one after the other
+ * in a flat array; the children of a node are baseNode + child - 1 and
+ * baseNode + child, where baseNode is the root of its tree. Leaves have child == 0.
+ */
+struct RFNode
+{
+  int child;
+  int featureId;
+  float threshold;
+};
+
+/*!
+ * The class parallelizing the evaluation of the trees over rows of patches.
+ *
+ * \param nodes : flat node array of the forest
+ * \param regFeatures : smoothed features, used by regular nodes
+ * \param ssFeatures : smoothed features, used by self similarity nodes
+ * \param offsetI : offsets of the regular features
+ * \param offsetX, offsetY : offsets of the pairs of self similarity features
+ * \param indexes : destination, leaf reached by each evaluated tree
+ */
+class TreesInvoker : public cv::ParallelLoopBody
+{
+
+private:
+  const RFNode *nodes;
+  const cv::Mat &regFeatures;
+  const cv::Mat &ssFeatures;
+  const std::vector<int> &offsetI;
+  const std::vector<int> &offsetX;
+  const std::vector<int> &offsetY;
+  cv::Mat &indexes;
+  const int nFeatures, nTrees, nTreesEval, nTreesNodes, stride, shrink;
+
+public:
+  TreesInvoker(const RFNode *_nodes, const cv::Mat &_regFeatures, const cv::Mat &_ssFeatures,
+               const std::vector<int> &_offsetI, const std::vector<int> &_offsetX, const std::vector<int> &_offsetY,
+               cv::Mat &_indexes, const int _nFeatures, const int _nTrees, const int _nTreesEval,
+               const int _nTreesNodes, const int _stride, const int _shrink)
+              : nodes(_nodes), regFeatures(_regFeatures), ssFeatures(_ssFeatures),
+                offsetI(_offsetI), offsetX(_offsetX), offsetY(_offsetY), indexes(_indexes),
+                nFeatures(_nFeatures), nTrees(_nTrees), nTreesEval(_nTreesEval),
+                nTreesNodes(_nTreesNodes), stride(_stride), shrink(_shrink)
+              {
+              }
+
+  void operator()(const cv::Range &range) const
+  {
+    const int nchannels = regFeatures.channels();
+
+    for (int i = range.start; i < range.end; ++i)
+    {
+      const float *regFeaturesPtr = regFeatures.ptr<float>(i*stride/shrink);
+      const float  *ssFeaturesPtr = ssFeatures.ptr<float>(i*stride/shrink);
+
+      int *indexPtr = indexes.ptr<int>(i);
+
+      for (int j = 0, k = 0; j < indexes.cols; ++k, j += !(k %= nTreesEval))
+          // for j,k in [0;width)x[0;nTreesEval)
+      {
+        int baseNode = ( ((i + j)%(2*nTreesEval) + k)%nTrees )*nTreesNodes;
+        int currentNode = baseNode;
+        // select root node of the tree to evaluate
+
+        int offset = (j*stride/shrink)*nchannels;
+        const RFNode *node = nodes + currentNode;
+        while ( node->child != 0 )
+        {
+          int currentId = node->featureId;
+          float currentFeature;
+
+          if (currentId >= nFeatures)
+          {
+            float A = ssFeaturesPtr[offset + offsetX[currentId - nFeatures]];
+            float B = ssFeaturesPtr[offset + offsetY[currentId - nFeatures]];
+
+            currentFeature = A - B;
+          }
+          else
+            currentFeature = regFeaturesPtr[offset + offsetI[currentId]];
+
+          // compare feature to threshold and move left or right accordingly
+          currentNode = baseNode + node->child - (currentFeature < node->threshold ? 1 : 0);
+          node = nodes + currentNode;
+        }
+
+        indexPtr[j*nTreesEval + k] = currentNode;
+      }
+    }
+  }
+};
+
+/*!
+ * The class parallelizing the accumulation of the leaves' edge maps.
+ * Patches of consecutive rows overlap, so only the rows i = phase (mod period)
+ * are processed, with period*stride >= patchInnerSize: their patches are disjoint.
+ *
+ * \param indexes : leaf reached by each evaluated tree
+ * \param edgeBoundaries, edgeBins : edge pixels of each leaf
+ * \param offsetE : offsets of the edge pixels in dst
+ * \param dst : destination edge map (single channel)
+ * \param step : amount added for each edge pixel
+ */
+class EdgesAccumulateInvoker : public cv::ParallelLoopBody
+{
+
+private:
+  const cv::Mat &indexes;
+  const std::vector<int> &edgeBoundaries;
+  const std::vector<int> &edgeBins;
+  const std::vector<int> &offsetE;
+  cv::Mat &dst;
+  const int nTreesEval, stride, phase, period;
+  const float step;
+
+public:
+  EdgesAccumulateInvoker(const cv::Mat &_indexes, const std::vector<int> &_edgeBoundaries,
+                         const std::vector<int> &_edgeBins, const std::vector<int> &_offsetE, cv::Mat &_dst,
+                         const int _nTreesEval, const int _stride, const int _phase, const int _period, const float _step)
+              : indexes(_indexes), edgeBoundaries(_edgeBoundaries), edgeBins(_edgeBins), offsetE(_offsetE),
+                dst(_dst), nTreesEval(_nTreesEval), stride(_stride), phase(_phase), period(_period), step(_step)
+              {
+              }
+
+  void operator()(const cv::Range &range) const
+  {
+    for (int r = range.start; r < range.end; ++r)
+    {
+      int i = phase + r*period;
+
+      const int *pIndex = indexes.ptr<int>(i);
+      float *pDst = dst.ptr<float>(i*stride);
+
+      for (int j = 0, k = 0; j < indexes.cols; ++k, j += !(k %= nTreesEval))
+      {// for j,k in [0;width)x[0;nTreesEval)
+
+        int currentNode = pIndex[j*nTreesEval + k];
+
+        int start  = edgeBoundaries[currentNode];
+        int finish = edgeBoundaries[currentNode + 1];
+
+        float *patch = pDst + j*stride;
+        for (int p = start; p < finish; ++p)
+          patch[offsetE[edgeBins[p]]] += step;
+      }
+    }
+  }
+};
+
 /********************* RFFeatureGetter class *********************/
 
 namespace cv
@@ -413,6 +565,9 @@ namespace cv
 namespace ximgproc
 {
 
+/*! signature at the start of binary model files */
+static const char binaryModelSignature[8] = {'C', 'V', 'S', 'E', 'D', 'R', 'F', '1'};
+
 class StructuredEdgeDetectionImpl : public StructuredEdgeDetection
 {
 public:
@@ -428,93 +583,35 @@ public:
                           ? _howToGetFeatures
                           : createRFFeatureGetter().staticCast<const RFFeatureGetter>() )
     {
-        cv::FileStorage modelFile(filename, FileStorage::READ);
-        CV_Assert( modelFile.isOpened() );
-
-        __rf.options.stride
-            = modelFile["options"]["stride"];
-        __rf.options.shrinkNumber
-            = modelFile["options"]["shrinkNumber"];
-        __rf.options.patchSize
-            = modelFile["options"]["patchSize"];
-        __rf.options.patchInnerSize
-            = modelFile["options"]["patchInnerSize"];
-
-        __rf.options.numberOfGradientOrientations
-            = modelFile["options"]["numberOfGradientOrientations"];
-        __rf.options.gradientSmoothingRadius
-            = modelFile["options"]["gradientSmoothingRadius"];
-        __rf.options.regFeatureSmoothingRadius
-            = modelFile["options"]["regFeatureSmoothingRadius"];
-        __rf.options.ssFeatureSmoothingRadius
-            = modelFile["options"]["ssFeatureSmoothingRadius"];
-        __rf.options.gradientNormalizationRadius
-            = modelFile["options"]["gradientNormalizationRadius"];
-
-        __rf.options.selfsimilarityGridSize
-            = modelFile["options"]["selfsimilarityGridSize"];
-
-        __rf.options.numberOfTrees
-            = modelFile["options"]["numberOfTrees"];
-        __rf.options.numberOfTreesToEvaluate
-            = modelFile["options"]["numberOfTreesToEvaluate"];
-
-        __rf.options.numberOfOutputChannels =
-            2*(__rf.options.numberOfGradientOrientations + 1) + 3;
-        //--------------------------------------------
-
-        cv::FileNode childs = modelFile["childs"];
-        cv::FileNode featureIds = modelFile["featureIds"];
-
-        std::vector <int> currentTree;
-
-        for(cv::FileNodeIterator it = childs.begin();
-            it != childs.end(); ++it)
-        {
-            (*it) >> currentTree;
-            std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.childs));
-        }
-
-        for(cv::FileNodeIterator it = featureIds.begin();
-            it != featureIds.end(); ++it)
-        {
-            (*it) >> currentTree;
-            std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.featureIds));
-        }
+        if ( !loadBinaryModel(filename) )
+            loadModel(filename);
+    }
 
-        cv::FileNode thresholds = modelFile["thresholds"];
-        std::vector <float> fcurrentTree;
+    /*!
+     * The function saves the model in the binary format.
+     *
+     * \param filename : name of the file where the model is saved
+     */
+    void saveBinaryModel(const String &filename) const
+    {
+        std::ofstream modelFile(filename.c_str(), std::ios::binary);
+        CV_Assert( modelFile.is_open() );
 
-        for(cv::FileNodeIterator it = thresholds.begin();
-            it != thresholds.end(); ++it)
-        {
-            (*it) >> fcurrentTree;
-            std::copy(fcurrentTree.begin(), fcurrentTree.end(),
-                std::back_inserter(__rf.thresholds));
-        }
+        modelFile.write(binaryModelSignature, sizeof(binaryModelSignature));
 
-        cv::FileNode edgeBoundaries = modelFile["edgeBoundaries"];
-        cv::FileNode edgeBins = modelFile["edgeBins"];
+        RandomForest::RandomForestOptions options = __rf.options;
+        int *fields[nOptionFields];
+        getOptionFields(options, fields);
+        for (int i = 0; i < nOptionFields; ++i)
+            modelFile.write((const char *)fields[i], sizeof(int));
 
-        for(cv::FileNodeIterator it = edgeBoundaries.begin();
-            it != edgeBoundaries.end(); ++it)
-        {
-            (*it) >> currentTree;
-            std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.edgeBoundaries));
-        }
+        modelFile.write((const char *)&__rf.numberOfTreeNodes, sizeof(int));
 
-        for(cv::FileNodeIterator it = edgeBins.begin();
-            it != edgeBins.end(); ++it)
-        {
-            (*it) >> currentTree;
-            std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.edgeBins));
-        }
+        writeVector(modelFile, __rf.nodes);
+        writeVector(modelFile, __rf.edgeBoundaries);
+        writeVector(modelFile, __rf.edgeBins);
 
-        __rf.numberOfTreeNodes = int( __rf.childs.size() ) / __rf.options.numberOfTrees;
+        CV_Assert( modelFile.good() );
     }
 
     /*!
@@ -645,6 +742,172 @@ public:
 
 
 protected:
+    /*!
+     * The function loads the model from a YAML/XML file (possibly gzipped)
+     *
+     * \param filename : name of the file where the model is stored
+     */
+    void loadModel(const cv::String &filename)
+    {
+        cv::FileStorage modelFile(filename, FileStorage::READ);
+        CV_Assert( modelFile.isOpened() );
+
+        __rf.options.stride
+            = modelFile["options"]["stride"];
+        __rf.options.shrinkNumber
+            = modelFile["options"]["shrinkNumber"];
+        __rf.options.patchSize
+            = modelFile["options"]["patchSize"];
+        __rf.options.patchInnerSize
+            = modelFile["options"]["patchInnerSize"];
+
+        __rf.options.numberOfGradientOrientations
+            = modelFile["options"]["numberOfGradientOrientations"];
+        __rf.options.gradientSmoothingRadius
+            = modelFile["options"]["gradientSmoothingRadius"];
+        __rf.options.regFeatureSmoothingRadius
+            = modelFile["options"]["regFeatureSmoothingRadius"];
+        __rf.options.ssFeatureSmoothingRadius
+            = modelFile["options"]["ssFeatureSmoothingRadius"];
+        __rf.options.gradientNormalizationRadius
+            = modelFile["options"]["gradientNormalizationRadius"];
+
+        __rf.options.selfsimilarityGridSize
+            = modelFile["options"]["selfsimilarityGridSize"];
+
+        __rf.options.numberOfTrees
+            = modelFile["options"]["numberOfTrees"];
+        __rf.options.numberOfTreesToEvaluate
+            = modelFile["options"]["numberOfTreesToEvaluate"];
+
+        __rf.options.numberOfOutputChannels =
+            2*(__rf.options.numberOfGradientOrientations + 1) + 3;
+        //--------------------------------------------
+
+        cv::FileNode childsNode = modelFile["childs"];
+        cv::FileNode featureIdsNode = modelFile["featureIds"];
+
+        std::vector <int> currentTree;
+        std::vector <int> childs, featureIds;
+        std::vector <float> thresholds;
+
+        for(cv::FileNodeIterator it = childsNode.begin();
+            it != childsNode.end(); ++it)
+        {
+            (*it) >> currentTree;
+            std::copy(currentTree.begin(), currentTree.end(),
+                std::back_inserter(childs));
+        }
+
+        for(cv::FileNodeIterator it = featureIdsNode.begin();
+            it != featureIdsNode.end(); ++it)
+        {
+            (*it) >> currentTree;
+            std::copy(currentTree.begin(), currentTree.end(),
+                std::back_inserter(featureIds));
+        }
+
+        cv::FileNode thresholdsNode = modelFile["thresholds"];
+        std::vector <float> fcurrentTree;
+
+        for(cv::FileNodeIterator it = thresholdsNode.begin();
+            it != thresholdsNode.end(); ++it)
+        {
+            (*it) >> fcurrentTree;
+            std::copy(fcurrentTree.begin(), fcurrentTree.end(),
+                std::back_inserter(thresholds));
+        }
+
+        cv::FileNode edgeBoundaries = modelFile["edgeBoundaries"];
+        cv::FileNode edgeBins = modelFile["edgeBins"];
+
+        for(cv::FileNodeIterator it = edgeBoundaries.begin();
+            it != edgeBoundaries.end(); ++it)
+        {
+            (*it) >> currentTree;
+            std::copy(currentTree.begin(), currentTree.end(),
+                std::back_inserter(__rf.edgeBoundaries));
+        }
+
+        for(cv::FileNodeIterator it = edgeBins.begin();
+            it != edgeBins.end(); ++it)
+        {
+            (*it) >> currentTree;
+            std::copy(currentTree.begin(), currentTree.end(),
+                std::back_inserter(__rf.edgeBins));
+        }
+
+        CV_Assert( childs.size() == featureIds.size() && childs.size() == thresholds.size() );
+
+        __rf.nodes.resize(childs.size());
+        for (size_t i = 0; i < childs.size(); ++i)
+        {
+            __rf.nodes[i].child = childs[i];
+            __rf.nodes[i].featureId = featureIds[i];
+            __rf.nodes[i].threshold = thresholds[i];
+        }
+
+        __rf.numberOfTreeNodes = int( __rf.nodes.size() ) / __rf.options.numberOfTrees;
+    }
+
+    /*!
+     * The function loads the model if it is stored in the binary format
+     * written by saveBinaryModel. The file is read as a few contiguous
+     * blocks, which is much faster than parsing the YAML model.
+     *
+     * \param filename : name of the file where the model is stored
+     * \return false if the file is not a binary model
+     */
+    bool loadBinaryModel(const cv::String &filename)
+    {
+        std::ifstream modelFile(filename.c_str(), std::ios::binary);
+        if ( !modelFile.is_open() )
+            return false;
+
+        char signature[sizeof(binaryModelSignature)];
+        modelFile.read(signature, sizeof(signature));
+        if ( !modelFile.good() || memcmp(signature, binaryModelSignature, sizeof(signature)) != 0 )
+            return false;
+
+        int *fields[nOptionFields];
+        getOptionFields(__rf.options, fields);
+        for (int i = 0; i < nOptionFields; ++i)
+            modelFile.read((char *)fields[i], sizeof(int));
+
+        modelFile.read((char *)&__rf.numberOfTreeNodes, sizeof(int));
+        CV_Assert( modelFile.good() );
+
+        readVector(modelFile, __rf.nodes);
+        readVector(modelFile, __rf.edgeBoundaries);
+        readVector(modelFile, __rf.edgeBins);
+
+        CV_Assert( __rf.options.numberOfTrees > 0 &&
+                   int( __rf.nodes.size() ) == __rf.numberOfTreeNodes * __rf.options.numberOfTrees &&
+                   __rf.edgeBoundaries.size() == __rf.nodes.size() + 1 );
+
+        return true;
+    }
+
+    template <typename T> static void writeVector(std::ofstream &file, const std::vector<T> &v)
+    {
+        int size = int( v.size() );
+        file.write((const char *)&size, sizeof(int));
+        if (size > 0)
+            file.write((const char *)&v[0], size*sizeof(T));
+    }
+
+    template <typename T> static void readVector(std::ifstream &file, std::vector<T> &v)
+    {
+        int size = 0;
+        file.read((char *)&size, sizeof(int));
+        CV_Assert( file.good() && size >= 0 );
+
+        v.resize(size);
+        if (size > 0)
+            file.read((char *)&v[0], size*sizeof(T));
+        CV_Assert( file.good() );
+    }
+
     /*!
      * Private method used by process method. The function
      * predict edges in n-channel feature image and store them to dst.
@@ -694,17 +957,6 @@ protected:
         }
         // lookup table for mapping linear index to offsets
 
-        std::vector <int> offsetE(/**/ CV_SQR(ipSize)*outNum, 0);
-        for (int i = 0; i < CV_SQR(ipSize)*outNum; ++i)
-        {
-            int z = i / CV_SQR(ipSize);
-            int y = ( i % CV_SQR(ipSize) )/ipSize;
-            int x = ( i % CV_SQR(ipSize) )%ipSize;
-
-            offsetE[i] = x*dst.cols*outNum + y*outNum + z;
-        }
-        // lookup table for mapping linear index to offsets
-
         std::vector <int> offsetX( CV_SQR(gridSize)*(CV_SQR(gridSize) - 1)/2 * nchannels, 0);
         std::vector <int> offsetY( CV_SQR(gridSize)*(CV_SQR(gridSize) - 1)/2 * nchannels, 0);
 
@@ -729,85 +981,31 @@ protected:
                 offsetY[n] = x2*features.cols*nchannels + y2*nchannels + z;
             }
             // lookup tables for mapping linear index to offset pairs
-        #ifdef _OPENMP
-        #pragma omp parallel for
-        #endif
-        for (int i = 0; i < height; ++i)
-        {
-            float *regFeaturesPtr = regFeatures.ptr<float>(i*stride/shrink);
-            float  *ssFeaturesPtr = ssFeatures.ptr<float>(i*stride/shrink);
-
-            int *indexPtr = indexes.ptr<int>(i);
+        parallel_for_(cv::Range(0, height), TreesInvoker(&__rf.nodes[0], regFeatures, ssFeatures,
+            offsetI, offsetX, offsetY, indexes, nFeatures, nTrees, nTreesEval, nTreesNodes, stride, shrink));
 
-            for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
-                // for j,k in [0;width)x[0;nTreesEval)
-            {
-                int baseNode = ( ((i + j)%(2*nTreesEval) + k)%nTrees )*nTreesNodes;
-                int currentNode = baseNode;
-                // select root node of the tree to evaluate
-
-                int offset = (j*stride/shrink)*nchannels;
-                while ( __rf.childs[currentNode] != 0 )
-                {
-                    int currentId = __rf.featureIds[currentNode];
-                    float currentFeature;
-
-                    if (currentId >= nFeatures)
-                    {
-                        int xIndex = offsetX[currentId - nFeatures];
-                        float A = ssFeaturesPtr[offset + xIndex];
-
-                        int yIndex = offsetY[currentId - nFeatures];
-                        float B = ssFeaturesPtr[offset + yIndex];
-
-                        currentFeature = A - B;
-                    }
-                    else
-                        currentFeature = regFeaturesPtr[offset + offsetI[currentId]];
-
-                    // compare feature to threshold and move left or right accordingly
-                    if (currentFeature < __rf.thresholds[currentNode])
-                        currentNode = baseNode + __rf.childs[currentNode] - 1;
-                    else
-                        currentNode = baseNode + __rf.childs[currentNode];
-                }
+        // Edge pixels of the leaves are summed over the output channels, so they are
+        // accumulated directly in a single channel map.
+        std::vector <int> offsetE(/**/ CV_SQR(ipSize)*outNum, 0);
+        for (int i = 0; i < CV_SQR(ipSize)*outNum; ++i)
+        {
+            int y = ( i % CV_SQR(ipSize) )/ipSize;
+            int x = ( i % CV_SQR(ipSize) )%ipSize;
 
-                indexPtr[j*nTreesEval + k] = currentNode;
-            }
+            offsetE[i] = x*dst.cols + y;
         }
+        // lookup table for mapping linear index to offsets
 
-        NChannelsMat dstM(dst.size(),
-            CV_MAKETYPE(DataType<float>::type, outNum));
-        dstM.setTo(0);
+        cv::Mat E = cv::Mat::zeros(dst.size(), cv::DataType<float>::type);
 
         float step = 2.0f * CV_SQR(stride) / CV_SQR(ipSize) / nTreesEval;
-        #ifdef _OPENMP
-        #pragma omp parallel for
-        #endif
-        for (int i = 0; i < height; ++i)
-        {
-            int *pIndex = indexes.ptr<int>(i);
-            float *pDst = dstM.ptr<float>(i*stride);
-
-                for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
-                {// for j,k in [0;width)x[0;nTreesEval)
+        int period = (ipSize + stride - 1) / stride;
+        for (int phase = 0; phase < std::min(period, height); ++phase)
+            parallel_for_(cv::Range(0, (height - phase + period - 1) / period),
+                EdgesAccumulateInvoker(indexes, __rf.edgeBoundaries, __rf.edgeBins, offsetE,
+                                       E, nTreesEval, stride, phase, period, step));
 
-                    int currentNode = pIndex[j*nTreesEval + k];
-
-                    int start  = __rf.edgeBoundaries[currentNode];
-                    int finish = __rf.edgeBoundaries[currentNode + 1];
-
-                    if (start == finish)
-                        continue;
-
-                    int offset = j*stride*outNum;
-                    for (int p = start; p < finish; ++p)
-                        pDst[offset + offsetE[__rf.edgeBins[p]]] += step;
-                }
-        }
-
-        cv::reduce( dstM.reshape(1, int( dstM.total() ) ), dstM, 2, CV_REDUCE_SUM);
-        imsmooth( dstM.reshape(1, dst.rows), 1 ).copyTo(dst);
+        imsmooth( E, 1 ).copyTo(dst);
     }
 
 /********************* Members *********************/
@@ -859,13 +1057,29 @@ protected:
 
         int numberOfTreeNodes;
 
-        std::vector <int> featureIds;     /*!< feature coordinate thresholded at k-th node */
-        std::vector <float> thresholds;   /*!< threshold applied to featureIds[k] at k-th node */
-        std::vector <int> childs;         /*!< k --> child[k] - 1, child[k] */
+        std::vector <RFNode> nodes;       /*!< nodes of all trees, numberOfTreeNodes per tree */
 
         std::vector <int> edgeBoundaries; /*!< ... */
         std::vector <int> edgeBins;       /*!< ... */
     } __rf;
+
+    /*! number of fields in RandomForest::RandomForestOptions */
+    enum { nOptionFields = 13 };
+
+    /*!
+     * The function lists the fields of the options, in the order of the binary format.
+     */
+    static void getOptionFields(RandomForest::RandomForestOptions &options, int *fields[nOptionFields])
+    {
+        int *allFields[nOptionFields] = {
+            &options.numberOfOutputChannels, &options.patchSize, &options.patchInnerSize,
+            &options.regFeatureSmoothingRadius, &options.ssFeatureSmoothingRadius, &options.shrinkNumber,
+            &options.numberOfGradientOrientations, &options.gradientSmoothingRadius,
+            &options.gradientNormalizationRadius, &options.selfsimilarityGridSize,
+            &options.numberOfTrees, &options.numberOfTreesToEvaluate, &options.stride };
+
+        std::copy(allFields, allFields + nOptionFields, fields);
+    }
 };
 
 Ptr<StructuredEdgeDetection> createStructuredEdgeDetection(const String &model,
@@ -0,0 +1,223 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "precomp.hpp"
+
+namespace cv
+{
+namespace ximgproc
+{
+
+/* Region access for images held in memory: regions are headers over the image data. */
+class MatTileSource : public TileSource
+{
+public:
+    MatTileSource(const Mat& img_) : img(img_) {}
+
+    Size size() const { return img.size(); }
+
+    void getRegion(const Rect& roi, Mat& dst)
+    {
+        dst = img(roi);
+    }
+
+protected:
+    Mat img;
+};
+
+/* The output image is allocated when the first tile arrives, since only then its type is known. */
+class OutputArrayTileSink : public TileSink
+{
+public:
+    OutputArrayTileSink(OutputArray dst_, Size size_) : dst(dst_), size(size_) {}
+
+    void putRegion(const Rect& roi, const Mat& src)
+    {
+        if (img.empty())
+        {
+            dst.create(size, src.type());
+            img = dst.getMat();
+        }
+        CV_Assert(src.type() == img.type() && src.size() == roi.size());
+        src.copyTo(img(roi));
+    }
+
+protected:
+    const _OutputArray& dst;
+    Size size;
+    Mat img;
+};
+
+class TiledEdgeAwareFilterImpl : public TiledEdgeAwareFilter
+{
+public:
+    TiledEdgeAwareFilterImpl(int tileSize_, int haloSize_)
+        : tileSize(tileSize_), haloSize(haloSize_)
+    {
+        CV_Assert(tileSize > 0 && haloSize >= 0);
+    }
+
+    void filter(const Ptr<TileSource>& guide, const Ptr<TileSource>& src, const Ptr<TileSink>& dst);
+
+    void filter(InputArray guide, InputArray src, OutputArray dst);
+
+    int getTileSize() const { return tileSize; }
+    void setTileSize(int tileSize_) { CV_Assert(tileSize_ > 0); tileSize = tileSize_; }
+    int getHaloSize() const { return haloSize; }
+    void setHaloSize(int haloSize_) { CV_Assert(haloSize_ >= 0); haloSize = haloSize_; }
+
+protected:
+    /* Filters one tile extended by its halo, guide and src have the same size. */
+    virtual void filterTile(const Mat& guide, const Mat& src, Mat& dst) = 0;
+
+    int tileSize;
+    int haloSize;
+};
+
+void TiledEdgeAwareFilterImpl::filter(const Ptr<TileSource>& guide, const Ptr<TileSource>& src, const Ptr<TileSink>& dst)
+{
+    CV_Assert(!guide.empty() && !src.empty() && !dst.empty());
+
+    Size sz = src->size();
+    CV_Assert(guide->size() == sz);
+
+    Rect whole(Point(), sz);
+    Mat guideTile, srcTile, dstTile;
+
+    /* Tiles are processed one after the other so that memory stays bounded by the tile size,
+     * the filters themselves are already parallel. */
+    for (int y = 0; y < sz.height; y += tileSize)
+    {
+        for (int x = 0; x < sz.width; x += tileSize)
+        {
+            Rect inner(x, y, std::min(tileSize, sz.width - x), std::min(tileSize, sz.height - y));
+            Rect outer(inner.x - haloSize, inner.y - haloSize, inner.width + 2*haloSize, inner.height + 2*haloSize);
+            outer &= whole;
+
+            guide->getRegion(outer, guideTile);
+            src->getRegion(outer, srcTile);
+            CV_Assert(guideTile.size() == outer.size() && srcTile.size() == outer.size());
+
+            filterTile(guideTile, srcTile, dstTile);
+
+            dst->putRegion(inner, dstTile(inner - outer.tl()));
+        }
+    }
+}
+
+void TiledEdgeAwareFilterImpl::filter(InputArray guide, InputArray src, OutputArray dst)
+{
+    CV_Assert(!guide.empty() && !src.empty() && guide.size() == src.size());
+
+    Mat guideMat = guide.getMat();
+    Mat srcMat = src.getMat();
+    Size sz = srcMat.size();
+
+    /* dst must not share memory with the inputs, since tiles are read after earlier ones were written */
+    Mat dstMat = dst.getMat();
+    if (!dstMat.empty() && (dstMat.datastart == srcMat.datastart || dstMat.datastart == guideMat.datastart))
+        dst.release();
+
+    filter(makePtr<MatTileSource>(guideMat), makePtr<MatTileSource>(srcMat), makePtr<OutputArrayTileSink>(dst, sz));
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+class TiledGuidedFilterImpl : public TiledEdgeAwareFilterImpl
+{
+public:
+    TiledGuidedFilterImpl(int radius_, double eps_, int tileSize_)
+        : TiledEdgeAwareFilterImpl(tileSize_, 2*radius_ + 1), radius(radius_), eps(eps_) {}
+
+protected:
+    void filterTile(const Mat& guide, const Mat& src, Mat& dst)
+    {
+        guidedFilter(guide, src, dst, radius, eps);
+    }
+
+    int radius;
+    double eps;
+};
+
+class TiledDTFilterImpl : public TiledEdgeAwareFilterImpl
+{
+public:
+    TiledDTFilterImpl(double sigmaSpatial_, double sigmaColor_, int mode_, int numIters_, int tileSize_)
+        : TiledEdgeAwareFilterImpl(tileSize_, cvCeil(4*sigmaSpatial_)),
+          sigmaSpatial(sigmaSpatial_), sigmaColor(sigmaColor_), mode(mode_), numIters(numIters_) {}
+
+protected:
+    void filterTile(const Mat& guide, const Mat& src, Mat& dst)
+    {
+        dtFilter(guide, src, dst, sigmaSpatial, sigmaColor, mode, numIters);
+    }
+
+    double sigmaSpatial, sigmaColor;
+    int mode, numIters;
+};
+
+class TiledFastGlobalSmootherFilterImpl : public TiledEdgeAwareFilterImpl
+{
+public:
+    TiledFastGlobalSmootherFilterImpl(double lambda_, double sigma_color_, double lambda_attenuation_, int num_iter_, int tileSize_)
+        : TiledEdgeAwareFilterImpl(tileSize_, cvCeil(4*std::sqrt(lambda_))),
+          lambda(lambda_), sigma_color(sigma_color_), lambda_attenuation(lambda_attenuation_), num_iter(num_iter_) {}
+
+protected:
+    void filterTile(const Mat& guide, const Mat& src, Mat& dst)
+    {
+        fastGlobalSmootherFilter(guide, src, dst, lambda, sigma_color, lambda_attenuation, num_iter);
+    }
+
+    double lambda, sigma_color, lambda_attenuation;
+    int num_iter;
+};
+
+class TiledAMFilterImpl : public TiledEdgeAwareFilterImpl
+{
+public:
+    TiledAMFilterImpl(double sigma_s, double sigma_r, bool adjust_outliers, int tileSize_)
+        : TiledEdgeAwareFilterImpl(tileSize_, cvCeil(4*sigma_s))
+    {
+        amf = createAMFilter(sigma_s, sigma_r, adjust_outliers);
+        amf->setUseRNG(false);
+    }
+
+protected:
+    void filterTile(const Mat& guide, const Mat& src, Mat& dst)
+    {
+        amf->filter(src, dst, guide);
+    }
+
+    Ptr<AdaptiveManifoldFilter> amf;
+};
+
+//////////////////////////////////////////////////////////////////////////
+
+Ptr<TiledEdgeAwareFilter> createTiledGuidedFilter(int radius, double eps, int tileSize)
+{
+    CV_Assert(radius >= 0);
+    return makePtr<TiledGuidedFilterImpl>(radius, eps, tileSize);
+}
+
+Ptr<TiledEdgeAwareFilter> createTiledDTFilter(double sigmaSpatial, double sigmaColor, int mode, int numIters, int tileSize)
+{
+    CV_Assert(sigmaSpatial > 0);
+    return makePtr<TiledDTFilterImpl>(sigmaSpatial, sigmaColor, mode, numIters, tileSize);
+}
+
+Ptr<TiledEdgeAwareFilter> createTiledFastGlobalSmootherFilter(double lambda, double sigma_color, double lambda_attenuation, int num_iter, int tileSize)
+{
+    CV_Assert(lambda > 0);
+    return makePtr<TiledFastGlobalSmootherFilterImpl>(lambda, sigma_color, lambda_attenuation, num_iter, tileSize);
+}
+
+Ptr<TiledEdgeAwareFilter> createTiledAMFilter(double sigma_s, double sigma_r, bool adjust_outliers, int tileSize)
+{
+    CV_Assert(sigma_s > 0);
+    return makePtr<TiledAMFilterImpl>(sigma_s, sigma_r, adjust_outliers, tileSize);
+}
+
+}
+}
@@ -150,50 +150,34 @@ void from32STo32F(Mat &img, Mat &outImg, float *mapping)
 
 
 /***************************************************************
- * Function: float2D
- * Description: allocate a 2D float array with dimension "dim1 x dim2"
+ * Struct: WMFWorkspace
+ * Description: joint-histogram, BCB and their necklace tables used by filterCore.
+ *                One workspace is kept per thread for the duration of a filterCore call,
+ *                and reused for all the columns that thread scans.
+ *                The joint-histogram is all zeros between two scanned columns.
  ***************************************************************/
-float** float2D(int dim1, int dim2)
+struct WMFWorkspace
 {
-    float **ret = new float*[dim1];
-    ret[0] = new float[dim1*dim2];
-    for(int i=1;i<dim1;i++)ret[i] = ret[i-1]+dim2;
+    Mat H;              // joint-histogram, nI x nF
+    Mat Hf, Hb;         // forward and backward links of the necklace tables of H
+    vector<int> BCB;    // balance counting box
+    vector<int> BCBf;   // forward links of the necklace table of BCB
+    vector<int> BCBb;   // backward links of the necklace table of BCB
 
-    return ret;
-}
-
-/***************************************************************
- * Function: float2D_release
- * Description: deallocate the 2D array created by float2D()
- ***************************************************************/
-void float2D_release(float **p)
-{
-    delete []p[0];
-    delete []p;
-}
-
-/***************************************************************
- * Function: int2D
- * Description: allocate a 2D integer array with dimension "dim1 x dim2"
- ***************************************************************/
-int** int2D(int dim1, int dim2)
-{
-    int **ret = new int*[dim1];
-    ret[0] = new int[dim1*dim2];
-    for(int i=1;i<dim1;i++)ret[i] = ret[i-1]+dim2;
-
-    return ret;
-}
-
-/***************************************************************
- * Function: int2D_release
- * Description: deallocate the 2D array created by int2D()
- ***************************************************************/
-void int2D_release(int **p)
-{
-    delete []p[0];
-    delete []p;
-}
+    void create(int nI, int nF)
+    {
+        if(H.rows != nI || H.cols != nF)
+        {
+            H.create(nI, nF, CV_32S);
+            H = Scalar(0);
+        }
+        Hf.create(nI, nF, CV_32S);
+        Hb.create(nI, nF, CV_32S);
+        BCB.resize(nF);
+        BCBf.resize(nF);
+        BCBb.resize(nF);
+    }
+};
 
 /***************************************************************
  * Function: updateBCB
@@ -201,7 +185,7 @@ void int2D_release(int **p)
  ***************************************************************/
 inline void updateBCB(int &num,int *f,int *b,int i,int v)
 {
-    static int p1,p2;
+    int p1,p2;
 
     if(i)
     {
@@ -231,7 +215,7 @@ inline void updateBCB(int &num,int *f,int *b,int i,int v)
  *                If F is 3-channel, perform k-means clustering
  *                If F is 1-channel, only perform type-casting
  ***************************************************************/
-void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightType){
+void featureIndexing(Mat &F, Mat &wMap, int &nF, float sigmaI, int weightType){
     // Configuration and Declaration
     Mat FNew;
     int cols = F.cols, rows = F.rows;
@@ -247,7 +231,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
         F.convertTo(FNew, CV_32S);
 
         // Compute weight map (weight between each pair of feature index)
-        wMap = float2D(nF,nF);
+        wMap.create(nF,nF,CV_32F);
         float nSigmaI = sigmaI;
         float divider = (1.0f/(2*nSigmaI*nSigmaI));
 
@@ -269,7 +253,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
                     default: val = exp(-(diff*diff)*divider);
                 }
 
-                wMap[i][j] = wMap[j][i] = val;
+                wMap.at<float>(i,j) = wMap.at<float>(j,i) = val;
             }
         }
     }
@@ -347,7 +331,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
         }
 
         // Compute weight map (weight between each pair of feature index)
-        wMap = float2D(nF,nF);
+        wMap.create(nF,nF,CV_32F);
         float nSigmaI = sigmaI/256.0f*LOW_NUM;
         float divider = (1.0f/(2*nSigmaI*nSigmaI));
 
@@ -384,7 +368,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
                     default: val = exp(-(diff0*diff0+diff1*diff1+diff2*diff2)*divider);
                 }
 
-                wMap[i][j] = wMap[j][i] = val;
+                wMap.at<float>(i,j) = wMap.at<float>(j,i) = val;
             }
         }
 
@@ -394,40 +378,46 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
     F = FNew;
 }
 
-Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, Mat mask=Mat())
+/***************************************************************
+ * Class: FilterCoreInvoker
+ * Description: joint-histogram filtering of a range of columns. Each column is scanned
+ *                from top to bottom independently of the others, its histogram is built
+ *                from the window of r columns on each side, so that ranges of columns can
+ *                be filtered in parallel with the same result as a sequential scan.
+ ***************************************************************/
+class FilterCoreInvoker : public ParallelLoopBody
 {
-    // Check validation
-    assert(I.depth() == CV_32S && I.channels()==1);//input image: 32SC1
-    assert(F.depth() == CV_32S && F.channels()==1);//feature image: 32SC1
+public:
+    FilterCoreInvoker(const Mat &I_, const Mat &F_, const Mat &wMap_, const Mat &mask_, Mat &outImg_, int r_, int nF_, int nI_,
+                      TLSData<WMFWorkspace> &workspace_)
+        : I(I_), F(F_), wMap(wMap_), mask(mask_), outImg(outImg_), r(r_), nF(nF_), nI(nI_), workspace(workspace_) {}
 
-    // Configuration and declaration
-    int rows = I.rows, cols = I.cols;
-    Mat outImg = I.clone();
+    void operator()(const Range &range) const;
 
-    // Handle Mask
-    if(mask.empty())
-    {
-        mask = Mat(I.size(),CV_8U);
-        mask = Scalar(1);
-    }
+private:
+    const Mat &I, &F, &wMap, &mask;
+    Mat &outImg;
+    int r, nF, nI;
+    TLSData<WMFWorkspace> &workspace;
+};
 
-    // Allocate memory for joint-histogram and BCB
-    int **H = int2D(nI,nF);
-    int *BCB = new int[nF];
+void FilterCoreInvoker::operator()(const Range &range) const
+{
+    int rows = I.rows, cols = I.cols;
+
+    WMFWorkspace &ws = *workspace.get();
+    ws.create(nI, nF);
 
-    // Allocate links for necklace table
-    int **Hf = int2D(nI,nF);//forward link
-    int **Hb = int2D(nI,nF);//backward link
-    int *BCBf = new int[nF];//forward link
-    int *BCBb = new int[nF];//backward link
+    int *BCB = &ws.BCB[0];
+    int *BCBf = &ws.BCBf[0];
+    int *BCBb = &ws.BCBb[0];
 
     // Column Scanning
-    for(int x=0;x<cols;x++)
+    for(int x=range.start;x<range.end;x++)
     {
-        // Reset histogram and BCB for each column
+        // Reset BCB for each column, the joint-histogram is already empty
         memset(BCB, 0, sizeof(int)*nF);
-        memset(H[0], 0, sizeof(int)*nF*nI);
-        for(int i=0;i<nI;i++)Hf[i][0]=Hb[i][0]=0;
+        for(int i=0;i<nI;i++)ws.Hf.ptr<int>(i)[0]=ws.Hb.ptr<int>(i)[0]=0;
         BCBf[0]=BCBb[0]=0;
 
         // Reset cut-point
@@ -441,23 +431,23 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
         int upY = min(rows-1,r);
         for(int i=0;i<=upY;i++)
         {
-            int *IPtr = I.ptr<int>(i);
-            int *FPtr = F.ptr<int>(i);
-            uchar *maskPtr = mask.ptr<uchar>(i);
+            const int *IPtr = I.ptr<int>(i);
+            const int *FPtr = F.ptr<int>(i);
+            const uchar *maskPtr = mask.ptr<uchar>(i);
 
             for(int j=downX;j<=upX;j++)
             {
                 if(!maskPtr[j])continue;
 
                 int fval = IPtr[j];
-                int *curHist = H[fval];
+                int *curHist = ws.H.ptr<int>(fval);
                 int gval = FPtr[j];
 
                 // Maintain necklace table of joint-histogram
                 if(!curHist[gval] && gval)
                 {
-                    int *curHf = Hf[fval];
-                    int *curHb = Hb[fval];
+                    int *curHf = ws.Hf.ptr<int>(fval);
+                    int *curHb = ws.Hb.ptr<int>(fval);
 
                     int p1=0,p2=curHf[0];
                     curHf[p1]=gval;
@@ -475,12 +465,12 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
         for(int y=0;y<rows;y++)
         {
             // Find weighted median with help of BCB and joint-histogram
-            float balanceWeight = 0;
             int curIndex = F.ptr<int>(y,x)[0];
-            float *fPtr = wMap[curIndex];
+            const float *fPtr = wMap.ptr<float>(curIndex);
             int &curMedianVal = medianVal;
 
             // Compute current balance
+            float balanceWeight = 0;
             {
                 int i=0;
                 do
@@ -496,8 +486,8 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                 for(;balanceWeight >= 0 && curMedianVal > 0; curMedianVal--)
                 {
                     float curWeight = 0;
-                    int *nextHist = H[curMedianVal];
-                    int *nextHf = Hf[curMedianVal];
+                    const int *nextHist = ws.H.ptr<int>(curMedianVal);
+                    const int *nextHf = ws.Hf.ptr<int>(curMedianVal);
 
                     // Compute weight change by shift cut-point
                     int i=0;
@@ -520,8 +510,8 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                 for(;balanceWeight < 0 && curMedianVal != nI-1; curMedianVal++)
                 {
                     float curWeight = 0;
-                    int *nextHist = H[curMedianVal+1];
-                    int *nextHf = Hf[curMedianVal+1];
+                    const int *nextHist = ws.H.ptr<int>(curMedianVal+1);
+                    const int *nextHf = ws.Hf.ptr<int>(curMedianVal+1);
 
                     // Compute weight change by shift cut-point
                     int i=0;
@@ -554,84 +544,104 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
             int rownum = y + r + 1;
             if(rownum < rows)
             {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
+                const int *inputImgPtr = I.ptr<int>(rownum);
+                const int *guideImgPtr = F.ptr<int>(rownum);
+                const uchar *maskPtr = mask.ptr<uchar>(rownum);
 
-                    for(int j=downX;j<=upX;j++)
-                    {
-                        if(!maskPtr[j])continue;
+                for(int j=downX;j<=upX;j++)
+                {
+                    if(!maskPtr[j])continue;
 
-                        fval = inputImgPtr[j];
-                        curHist = H[fval];
-                        gval = guideImgPtr[j];
+                    fval = inputImgPtr[j];
+                    curHist = ws.H.ptr<int>(fval);
+                    gval = guideImgPtr[j];
 
-                        // Maintain necklace table of joint-histogram
-                        if(!curHist[gval] && gval)
-                        {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
+                    // Maintain necklace table of joint-histogram
+                    if(!curHist[gval] && gval)
+                    {
+                        int *curHf = ws.Hf.ptr<int>(fval);
+                        int *curHb = ws.Hb.ptr<int>(fval);
 
-                            int p1=0,p2=curHf[0];
-                            curHf[gval]=p2;
-                            curHb[gval]=p1;
-                            curHf[p1]=curHb[p2]=gval;
-                        }
+                        int p1=0,p2=curHf[0];
+                        curHf[gval]=p2;
+                        curHb[gval]=p1;
+                        curHf[p1]=curHb[p2]=gval;
+                    }
 
-                        curHist[gval]++;
+                    curHist[gval]++;
 
-                        // Maintain necklace table of BCB
-                        updateBCB(BCB[gval],BCBf,BCBb,gval,((fval <= medianVal)<<1)-1);
-                    }
+                    // Maintain necklace table of BCB
+                    updateBCB(BCB[gval],BCBf,BCBb,gval,((fval <= medianVal)<<1)-1);
                 }
+            }
 
+            // Delete leaving pixels into joint-histogram and BCB
+            rownum = y - r;
+            if(rownum >= 0)
+            {
+                const int *inputImgPtr = I.ptr<int>(rownum);
+                const int *guideImgPtr = F.ptr<int>(rownum);
+                const uchar *maskPtr = mask.ptr<uchar>(rownum);
 
-                // Delete leaving pixels into joint-histogram and BCB
-                rownum = y - r;
-                if(rownum >= 0)
+                for(int j=downX;j<=upX;j++)
                 {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
-
-                    for(int j=downX;j<=upX;j++)
-                    {
-                        if(!maskPtr[j])continue;
+                    if(!maskPtr[j])continue;
 
-                        fval = inputImgPtr[j];
-                        curHist = H[fval];
-                        gval = guideImgPtr[j];
+                    fval = inputImgPtr[j];
+                    curHist = ws.H.ptr<int>(fval);
+                    gval = guideImgPtr[j];
 
-                        curHist[gval]--;
+                    curHist[gval]--;
 
-                        // Maintain necklace table of joint-histogram
-                        if(!curHist[gval] && gval)
-                        {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
-
-                            int p1=curHb[gval],p2=curHf[gval];
-                            curHf[p1]=p2;
-                            curHb[p2]=p1;
-                        }
+                    // Maintain necklace table of joint-histogram
+                    if(!curHist[gval] && gval)
+                    {
+                        int *curHf = ws.Hf.ptr<int>(fval);
+                        int *curHb = ws.Hb.ptr<int>(fval);
 
-                        // Maintain necklace table of BCB
-                        updateBCB(BCB[gval],BCBf,BCBb,gval,-((fval <= medianVal)<<1)+1);
+                        int p1=curHb[gval],p2=curHf[gval];
+                        curHf[p1]=p2;
+                        curHb[p2]=p1;
                     }
+
+                    // Maintain necklace table of BCB
+                    updateBCB(BCB[gval],BCBf,BCBb,gval,-((fval <= medianVal)<<1)+1);
                 }
+            }
+        }
+
+        // Empty the joint-histogram for the next column: only the cells of the pixels
+        // still in the window can be non-zero, which is cheaper than clearing it all
+        for(int i=max(0,rows-r-1);i<rows;i++)
+        {
+            const int *IPtr = I.ptr<int>(i);
+            const int *FPtr = F.ptr<int>(i);
+            for(int j=downX;j<=upX;j++)
+                ws.H.ptr<int>(IPtr[j])[FPtr[j]] = 0;
         }
     }
+}
+
+Mat filterCore(Mat &I, Mat &F, const Mat &wMap, int r=20, int nF=256, int nI=256, Mat mask=Mat())
+{
+    // Check validation
+    CV_Assert(I.depth() == CV_32S && I.channels()==1);//input image: 32SC1
+    CV_Assert(F.depth() == CV_32S && F.channels()==1);//feature image: 32SC1
 
-    // Deallocate the memory
+    // Configuration and declaration
+    Mat outImg = I.clone();
+
+    // Handle Mask
+    if(mask.empty())
     {
-        delete []BCB;
-        delete []BCBf;
-        delete []BCBb;
-        int2D_release(H);
-        int2D_release(Hf);
-        int2D_release(Hb);
+        mask = Mat(I.size(),CV_8U);
+        mask = Scalar(1);
     }
 
+    // Columns are independent, each range of columns uses the workspace of its thread
+    TLSData<WMFWorkspace> workspace;
+    parallel_for_(Range(0, I.cols), FilterCoreInvoker(I, F, wMap, mask, outImg, r, nF, nI, workspace));
+
     // end of the function
     return outImg;
 }
@@ -695,8 +705,8 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
     //If "F" is 1-channel image, featureIndexing only does a type-casting on "F".
     //The output "F" is CV_32S type, containing indexes of feature values.
     //"wMap" is a 2D array that defines the distance between each pair of feature indexes.
-    // wMap[i][j] is the weight between feature index "i" and "j".
-    float **wMap = NULL;
+    // wMap(i,j) is the weight between feature index "i" and "j".
+    Mat wMap;
     featureIndexing(F, wMap, nF, float(sigma), weightType);
 
     //Filtering - Joint-Histogram Framework
@@ -704,7 +714,6 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
     {
         Is[i] = filterCore(Is[i], F, wMap, r, nF, nI, mask.getMat());
     }
-    float2D_release(wMap);
 
     //Postprocess F
     //Convert input image back to the original type.
@@ -467,4 +467,69 @@ INSTANTIATE_TEST_CASE_P(FullSet, FastHoughTransformTest,
 #undef FHT_ALL_DEPTHS
 #undef FHT_ALL_CHANNELS
 
+//----------------------TEST----------------------------------------------------
+TEST(ximgproc_FastHoughTransform, threads_and_quadrants)
+{
+    // odd sizes, so that the butterfly nodes are not all of the same height
+    Mat src(301, 223, CV_8UC3);
+    randu(src, Scalar::all(0), Scalar::all(256));
+
+    int const ranges[] = { ARO_315_0, ARO_0_45, ARO_45_90, ARO_90_135,
+                           ARO_315_45, ARO_45_135, ARO_315_135,
+                           ARO_CTR_VER, ARO_CTR_HOR };
+    int const ops[] = { FHT_ADD, FHT_AVE, FHT_MIN, FHT_MAX };
+    int const depths[] = { CV_8U, CV_16S, CV_32S, CV_32F };
+
+    int const nThreads = getNumThreads();
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); ++r)
+    for (size_t o = 0; o < sizeof(ops) / sizeof(ops[0]); ++o)
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); ++d)
+    {
+        Mat fht, fhtSerial;
+        FastHoughTransform(src, fht, depths[d], ranges[r], ops[o]);
+        setNumThreads(1);
+        FastHoughTransform(src, fhtSerial, depths[d], ranges[r], ops[o]);
+        setNumThreads(nThreads);
+        EXPECT_EQ(0, cvtest::norm(fht, fhtSerial, NORM_INF))
+            << "angleRange " << ranges[r] << ", op " << ops[o]
+            << ", depth " << depths[d];
+    }
+
+    // each quadrant of the full range is the quadrant computed alone,
+    // the row shared with the next quadrant is taken from the latter
+    Mat full;
+    FastHoughTransform(src, full, CV_32S, ARO_315_135, FHT_ADD);
+    int const quadrants[] = { ARO_315_0, ARO_0_45, ARO_45_90, ARO_90_135 };
+    int y = 0;
+    for (int q = 0; q < 4; ++q)
+    {
+        Mat quad;
+        FastHoughTransform(src, quad, CV_32S, quadrants[q], FHT_ADD);
+        int const rows = (q == 3) ? quad.rows : quad.rows - 1;
+        EXPECT_EQ(0, cvtest::norm(full.rowRange(y, y + rows),
+                                  quad.rowRange(0, rows), NORM_INF))
+            << "quadrant " << quadrants[q];
+        y += quad.rows - 1;
+    }
+    EXPECT_EQ(full.rows, y + 1);
+}
+
+TEST(ximgproc_FastHoughTransform, batched_point2line)
+{
+    Mat src = Mat::zeros(120, 170, CV_8UC1);
+    Mat fht;
+    FastHoughTransform(src, fht, CV_32S);
+
+    RNG rng(0);
+    vector<Point> points(200);
+    for (size_t i = 0; i < points.size(); ++i)
+        points[i] = Point(rng.uniform(0, fht.cols), rng.uniform(0, fht.rows));
+
+    vector<Vec4i> lines;
+    HoughPoint2Line(points, src, lines);
+    ASSERT_EQ(points.size(), lines.size());
+    for (size_t i = 0; i < points.size(); ++i)
+        EXPECT_EQ(HoughPoint2Line(points[i], src), lines[i]) << points[i];
+}
+
 } // namespace cvtest
@@ -171,3 +171,40 @@ TEST_F(ximgproc_FLD, rotatedRect)
     }
     ASSERT_EQ(EPOCHS, passedtests);
 }
+
+TEST_F(ximgproc_FLD, threadsMatchSequential)
+{
+    int nthreads = getNumThreads();
+    for (int i = 0; i < EPOCHS; ++i)
+    {
+        // vertical lines cross the whole image, rotated rectangles give chains in every direction
+        if (i % 3 == 0)
+            GenerateLines(test_image, 1);
+        else if (i % 3 == 1)
+            GenerateBrokenLines(test_image, 3);
+        else
+            GenerateRotatedRect(test_image);
+
+        for (int merge = 0; merge < 2; ++merge)
+        {
+            Ptr<FastLineDetector> detector = createFastLineDetector(10, 1.414213562f, 50, 50, 3, merge != 0);
+
+            vector<Vec4f> lines_seq;
+            setNumThreads(1);
+            detector->detect(test_image, lines_seq);
+            setNumThreads(nthreads);
+            detector->detect(test_image, lines);
+
+            ASSERT_EQ(lines_seq.size(), lines.size());
+            for (size_t j = 0; j < lines.size(); ++j)
+                ASSERT_EQ(lines_seq[j], lines[j]);
+
+            // edge chains are not cut anywhere along the lines
+            if (i % 3 == 0 && merge == 0)
+            {
+                for (size_t j = 0; j < lines.size(); ++j)
+                    ASSERT_GT(std::abs(lines[j][3] - lines[j][1]), img_size.height - 40);
+            }
+        }
+    }
+}
@@ -0,0 +1,126 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+using namespace cv::ximgproc::segmentation;
+
+namespace {
+
+static void createTestImage(Mat& img)
+{
+    RNG rng(0);
+    img.create(Size(320, 240), CV_8UC3);
+    img.setTo(Scalar(128, 128, 128));
+    for (int i = 0; i < 20; i++)
+    {
+        Point center(rng.uniform(0, img.cols), rng.uniform(0, img.rows));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        circle(img, center, rng.uniform(10, 60), color, -1);
+    }
+}
+
+static int checkLabels(const Mat& labels)
+{
+    EXPECT_EQ(CV_32SC1, labels.type());
+
+    double minLabel, maxLabel;
+    minMaxLoc(labels, &minLabel, &maxLabel);
+    EXPECT_EQ(0, minLabel);
+
+    // Ids must be sequential
+    std::vector<bool> used((int)maxLabel + 1, false);
+    for (int i = 0; i < labels.rows; i++)
+        for (int j = 0; j < labels.cols; j++)
+            used[labels.at<int>(i, j)] = true;
+    for (size_t i = 0; i < used.size(); i++)
+        EXPECT_TRUE(used[i]) << "label " << i;
+
+    return (int)maxLabel + 1;
+}
+
+TEST(ximgproc_GraphSegmentation, regression)
+{
+    Mat img;
+    createTestImage(img);
+
+    Ptr<GraphSegmentation> gs = createGraphSegmentation(0.5, 300, 100);
+    Mat labels;
+    gs->processImage(img, labels);
+
+    int nbSegments = checkLabels(labels);
+    EXPECT_GE(nbSegments, 2);
+    EXPECT_LE(nbSegments, img.rows * img.cols / 100);
+
+    // A single tile covering the image is the same as no tiling
+    gs->setTileSize(std::max(img.cols, img.rows));
+    Mat labelsSingleTile;
+    gs->processImage(img, labelsSingleTile);
+    EXPECT_EQ(0, cvtest::norm(labels, labelsSingleTile, NORM_INF));
+}
+
+TEST(ximgproc_GraphSegmentation, tiled)
+{
+    Mat img;
+    createTestImage(img);
+
+    Ptr<GraphSegmentation> gs = createGraphSegmentation(0.5, 300, 100);
+    Mat labels;
+    gs->processImage(img, labels);
+    int nbSegments = checkLabels(labels);
+
+    gs->setTileSize(64);
+    Mat labelsTiled;
+    gs->processImage(img, labelsTiled);
+    int nbSegmentsTiled = checkLabels(labelsTiled);
+
+    // Stitching only approximates the untiled segmentation
+    EXPECT_LE(nbSegmentsTiled, 2 * nbSegments);
+    EXPECT_GE(2 * nbSegmentsTiled, nbSegments);
+}
+
+
+TEST(ximgproc_GraphSegmentation, baseline_output)
+{
+    // Three regions with noise, in 1/16 steps so that the edge weights are computed exactly and have no ties.
+    // With a negligible sigma the filtering is the identity. The expected segment counts and hashes of the labels
+    // were computed with the original implementation, which sorted all the edges of the image at once.
+    Mat img(48, 64, CV_32FC3);
+    static const int base[4][3] = { { 40, 70, 100 }, { 100, 60, 30 }, { 20, 110, 60 }, { 90, 90, 90 } };
+    for (int y = 0; y < img.rows; y++)
+    {
+        for (int x = 0; x < img.cols; x++)
+        {
+            unsigned h = (unsigned)(x * 73856093u) ^ (unsigned)(y * 19349663u);
+            h ^= h >> 13; h *= 0x5bd1e995u; h ^= h >> 15;
+            int region = (x + y / 2 < 48 ? 0 : 1) + ((x - 32) * (x - 32) + (y - 24) * (y - 24) < 144 ? 2 : 0);
+            for (int c = 0; c < 3; c++)
+                img.at<Vec3f>(y, x)[c] = (float)(base[region][c] * 16 + (int)((h >> (c * 8)) % 401) - 200) / 16.f;
+        }
+    }
+
+    const float ks[] = { 60, 150 };
+    const int expectedSegments[] = { 89, 8 };
+    const unsigned expectedHashes[] = { 0x7ff28800u, 0x651b782eu };
+
+    for (int t = 0; t < 2; t++)
+    {
+        Ptr<GraphSegmentation> gs = createGraphSegmentation(0.001, ks[t], 10);
+        gs->setTileSize(std::max(img.cols, img.rows));
+        Mat labels;
+        gs->processImage(img, labels);
+
+        EXPECT_EQ(expectedSegments[t], checkLabels(labels)) << "k=" << ks[t];
+
+        // FNV-1a
+        unsigned hash = 2166136261u;
+        for (int y = 0; y < labels.rows; y++)
+            for (int x = 0; x < labels.cols; x++)
+                hash = (hash ^ (unsigned)labels.at<int>(y, x)) * 16777619u;
+        EXPECT_EQ(expectedHashes[t], hash) << "k=" << ks[t];
+    }
+}
+
+}
@@ -0,0 +1,64 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace std;
+using namespace cv;
+using namespace cv::ximgproc;
+
+static Mat computeLSCLabels(const Mat& img, int region_size, float ratio)
+{
+    Ptr<SuperpixelLSC> lsc = createSuperpixelLSC(img, region_size, ratio);
+    lsc->iterate(10);
+    lsc->enforceLabelConnectivity(20);
+
+    Mat labels;
+    lsc->getLabels(labels);
+    EXPECT_EQ(img.size(), labels.size());
+
+    double minLabel, maxLabel;
+    minMaxLoc(labels, &minLabel, &maxLabel);
+    EXPECT_GE(minLabel, 0);
+    EXPECT_LT(maxLabel, lsc->getNumberOfSuperpixels());
+    return labels.clone();
+}
+
+TEST(ximgproc_SuperpixelLSC, deterministic_across_threads)
+{
+    Mat img = imread(cvtest::TS::ptr()->get_data_path() + "cv/ximgproc/sources/01.png");
+    ASSERT_FALSE(img.empty());
+    cvtColor(img, img, COLOR_BGR2Lab);
+
+    // 8-bit channels use the tabulated features, floating point channels compute them per pixel
+    Mat imgF;
+    img.convertTo(imgF, CV_32F, 1.0 / 255);
+
+    int numThreads = getNumThreads();
+
+    for (int depth = 0; depth < 2; depth++)
+    {
+        const Mat& src = depth == 0 ? img : imgF;
+
+        setNumThreads(1);
+        Mat ref = computeLSCLabels(src, 16, 0.075f);
+
+        for (int threads = 2; threads <= std::max(2, getNumberOfCPUs()); threads *= 2)
+        {
+            setNumThreads(threads);
+            for (int iter = 0; iter < 2; iter++)
+            {
+                Mat labels = computeLSCLabels(src, 16, 0.075f);
+                EXPECT_EQ(0, cvtest::norm(ref, labels, NORM_INF)) << "depth=" << src.depth() << " threads=" << threads;
+            }
+        }
+    }
+
+    setNumThreads(numThreads);
+}
+
+}
@@ -0,0 +1,52 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace std;
+using namespace cv;
+using namespace cv::ximgproc;
+
+static Mat computeSEEDSLabels(const Mat& img, int num_superpixels, int num_levels)
+{
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(img.cols, img.rows, img.channels(),
+            num_superpixels, num_levels, 2, 5, true);
+    seeds->iterate(img, 4);
+
+    Mat labels;
+    seeds->getLabels(labels);
+    EXPECT_EQ(img.size(), labels.size());
+
+    double minLabel, maxLabel;
+    minMaxLoc(labels, &minLabel, &maxLabel);
+    EXPECT_GE(minLabel, 0);
+    EXPECT_LT(maxLabel, seeds->getNumberOfSuperpixels());
+    return labels.clone();
+}
+
+TEST(ximgproc_SuperpixelSEEDS, deterministic_across_threads)
+{
+    Mat img = imread(cvtest::TS::ptr()->get_data_path() + "cv/ximgproc/sources/01.png");
+    ASSERT_FALSE(img.empty());
+    cvtColor(img, img, COLOR_BGR2HSV);
+
+    int numThreads = getNumThreads();
+
+    setNumThreads(1);
+    Mat ref = computeSEEDSLabels(img, 200, 4);
+
+    setNumThreads(getNumberOfCPUs());
+    for (int iter = 0; iter < 3; iter++)
+    {
+        Mat labels = computeSEEDSLabels(img, 200, 4);
+        EXPECT_EQ(0, cvtest::norm(ref, labels, NORM_INF));
+    }
+
+    setNumThreads(numThreads);
+}
+
+}
@@ -0,0 +1,184 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+using namespace cv::ximgproc::segmentation;
+
+namespace {
+
+// Wraps a built-in strategy behind an unknown type, which forces the sequential code path
+class WrappedStrategy : public SelectiveSearchSegmentationStrategy
+{
+public:
+    WrappedStrategy(const Ptr<SelectiveSearchSegmentationStrategy>& s_) : s(s_) {}
+
+    virtual void setImage(InputArray img, InputArray regions, InputArray sizes, int image_id = -1)
+    {
+        s->setImage(img, regions, sizes, image_id);
+    }
+    virtual float get(int r1, int r2) { return s->get(r1, r2); }
+    virtual void merge(int r1, int r2) { s->merge(r1, r2); }
+
+private:
+    Ptr<SelectiveSearchSegmentationStrategy> s;
+};
+
+/* Fixed segmentation: 18 slanted cells, numbered in the order they are first met */
+class FixedGraphSegmentation : public GraphSegmentation
+{
+public:
+    virtual void processImage(InputArray src, OutputArray dst)
+    {
+        Size sz = src.size();
+        dst.create(sz, CV_32SC1);
+        Mat labels = dst.getMat();
+
+        std::vector<int> remap(64, -1);
+        int nb = 0;
+        for (int y = 0; y < sz.height; y++)
+        {
+            for (int x = 0; x < sz.width; x++)
+            {
+                int cell = ((y * 2 + x / 4) / 17) * 8 + (x * 3 + y) / 33;
+                if (remap[cell] < 0)
+                    remap[cell] = nb++;
+                labels.at<int>(y, x) = remap[cell];
+            }
+        }
+    }
+
+    virtual void setSigma(double) {}
+    virtual double getSigma() { return 0; }
+    virtual void setK(float) {}
+    virtual float getK() { return 0; }
+    virtual void setMinSize(int) {}
+    virtual int getMinSize() { return 0; }
+};
+
+/* Similarity of the mean values of the regions. The values are chosen so that there are no ties,
+   the order of the merges doesn't depend on how equal similarities are sorted. */
+class MeanValueStrategy : public SelectiveSearchSegmentationStrategy
+{
+public:
+    virtual void setImage(InputArray, InputArray, InputArray sizes_, int = -1)
+    {
+        Mat sizesMat = sizes_.getMat();
+        int nb = sizesMat.rows;
+        sizes.resize(nb);
+        values.resize(nb);
+        for (int i = 0; i < nb; i++)
+        {
+            sizes[i] = sizesMat.at<int>(i);
+            values[i] = std::sqrt((float)(i * 17 + 5));
+        }
+    }
+
+    virtual float get(int r1, int r2) { return -std::fabs(values[r1] - values[r2]); }
+
+    virtual void merge(int r1, int r2)
+    {
+        float v = (values[r1] * sizes[r1] + values[r2] * sizes[r2]) / (float)(sizes[r1] + sizes[r2]);
+        values[r1] = values[r2] = v;
+        sizes[r1] = sizes[r2] = sizes[r1] + sizes[r2];
+    }
+
+private:
+    std::vector<int> sizes;
+    std::vector<float> values;
+};
+
+static void createTestImage(Mat& img)
+{
+    RNG rng(0);
+    img.create(Size(320, 240), CV_8UC3);
+    img.setTo(Scalar(128, 128, 128));
+    for (int i = 0; i < 20; i++)
+    {
+        Point center(rng.uniform(0, img.cols), rng.uniform(0, img.rows));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        circle(img, center, rng.uniform(10, 60), color, -1);
+    }
+}
+
+static bool rectLess(const Rect& a, const Rect& b)
+{
+    if (a.x != b.x)
+        return a.x < b.x;
+    if (a.y != b.y)
+        return a.y < b.y;
+    if (a.width != b.width)
+        return a.width < b.width;
+    return a.height < b.height;
+}
+
+static void runSelectiveSearch(const Mat& img, bool wrapped, std::vector<Rect>& rects)
+{
+    Ptr<SelectiveSearchSegmentation> ss = createSelectiveSearchSegmentation();
+    ss->setBaseImage(img);
+    ss->switchToSelectiveSearchFast();
+    ss->clearStrategies();
+
+    Ptr<SelectiveSearchSegmentationStrategy> s = createSelectiveSearchSegmentationStrategyMultiple(
+        createSelectiveSearchSegmentationStrategyColor(), createSelectiveSearchSegmentationStrategyFill());
+    if (wrapped)
+        s = makePtr<WrappedStrategy>(s);
+    ss->addStrategy(s);
+
+    srand(0);
+    ss->process(rects);
+}
+
+TEST(ximgproc_SelectiveSearch, parallel_matches_sequential)
+{
+    Mat img;
+    createTestImage(img);
+
+    std::vector<Rect> parallelRects, sequentialRects;
+    runSelectiveSearch(img, false, parallelRects);
+    runSelectiveSearch(img, true, sequentialRects);
+
+    ASSERT_FALSE(parallelRects.empty());
+    ASSERT_EQ(sequentialRects.size(), parallelRects.size());
+    for (size_t i = 0; i < parallelRects.size(); i++)
+        EXPECT_EQ(sequentialRects[i], parallelRects[i]) << "i=" << i;
+}
+
+TEST(ximgproc_SelectiveSearch, baseline_output)
+{
+    // The rects were computed with the original implementation, which compared all pairs of regions
+    // for adjacency and sorted the whole similarity list after each merge.
+    static const int expected[][4] = {
+        { 0, 0, 11, 9 }, { 0, 0, 40, 9 }, { 0, 0, 40, 30 }, { 0, 4, 40, 13 }, { 0, 4, 40, 22 },
+        { 0, 4, 40, 26 }, { 0, 7, 20, 10 }, { 0, 8, 9, 9 }, { 0, 17, 6, 9 }, { 0, 17, 40, 13 },
+        { 0, 21, 40, 9 }, { 0, 23, 26, 7 }, { 0, 24, 14, 6 }, { 0, 26, 3, 4 }, { 2, 24, 12, 6 },
+        { 3, 13, 37, 13 }, { 3, 14, 26, 12 }, { 3, 15, 14, 11 }, { 6, 7, 14, 10 }, { 9, 0, 13, 8 },
+        { 9, 0, 31, 8 }, { 13, 23, 13, 7 }, { 15, 14, 14, 10 }, { 18, 4, 22, 11 }, { 18, 5, 14, 10 },
+        { 21, 0, 12, 6 }, { 21, 0, 19, 6 }, { 24, 21, 13, 9 }, { 24, 21, 16, 9 }, { 26, 13, 14, 10 },
+        { 29, 4, 11, 10 }, { 32, 0, 8, 5 }, { 35, 21, 5, 9 }, { 38, 15, 2, 6 }
+    };
+    const int nbExpected = (int)(sizeof(expected) / sizeof(expected[0]));
+
+    Mat img(30, 40, CV_8UC3, Scalar::all(0));
+
+    Ptr<SelectiveSearchSegmentation> ss = createSelectiveSearchSegmentation();
+    ss->setBaseImage(img);
+    ss->addImage(img);
+    ss->addGraphSegmentation(makePtr<FixedGraphSegmentation>());
+    ss->addStrategy(makePtr<MeanValueStrategy>());
+
+    std::vector<Rect> rects;
+    ss->process(rects);
+
+    // the order of the rects depends on rand(), only the set is compared
+    std::vector<Rect> sorted(rects);
+    std::sort(sorted.begin(), sorted.end(), rectLess);
+
+    ASSERT_EQ(nbExpected, (int)sorted.size());
+    for (int i = 0; i < nbExpected; i++)
+        EXPECT_EQ(Rect(expected[i][0], expected[i][1], expected[i][2], expected[i][3]), sorted[i]) << "i=" << i;
+}
+
+}
@@ -37,4 +37,28 @@ TEST(ximpgroc_StructuredEdgeDetection, regression)
     }
 }
 
+TEST(ximpgroc_StructuredEdgeDetection, binary_model)
+{
+    cv::String dir = cvtest::TS::ptr()->get_data_path() + "cv/ximgproc/";
+
+    cv::Ptr<cv::ximgproc::StructuredEdgeDetection> pDollar =
+        cv::ximgproc::createStructuredEdgeDetection(dir + "model.yml.gz");
+
+    cv::String binaryModelName = cv::tempfile(".bin");
+    pDollar->saveBinaryModel(binaryModelName);
+    cv::Ptr<cv::ximgproc::StructuredEdgeDetection> pDollarBinary =
+        cv::ximgproc::createStructuredEdgeDetection(binaryModelName);
+    remove(binaryModelName.c_str());
+
+    cv::Mat src = cv::imread( dir + "sources/01.png", 1 );
+    ASSERT_TRUE(!src.empty());
+    src.convertTo( src, cv::DataType<float>::type, 1/255.0 );
+
+    cv::Mat result, resultBinary;
+    pDollar->detectEdges( src, result );
+    pDollarBinary->detectEdges( src, resultBinary );
+
+    EXPECT_EQ( 0, cvtest::norm( result, resultBinary, cv::NORM_INF ) );
+}
+
 }
\ No newline at end of file
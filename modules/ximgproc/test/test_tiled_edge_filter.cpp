@@ -0,0 +1,121 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace std;
+using namespace cv;
+using namespace cv::ximgproc;
+
+static Mat makeTestImage(Size sz, int type, uint64 seed)
+{
+    RNG rng(seed);
+    Mat img(sz, type);
+    rng.fill(img, RNG::UNIFORM, 0, 255);
+    // smooth regions separated by edges, closer to natural images than noise
+    GaussianBlur(img, img, Size(9, 9), 3);
+    rectangle(img, Rect(sz.width/4, sz.height/3, sz.width/2, sz.height/4), Scalar::all(220), -1);
+    circle(img, Point(sz.width/3, sz.height/2), sz.height/5, Scalar::all(30), -1);
+    return img;
+}
+
+/* Source which copies the regions, like a reader of a file would, and records their size. */
+class CountingTileSource : public TileSource
+{
+public:
+    CountingTileSource(const Mat& img_) : img(img_), maxArea(0) {}
+
+    Size size() const { return img.size(); }
+
+    void getRegion(const Rect& roi, Mat& dst)
+    {
+        img(roi).copyTo(dst);
+        maxArea = std::max(maxArea, roi.area());
+    }
+
+    Mat img;
+    int maxArea;
+};
+
+class MatTileSink : public TileSink
+{
+public:
+    MatTileSink(Size sz, int type) : img(sz, type, Scalar::all(0)), covered(sz, CV_8U, Scalar(0)) {}
+
+    void putRegion(const Rect& roi, const Mat& src)
+    {
+        ASSERT_EQ(0, countNonZero(covered(roi)));
+        covered(roi).setTo(1);
+        src.copyTo(img(roi));
+    }
+
+    Mat img;
+    Mat covered;
+};
+
+TEST(TiledEdgeAwareFilter, guided_matches_whole_image)
+{
+    Size sz(333, 250);
+    Mat guide = makeTestImage(sz, CV_8UC3, 1);
+    Mat src = makeTestImage(sz, CV_32FC1, 2);
+
+    int radius = 5;
+    double eps = 100;
+    Mat ref, res;
+    guidedFilter(guide, src, ref, radius, eps);
+
+    Ptr<TiledEdgeAwareFilter> tf = createTiledGuidedFilter(radius, eps, 64);
+    EXPECT_EQ(2*radius + 1, tf->getHaloSize());
+    tf->filter(guide, src, res);
+
+    ASSERT_EQ(ref.size(), res.size());
+    ASSERT_EQ(ref.type(), res.type());
+    EXPECT_LE(cvtest::norm(ref, res, NORM_INF), 1e-2);
+}
+
+TEST(TiledEdgeAwareFilter, dt_close_to_whole_image)
+{
+    Size sz(320, 240);
+    Mat img = makeTestImage(sz, CV_8UC3, 3);
+
+    double sigmaSpatial = 10, sigmaColor = 30;
+    Mat ref, res;
+    dtFilter(img, img, ref, sigmaSpatial, sigmaColor);
+
+    Ptr<TiledEdgeAwareFilter> tf = createTiledDTFilter(sigmaSpatial, sigmaColor, DTF_NC, 3, 100);
+    tf->filter(img, img, res);
+
+    ASSERT_EQ(ref.size(), res.size());
+    ASSERT_EQ(ref.type(), res.type());
+    EXPECT_LE(cvtest::norm(ref, res, NORM_L1) / ref.total() / ref.channels(), 1.0);
+}
+
+TEST(TiledEdgeAwareFilter, region_callbacks)
+{
+    Size sz(300, 200);
+    Mat guide = makeTestImage(sz, CV_8UC1, 4);
+    Mat src = makeTestImage(sz, CV_8UC1, 5);
+
+    int radius = 3, tileSize = 50;
+    Ptr<TiledEdgeAwareFilter> tf = createTiledGuidedFilter(radius, 50, tileSize);
+    int halo = tf->getHaloSize();
+
+    Ptr<CountingTileSource> guideSource = makePtr<CountingTileSource>(guide);
+    Ptr<CountingTileSource> srcSource = makePtr<CountingTileSource>(src);
+    Ptr<MatTileSink> sink = makePtr<MatTileSink>(sz, CV_8UC1);
+    tf->filter(guideSource, srcSource, sink);
+
+    EXPECT_EQ(sz.area(), countNonZero(sink->covered));
+    EXPECT_LE(srcSource->maxArea, (tileSize + 2*halo)*(tileSize + 2*halo));
+    EXPECT_LE(guideSource->maxArea, (tileSize + 2*halo)*(tileSize + 2*halo));
+
+    Mat ref;
+    tf->filter(guide, src, ref);
+    EXPECT_EQ(0, cvtest::norm(ref, sink->img, NORM_INF));
+}
+
+}
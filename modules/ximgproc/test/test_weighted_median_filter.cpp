@@ -112,6 +112,79 @@ TEST(WeightedMedianFilterTest, mask_zeros_no_crash)
     EXPECT_EQ(cv::norm(img, filtered, NORM_INF), 0.0);
 }
 
+TEST(WeightedMedianFilterTest, threads_and_repeated_calls)
+{
+    Mat img = imread(getDataDir() + "cv/ximgproc/sources/01.png");
+    ASSERT_FALSE(img.empty());
+    Mat gray;
+    cvtColor(img, gray, COLOR_BGR2GRAY);
+
+    int numThreads = cv::getNumThreads();
+
+    // the per-thread workspaces are reused with a different number of feature indexes,
+    // the RNG is reset for the k-means clustering of the 3-channel guide
+    Mat ref3, ref1;
+    cv::setNumThreads(1);
+    theRNG() = RNG(0);
+    weightedMedianFilter(img, img, ref3, 5, 25.5, WMF_EXP);
+    weightedMedianFilter(gray, img, ref1, 5, 25.5, WMF_EXP);
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+    for (int iter = 0; iter < 2; iter++)
+    {
+        Mat res3, res1;
+        theRNG() = RNG(0);
+        weightedMedianFilter(img, img, res3, 5, 25.5, WMF_EXP);
+        weightedMedianFilter(gray, img, res1, 5, 25.5, WMF_EXP);
+        EXPECT_EQ(0, cvtest::norm(ref3, res3, NORM_INF));
+        EXPECT_EQ(0, cvtest::norm(ref1, res1, NORM_INF));
+    }
+
+    cv::setNumThreads(numThreads);
+}
+
+TEST(WeightedMedianFilterTest, baseline_output)
+{
+    // synthetic step edge with noise, the expected hashes of the output were computed
+    // with the original sequential implementation of the filter
+    Mat src(48, 64, CV_8UC1), guide(48, 64, CV_8UC1);
+    for (int y = 0; y < src.rows; y++)
+    {
+        for (int x = 0; x < src.cols; x++)
+        {
+            unsigned h = (unsigned)(x*73856093u) ^ (unsigned)(y*19349663u);
+            h ^= h >> 13; h *= 0x5bd1e995u; h ^= h >> 15;
+            int edge = x + y/2 < 48 ? 60 : 190;
+            src.at<uchar>(y, x) = (uchar)((edge + (int)(h % 61) - 30 + 256) % 256);
+            guide.at<uchar>(y, x) = (uchar)(edge + (int)((h >> 8) % 21) - 10);
+        }
+    }
+
+    const int weightTypes[] = { WMF_EXP, WMF_IV1, WMF_JAC };
+    const double sigmas[] = { 25.5, 10, 1 };
+    const int radii[] = { 5, 7, 3 };
+    const unsigned expected[] = { 0x6857270fu, 0x088186deu, 0x5107da81u };
+
+    int numThreads = cv::getNumThreads();
+    for (int t = 0; t < 3; t++)
+    {
+        for (int threads = 1; threads <= 2; threads++)
+        {
+            cv::setNumThreads(threads == 1 ? 1 : cv::getNumberOfCPUs());
+            Mat res;
+            weightedMedianFilter(guide, src, res, radii[t], sigmas[t], weightTypes[t]);
+
+            // FNV-1a
+            unsigned hash = 2166136261u;
+            for (int y = 0; y < res.rows; y++)
+                for (int x = 0; x < res.cols; x++)
+                    hash = (hash ^ res.at<uchar>(y, x)) * 16777619u;
+            EXPECT_EQ(expected[t], hash) << "weightType=" << weightTypes[t] << " threads=" << cv::getNumThreads();
+        }
+    }
+    cv::setNumThreads(numThreads);
+}
+
 INSTANTIATE_TEST_CASE_P(TypicalSET, WeightedMedianFilterTest, Combine(Values(szODD, szQVGA),  Values(WMF_EXP, WMF_IV2, WMF_OFF)));
 
 }